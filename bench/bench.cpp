@@ -0,0 +1,278 @@
+// CPU micro-benchmarks of engine hot paths. Runs without a window or a Vulkan device, the engine
+// sources are linked in but nijiEngine never gets initialized.
+//
+// niji_bench [--filter=<substring>] [--samples=<n>] [--min-sample-ms=<ms>] [--json=<file>]
+// niji_bench --check [--filter=<substring>]
+
+#define VMA_IMPLEMENTATION
+#include <vk_mem_alloc.h>
+
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+using namespace niji::bench;
+using json = nlohmann::json;
+
+struct RegisteredBench
+{
+    std::string Name = {};
+    BenchFunction Function = nullptr;
+};
+
+// Function local, registrars of other translation units may run before this file's statics
+static std::vector<RegisteredBench>& get_registry()
+{
+    static std::vector<RegisteredBench> registry = {};
+    return registry;
+}
+
+BenchRegistrar::BenchRegistrar(const char* name, BenchFunction function)
+{
+    get_registry().push_back({name, function});
+}
+
+struct RegisteredCheck
+{
+    std::string Name = {};
+    CheckFunction Function = nullptr;
+};
+
+static std::vector<RegisteredCheck>& get_check_registry()
+{
+    static std::vector<RegisteredCheck> registry = {};
+    return registry;
+}
+
+CheckRegistrar::CheckRegistrar(const char* name, CheckFunction function)
+{
+    get_check_registry().push_back({name, function});
+}
+
+void niji::bench::fail_check(const char* condition, const char* file, int line)
+{
+    throw CheckFailure(std::string(file) + ":" + std::to_string(line) + ": " + condition);
+}
+
+// Every check runs even after one failed, the exit code says whether all of them passed
+static int run_checks(const std::string& filter)
+{
+    std::vector<RegisteredCheck> checks = get_check_registry();
+    std::sort(checks.begin(), checks.end(),
+              [](const RegisteredCheck& a, const RegisteredCheck& b) { return a.Name < b.Name; });
+
+    uint32_t ran = 0;
+    uint32_t failed = 0;
+    for (const RegisteredCheck& check : checks)
+    {
+        if (!filter.empty() && check.Name.find(filter) == std::string::npos)
+            continue;
+
+        ran++;
+        try
+        {
+            check.Function();
+            printf("%-44s passed\n", check.Name.c_str());
+        }
+        catch (const std::exception& error)
+        {
+            failed++;
+            printf("%-44s FAILED: %s\n", check.Name.c_str(), error.what());
+        }
+    }
+
+    printf("[Check] %u of %u checks passed\n", ran - failed, ran);
+    return failed == 0 && ran > 0 ? 0 : 1;
+}
+
+double BenchState::run_sample(const std::function<void()>& function, uint64_t iterations) const
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++)
+        function();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+void BenchState::measure(const std::function<void()>& function)
+{
+    // Double the iterations until one sample is long enough to drown out the timer resolution
+    const double minSampleNs = m_settings.MinSampleMs * 1e6;
+    uint64_t iterations = 1;
+    double sampleNs = run_sample(function, iterations);
+    while (sampleNs < minSampleNs && iterations < (1ull << 40))
+    {
+        // Jump close to the target once a sample takes long enough to extrapolate from
+        if (sampleNs > minSampleNs / 100.0)
+            iterations = static_cast<uint64_t>(std::ceil(iterations * minSampleNs / sampleNs));
+        else
+            iterations *= 2;
+        sampleNs = run_sample(function, iterations);
+    }
+
+    for (uint32_t i = 0; i < m_settings.WarmupSamples; i++)
+        run_sample(function, iterations);
+
+    std::vector<double> samples(std::max(m_settings.Samples, 2u));
+    for (double& sample : samples)
+        sample = run_sample(function, iterations) / static_cast<double>(iterations);
+
+    std::vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+
+    const size_t count = sorted.size();
+    const auto median_of = [](const std::vector<double>& values) {
+        const size_t half = values.size() / 2;
+        return values.size() % 2 ? values[half] : (values[half - 1] + values[half]) * 0.5;
+    };
+
+    double total = 0.0;
+    for (double sample : sorted)
+        total += sample;
+    const double mean = total / count;
+
+    double variance = 0.0;
+    for (double sample : sorted)
+        variance += (sample - mean) * (sample - mean);
+    variance /= static_cast<double>(count - 1);
+
+    const double median = median_of(sorted);
+    std::vector<double> deviations(count);
+    for (size_t i = 0; i < count; i++)
+        deviations[i] = std::abs(sorted[i] - median);
+    std::sort(deviations.begin(), deviations.end());
+    const double mad = median_of(deviations);
+
+    uint32_t outliers = 0;
+    for (double sample : sorted)
+    {
+        if (mad > 0.0 && std::abs(sample - median) > 3.0 * mad)
+            outliers++;
+    }
+
+    m_result.Samples = static_cast<uint32_t>(count);
+    m_result.IterationsPerSample = iterations;
+    m_result.MeanNs = mean;
+    m_result.MedianNs = median;
+    m_result.StdDevNs = std::sqrt(variance);
+    m_result.MinNs = sorted.front();
+    m_result.MaxNs = sorted.back();
+    // Normal approximation, fine with the default 30 samples
+    m_result.Ci95Ns = 1.96 * m_result.StdDevNs / std::sqrt(static_cast<double>(count));
+    m_result.Outliers = outliers;
+}
+
+static bool read_value(const std::string& arg, const std::string& option, std::string& value)
+{
+    const std::string prefix = option + "=";
+    if (arg.rfind(prefix, 0) != 0)
+        return false;
+
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+static json to_json(const BenchResult& result)
+{
+    json j;
+    j["Name"] = result.Name;
+    j["Samples"] = result.Samples;
+    j["IterationsPerSample"] = result.IterationsPerSample;
+    j["MeanNs"] = result.MeanNs;
+    j["MedianNs"] = result.MedianNs;
+    j["StdDevNs"] = result.StdDevNs;
+    j["MinNs"] = result.MinNs;
+    j["MaxNs"] = result.MaxNs;
+    j["Ci95Ns"] = result.Ci95Ns;
+    j["Outliers"] = result.Outliers;
+    if (result.ItemsPerIteration > 0)
+    {
+        j["ItemsPerIteration"] = result.ItemsPerIteration;
+        j["ItemsPerSecond"] = result.ItemsPerIteration / (result.MedianNs * 1e-9);
+    }
+    return j;
+}
+
+int main(int argc, char** argv)
+{
+    BenchSettings settings = {};
+    std::string jsonPath = {};
+    bool check = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        std::string value = {};
+
+        if (read_value(arg, "--filter", value))
+            settings.Filter = value;
+        else if (read_value(arg, "--samples", value))
+            settings.Samples = static_cast<uint32_t>(std::max(std::atoi(value.c_str()), 2));
+        else if (read_value(arg, "--min-sample-ms", value))
+            settings.MinSampleMs = std::max(std::atof(value.c_str()), 0.1);
+        else if (read_value(arg, "--json", value))
+            jsonPath = value;
+        else if (arg == "--check")
+            check = true;
+        else
+            printf("[Bench] Unknown Argument: %s\n", arg.c_str());
+    }
+
+    if (check)
+        return run_checks(settings.Filter);
+
+    std::vector<RegisteredBench> benches = get_registry();
+    std::sort(benches.begin(), benches.end(),
+              [](const RegisteredBench& a, const RegisteredBench& b) { return a.Name < b.Name; });
+
+    printf("%-44s %12s %12s %10s %8s %6s\n", "Benchmark", "Median (ns)", "Mean (ns)", "+/- 95%",
+           "Iters", "Outl.");
+
+    json results = json::array();
+    for (const RegisteredBench& bench : benches)
+    {
+        if (!settings.Filter.empty() && bench.Name.find(settings.Filter) == std::string::npos)
+            continue;
+
+        BenchState state(bench.Name, settings);
+        bench.Function(state);
+
+        const BenchResult& result = state.get_result();
+        if (result.Samples == 0)
+        {
+            printf("%-44s skipped\n", bench.Name.c_str());
+            continue;
+        }
+
+        printf("%-44s %12.1f %12.1f %9.2f%% %8llu %6u\n", result.Name.c_str(), result.MedianNs,
+               result.MeanNs, 100.0 * result.Ci95Ns / result.MeanNs,
+               static_cast<unsigned long long>(result.IterationsPerSample), result.Outliers);
+        results.push_back(to_json(result));
+    }
+
+    if (!jsonPath.empty())
+    {
+        std::ofstream file(jsonPath);
+        if (!file.is_open())
+        {
+            printf("[Bench] Failed to write %s\n", jsonPath.c_str());
+            return 1;
+        }
+
+        json root;
+        root["Settings"] = {{"Samples", settings.Samples},
+                            {"MinSampleMs", settings.MinSampleMs},
+                            {"WarmupSamples", settings.WarmupSamples}};
+        root["Results"] = results;
+        file << root.dump(4);
+    }
+
+    return 0;
+}
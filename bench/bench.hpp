@@ -0,0 +1,138 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace niji::bench
+{
+
+struct BenchResult
+{
+    std::string Name = {};
+    uint32_t Samples = 0;
+    uint64_t IterationsPerSample = 0;
+    // Per iteration, in nanoseconds
+    double MeanNs = 0.0;
+    double MedianNs = 0.0;
+    double StdDevNs = 0.0;
+    double MinNs = 0.0;
+    double MaxNs = 0.0;
+    // Half width of the 95% confidence interval of the mean
+    double Ci95Ns = 0.0;
+    // Samples further than 3 median absolute deviations from the median
+    uint32_t Outliers = 0;
+    // Work items per iteration (vertices, lights, ...), 0 when it doesn't apply
+    uint64_t ItemsPerIteration = 0;
+};
+
+struct BenchSettings
+{
+    uint32_t Samples = 30;
+    // Iterations per sample get calibrated so a sample takes at least this long
+    double MinSampleMs = 10.0;
+    uint32_t WarmupSamples = 3;
+    std::string Filter = {};
+};
+
+// Handed to every benchmark. Setup happens before measure(), only the measured function is timed.
+class BenchState
+{
+  public:
+    BenchState(const std::string& name, const BenchSettings& settings)
+        : m_settings(settings)
+    {
+        m_result.Name = name;
+    }
+
+    void set_items_per_iteration(uint64_t items)
+    {
+        m_result.ItemsPerIteration = items;
+    }
+
+    // Calibrates the iteration count, runs the warm-up samples and then the measured ones
+    void measure(const std::function<void()>& function);
+
+    const BenchResult& get_result() const
+    {
+        return m_result;
+    }
+
+  private:
+    double run_sample(const std::function<void()>& function, uint64_t iterations) const;
+
+  private:
+    const BenchSettings& m_settings;
+    BenchResult m_result = {};
+};
+
+using BenchFunction = void (*)(BenchState& state);
+
+// Static registration, see NIJI_BENCHMARK
+struct BenchRegistrar
+{
+    BenchRegistrar(const char* name, BenchFunction function);
+};
+
+// Correctness checks, `niji_bench --check` runs them instead of the benchmarks and exits with 1 once
+// one of them threw (CTest runs it as niji_checks). See NIJI_CHECK and NIJI_REQUIRE.
+using CheckFunction = void (*)();
+
+struct CheckRegistrar
+{
+    CheckRegistrar(const char* name, CheckFunction function);
+};
+
+class CheckFailure : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+[[noreturn]] void fail_check(const char* condition, const char* file, int line);
+
+// Keeps the compiler from optimizing away a result that's otherwise unused
+template <typename T>
+inline void do_not_optimize(const T& value)
+{
+#if defined(_MSC_VER)
+    static volatile const void* sink = nullptr;
+    sink = &value;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+} // namespace niji::bench
+
+#define NIJI_BENCH_CONCAT_IMPL(a, b) a##b
+#define NIJI_BENCH_CONCAT(a, b) NIJI_BENCH_CONCAT_IMPL(a, b)
+#define NIJI_BENCHMARK(name, function)                                                             \
+    static ::niji::bench::BenchRegistrar NIJI_BENCH_CONCAT(benchRegistrar, __LINE__)(name, function)
+#define NIJI_CHECK(name, function)                                                                 \
+    static ::niji::bench::CheckRegistrar NIJI_BENCH_CONCAT(checkRegistrar, __LINE__)(name, function)
+// Fails the running check, with the condition and where it sits
+#define NIJI_REQUIRE(condition)                                                                    \
+    do                                                                                             \
+    {                                                                                              \
+        if (!(condition))                                                                          \
+            ::niji::bench::fail_check(#condition, __FILE__, __LINE__);                             \
+    } while (false)
+#define NIJI_REQUIRE_THROWS(expression)                                                            \
+    do                                                                                             \
+    {                                                                                              \
+        bool nijiThrew = false;                                                                    \
+        try                                                                                        \
+        {                                                                                          \
+            expression;                                                                            \
+        }                                                                                          \
+        catch (...)                                                                                \
+        {                                                                                          \
+            nijiThrew = true;                                                                      \
+        }                                                                                          \
+        if (!nijiThrew)                                                                            \
+            ::niji::bench::fail_check(#expression " throws", __FILE__, __LINE__);                  \
+    } while (false)
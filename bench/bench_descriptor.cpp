@@ -0,0 +1,169 @@
+#include "bench.hpp"
+
+#include "core/descriptor.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace niji;
+using namespace niji::bench;
+
+// Same binding layout as the light culling pass (the widest push descriptor in the renderer).
+// Descriptor::push_descriptor_writes() only forwards its bindings to build_descriptor_writes().
+static void descriptor_push_writes(BenchState& state)
+{
+    static Buffer buffers[4] = {};
+    static Texture textures[3] = {};
+
+    std::vector<DescriptorBinding> bindings(8);
+    const DescriptorBinding::BindType types[8] = {
+        DescriptorBinding::BindType::UBO,            DescriptorBinding::BindType::STORAGE_BUFFER,
+        DescriptorBinding::BindType::STORAGE_BUFFER, DescriptorBinding::BindType::STORAGE_BUFFER,
+        DescriptorBinding::BindType::STORAGE_TEXTURE, DescriptorBinding::BindType::TEXTURE,
+        DescriptorBinding::BindType::STORAGE_BUFFER, DescriptorBinding::BindType::UBO};
+
+    uint32_t bufferIndex = 0;
+    uint32_t textureIndex = 0;
+    for (size_t i = 0; i < bindings.size(); i++)
+    {
+        bindings[i].Type = types[i];
+        bindings[i].Count = 1;
+        bindings[i].Stage = DescriptorBinding::BindStage::COMPUTE;
+        if (types[i] == DescriptorBinding::BindType::STORAGE_TEXTURE ||
+            types[i] == DescriptorBinding::BindType::TEXTURE)
+            bindings[i].Resource = &textures[textureIndex++ % 3];
+        else
+            bindings[i].Resource = &buffers[bufferIndex++ % 4];
+    }
+    state.set_items_per_iteration(bindings.size());
+
+    // Reserved the way the passes do it, the writes point into the info vectors
+    FrameVector<VkWriteDescriptorSet> writes = {};
+    FrameVector<VkDescriptorBufferInfo> bufferInfos = {};
+    FrameVector<VkDescriptorImageInfo> imageInfos = {};
+    state.measure([&]() {
+        writes.clear();
+        bufferInfos.clear();
+        imageInfos.clear();
+        writes.reserve(bindings.size());
+        bufferInfos.reserve(bindings.size());
+        imageInfos.reserve(bindings.size());
+
+        Descriptor::build_descriptor_writes(bindings, writes, bufferInfos, imageInfos);
+        do_not_optimize(writes.data());
+    });
+}
+NIJI_BENCHMARK("descriptor/push_descriptor_writes", descriptor_push_writes);
+
+// The same bindings filled the way a pass feeds an update template, what's left of the CPU work
+// per push once the driver reads the descriptors straight from DescriptorUpdateData
+static void descriptor_update_template_data(BenchState& state)
+{
+    static Buffer buffers[4] = {};
+    static Texture textures[3] = {};
+    state.set_items_per_iteration(8);
+
+    state.measure([&]() {
+        DescriptorUpdateData data = {};
+        data.set_buffer(0, buffers[0]);
+        data.set_buffer(1, buffers[1]);
+        data.set_buffer(2, buffers[2]);
+        data.set_buffer(3, buffers[3]);
+        data.set_texture(4, textures[0]);
+        data.set_texture(5, textures[1]);
+        data.set_buffer(6, buffers[0]);
+        data.set_buffer(7, buffers[1]);
+        do_not_optimize(data);
+    });
+}
+NIJI_BENCHMARK("descriptor/update_template_data", descriptor_update_template_data);
+
+// Per draw in the forward pass: set 1 has 18 bindings, a new material pushes its sampler (3) and
+// textures (5..9) again. Both benchmarks time one such draw's CPU side, without the driver's push.
+using BindType = DescriptorBinding::BindType;
+static const BindType FORWARD_PASS_BINDINGS[] = {
+    BindType::UBO,     BindType::STORAGE_BUFFER,  BindType::STORAGE_BUFFER, BindType::SAMPLER,
+    BindType::SAMPLER, BindType::TEXTURE,         BindType::TEXTURE,        BindType::TEXTURE,
+    BindType::TEXTURE, BindType::TEXTURE,         BindType::TEXTURE,        BindType::TEXTURE,
+    BindType::TEXTURE, BindType::UBO,             BindType::STORAGE_TEXTURE,
+    BindType::STORAGE_BUFFER, BindType::SAMPLER,  BindType::STORAGE_BUFFER};
+constexpr uint32_t FORWARD_BENCH_MATERIALS = 64;
+
+// Before update templates: every resource of the copied bindings set again, all 18 writes built
+// and then all but the material ones dropped
+static void descriptor_forward_draw_writes(BenchState& state)
+{
+    static Buffer buffers[6] = {};
+    static Sampler samplers[2 + FORWARD_BENCH_MATERIALS] = {};
+    static Texture textures[4 + 5 * FORWARD_BENCH_MATERIALS] = {};
+
+    std::vector<DescriptorBinding> bindings(std::size(FORWARD_PASS_BINDINGS));
+    for (size_t i = 0; i < bindings.size(); i++)
+    {
+        bindings[i].Type = FORWARD_PASS_BINDINGS[i];
+        bindings[i].Count = 1;
+        bindings[i].Stage = DescriptorBinding::BindStage::ALL_GRAPHICS;
+    }
+    state.set_items_per_iteration(1);
+
+    // Kept across draws, the old path allocated fresh vectors for every push on top of this
+    FrameVector<VkWriteDescriptorSet> writes = {};
+    FrameVector<VkDescriptorBufferInfo> bufferInfos = {};
+    FrameVector<VkDescriptorImageInfo> imageInfos = {};
+    uint32_t material = 0;
+    state.measure([&]() {
+        material = (material + 1) % FORWARD_BENCH_MATERIALS;
+
+        bindings[0].Resource = &buffers[0];
+        bindings[1].Resource = &buffers[1];
+        bindings[2].Resource = &buffers[2];
+        bindings[3].Resource = &samplers[2 + material];
+        bindings[4].Resource = &samplers[0];
+        for (uint32_t i = 0; i < 5; ++i)
+            bindings[5 + i].Resource = &textures[4 + material * 5 + i];
+        for (uint32_t i = 0; i < 3; ++i)
+            bindings[10 + i].Resource = &textures[i];
+        bindings[13].Resource = &buffers[3];
+        bindings[14].Resource = &textures[3];
+        bindings[15].Resource = &buffers[4];
+        bindings[16].Resource = &samplers[1];
+        bindings[17].Resource = &buffers[5];
+
+        writes.clear();
+        bufferInfos.clear();
+        imageInfos.clear();
+        writes.reserve(bindings.size());
+        bufferInfos.reserve(bindings.size());
+        imageInfos.reserve(bindings.size());
+
+        Descriptor::build_descriptor_writes(bindings, writes, bufferInfos, imageInfos);
+        writes.erase(std::remove_if(writes.begin(), writes.end(),
+                                    [](const VkWriteDescriptorSet& write) {
+                                        return write.dstBinding != 3 &&
+                                               (write.dstBinding < 5 || write.dstBinding > 9);
+                                    }),
+                     writes.end());
+        do_not_optimize(writes.data());
+    });
+}
+NIJI_BENCHMARK("descriptor/forward_draw_writes", descriptor_forward_draw_writes);
+
+// With update templates: the material's sampler and textures go into the pass' plain data
+static void descriptor_forward_draw_template(BenchState& state)
+{
+    static Sampler samplers[FORWARD_BENCH_MATERIALS] = {};
+    static Texture textures[5 * FORWARD_BENCH_MATERIALS] = {};
+    state.set_items_per_iteration(1);
+
+    DescriptorUpdateData passData = {};
+    uint32_t material = 0;
+    state.measure([&]() {
+        material = (material + 1) % FORWARD_BENCH_MATERIALS;
+
+        passData.set_sampler(3, samplers[material]);
+        for (uint32_t i = 0; i < 5; ++i)
+            passData.set_texture(5 + i, textures[material * 5 + i]);
+        do_not_optimize(passData);
+    });
+}
+NIJI_BENCHMARK("descriptor/forward_draw_template", descriptor_forward_draw_template);
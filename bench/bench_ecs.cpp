@@ -0,0 +1,116 @@
+#include "bench.hpp"
+
+#include "core/components/render-components.hpp"
+#include "core/components/transform.hpp"
+#include "core/ecs.hpp"
+
+#include "../src/app/animation_systems.hpp"
+#include "../src/app/camera_system.hpp"
+
+#include <vector>
+
+using namespace niji;
+using namespace niji::bench;
+
+// Checks of the system scheduler, the waves get built without any system updating
+
+namespace
+{
+
+// Declares whatever the check hands it, updates on the job threads
+class AccessSystem : public System
+{
+  public:
+    template <typename... T>
+    void declare_reads()
+    {
+        reads<T...>();
+        update_on_job_threads();
+    }
+    template <typename... T>
+    void declare_writes()
+    {
+        writes<T...>();
+        update_on_job_threads();
+    }
+};
+
+size_t find_wave(const std::vector<std::vector<System*>>& waves, const System* system)
+{
+    for (size_t i = 0; i < waves.size(); i++)
+    {
+        for (const System* waveSystem : waves[i])
+        {
+            if (waveSystem == system)
+                return i;
+        }
+    }
+    fail_check("system missing from the schedule", __FILE__, __LINE__);
+    return waves.size();
+}
+
+} // namespace
+
+// Readers share a wave, a writer lands after every earlier system touching the same type and
+// undeclared systems get a wave to themselves
+static void check_ecs_schedule_waves()
+{
+    AccessSystem writeTransform, writeLight, readTransformA, readTransformB, writeTransformAgain,
+        readLight, writeCamera;
+    System undeclared;
+    writeTransform.declare_writes<Transform>();
+    writeLight.declare_writes<PointLight>();
+    readTransformA.declare_reads<Transform>();
+    readTransformB.declare_reads<Transform>();
+    writeTransformAgain.declare_writes<Transform>();
+    readLight.declare_reads<PointLight>();
+    writeCamera.declare_writes<Camera>();
+
+    const std::vector<std::vector<System*>> waves = ECS::build_waves(
+        {&writeTransform, &writeLight, &readTransformA, &readTransformB, &writeTransformAgain,
+         &readLight, &undeclared, &writeCamera});
+
+    // Nothing in common
+    NIJI_REQUIRE(find_wave(waves, &writeTransform) == 0);
+    NIJI_REQUIRE(find_wave(waves, &writeLight) == 0);
+
+    // Reading what an earlier one writes, but not conflicting with each other
+    NIJI_REQUIRE(find_wave(waves, &readTransformA) == 1);
+    NIJI_REQUIRE(find_wave(waves, &readTransformB) == 1);
+    NIJI_REQUIRE(find_wave(waves, &readLight) == 1);
+
+    // Conflicting systems keep their registration order
+    NIJI_REQUIRE(find_wave(waves, &writeTransformAgain) == 2);
+
+    // Undeclared, alone and after everything registered before it
+    const size_t undeclaredWave = find_wave(waves, &undeclared);
+    NIJI_REQUIRE(undeclaredWave == 3);
+    NIJI_REQUIRE(waves[undeclaredWave].size() == 1);
+    NIJI_REQUIRE(find_wave(waves, &writeCamera) == 4);
+}
+NIJI_CHECK("ecs/schedule_waves", check_ecs_schedule_waves);
+
+// The app's own systems: the camera and both animation systems share the wave after the (undeclared)
+// App, only the camera stays on the main thread
+static void check_ecs_app_systems()
+{
+    const std::vector<LightSet> lightSets = {};
+    const StressTestInstances stressTest = {};
+
+    System app;
+    CameraSystem camera;
+    LightAnimationSystem lights(lightSets);
+    StressTestMotionSystem stressTestMotion(stressTest);
+
+    const std::vector<std::vector<System*>> waves =
+        ECS::build_waves({&app, &camera, &lights, &stressTestMotion});
+
+    NIJI_REQUIRE(waves.size() == 2);
+    NIJI_REQUIRE(waves[0].size() == 1 && waves[0][0] == &app);
+    NIJI_REQUIRE(waves[1].size() == 3);
+
+    NIJI_REQUIRE(camera.get_access().MainThread);
+    NIJI_REQUIRE(!lights.get_access().MainThread);
+    NIJI_REQUIRE(!stressTestMotion.get_access().MainThread);
+}
+NIJI_CHECK("ecs/app_systems", check_ecs_app_systems);
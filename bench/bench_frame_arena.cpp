@@ -0,0 +1,53 @@
+#include "bench.hpp"
+
+#include "core/frame_arena.hpp"
+
+#include <glm/glm.hpp>
+
+using namespace niji;
+using namespace niji::bench;
+
+// Shaped like the per-frame light list in ForwardPass::update_impl
+struct BenchLight
+{
+    glm::vec3 Position = {};
+    float Range = 0.0f;
+    glm::vec4 Color = {};
+};
+
+constexpr uint32_t BENCH_FRAME_LIGHTS = 1024;
+
+template <typename Vector>
+static void fill_lights(Vector& lights)
+{
+    for (uint32_t i = 0; i < BENCH_FRAME_LIGHTS; i++)
+    {
+        BenchLight light = {};
+        light.Range = static_cast<float>(i);
+        lights.push_back(light);
+    }
+}
+
+static void frame_temporaries_heap(BenchState& state)
+{
+    state.set_items_per_iteration(BENCH_FRAME_LIGHTS);
+    state.measure([&]() {
+        std::vector<BenchLight> lights = {};
+        fill_lights(lights);
+        do_not_optimize(lights.data());
+    });
+}
+NIJI_BENCHMARK("frame_arena/temporaries_heap", frame_temporaries_heap);
+
+// Same growth pattern, each iteration is a frame that resets the arena first
+static void frame_temporaries_arena(BenchState& state)
+{
+    state.set_items_per_iteration(BENCH_FRAME_LIGHTS);
+    state.measure([&]() {
+        get_frame_arena().reset();
+        FrameVector<BenchLight> lights = {};
+        fill_lights(lights);
+        do_not_optimize(lights.data());
+    });
+}
+NIJI_BENCHMARK("frame_arena/temporaries_arena", frame_temporaries_arena);
@@ -0,0 +1,265 @@
+#include "bench.hpp"
+
+#include "core/job_system.hpp"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace niji;
+using namespace niji::bench;
+
+// The benchmarks only time, the jobs/ checks below verify the results under contention
+
+constexpr uint32_t BENCH_JOB_COUNT = 1024;
+constexpr uint32_t BENCH_RANGE_SIZE = 1 << 20;
+constexpr uint32_t BENCH_CHAIN_LENGTH = 64;
+
+// Scheduling overhead, the jobs themselves do next to nothing
+static void jobs_empty(BenchState& state)
+{
+    JobSystem jobs = {};
+    jobs.init();
+
+    std::atomic<uint32_t> ran{0};
+    state.set_items_per_iteration(BENCH_JOB_COUNT);
+    state.measure([&]() {
+        ran.store(0, std::memory_order_relaxed);
+        JobCounter counter = {};
+        for (uint32_t i = 0; i < BENCH_JOB_COUNT; i++)
+            jobs.run([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); }, &counter);
+        jobs.wait(counter);
+        do_not_optimize(ran);
+    });
+}
+NIJI_BENCHMARK("jobs/empty", jobs_empty);
+
+static void jobs_parallel_for(BenchState& state)
+{
+    JobSystem jobs = {};
+    jobs.init();
+
+    std::vector<uint32_t> values(BENCH_RANGE_SIZE);
+    for (uint32_t i = 0; i < BENCH_RANGE_SIZE; i++)
+        values[i] = i * 2654435761u;
+
+    state.set_items_per_iteration(BENCH_RANGE_SIZE);
+    state.measure([&]() {
+        std::atomic<uint64_t> sum{0};
+        jobs.parallel_for(BENCH_RANGE_SIZE, 4096, [&](uint32_t begin, uint32_t end) {
+            uint64_t partial = 0;
+            for (uint32_t i = begin; i < end; i++)
+                partial += values[i] >> 16;
+            sum.fetch_add(partial, std::memory_order_relaxed);
+        });
+        do_not_optimize(sum);
+    });
+}
+NIJI_BENCHMARK("jobs/parallel_for", jobs_parallel_for);
+
+// Every link of the chain waits on the previous one, all of them get queued up front
+static void jobs_continuations(BenchState& state)
+{
+    JobSystem jobs = {};
+    jobs.init();
+
+    state.set_items_per_iteration(BENCH_CHAIN_LENGTH);
+    state.measure([&]() {
+        std::atomic<uint32_t> step{0};
+        JobCounter links[BENCH_CHAIN_LENGTH] = {};
+
+        jobs.run([&step]() { step.fetch_add(1); }, &links[0]);
+        for (uint32_t i = 1; i < BENCH_CHAIN_LENGTH; i++)
+            jobs.run_after(links[i - 1], [&step]() { step.fetch_add(1); }, &links[i]);
+        jobs.wait(links[BENCH_CHAIN_LENGTH - 1]);
+        do_not_optimize(step);
+    });
+}
+NIJI_BENCHMARK("jobs/continuations", jobs_continuations);
+
+// Checks. Every one of them repeats enough rounds for the workers to actually fight over the jobs.
+
+constexpr uint32_t CHECK_ROUNDS = 200;
+// Fixed, so there is contention even on machines with few cores
+constexpr uint32_t CHECK_THREADS = 8;
+constexpr uint32_t CHECK_SUBMIT_THREADS = 4;
+
+// Every job runs exactly once, whether it got popped, stolen or came through the shared queue
+static void check_jobs_run_once()
+{
+    JobSystem jobs = {};
+    jobs.init(CHECK_THREADS);
+
+    std::vector<std::atomic<uint32_t>> runs(BENCH_JOB_COUNT);
+    for (uint32_t round = 0; round < CHECK_ROUNDS; round++)
+    {
+        for (auto& run : runs)
+            run.store(0, std::memory_order_relaxed);
+
+        JobCounter counter = {};
+        for (uint32_t i = 0; i < BENCH_JOB_COUNT; i++)
+            jobs.run([&runs, i]() { runs[i].fetch_add(1, std::memory_order_relaxed); }, &counter);
+        jobs.wait(counter);
+
+        NIJI_REQUIRE(counter.is_done());
+        for (const auto& run : runs)
+            NIJI_REQUIRE(run.load() == 1);
+    }
+}
+NIJI_CHECK("jobs/run_once", check_jobs_run_once);
+
+// Threads outside the system submitting and waiting at the same time as the workers, with jobs
+// that queue (and wait on) jobs of their own
+static void check_jobs_foreign_threads()
+{
+    JobSystem jobs = {};
+    jobs.init(CHECK_THREADS);
+
+    constexpr uint32_t jobsPerThread = 256;
+    constexpr uint32_t childrenPerJob = 4;
+
+    std::vector<std::atomic<uint32_t>> done(CHECK_SUBMIT_THREADS);
+    std::vector<std::thread> threads = {};
+    for (uint32_t thread = 0; thread < CHECK_SUBMIT_THREADS; thread++)
+    {
+        threads.emplace_back([&jobs, &done, thread]() {
+            for (uint32_t round = 0; round < CHECK_ROUNDS / 10; round++)
+            {
+                std::atomic<uint32_t> ran{0};
+                JobCounter counter = {};
+                for (uint32_t i = 0; i < jobsPerThread; i++)
+                {
+                    jobs.run(
+                        [&jobs, &ran]() {
+                            JobCounter children = {};
+                            for (uint32_t child = 0; child < childrenPerJob; child++)
+                                jobs.run([&ran]() { ran.fetch_add(1); }, &children);
+                            jobs.wait(children);
+                            ran.fetch_add(1);
+                        },
+                        &counter);
+                }
+                jobs.wait(counter);
+
+                if (ran.load() == jobsPerThread * (childrenPerJob + 1))
+                    done[thread].fetch_add(1);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (const auto& rounds : done)
+        NIJI_REQUIRE(rounds.load() == CHECK_ROUNDS / 10);
+}
+NIJI_CHECK("jobs/foreign_threads", check_jobs_foreign_threads);
+
+// Every index exactly once, including counts that don't split evenly and ones below a batch
+static void check_jobs_parallel_for()
+{
+    JobSystem jobs = {};
+    jobs.init(CHECK_THREADS);
+
+    const uint32_t counts[] = {0, 1, 7, 4095, 4096, 4097, 100003, BENCH_RANGE_SIZE};
+    for (uint32_t count : counts)
+    {
+        std::unique_ptr<std::atomic<uint8_t>[]> visits(new std::atomic<uint8_t>[count + 1]);
+        for (uint32_t i = 0; i < count; i++)
+            visits[i].store(0, std::memory_order_relaxed);
+
+        jobs.parallel_for(count, 1024, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++)
+                visits[i].fetch_add(1, std::memory_order_relaxed);
+        });
+
+        for (uint32_t i = 0; i < count; i++)
+            NIJI_REQUIRE(visits[i].load() == 1);
+    }
+}
+NIJI_CHECK("jobs/parallel_for", check_jobs_parallel_for);
+
+// A link never starts before the one it depends on finished
+static void check_jobs_continuations()
+{
+    JobSystem jobs = {};
+    jobs.init(CHECK_THREADS);
+
+    for (uint32_t round = 0; round < CHECK_ROUNDS; round++)
+    {
+        std::atomic<uint32_t> step{0};
+        std::atomic<bool> outOfOrder{false};
+        JobCounter links[BENCH_CHAIN_LENGTH] = {};
+
+        jobs.run([&step]() { step.fetch_add(1); }, &links[0]);
+        for (uint32_t i = 1; i < BENCH_CHAIN_LENGTH; i++)
+            jobs.run_after(
+                links[i - 1],
+                [&step, &outOfOrder, i]() {
+                    if (step.load() != i)
+                        outOfOrder = true;
+                    step.fetch_add(1);
+                },
+                &links[i]);
+        jobs.wait(links[BENCH_CHAIN_LENGTH - 1]);
+
+        NIJI_REQUIRE(!outOfOrder.load());
+        NIJI_REQUIRE(step.load() == BENCH_CHAIN_LENGTH);
+    }
+}
+NIJI_CHECK("jobs/continuations", check_jobs_continuations);
+
+// An exception only comes out of the wait() on its own counter, and only once
+static void check_jobs_errors()
+{
+    JobSystem jobs = {};
+    jobs.init(CHECK_THREADS);
+
+    for (uint32_t round = 0; round < CHECK_ROUNDS; round++)
+    {
+        JobCounter failing = {};
+        JobCounter healthy = {};
+        std::atomic<uint32_t> ran{0};
+        for (uint32_t i = 0; i < 64; i++)
+        {
+            jobs.run(
+                [i]() {
+                    if (i == 17)
+                        throw std::runtime_error("job 17");
+                },
+                &failing);
+            jobs.run([&ran]() { ran.fetch_add(1); }, &healthy);
+        }
+
+        // The failing jobs ran interleaved with these, their exception must not leak in here
+        jobs.wait(healthy);
+        NIJI_REQUIRE(ran.load() == 64);
+
+        bool threw = false;
+        try
+        {
+            jobs.wait(failing);
+        }
+        catch (const std::runtime_error& error)
+        {
+            threw = std::string(error.what()) == "job 17";
+        }
+        NIJI_REQUIRE(threw);
+
+        // Handed out once
+        jobs.wait(failing);
+    }
+
+    // The job's counter still reaches 0 with continuations queued behind it
+    JobCounter failing = {};
+    JobCounter after = {};
+    std::atomic<bool> continued{false};
+    jobs.run([]() { throw std::runtime_error("dependency"); }, &failing);
+    jobs.run_after(failing, [&continued]() { continued = true; }, &after);
+    jobs.wait(after);
+    NIJI_REQUIRE(continued.load());
+    NIJI_REQUIRE_THROWS(jobs.wait(failing));
+}
+NIJI_CHECK("jobs/errors", check_jobs_errors);
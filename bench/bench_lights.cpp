@@ -0,0 +1,147 @@
+#include "bench.hpp"
+
+#include <filesystem>
+#include <random>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "engine.hpp"
+#include "../src/app/app.hpp"
+
+#include "light_culling_cpu.hpp"
+
+using namespace niji;
+using namespace niji::bench;
+
+constexpr uint32_t BENCH_LIGHT_COUNT = 1000;
+constexpr uint32_t BENCH_SCREEN_WIDTH = 1920;
+constexpr uint32_t BENCH_SCREEN_HEIGHT = 1080;
+
+// A light file with BENCH_LIGHT_COUNT point lights, written through App so it matches the format
+static std::filesystem::path create_light_file(std::vector<LightSet>& sets)
+{
+    std::mt19937 rng(BENCH_LIGHT_COUNT);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    LightSet set;
+    set.Name = "Bench";
+    for (uint32_t i = 0; i < BENCH_LIGHT_COUNT; i++)
+    {
+        auto ent = nijiEngine.ecs.create_entity();
+        nijiEngine.ecs.add_component<PointLight>(
+            ent, glm::vec3(unit(rng), unit(rng), unit(rng)) * 10.0f,
+            glm::vec3(unit(rng), unit(rng), unit(rng)), 1.0f, 1.5f);
+        set.PointLights.push_back(ent);
+    }
+    sets.push_back(std::move(set));
+
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "niji_bench_lights.json";
+    App::save_light_sets(path.string(), sets);
+    return path;
+}
+
+static void destroy_light_sets(std::vector<LightSet>& sets)
+{
+    for (const LightSet& set : sets)
+        for (Entity ent : set.PointLights)
+            nijiEngine.ecs.m_registry.destroy(ent);
+    sets.clear();
+
+    auto dirLights = nijiEngine.ecs.m_registry.view<DirectionalLight>();
+    nijiEngine.ecs.m_registry.destroy(dirLights.begin(), dirLights.end());
+}
+
+// Parse + entity creation, the created entities get destroyed again inside the timed loop
+static void lights_json_load(BenchState& state)
+{
+    std::vector<LightSet> sets = {};
+    const std::filesystem::path path = create_light_file(sets);
+    destroy_light_sets(sets);
+    state.set_items_per_iteration(BENCH_LIGHT_COUNT);
+
+    state.measure([&]() {
+        App::load_light_sets(path.string(), sets);
+        destroy_light_sets(sets);
+    });
+
+    std::filesystem::remove(path);
+}
+NIJI_BENCHMARK("lights/json_load_1k", lights_json_load);
+
+static void lights_json_save(BenchState& state)
+{
+    std::vector<LightSet> sets = {};
+    const std::filesystem::path path = create_light_file(sets);
+    state.set_items_per_iteration(BENCH_LIGHT_COUNT);
+
+    state.measure([&]() { App::save_light_sets(path.string(), sets); });
+
+    destroy_light_sets(sets);
+    std::filesystem::remove(path);
+}
+NIJI_BENCHMARK("lights/json_save_1k", lights_json_save);
+
+static TileGrid create_tile_grid()
+{
+    glm::mat4 projection =
+        glm::perspective(glm::radians(60.0f),
+                         static_cast<float>(BENCH_SCREEN_WIDTH) / BENCH_SCREEN_HEIGHT, 0.1f, 100.0f);
+    projection[1][1] *= -1;
+
+    TileGrid grid = {};
+    grid.InverseProjection = glm::inverse(projection);
+    grid.ScreenDimensions = glm::vec2(BENCH_SCREEN_WIDTH, BENCH_SCREEN_HEIGHT);
+    grid.Tiles = glm::uvec2((BENCH_SCREEN_WIDTH + GROUP_SIZE - 1) / GROUP_SIZE,
+                            (BENCH_SCREEN_HEIGHT + GROUP_SIZE - 1) / GROUP_SIZE);
+    return grid;
+}
+
+static void culling_grid_frustums(BenchState& state)
+{
+    const TileGrid grid = create_tile_grid();
+    state.set_items_per_iteration(grid.Tiles.x * grid.Tiles.y);
+
+    std::vector<Frustum> frustums = {};
+    state.measure([&]() {
+        compute_grid_frustums(grid, frustums);
+        do_not_optimize(frustums.data());
+    });
+}
+NIJI_BENCHMARK("culling/grid_frustums_1080p", culling_grid_frustums);
+
+// View space lights in front of the camera and a depth range per tile that varies like a scene
+static void culling_lights(BenchState& state)
+{
+    const TileGrid grid = create_tile_grid();
+    std::vector<Frustum> frustums = {};
+    compute_grid_frustums(grid, frustums);
+
+    std::mt19937 rng(BENCH_LIGHT_COUNT);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<Sphere> lights(BENCH_LIGHT_COUNT);
+    for (Sphere& light : lights)
+    {
+        light.Center = glm::vec3((unit(rng) - 0.5f) * 30.0f, (unit(rng) - 0.5f) * 20.0f,
+                                 -unit(rng) * 40.0f);
+        light.Radius = 1.5f;
+    }
+
+    std::vector<glm::vec2> tileDepths(frustums.size());
+    for (glm::vec2& depth : tileDepths)
+    {
+        const float a = unit(rng);
+        const float b = unit(rng);
+        depth = glm::vec2(std::min(a, b), std::max(a, b));
+    }
+    state.set_items_per_iteration(static_cast<uint64_t>(frustums.size()) * lights.size());
+
+    std::vector<glm::uvec2> lightGrid = {};
+    std::vector<uint32_t> lightIndexList = {};
+    state.measure([&]() {
+        cull_lights(grid, frustums, tileDepths, lights, lightGrid, lightIndexList);
+        do_not_optimize(lightIndexList.data());
+    });
+}
+NIJI_BENCHMARK("culling/lights_1k_1080p", culling_lights);
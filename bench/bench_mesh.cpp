@@ -0,0 +1,125 @@
+#include "bench.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+
+#include <fastgltf/core.hpp>
+
+#include "rendering/model/mesh.hpp"
+#include "rendering/model/tangent_space_wrapper.hpp"
+
+using namespace niji;
+using namespace niji::bench;
+
+constexpr const char* BENCH_GLTF_PATH = "assets/Sponza/Sponza.gltf";
+
+// Parsed once and shared, only the accessor conversion is measured
+static const fastgltf::Asset* get_bench_asset()
+{
+    static std::unique_ptr<fastgltf::Asset> asset = []() -> std::unique_ptr<fastgltf::Asset> {
+        fastgltf::Parser parser{};
+        auto data = fastgltf::GltfDataBuffer::FromPath(BENCH_GLTF_PATH);
+        if (data.error() != fastgltf::Error::None)
+            return nullptr;
+
+        auto loaded = parser.loadGltf(data.get(),
+                                      std::filesystem::path(BENCH_GLTF_PATH).parent_path(),
+                                      fastgltf::Options::LoadExternalBuffers);
+        if (loaded.error() != fastgltf::Error::None)
+            return nullptr;
+
+        return std::make_unique<fastgltf::Asset>(std::move(loaded.get()));
+    }();
+
+    if (!asset)
+        printf("[Bench] Couldn't load %s, run from the directory holding assets/\n",
+               BENCH_GLTF_PATH);
+    return asset.get();
+}
+
+// Every primitive of the scene, accessors to Vertex (+ tangent generation where it's missing)
+static void gltf_load_primitives(BenchState& state)
+{
+    const fastgltf::Asset* asset = get_bench_asset();
+    if (!asset)
+        return;
+
+    uint64_t vertexCount = 0;
+    for (const auto& mesh : asset->meshes)
+        for (const auto& primitive : mesh.primitives)
+            vertexCount += Mesh::load_primitive(*asset, primitive).Vertices.size();
+    state.set_items_per_iteration(vertexCount);
+
+    state.measure([&]() {
+        for (const auto& mesh : asset->meshes)
+            for (const auto& primitive : mesh.primitives)
+                do_not_optimize(Mesh::load_primitive(*asset, primitive));
+    });
+}
+NIJI_BENCHMARK("gltf/load_primitives", gltf_load_primitives);
+
+// Vertex to the geometry pool's PackedVertex layout
+static void gltf_pack_vertices(BenchState& state)
+{
+    const fastgltf::Asset* asset = get_bench_asset();
+    if (!asset)
+        return;
+
+    std::vector<std::vector<Vertex>> meshes = {};
+    uint64_t vertexCount = 0;
+    for (const auto& mesh : asset->meshes)
+        for (const auto& primitive : mesh.primitives)
+        {
+            meshes.push_back(Mesh::load_primitive(*asset, primitive).Vertices);
+            vertexCount += meshes.back().size();
+        }
+    state.set_items_per_iteration(vertexCount);
+
+    std::vector<PackedVertex> packed = {};
+    state.measure([&]() {
+        for (const auto& vertices : meshes)
+        {
+            Mesh::pack_vertices(vertices, packed);
+            do_not_optimize(packed.data());
+        }
+    });
+}
+NIJI_BENCHMARK("gltf/pack_vertices", gltf_pack_vertices);
+
+// Synthetic grid, so the tangent generation doesn't depend on what the asset already has
+static void mikktspace_get_tangents(BenchState& state)
+{
+    constexpr uint32_t GRID_SIZE = 128;
+
+    MikkTSpaceTangent::MikktSpaceMesh mesh = {};
+    for (uint32_t y = 0; y <= GRID_SIZE; y++)
+    {
+        for (uint32_t x = 0; x <= GRID_SIZE; x++)
+        {
+            const glm::vec2 uv = glm::vec2(x, y) / static_cast<float>(GRID_SIZE);
+            mesh.m_positions.push_back(glm::vec3(uv.x, std::sin(uv.x * 6.0f) * 0.1f, uv.y));
+            mesh.m_normals.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
+            mesh.m_texcoords.push_back(uv);
+        }
+    }
+    for (uint32_t y = 0; y < GRID_SIZE; y++)
+    {
+        for (uint32_t x = 0; x < GRID_SIZE; x++)
+        {
+            const uint32_t i = y * (GRID_SIZE + 1) + x;
+            mesh.m_indices.insert(mesh.m_indices.end(), {i, i + GRID_SIZE + 1, i + 1});
+            mesh.m_indices.insert(mesh.m_indices.end(),
+                                  {i + 1, i + GRID_SIZE + 1, i + GRID_SIZE + 2});
+        }
+    }
+    state.set_items_per_iteration(mesh.m_positions.size());
+
+    std::vector<glm::vec4> tangents = {};
+    state.measure([&]() {
+        MikkTSpaceTangent::GetTangents(mesh, tangents);
+        do_not_optimize(tangents.data());
+    });
+}
+NIJI_BENCHMARK("mikktspace/get_tangents_grid128", mikktspace_get_tangents);
@@ -0,0 +1,138 @@
+#include "bench.hpp"
+
+#include "engine.hpp"
+#include "core/components/transform.hpp"
+
+#include <glm/gtc/epsilon.hpp>
+
+using namespace niji;
+using namespace niji::bench;
+
+constexpr uint32_t TRANSFORM_CHAIN_DEPTH = 64;
+constexpr uint32_t TRANSFORM_CHAINS = 64;
+
+namespace niji::bench
+{
+
+// What SetParent() did before it got stubbed out in transform.cpp, so the chains below actually
+// walk their parents in World()
+struct TransformHierarchy
+{
+    static void link(Entity child, Entity parent)
+    {
+        auto& registry = nijiEngine.ecs.m_registry;
+        registry.get<Transform>(parent).AddChild(child);
+
+        Transform& transform = registry.get<Transform>(child);
+        transform.m_parent = parent;
+        transform.SetMatrixDirty();
+    }
+};
+
+} // namespace niji::bench
+
+// Every node sits 1 up and 5 degrees around Y from its parent
+static std::vector<std::vector<Entity>> create_chains(uint32_t chainCount)
+{
+    std::vector<std::vector<Entity>> chains(chainCount);
+    for (auto& chain : chains)
+    {
+        Entity parent = entt::null;
+        for (uint32_t depth = 0; depth < TRANSFORM_CHAIN_DEPTH; depth++)
+        {
+            Entity entity = nijiEngine.ecs.create_entity();
+            auto& transform = nijiEngine.ecs.add_component<Transform>(entity);
+            transform.SetTranslation(glm::vec3(0.0f, 1.0f, 0.0f));
+            transform.SetRotation(glm::quat(glm::vec3(0.0f, glm::radians(5.0f), 0.0f)));
+            if (parent != entt::null)
+                TransformHierarchy::link(entity, parent);
+
+            chain.push_back(entity);
+            parent = entity;
+        }
+    }
+    return chains;
+}
+
+static void destroy_chains(const std::vector<std::vector<Entity>>& chains)
+{
+    for (const auto& chain : chains)
+        for (Entity entity : chain)
+            nijiEngine.ecs.m_registry.destroy(entity);
+}
+
+// Root moves, which dirties its whole chain, then every node asks for its world matrix (leaf
+// first, worst case: the leaf's World() recurses up to the root)
+static void transform_world_dirty_chains(BenchState& state)
+{
+    auto chains = create_chains(TRANSFORM_CHAINS);
+    state.set_items_per_iteration(TRANSFORM_CHAINS * TRANSFORM_CHAIN_DEPTH);
+
+    float offset = 0.0f;
+    state.measure([&]() {
+        offset += 0.001f;
+        for (const auto& chain : chains)
+        {
+            nijiEngine.ecs.m_registry.get<Transform>(chain.front())
+                .SetTranslation(glm::vec3(offset, 1.0f, 0.0f));
+            for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+                do_not_optimize(nijiEngine.ecs.m_registry.get<Transform>(*it).World());
+        }
+    });
+
+    destroy_chains(chains);
+}
+NIJI_BENCHMARK("transform/world_dirty_chains", transform_world_dirty_chains);
+
+// Nothing moved, World() only returns the cached matrix
+static void transform_world_clean_chains(BenchState& state)
+{
+    auto chains = create_chains(TRANSFORM_CHAINS);
+    state.set_items_per_iteration(TRANSFORM_CHAINS * TRANSFORM_CHAIN_DEPTH);
+
+    state.measure([&]() {
+        for (const auto& chain : chains)
+            for (Entity entity : chain)
+                do_not_optimize(nijiEngine.ecs.m_registry.get<Transform>(entity).World());
+    });
+
+    destroy_chains(chains);
+}
+NIJI_BENCHMARK("transform/world_clean_chains", transform_world_clean_chains);
+
+// The leaf's world matrix is the product of every local matrix up the chain, and moving the
+// root moves the leaf with it
+static void check_transform_chain_world()
+{
+    auto chains = create_chains(1);
+    const std::vector<Entity>& chain = chains.front();
+    auto& registry = nijiEngine.ecs.m_registry;
+
+    glm::mat4 expected = glm::identity<glm::mat4>();
+    for (Entity entity : chain)
+    {
+        const Transform& transform = registry.get<Transform>(entity);
+        expected = expected * glm::translate(glm::mat4(1.0f), transform.GetTranslation()) *
+                   glm::toMat4(transform.GetRotation());
+    }
+
+    const auto matrices_match = [](const glm::mat4& a, const glm::mat4& b) {
+        for (int column = 0; column < 4; column++)
+        {
+            if (!glm::all(glm::epsilonEqual(a[column], b[column], 1e-3f)))
+                return false;
+        }
+        return true;
+    };
+
+    Transform& leaf = registry.get<Transform>(chain.back());
+    NIJI_REQUIRE(leaf.HasParent());
+    NIJI_REQUIRE(matrices_match(leaf.World(), expected));
+
+    registry.get<Transform>(chain.front()).SetTranslation(glm::vec3(10.0f, 1.0f, 0.0f));
+    expected = glm::translate(glm::mat4(1.0f), glm::vec3(10.0f, 0.0f, 0.0f)) * expected;
+    NIJI_REQUIRE(matrices_match(leaf.World(), expected));
+
+    destroy_chains(chains);
+}
+NIJI_CHECK("transform/chain_world", check_transform_chain_world);
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "rendering/passes/light_culling.hpp"
+#include "rendering/renderer.hpp"
+
+// CPU port of grid_frustums_cs.slang and light_culling_cs.slang, kept line for line with the
+// shaders so changes to the math can be measured (and checked) without a GPU.
+namespace niji::bench
+{
+
+// Shader side MAX_LIGHTS_PER_TILE (light_culling_cs.slang)
+constexpr uint32_t CPU_MAX_LIGHTS_PER_TILE = 256;
+
+struct TileGrid
+{
+    glm::mat4 InverseProjection = {};
+    glm::vec2 ScreenDimensions = {};
+    glm::uvec2 Tiles = {};
+};
+
+inline glm::vec4 clip_to_view(const TileGrid& grid, const glm::vec4& clip)
+{
+    glm::vec4 view = grid.InverseProjection * clip;
+    return view / view.w;
+}
+
+inline glm::vec4 screen_to_view(const TileGrid& grid, const glm::vec4& screen)
+{
+    const glm::vec2 texCoord = glm::vec2(screen) / grid.ScreenDimensions;
+    const glm::vec4 clip =
+        glm::vec4(glm::vec2(texCoord.x, 1.0f - texCoord.y) * 2.0f - 1.0f, screen.z, screen.w);
+    return clip_to_view(grid, clip);
+}
+
+inline Plane compute_plane(const glm::vec3& point0, const glm::vec3& point1,
+                           const glm::vec3& point2)
+{
+    Plane plane = {};
+    plane.Normal = glm::normalize(glm::cross(point1 - point0, point2 - point0));
+    plane.Distance = glm::dot(plane.Normal, point0);
+    return plane;
+}
+
+// grid_frustums_cs.slang, one frustum per tile
+inline void compute_grid_frustums(const TileGrid& grid, std::vector<Frustum>& frustums)
+{
+    frustums.resize(grid.Tiles.x * grid.Tiles.y);
+
+    const glm::vec3 eyePos = glm::vec3(0.0f);
+    for (uint32_t y = 0; y < grid.Tiles.y; y++)
+    {
+        for (uint32_t x = 0; x < grid.Tiles.x; x++)
+        {
+            const glm::vec4 screenSpace[4] = {
+                glm::vec4(glm::vec2(x, y) * float(GROUP_SIZE), -1.0f, 1.0f),
+                glm::vec4(glm::vec2(x + 1, y) * float(GROUP_SIZE), -1.0f, 1.0f),
+                glm::vec4(glm::vec2(x, y + 1) * float(GROUP_SIZE), -1.0f, 1.0f),
+                glm::vec4(glm::vec2(x + 1, y + 1) * float(GROUP_SIZE), -1.0f, 1.0f)};
+
+            glm::vec3 viewSpace[4] = {};
+            for (int i = 0; i < 4; i++)
+                viewSpace[i] = glm::vec3(screen_to_view(grid, screenSpace[i]));
+
+            Frustum& frustum = frustums[x + y * grid.Tiles.x];
+            frustum.Planes[0] = compute_plane(eyePos, viewSpace[2], viewSpace[0]);
+            frustum.Planes[1] = compute_plane(eyePos, viewSpace[1], viewSpace[3]);
+            frustum.Planes[2] = compute_plane(eyePos, viewSpace[0], viewSpace[1]);
+            frustum.Planes[3] = compute_plane(eyePos, viewSpace[3], viewSpace[2]);
+        }
+    }
+}
+
+inline bool sphere_inside_plane(const Sphere& sphere, const Plane& plane)
+{
+    return glm::dot(plane.Normal, sphere.Center) - plane.Distance < -sphere.Radius;
+}
+
+inline bool sphere_inside_frustum(const Sphere& sphere, const Frustum& frustum, float zNear,
+                                  float zFar)
+{
+    if (sphere.Center.z - sphere.Radius > zNear || sphere.Center.z + sphere.Radius < zFar)
+        return false;
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (sphere_inside_plane(sphere, frustum.Planes[i]))
+            return false;
+    }
+    return true;
+}
+
+// light_culling_cs.slang for every tile, with the tile's depth bounds taken from `tileDepths`
+// (min, max in [0, 1]). Writes the light grid (offset, count) and the compacted index list.
+inline void cull_lights(const TileGrid& grid, const std::vector<Frustum>& frustums,
+                        const std::vector<glm::vec2>& tileDepths,
+                        const std::vector<Sphere>& lights, std::vector<glm::uvec2>& lightGrid,
+                        std::vector<uint32_t>& lightIndexList)
+{
+    const uint32_t tileCount = grid.Tiles.x * grid.Tiles.y;
+    lightGrid.resize(tileCount);
+    lightIndexList.clear();
+
+    const float nearClipVS = screen_to_view(grid, glm::vec4(0, 0, 0, 1)).z;
+    for (uint32_t tile = 0; tile < tileCount; tile++)
+    {
+        const float minDepthVS = screen_to_view(grid, glm::vec4(0, 0, tileDepths[tile].x, 1)).z;
+        const float maxDepthVS = screen_to_view(grid, glm::vec4(0, 0, tileDepths[tile].y, 1)).z;
+        const Plane minPlane = {glm::vec3(0, 0, -1), -minDepthVS};
+
+        const uint32_t offset = static_cast<uint32_t>(lightIndexList.size());
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < lights.size(); i++)
+        {
+            if (sphere_inside_frustum(lights[i], frustums[tile], nearClipVS, maxDepthVS) &&
+                !sphere_inside_plane(lights[i], minPlane))
+            {
+                if (count < CPU_MAX_LIGHTS_PER_TILE)
+                    lightIndexList.push_back(i);
+                count++;
+            }
+        }
+
+        lightGrid[tile] = glm::uvec2(offset, std::min(count, CPU_MAX_LIGHTS_PER_TILE));
+    }
+}
+
+} // namespace niji::bench
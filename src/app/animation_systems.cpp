@@ -0,0 +1,69 @@
+#include "animation_systems.hpp"
+
+#include "../engine/core/components/render-components.hpp"
+#include "../engine/core/components/transform.hpp"
+#include "../engine/engine.hpp"
+
+LightAnimationSystem::LightAnimationSystem(const std::vector<LightSet>& lightSets)
+    : m_lightSets(lightSets), m_startTime(std::chrono::high_resolution_clock::now())
+{
+    writes<niji::PointLight>();
+    update_on_job_threads();
+}
+
+void LightAnimationSystem::update(float deltaTime)
+{
+    NIJI_PROFILE_FUNCTION();
+
+    const float time = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() -
+                                                    m_startTime)
+                           .count();
+
+    for (const LightSet& set : m_lightSets)
+    {
+        if (!set.Animate)
+            continue;
+
+        for (size_t i = 0; i < set.PointLights.size(); ++i)
+        {
+            auto ent = set.PointLights[i];
+            if (!nijiEngine.ecs.m_registry.valid(ent))
+                continue;
+
+            auto& light = nijiEngine.ecs.m_registry.get<niji::PointLight>(ent);
+            float angle = time * set.Speed + (i * glm::two_pi<float>() / set.PointLights.size());
+
+            light.Position.x = set.Center.x + set.RadiusX * std::cos(angle);
+            light.Position.z = set.Center.y + set.RadiusZ * std::sin(angle);
+            light.Position.y = set.YPos;
+        }
+    }
+}
+
+StressTestMotionSystem::StressTestMotionSystem(const StressTestInstances& stressTest)
+    : m_stressTest(stressTest)
+{
+    writes<niji::Transform>();
+    update_on_job_threads();
+}
+
+void StressTestMotionSystem::update(float deltaTime)
+{
+    if (m_stressTest.MoveEvery == 0)
+        return;
+
+    NIJI_PROFILE_FUNCTION();
+
+    m_time += deltaTime;
+
+    // Phase per instance, so the moving ones don't all sit at the same height
+    const std::vector<StressTestInstances::Instance>& instances = m_stressTest.Instances;
+    for (size_t i = 0; i < instances.size(); i += m_stressTest.MoveEvery)
+    {
+        const StressTestInstances::Instance& instance = instances[i];
+        auto& trans = nijiEngine.ecs.get_component<niji::Transform>(instance.Entity);
+        const float offset = std::sin(m_time * 2.0f + static_cast<float>(i) * 0.1f);
+        trans.SetTranslation(instance.Base + glm::vec3(0.0f, offset * 0.25f, 0.0f));
+        nijiEngine.ecs.mark_moved(instance.Entity);
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+
+#include "app.hpp"
+
+// Both only write their own component type and read state the App edits, which has its own wave.
+// So they update on the job threads, next to each other and the CameraSystem.
+
+// Orbits the point lights of every animated light set
+class LightAnimationSystem : public niji::System
+{
+  public:
+    explicit LightAnimationSystem(const std::vector<LightSet>& lightSets);
+
+    void update(float deltaTime) override;
+
+  private:
+    const std::vector<LightSet>& m_lightSets;
+    std::chrono::high_resolution_clock::time_point m_startTime = {};
+};
+
+// Bobs every n-th stress test instance up and down
+class StressTestMotionSystem : public niji::System
+{
+  public:
+    explicit StressTestMotionSystem(const StressTestInstances& stressTest);
+
+    void update(float deltaTime) override;
+
+  private:
+    const StressTestInstances& m_stressTest;
+    float m_time = 0.0f;
+};
@@ -12,13 +12,22 @@
 #include "../engine/core/envmap.hpp"
 #include "../engine/engine.hpp"
 
+#include "benchmark.hpp"
 #include "camera_system.hpp"
 
 using json = nlohmann::json;
 
+constexpr uint32_t STRESS_TEST_INSTANCE_COUNT = 100000;
+// Every n-th stress test instance bobs up and down once moving is turned on
+constexpr uint32_t STRESS_TEST_MOVE_EVERY = 16;
+// Generated point lights are scattered inside this box (roughly Sponza's interior at 0.01 scale)
+constexpr glm::vec3 GENERATED_LIGHTS_MIN = glm::vec3(-12.0f, 0.2f, -5.0f);
+constexpr glm::vec3 GENERATED_LIGHTS_MAX = glm::vec3(12.0f, 11.0f, 5.0f);
+
 static glm::vec3 get_rand_color()
 {
-    static std::mt19937 rng(std::random_device{}());
+    // Fixed seed headless, so runs can be compared frame for frame
+    static std::mt19937 rng(nijiEngine.m_context.is_headless() ? 0u : std::random_device{}());
     static std::uniform_real_distribution<float> dist(0.0f, 1.0f);
 
     return glm::vec3(dist(rng), dist(rng), dist(rng));
@@ -34,11 +43,30 @@ App::App()
     t.SetScale({0.01f, 0.01f, 0.01f});
     t.SetRotation(glm::quat(glm::vec3(glm::radians(0.0f), glm::radians(0.0f), glm::radians(0.0f))));
 
-    load_lights("assets/lights.json");
+    std::string scene = "assets/Sponza/Sponza.gltf";
+    uint32_t stressInstances = 0;
+    auto benchmarks = nijiEngine.ecs.find_systems<BenchmarkSystem>();
+    if (!benchmarks.empty())
+    {
+        const BenchmarkScenario& scenario = benchmarks[0]->get_scenario();
+        scene = scenario.Scene;
+        m_benchmarking = true;
+
+        const bool generateLights = scenario.PointLightCount >= 0;
+        load_lights(scenario.Lights, !generateLights);
+        if (generateLights)
+            generate_point_lights(static_cast<uint32_t>(scenario.PointLightCount),
+                                  scenario.PointLightRange);
+
+        stressInstances = scenario.StressInstances;
+        m_stressTest.MoveEvery = scenario.MoveStressInstances;
+    }
+    else
+        load_lights("assets/lights.json");
 
     // m_models.emplace_back(std::make_shared<niji::Model>("assets/DamagedHelmet/DamagedHelmet.glb",
     // entity));
-    m_models.emplace_back(std::make_shared<niji::Model>("assets/Sponza/Sponza.gltf", entity));
+    m_models.emplace_back(std::make_shared<niji::Model>(scene, entity));
 
     m_envmap = niji::Envmap("assets/environments/footprint_court");
     renderer.set_envmap(m_envmap);
@@ -47,6 +75,12 @@ App::App()
     {
         model->Instantiate();
     }
+
+    if (stressInstances > 0)
+        spawn_stress_test_instances(stressInstances);
+
+    nijiEngine.m_editor.add_debug_menu_panel("Stress Test Panel",
+                                             std::bind(&App::stress_test_panel, this));
 }
 
 App::~App()
@@ -57,6 +91,7 @@ App::~App()
 static int selectedPointLightIndex = -1;
 void App::draw_light_editor()
 {
+    NIJI_PROFILE_FUNCTION();
     ImGui::Begin("Light Editor");
 
     ImGui::Text("Light Sets");
@@ -208,45 +243,119 @@ void App::draw_light_editor()
     ImGui::End();
 }
 
-void App::rotate_point_lights()
+void App::stress_test_panel()
 {
-    static auto startTime = std::chrono::high_resolution_clock::now();
-    float time =
-        std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - startTime).count();
+    ImGui::Text("Stress Test Instances: %u", m_stressTestInstances);
+    if (ImGui::Button("Spawn 100k Instances"))
+        spawn_stress_test_instances(STRESS_TEST_INSTANCE_COUNT);
+
+    bool move = m_stressTest.MoveEvery > 0;
+    if (ImGui::Checkbox("Move Instances", &move))
+        m_stressTest.MoveEvery = move ? STRESS_TEST_MOVE_EVERY : 0;
+}
 
-    for (auto& set : m_lightSets)
+void App::spawn_stress_test_instances(uint32_t count)
+{
+    // Load the cube once, every stress test instance shares its mesh and material
+    if (!m_stressTestModel)
     {
-        if (!set.Animate)
-            continue;
+        auto parent = nijiEngine.ecs.create_entity();
+        nijiEngine.ecs.add_component<niji::Transform>(parent);
+
+        m_stressTestModel = std::make_shared<niji::Model>("assets/cube/cube.gltf", parent);
+        m_stressTestModel->Instantiate();
+        m_models.push_back(m_stressTestModel);
+    }
 
-        for (size_t i = 0; i < set.PointLights.size(); ++i)
+    niji::MeshComponent prototype = {};
+    auto meshView = nijiEngine.ecs.m_registry.view<niji::MeshComponent>();
+    for (auto&& [entity, mesh] : meshView.each())
+    {
+        if (mesh.Model == m_stressTestModel)
         {
-            auto ent = set.PointLights[i];
-            if (!nijiEngine.ecs.m_registry.valid(ent))
-                continue;
+            prototype = mesh;
+            break;
+        }
+    }
 
-            auto& light = nijiEngine.ecs.m_registry.get<niji::PointLight>(ent);
-            float angle = time * set.Speed + (i * glm::two_pi<float>() / set.PointLights.size());
+    if (!prototype.Model)
+    {
+        printf("[App]: Stress test model has no meshes! \n");
+        return;
+    }
 
-            light.Position.x = set.Center.x + set.RadiusX * std::cos(angle);
-            light.Position.z = set.Center.y + set.RadiusZ * std::sin(angle);
-            light.Position.y = set.YPos;
-        }
+    // Lay the instances out on a cube shaped grid so most of them end up off-screen
+    const uint32_t gridSize = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<float>(count))));
+    const float spacing = 0.5f;
+    const float halfExtent = gridSize * spacing * 0.5f;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t x = i % gridSize;
+        uint32_t y = (i / gridSize) % gridSize;
+        uint32_t z = i / (gridSize * gridSize);
+
+        const glm::vec3 position =
+            glm::vec3(x * spacing - halfExtent, y * spacing, z * spacing - halfExtent);
+
+        auto entity = nijiEngine.ecs.create_entity();
+        auto& trans = nijiEngine.ecs.add_component<niji::Transform>(entity);
+        trans.SetTranslation(position);
+        trans.SetScale(glm::vec3(0.1f));
+
+        nijiEngine.ecs.add_component<niji::MeshComponent>(entity, prototype);
+        m_stressTest.Instances.push_back({entity, position});
     }
+
+    m_stressTestInstances += count;
 }
 
 void App::update(float deltaTime)
 {
+    // The lights and stress test instances move in their own systems, see animation_systems.hpp
     draw_light_editor();
-
-    rotate_point_lights();
 }
 
 void App::render()
 {
 }
 
-void App::load_lights(std::string path)
+void App::generate_point_lights(uint32_t count, float range)
+{
+    // Own seed, so every run of a scenario gets the same lights
+    std::mt19937 rng(count);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    LightSet set;
+    set.Name = "Generated (" + std::to_string(count) + ")";
+    set.Animate = false;
+    set.PointLights.reserve(count);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const glm::vec3 t = glm::vec3(unit(rng), unit(rng), unit(rng));
+        const glm::vec3 position = glm::mix(GENERATED_LIGHTS_MIN, GENERATED_LIGHTS_MAX, t);
+        const glm::vec3 color = glm::vec3(unit(rng), unit(rng), unit(rng));
+
+        auto ent = nijiEngine.ecs.create_entity();
+        nijiEngine.ecs.add_component<niji::PointLight>(ent, position, color, 1.0f, range);
+        set.PointLights.push_back(ent);
+    }
+
+    m_lightSets.push_back(std::move(set));
+}
+
+void App::load_lights(std::string path, bool pointLights)
+{
+    load_light_sets(path, m_lightSets, pointLights);
+}
+
+void App::save_lights(std::string path)
+{
+    save_light_sets(path, m_lightSets);
+}
+
+void App::load_light_sets(const std::string& path, std::vector<LightSet>& sets, bool pointLights)
 {
     std::ifstream file(path);
     if (!file.is_open())
@@ -272,13 +381,16 @@ void App::load_lights(std::string path)
 
         for (auto& jlight : jset["PointLights"])
         {
+            if (!pointLights)
+                break;
+
             niji::PointLight light = jlight.get<niji::PointLight>();
             auto ent = nijiEngine.ecs.create_entity();
             nijiEngine.ecs.add_component<niji::PointLight>(ent, light);
             set.PointLights.push_back(ent);
         }
 
-        m_lightSets.push_back(std::move(set));
+        sets.push_back(std::move(set));
     }
 
     for (auto& j : root["DirectionalLights"])
@@ -289,11 +401,11 @@ void App::load_lights(std::string path)
     }
 }
 
-void App::save_lights(std::string path)
+void App::save_light_sets(const std::string& path, const std::vector<LightSet>& sets)
 {
     json root;
 
-    for (const auto& set : m_lightSets)
+    for (const auto& set : sets)
     {
         json setJson;
         setJson["Name"] = set.Name;
@@ -331,8 +443,9 @@ void App::save_lights(std::string path)
 
 void App::cleanup()
 {
-    // Save Lights to File
-    save_lights("assets/lights.json");
+    // Save Lights to File (benchmark lights are generated, they'd overwrite the real ones)
+    if (!m_benchmarking)
+        save_lights("assets/lights.json");
 
     for (auto& model : m_models)
     {
@@ -18,6 +18,23 @@ struct LightSet
     bool DrawDebugSpheres = false;
 };
 
+// Instances spawned by the stress test, StressTestMotionSystem moves them
+struct StressTestInstances
+{
+    struct Instance
+    {
+        niji::Entity Entity = {};
+        glm::vec3 Base = {};
+    };
+
+    std::vector<Instance> Instances = {};
+    // Every n-th instance moves, 0 keeps them still
+    uint32_t MoveEvery = 0;
+};
+
+// Undeclared access, so it updates on its own: the light editor creates and destroys entities
+// straight through the registry
+
 class App : public niji::System
 {
   public:
@@ -29,14 +46,42 @@ class App : public niji::System
     void cleanup() override;
 
     void draw_light_editor();
-    void rotate_point_lights();
 
-    void load_lights(std::string path);
+    void stress_test_panel();
+    void spawn_stress_test_instances(uint32_t count);
+
+    // Scattered through the scene with a fixed seed (benchmark scenarios)
+    void generate_point_lights(uint32_t count, float range);
+
+    // Without pointLights only the directional lights (and empty light sets) get loaded
+    void load_lights(std::string path, bool pointLights = true);
     void save_lights(std::string path);
+
+    // The light entities get created in / read from the registry, no renderer needed
+    static void load_light_sets(const std::string& path, std::vector<LightSet>& sets,
+                                bool pointLights = true);
+    static void save_light_sets(const std::string& path, const std::vector<LightSet>& sets);
+
+    // Read by the animation systems, which update after the App
+    const std::vector<LightSet>& get_light_sets() const
+    {
+        return m_lightSets;
+    }
+    const StressTestInstances& get_stress_test() const
+    {
+        return m_stressTest;
+    }
+
   private:
     std::vector<std::shared_ptr<niji::Model>> m_models = {};
     std::vector<LightSet> m_lightSets = {};
     int m_selectedLightSet = 0;
 
+    std::shared_ptr<niji::Model> m_stressTestModel = nullptr;
+    uint32_t m_stressTestInstances = 0;
+    StressTestInstances m_stressTest = {};
+
+    bool m_benchmarking = false;
+
     niji::Envmap m_envmap = {};
 };
\ No newline at end of file
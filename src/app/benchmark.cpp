@@ -0,0 +1,347 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+#include "../engine/core/frame_arena.hpp"
+#include "../engine/engine.hpp"
+#include "../engine/rendering/passes/draw_culling.hpp"
+#include "../engine/rendering/passes/forward_pass.hpp"
+#include "../engine/rendering/renderer.hpp"
+
+#include "camera_system.hpp"
+
+using json = nlohmann::json;
+
+static glm::vec3 read_vec3(const json& j)
+{
+    return glm::vec3(j.at(0).get<float>(), j.at(1).get<float>(), j.at(2).get<float>());
+}
+
+BenchmarkScenario BenchmarkScenario::load(const std::string& path, const std::string& name)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+        throw std::runtime_error("Failed to Open Benchmark File: " + path);
+
+    json root;
+    file >> root;
+
+    for (const auto& jscenario : root["Scenarios"])
+    {
+        if (jscenario.value("Name", "") != name)
+            continue;
+
+        BenchmarkScenario scenario = {};
+        scenario.Name = name;
+        scenario.Scene = jscenario.value("Scene", scenario.Scene);
+        scenario.Lights = jscenario.value("Lights", scenario.Lights);
+        scenario.PointLightCount = jscenario.value("PointLightCount", scenario.PointLightCount);
+        scenario.PointLightRange = jscenario.value("PointLightRange", scenario.PointLightRange);
+        scenario.StressInstances = jscenario.value("StressInstances", scenario.StressInstances);
+        scenario.MoveStressInstances =
+            jscenario.value("MoveStressInstances", scenario.MoveStressInstances);
+        scenario.VerifyCulling = jscenario.value("VerifyCulling", scenario.VerifyCulling);
+        scenario.CompareRecording =
+            jscenario.value("CompareRecording", scenario.CompareRecording);
+        scenario.WarmupFrames = jscenario.value("WarmupFrames", scenario.WarmupFrames);
+        scenario.Frames = std::max(jscenario.value("Frames", scenario.Frames), 1u);
+
+        // Paths are shared between scenarios, so they're referenced by name
+        const std::string pathName = jscenario.value("CameraPath", "");
+        if (root.contains("CameraPaths") && root["CameraPaths"].contains(pathName))
+        {
+            for (const auto& jkey : root["CameraPaths"][pathName])
+            {
+                CameraKeyframe key = {};
+                key.Time = jkey.value("Time", 0.0f);
+                key.Position = read_vec3(jkey.at("Position"));
+                key.Yaw = jkey.value("Yaw", key.Yaw);
+                key.Pitch = jkey.value("Pitch", key.Pitch);
+                scenario.CameraPath.push_back(key);
+            }
+        }
+        else
+            printf("[Benchmark]: Scenario '%s' has no camera path, the camera stays put! \n",
+                   name.c_str());
+
+        std::sort(scenario.CameraPath.begin(), scenario.CameraPath.end(),
+                  [](const CameraKeyframe& a, const CameraKeyframe& b) { return a.Time < b.Time; });
+        return scenario;
+    }
+
+    throw std::runtime_error("Unknown Benchmark Scenario: " + name);
+}
+
+BenchmarkSystem::BenchmarkSystem(const std::string& scenario)
+{
+    m_scenario = BenchmarkScenario::load(BENCHMARK_SCENARIO_FILE, scenario);
+    m_frameTimesMs.reserve(m_scenario.Frames);
+
+    // A headless run stops after HeadlessFrames, which also picks the captured frame. The frame
+    // after the last measured one closes the last sample and writes the report.
+    nijiEngine.m_config.HeadlessFrames = m_scenario.WarmupFrames + m_scenario.Frames + 1;
+
+    printf("[Benchmark]: Running '%s', %u warm-up + %u measured frames \n",
+           m_scenario.Name.c_str(), m_scenario.WarmupFrames, m_scenario.Frames);
+}
+
+BenchmarkSystem::~BenchmarkSystem()
+{
+}
+
+void BenchmarkSystem::update(float deltaTime)
+{
+    auto now = std::chrono::high_resolution_clock::now();
+    auto& renderer = nijiEngine.ecs.find_system<niji::Renderer>();
+
+    if (m_frame == 0 && m_scenario.VerifyCulling)
+    {
+        niji::DrawCullingPass* culling = renderer.find_pass<niji::DrawCullingPass>();
+        if (!culling)
+            throw std::runtime_error("Benchmark Scenario Verifies Culling Without a Culling Pass!");
+        culling->set_verify_results(true);
+    }
+
+    if (m_frame == m_scenario.WarmupFrames)
+        renderer.get_gpu_profiler().reset_stats();
+    else if (m_frame > m_scenario.WarmupFrames)
+    {
+        m_frameTimesMs.push_back(
+            std::chrono::duration<float, std::milli>(now - m_lastFrame).count());
+
+        const niji::BindStats& binds = renderer.get_bind_stats();
+        m_totalDraws += binds.Draws;
+        m_maxDraws = std::max(m_maxDraws, binds.Draws);
+        m_totalPipelineBinds += binds.PipelineBinds;
+
+        const uint64_t heapAllocations = renderer.get_frame_heap_allocations();
+        m_totalHeapAllocations += heapAllocations;
+        m_maxHeapAllocations = std::max(m_maxHeapAllocations, heapAllocations);
+
+        // A frame counts as parallel once any of its passes got split into chunks
+        const niji::RecordStats& recording = renderer.get_parallel_recorder().get_last_stats();
+        const size_t mode = recording.ParallelPasses > 0 ? 1 : 0;
+        m_recordFrames[mode]++;
+        m_totalRecordMs[mode] += recording.RecordMs;
+        m_totalRecordChunks += recording.Chunks;
+    }
+    m_lastFrame = now;
+
+    if (m_scenario.CompareRecording && m_frame >= m_scenario.WarmupFrames)
+        renderer.get_parallel_recorder().set_enabled(m_frame % 2 == 0);
+
+    if (m_frame == m_scenario.WarmupFrames + m_scenario.Frames)
+    {
+        const bool passed = write_report();
+        nijiEngine.request_exit(passed ? 0 : 1);
+        return;
+    }
+
+    apply_camera(m_frame);
+    m_frame++;
+}
+
+void BenchmarkSystem::render()
+{
+}
+
+void BenchmarkSystem::apply_camera(uint32_t frame)
+{
+    const std::vector<CameraKeyframe>& path = m_scenario.CameraPath;
+    if (path.empty())
+        return;
+
+    // Warm-up sits on the first keyframe, the measured frames spread evenly over the whole path
+    float time = path.front().Time;
+    if (frame >= m_scenario.WarmupFrames && m_scenario.Frames > 1)
+    {
+        const float t = static_cast<float>(frame - m_scenario.WarmupFrames) /
+                        static_cast<float>(m_scenario.Frames - 1);
+        time = glm::mix(path.front().Time, path.back().Time, t);
+    }
+
+    auto next = std::upper_bound(path.begin(), path.end(), time,
+                                 [](float value, const CameraKeyframe& key) {
+                                     return value < key.Time;
+                                 });
+    const CameraKeyframe& b = next == path.end() ? path.back() : *next;
+    const CameraKeyframe& a = next == path.begin() ? path.front() : *(next - 1);
+    const float span = b.Time - a.Time;
+    const float t = span > 0.0f ? glm::clamp((time - a.Time) / span, 0.0f, 1.0f) : 0.0f;
+
+    niji::Camera& camera = nijiEngine.ecs.find_system<CameraSystem>().m_camera;
+    camera.Position = glm::mix(a.Position, b.Position, t);
+    camera.Yaw = glm::mix(a.Yaw, b.Yaw, t);
+    camera.Pitch = glm::mix(a.Pitch, b.Pitch, t);
+    camera.UpdateVectors();
+}
+
+bool BenchmarkSystem::write_report()
+{
+    auto& renderer = nijiEngine.ecs.find_system<niji::Renderer>();
+    const niji::EngineConfig& config = nijiEngine.m_config;
+
+    std::vector<float> samples = m_frameTimesMs;
+    std::sort(samples.begin(), samples.end());
+    const auto percentile = [&samples](float p) {
+        return samples[static_cast<size_t>(p * (samples.size() - 1) + 0.5f)];
+    };
+
+    float total = 0.0f;
+    for (float sample : samples)
+        total += sample;
+
+    const uint32_t pointLights =
+        static_cast<uint32_t>(nijiEngine.ecs.m_registry.view<niji::PointLight>().size());
+
+    json report;
+    report["Scenario"] = m_scenario.Name;
+    report["Scene"] = m_scenario.Scene;
+    report["PointLights"] = pointLights;
+    report["Headless"] = nijiEngine.m_context.is_headless();
+    report["WarmupFrames"] = m_scenario.WarmupFrames;
+    report["Frames"] = samples.size();
+
+    json& frameTime = report["FrameTimeMs"];
+    frameTime["Mean"] = total / samples.size();
+    frameTime["P50"] = percentile(0.50f);
+    frameTime["P95"] = percentile(0.95f);
+    frameTime["P99"] = percentile(0.99f);
+    frameTime["Max"] = samples.back();
+
+    // The profiler only keeps its last GPU_PROFILER_HISTORY samples per pass
+    niji::GpuProfiler& profiler = renderer.get_gpu_profiler();
+    report["Passes"] = json::array();
+    for (const std::string& name : profiler.get_scope_names())
+    {
+        const niji::GpuScopeStats stats = profiler.get_scope_stats(name);
+        if (stats.Samples == 0)
+            continue;
+
+        report["Passes"].push_back({{"Name", name},
+                                    {"Samples", stats.Samples},
+                                    {"MeanMs", stats.AverageMs},
+                                    {"P50Ms", stats.P50Ms},
+                                    {"P95Ms", stats.P95Ms},
+                                    {"P99Ms", stats.P99Ms},
+                                    {"MaxMs", stats.MaxMs}});
+    }
+
+    json& draws = report["Draws"];
+    draws["MeanDrawCalls"] = static_cast<double>(m_totalDraws) / samples.size();
+    draws["MaxDrawCalls"] = m_maxDraws;
+    draws["MeanPipelineBinds"] = static_cast<double>(m_totalPipelineBinds) / samples.size();
+
+    // CPU time the depth and forward passes spent recording, per frame. Only a CompareRecording
+    // scenario (or a scene too small to split) fills in the inline side next to the parallel one.
+    json& recording = report["Recording"];
+    const auto mean_record_ms = [this](size_t mode) {
+        return m_recordFrames[mode] ? m_totalRecordMs[mode] / m_recordFrames[mode] : 0.0;
+    };
+    recording["InlineFrames"] = m_recordFrames[0];
+    recording["MeanInlineMs"] = mean_record_ms(0);
+    recording["ParallelFrames"] = m_recordFrames[1];
+    recording["MeanParallelMs"] = mean_record_ms(1);
+    recording["MeanParallelChunks"] =
+        m_recordFrames[1] ? static_cast<double>(m_totalRecordChunks) / m_recordFrames[1] : 0.0;
+
+    // Global operator new calls per measured frame, should be 0 in a steady state. Only counted in
+    // NIJI_HEAP_COUNTER builds, the numbers stay 0 otherwise
+    json& heap = report["HeapAllocations"];
+    heap["Counted"] = NIJI_HEAP_COUNTER != 0;
+    heap["MeanPerFrame"] = static_cast<double>(m_totalHeapAllocations) / samples.size();
+    heap["MaxPerFrame"] = m_maxHeapAllocations;
+
+    // Cold start, how long the passes' pipelines took to build
+    const niji::PipelineCompileStats& pipelines = renderer.get_pipeline_compile_stats();
+    json& startup = report["Startup"];
+    startup["Pipelines"] = pipelines.Pipelines;
+    startup["FirstFramePipelinesMs"] = pipelines.FirstFrameMs;
+    startup["AllPipelinesMs"] = pipelines.AllMs;
+    startup["MainThreadWaitMs"] = pipelines.MainThreadWaitMs;
+    const niji::PipelineCacheStats cache = nijiEngine.m_context.get_pipeline_cache().get_stats();
+    startup["PipelineCacheHits"] = cache.Hits;
+    startup["PipelineCacheMisses"] = cache.Misses;
+    const niji::PipelineLibraryStats library =
+        nijiEngine.m_context.get_pipeline_library().get_stats();
+    startup["PipelineLinks"] = library.Links;
+    startup["MaxPipelineLinkMs"] = library.MaxLinkMs;
+
+    const niji::GpuMemoryUsage memory = renderer.get_memory_usage();
+    json& memoryJson = report["MemoryMB"];
+    memoryJson["Allocated"] = memory.AllocatedBytes / (1024.0 * 1024.0);
+    memoryJson["Blocks"] = memory.BlockBytes / (1024.0 * 1024.0);
+    memoryJson["Usage"] = memory.UsageBytes / (1024.0 * 1024.0);
+    memoryJson["Budget"] = memory.BudgetBytes / (1024.0 * 1024.0);
+
+    bool passed = true;
+    if (m_scenario.VerifyCulling)
+    {
+        const niji::DrawCullingCheck& check =
+            renderer.find_pass<niji::DrawCullingPass>()->get_check();
+        passed = check.Frames > 0 && check.CountMismatches == 0 && check.InstanceMismatches == 0;
+
+        json& checks = report["CullingChecks"];
+        checks["Passed"] = passed;
+        checks["Instances"] = nijiEngine.ecs.m_registry.view<niji::MeshComponent>().size();
+        checks["CheckedFrames"] = check.Frames;
+        checks["CountMismatches"] = check.CountMismatches;
+        checks["MaxCountDifference"] = check.MaxCountDifference;
+        checks["InstanceMismatches"] = check.InstanceMismatches;
+        checks["MeanGpuDraws"] =
+            check.Frames > 0 ? static_cast<double>(check.GpuDraws) / check.Frames : 0.0;
+
+        printf("[Benchmark]: Culling checks %s, %u frames, %u draw count mismatches (max off by "
+               "%u), %u instance mismatches \n",
+               passed ? "passed" : "FAILED", check.Frames, check.CountMismatches,
+               check.MaxCountDifference, check.InstanceMismatches);
+    }
+
+    // What the specialization constants actually saved, the variants next to the unspecialized
+    // forward pipeline
+    if (const niji::ForwardPass* forward = renderer.find_pass<niji::ForwardPass>())
+    {
+        const auto statistics_json = [](const std::vector<niji::ShaderStatistic>& statistics) {
+            json result = json::array();
+            for (const niji::ShaderStatistic& statistic : statistics)
+                result.push_back({{"Executable", statistic.Executable},
+                                  {"Name", statistic.Name},
+                                  {"Value", statistic.Value}});
+            return result;
+        };
+
+        json& shaders = report["ForwardShaderStatistics"];
+        shaders["Available"] = nijiEngine.m_context.has_pipeline_executable_info();
+        shaders["Base"] = statistics_json(forward->get_base_statistics());
+
+        json& variants = shaders["Variants"];
+        variants = json::array();
+        for (const auto& [mask, variant] : forward->get_variants())
+        {
+            variants.push_back(
+                {{"Mask", mask},
+                 {"Description", niji::ForwardPass::get_variant_description(mask)},
+                 {"BuildMs", variant.BuildMs},
+                 {"Statistics", statistics_json(niji::query_shader_statistics(
+                                    variant.VariantPipeline->PipelineObject))}});
+        }
+    }
+
+    const std::filesystem::path outputDir = config.OutputDir;
+    std::filesystem::create_directories(outputDir);
+    const std::filesystem::path reportPath = outputDir / ("benchmark_" + m_scenario.Name + ".json");
+
+    std::ofstream file(reportPath);
+    if (file.is_open())
+        file << report.dump(4);
+
+    printf("[Benchmark]: '%s' mean %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms, wrote %s \n",
+           m_scenario.Name.c_str(), total / samples.size(), percentile(0.95f),
+           percentile(0.99f), samples.back(), reportPath.string().c_str());
+    return passed;
+}
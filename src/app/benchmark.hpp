@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+
+#include "../engine/core/components/render-components.hpp"
+#include "../engine/core/ecs.hpp"
+
+constexpr const char* BENCHMARK_SCENARIO_FILE = "assets/benchmarks.json";
+
+struct CameraKeyframe
+{
+    float Time = 0.0f; // Seconds into the path
+    glm::vec3 Position = glm::vec3(0.0f);
+    float Yaw = -90.0f;
+    float Pitch = 0.0f;
+};
+
+struct BenchmarkScenario
+{
+    std::string Name = {};
+    std::string Scene = "assets/Sponza/Sponza.gltf";
+    // Directional light and (unless PointLightCount is set) point lights
+    std::string Lights = "assets/lights.json";
+    // Replaces the file's point lights with this many generated ones, -1 keeps the file's
+    int PointLightCount = -1;
+    float PointLightRange = 1.5f;
+
+    // Cube instances spawned on top of the scene (see App::spawn_stress_test_instances), every
+    // MoveStressInstances-th one of them moves each frame (0 keeps them all still)
+    uint32_t StressInstances = 0;
+    uint32_t MoveStressInstances = 0;
+    // Checks the GPU culling results and the uploaded instances against the CPU every frame,
+    // the run exits with 1 once one of them was off
+    bool VerifyCulling = false;
+    // Switches the geometry passes between inline and parallel recording every measured frame,
+    // the report then holds the mean record time of both
+    bool CompareRecording = false;
+
+    uint32_t WarmupFrames = 60;
+    uint32_t Frames = 600;
+    std::vector<CameraKeyframe> CameraPath = {};
+
+    // Throws when the file or the scenario can't be found
+    static BenchmarkScenario load(const std::string& path, const std::string& name);
+};
+
+// Flies the camera along the scenario's path, one fixed step per frame so every run renders the
+// same views. Frame times only count after the warm-up, the report (frame time percentiles, GPU
+// pass times, draws and memory) gets written as JSON once the last frame is done.
+class BenchmarkSystem : public niji::System
+{
+  public:
+    BenchmarkSystem(const std::string& scenario);
+    ~BenchmarkSystem();
+
+    void update(float deltaTime) override;
+    void render() override;
+
+    const BenchmarkScenario& get_scenario() const
+    {
+        return m_scenario;
+    }
+
+  private:
+    void apply_camera(uint32_t frame);
+    // False when a check of the scenario failed
+    bool write_report();
+
+  private:
+    BenchmarkScenario m_scenario = {};
+
+    uint32_t m_frame = 0;
+    std::chrono::high_resolution_clock::time_point m_lastFrame = {};
+
+    // Measured frames only
+    std::vector<float> m_frameTimesMs = {};
+    uint64_t m_totalDraws = 0;
+    uint32_t m_maxDraws = 0;
+    uint64_t m_totalPipelineBinds = 0;
+    uint64_t m_totalHeapAllocations = 0;
+    uint64_t m_maxHeapAllocations = 0;
+    // [inline, parallel] frames, split by how the geometry passes got recorded
+    std::array<uint32_t, 2> m_recordFrames = {};
+    std::array<double, 2> m_totalRecordMs = {};
+    uint64_t m_totalRecordChunks = 0;
+};
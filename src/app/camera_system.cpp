@@ -6,7 +6,22 @@
 
 CameraSystem::CameraSystem()
 {
+    // Polls GLFW, so it stays on the main thread
+    writes<niji::Camera>();
+
     m_camera = niji::Camera();
+
+    const niji::EngineConfig& config = nijiEngine.m_config;
+    if (config.OverrideCamera)
+    {
+        m_camera.Position = config.CameraPosition;
+        m_camera.Yaw = config.CameraYaw;
+        m_camera.Pitch = config.CameraPitch;
+        m_camera.UpdateVectors();
+    }
+    // No viewport panel resizes the camera without the editor
+    if (nijiEngine.m_context.is_headless())
+        m_camera.AspectRatio = static_cast<float>(config.Width) / static_cast<float>(config.Height);
 }
 
 CameraSystem::~CameraSystem()
@@ -8,12 +8,17 @@
 using namespace niji;
 
 CommandList::CommandList()
+    : CommandList(nijiEngine.m_context.m_commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY)
+{
+}
+
+CommandList::CommandList(VkCommandPool pool, VkCommandBufferLevel level) : m_pool(pool)
 {
     // Allocate Command Buffer
     VkCommandBufferAllocateInfo allocInfo = {};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = nijiEngine.m_context.m_commandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = pool;
+    allocInfo.level = level;
     allocInfo.commandBufferCount = 1;
 
     if (vkAllocateCommandBuffers(nijiEngine.m_context.m_device, &allocInfo, &m_commandBuffer) !=
@@ -37,8 +42,40 @@ void CommandList::begin_list(const char* debugName) const
         throw std::runtime_error("Failed to begin recording command buffer!");
 }
 
+void CommandList::begin_secondary(const RenderInfo& info, bool renderToViewport) const
+{
+    const RenderTarget* target = renderToViewport ? info.ViewportTarget : info.ColorAttachment;
+    const bool hasColor = target->LoadOp != VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+
+    // Has to match what begin_rendering hands to vkCmdBeginRendering
+    VkCommandBufferInheritanceRenderingInfoKHR renderingInfo = {};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+    renderingInfo.colorAttachmentCount = hasColor ? 1 : 0;
+    renderingInfo.pColorAttachmentFormats = hasColor ? &target->Format : nullptr;
+    renderingInfo.depthAttachmentFormat =
+        info.HasDepth ? info.DepthAttachment->Format : VK_FORMAT_UNDEFINED;
+    renderingInfo.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+    renderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkCommandBufferInheritanceInfo inheritanceInfo = {};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.pNext = &renderingInfo;
+    // Passes can be recorded inside a GPU profiler pipeline statistics query
+    if (nijiEngine.m_context.has_pipeline_statistics())
+        inheritanceInfo.pipelineStatistics = PROFILED_PIPELINE_STATISTICS;
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT |
+                      VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    if (vkBeginCommandBuffer(m_commandBuffer, &beginInfo) != VK_SUCCESS)
+        throw std::runtime_error("Failed to begin recording secondary command buffer!");
+}
+
 void CommandList::begin_rendering(const RenderInfo& info, const std::string& passName,
-                                  bool renderToViewport) const
+                                  bool renderToViewport, bool secondaryContents) const
 {
     VkDebugUtilsLabelEXT labelInfo{VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
     labelInfo.pLabelName = passName.c_str();
@@ -75,6 +112,8 @@ void CommandList::begin_rendering(const RenderInfo& info, const std::string& pas
 
     VkRenderingInfoKHR renderingInfo = {};
     renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+    renderingInfo.flags =
+        secondaryContents ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR : 0;
     renderingInfo.renderArea = info.RenderArea;
     renderingInfo.layerCount = info.LayerCount;
     renderingInfo.colorAttachmentCount = target->LoadOp != VK_ATTACHMENT_LOAD_OP_DONT_CARE ? 1 : 0;
@@ -147,6 +186,19 @@ void CommandList::push_descriptor_set(VkPipelineBindPoint pipelineBindPoint,
                               pDescriptorWrites);
 }
 
+void CommandList::push_descriptor_set_with_template(VkDescriptorUpdateTemplate updateTemplate,
+                                                    VkPipelineLayout layout, uint32_t set,
+                                                    const void* data) const
+{
+    VKCmdPushDescriptorSetWithTemplateKHR(m_commandBuffer, updateTemplate, layout, set, data);
+}
+
+void CommandList::push_constants(VkPipelineLayout layout, VkShaderStageFlags stages,
+                                 uint32_t offset, uint32_t size, const void* data) const
+{
+    vkCmdPushConstants(m_commandBuffer, layout, stages, offset, size, data);
+}
+
 void CommandList::draw_indexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex,
                                int32_t vertexOffset, uint32_t firstInstance) const
 {
@@ -160,6 +212,23 @@ void CommandList::draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t fi
     vkCmdDraw(m_commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
 }
 
+void CommandList::draw_indexed_indirect_count(VkBuffer buffer, VkDeviceSize offset,
+                                              VkBuffer countBuffer, VkDeviceSize countBufferOffset,
+                                              uint32_t maxDrawCount, uint32_t stride) const
+{
+    vkCmdDrawIndexedIndirectCount(m_commandBuffer, buffer, offset, countBuffer, countBufferOffset,
+                                  maxDrawCount, stride);
+}
+
+void CommandList::execute_commands(const FrameVector<VkCommandBuffer>& commandBuffers) const
+{
+    if (commandBuffers.empty())
+        return;
+
+    vkCmdExecuteCommands(m_commandBuffer, static_cast<uint32_t>(commandBuffers.size()),
+                         commandBuffers.data());
+}
+
 void CommandList::dispatch(const uint32_t groupCountX, const uint32_t groupCountY,
                            const uint32_t groupCountZ) const
 {
@@ -170,14 +239,6 @@ void CommandList::end_rendering(const RenderInfo& info) const
 {
     VKCmdEndRenderingKHR(m_commandBuffer);
 
-    if (info.PrepareForPresent)
-    {
-        auto& rt = info.ColorAttachment;
-        transition_image(rt->Image, rt->Format, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-                         VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, TransitionType::Present);
-        rt->CurrentLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-    }
-
     VKCmdEndDebugUtilsLabelEXT(m_commandBuffer);
 }
 
@@ -196,8 +257,7 @@ void CommandList::cleanup()
 {
     if (m_commandBuffer != VK_NULL_HANDLE)
     {
-        vkFreeCommandBuffers(nijiEngine.m_context.m_device, nijiEngine.m_context.m_commandPool, 1,
-                             &m_commandBuffer);
+        vkFreeCommandBuffers(nijiEngine.m_context.m_device, m_pool, 1, &m_commandBuffer);
         m_commandBuffer = VK_NULL_HANDLE;
     }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common.hpp"
+#include "frame_arena.hpp"
 
 namespace niji
 {
@@ -8,10 +9,15 @@ class CommandList
 {
   public:
     CommandList();
+    CommandList(VkCommandPool pool, VkCommandBufferLevel level);
 
     void begin_list(const char* debugName = "Unnamed Commandlist") const;
+    // Begins a secondary command buffer that continues the dynamic rendering pass `info` describes
+    void begin_secondary(const RenderInfo& info, bool renderToViewport = true) const;
 
-    void begin_rendering(const RenderInfo& info, const std::string& passName, bool renderToViewport = true) const;
+    // `secondaryContents` means the pass contents come from execute_commands only
+    void begin_rendering(const RenderInfo& info, const std::string& passName, bool renderToViewport = true,
+                         bool secondaryContents = false) const;
     void bind_pipeline(const VkPipeline& pipeline, const bool isCompute = false) const;
     void bind_viewport(const VkExtent2D& extent) const;
     void bind_scissor(const VkExtent2D& extent) const;
@@ -23,9 +29,15 @@ class CommandList
                             uint32_t firstSet, uint32_t descriptorSetCount,
                             const VkDescriptorSet* pDescriptorSets, uint32_t dynamicOffsetCount = 0,
                             const uint32_t* pDynamicOffsets = nullptr) const;
+    // `data` is laid out the way the template expects it (see DescriptorUpdateData)
+    void push_descriptor_set_with_template(VkDescriptorUpdateTemplate updateTemplate,
+                                           VkPipelineLayout layout, uint32_t set,
+                                           const void* data) const;
     void push_descriptor_set(VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout,
                              uint32_t set, uint32_t descriptorWriteCount,
                              const VkWriteDescriptorSet* pDescriptorWrites) const;
+    void push_constants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset,
+                        uint32_t size, const void* data) const;
 
     void draw_indexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex,
                      int32_t vertexOffset, uint32_t firstInstance) const;
@@ -33,6 +45,12 @@ class CommandList
     void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex,
               uint32_t firstInstance) const;
 
+    void draw_indexed_indirect_count(VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer,
+                                     VkDeviceSize countBufferOffset, uint32_t maxDrawCount,
+                                     uint32_t stride) const;
+
+    void execute_commands(const FrameVector<VkCommandBuffer>& commandBuffers) const;
+
     void dispatch(const uint32_t groupCountX, const uint32_t groupCountY,
                   const uint32_t groupCountZ) const;
 
@@ -60,13 +78,16 @@ class CommandList
     friend class Renderer;
     friend class ImGuiPass;
     friend class DepthPass;
+    friend class DrawCullingPass;
     friend class ForwardPass;
     friend class ImGuiPass;
     friend class LightCullingPass;
     friend class LineRenderPass;
     friend class SkyboxPass;
+    friend class ParallelCommandRecorder;
 
     VkCommandBuffer m_commandBuffer = {};
+    VkCommandPool m_pool = VK_NULL_HANDLE;
     char* m_name = nullptr;
 };
 } // namespace niji
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "common.hpp"
 
+#include <array>
+#include <chrono>
 #include <filesystem>
 #include <stdexcept>
 #include <fstream>
@@ -9,6 +11,7 @@
 #include <stb_image.h>
 
 #include "engine.hpp"
+#include "vulkan-functions.hpp"
 
 namespace fs = std::filesystem;
 
@@ -62,12 +65,17 @@ Buffer::Buffer(BufferDesc& desc, void* data)
         usageFlags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         memUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
         break;
+    case BufferDesc::BufferUsage::Indirect:
+        // Transfer source for the draw count readbacks of DrawCullingPass' checks
+        usageFlags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        break;
     default:
         break;
     }
 
     nijiEngine.m_context.create_buffer(desc.Size, usageFlags, memUsage, Handle, BufferAllocation,
-                                       desc.IsPersistent);
+                                       desc.IsPersistent, desc.SharedQueues);
     vmaSetAllocationName(nijiEngine.m_context.m_allocator, BufferAllocation, desc.Name);
 
     if (!desc.IsPersistent/*desc.Usage != BufferDesc::BufferUsage::Uniform &&
@@ -158,6 +166,78 @@ std::vector<char> niji::read_file(const std::string& filename)
     return buffer;
 }
 
+uint64_t niji::hash_bytes(const void* data, size_t size, uint64_t hash)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::vector<ShaderStatistic> niji::query_shader_statistics(VkPipeline pipeline)
+{
+    std::vector<ShaderStatistic> statistics = {};
+    if (!nijiEngine.m_context.has_pipeline_executable_info() || pipeline == VK_NULL_HANDLE)
+        return statistics;
+
+    VkDevice device = nijiEngine.m_context.m_device;
+
+    VkPipelineInfoKHR pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INFO_KHR;
+    pipelineInfo.pipeline = pipeline;
+
+    uint32_t executableCount = 0;
+    VKGetPipelineExecutablePropertiesKHR(device, &pipelineInfo, &executableCount, nullptr);
+    std::vector<VkPipelineExecutablePropertiesKHR> executables(executableCount);
+    for (auto& executable : executables)
+        executable.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_PROPERTIES_KHR;
+    VKGetPipelineExecutablePropertiesKHR(device, &pipelineInfo, &executableCount,
+                                         executables.data());
+
+    for (uint32_t i = 0; i < executableCount; i++)
+    {
+        VkPipelineExecutableInfoKHR executableInfo = {};
+        executableInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_INFO_KHR;
+        executableInfo.pipeline = pipeline;
+        executableInfo.executableIndex = i;
+
+        uint32_t statisticCount = 0;
+        VKGetPipelineExecutableStatisticsKHR(device, &executableInfo, &statisticCount, nullptr);
+        std::vector<VkPipelineExecutableStatisticKHR> driverStatistics(statisticCount);
+        for (auto& statistic : driverStatistics)
+            statistic.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_STATISTIC_KHR;
+        VKGetPipelineExecutableStatisticsKHR(device, &executableInfo, &statisticCount,
+                                             driverStatistics.data());
+
+        for (const auto& driverStatistic : driverStatistics)
+        {
+            ShaderStatistic statistic = {};
+            statistic.Executable = executables[i].name;
+            statistic.Name = driverStatistic.name;
+            switch (driverStatistic.format)
+            {
+            case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_BOOL32_KHR:
+                statistic.Value = driverStatistic.value.b32 ? 1.0 : 0.0;
+                break;
+            case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_INT64_KHR:
+                statistic.Value = static_cast<double>(driverStatistic.value.i64);
+                break;
+            case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_UINT64_KHR:
+                statistic.Value = static_cast<double>(driverStatistic.value.u64);
+                break;
+            default:
+                statistic.Value = driverStatistic.value.f64;
+                break;
+            }
+            statistics.push_back(statistic);
+        }
+    }
+    return statistics;
+}
+
 static VkShaderModule create_shader_module(VkDevice& device, const std::vector<char>& code)
 {
     VkShaderModuleCreateInfo createInfo = {};
@@ -171,6 +251,47 @@ static VkShaderModule create_shader_module(VkDevice& device, const std::vector<c
     return shaderModule;
 }
 
+template <typename T>
+inline static uint64_t hash_value(const T& value, uint64_t hash)
+{
+    return hash_bytes(&value, sizeof(T), hash);
+}
+
+// One VK_EXT_graphics_pipeline_library part, `info` only holds the state that part owns
+static VkPipeline create_library_part(VkGraphicsPipelineLibraryFlagsEXT part,
+                                      VkGraphicsPipelineCreateInfo info, const char* name)
+{
+    VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo = {};
+    libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+    libraryInfo.pNext = info.pNext;
+    libraryInfo.flags = part;
+
+    PipelineCache& cache = nijiEngine.m_context.get_pipeline_cache();
+    VkPipelineCreationFeedback feedback = {};
+    VkPipelineCreationFeedbackCreateInfo feedbackInfo = PipelineCache::make_feedback_info(feedback);
+    feedbackInfo.pNext = &libraryInfo;
+
+    info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    info.pNext = &feedbackInfo;
+    // Keeps what the optimized link needs to optimize across the parts
+    info.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR |
+                 VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+    info.basePipelineHandle = VK_NULL_HANDLE;
+    info.basePipelineIndex = -1;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    auto start = std::chrono::high_resolution_clock::now();
+    if (vkCreateGraphicsPipelines(nijiEngine.m_context.m_device, cache.get_handle(), 1, &info,
+                                  nullptr, &pipeline) != VK_SUCCESS)
+        throw std::runtime_error("Failed to Create Graphics Pipeline Library!");
+    cache.record_creation(feedback, std::chrono::duration<double, std::milli>(
+                                        std::chrono::high_resolution_clock::now() - start)
+                                        .count());
+
+    SetObjectName(nijiEngine.m_context.m_device, VK_OBJECT_TYPE_PIPELINE, pipeline, name);
+    return pipeline;
+}
+
 inline static VkPrimitiveTopology to_vk(GraphicsPipelineDesc::PrimitiveTopology& primTopology)
 {
     switch (primTopology)
@@ -282,24 +403,29 @@ Pipeline::Pipeline(GraphicsPipelineDesc desc)
     auto vertShaderCode = read_file(desc.VertexShader);
     auto fragShaderCode = read_file(desc.FragmentShader);
 
-    VkShaderModule vertShaderModule =
-        create_shader_module(nijiEngine.m_context.m_device, vertShaderCode);
-    VkShaderModule fragShaderModule =
-        create_shader_module(nijiEngine.m_context.m_device, fragShaderCode);
-
+    // Modules get created once a stage actually gets built, reused library parts don't need them
     VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
     vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = vertShaderModule;
     vertShaderStageInfo.pName = "main";
 
     VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
     fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = fragShaderModule;
     fragShaderStageInfo.pName = "main";
 
-    VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
+    std::vector<VkSpecializationMapEntry> fragConstantEntries = {};
+    for (uint32_t i = 0; i < desc.FragmentConstants.size(); i++)
+        fragConstantEntries.push_back({i, i * static_cast<uint32_t>(sizeof(uint32_t)),
+                                       sizeof(uint32_t)});
+
+    VkSpecializationInfo fragSpecialization = {};
+    fragSpecialization.mapEntryCount = static_cast<uint32_t>(fragConstantEntries.size());
+    fragSpecialization.pMapEntries = fragConstantEntries.data();
+    fragSpecialization.dataSize = desc.FragmentConstants.size() * sizeof(uint32_t);
+    fragSpecialization.pData = desc.FragmentConstants.data();
+    if (!desc.FragmentConstants.empty())
+        fragShaderStageInfo.pSpecializationInfo = &fragSpecialization;
 
     std::vector<VkDynamicState> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT,
                                                  VK_DYNAMIC_STATE_SCISSOR};
@@ -309,10 +435,14 @@ Pipeline::Pipeline(GraphicsPipelineDesc desc)
     dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
     dynamicState.pDynamicStates = dynamicStates.data();
 
+    // Pipelines without attributes pull their vertices in the shader
+    const bool hasVertexInput = !desc.VertexLayout.Attributes.empty();
+
     VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.pVertexBindingDescriptions = &desc.VertexLayout.Binding;
+    vertexInputInfo.vertexBindingDescriptionCount = hasVertexInput ? 1 : 0;
+    vertexInputInfo.pVertexBindingDescriptions =
+        hasVertexInput ? &desc.VertexLayout.Binding : nullptr;
     vertexInputInfo.vertexAttributeDescriptionCount =
         static_cast<uint32_t>(desc.VertexLayout.Attributes.size());
     vertexInputInfo.pVertexAttributeDescriptions = desc.VertexLayout.Attributes.data();
@@ -387,12 +517,18 @@ Pipeline::Pipeline(GraphicsPipelineDesc desc)
     std::vector<VkDescriptorSetLayout> setLayouts = {desc.GlobalDescriptorSetLayout,
                                                      desc.PassDescriptorSetLayout};
 
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = desc.PushConstantStages;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = desc.PushConstantSize;
+
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipelineLayoutInfo.setLayoutCount = setLayouts.size();
     pipelineLayoutInfo.pSetLayouts = setLayouts.data();
-    pipelineLayoutInfo.pushConstantRangeCount = 0;
-    pipelineLayoutInfo.pPushConstantRanges = nullptr;
+    pipelineLayoutInfo.pushConstantRangeCount = desc.PushConstantSize > 0 ? 1 : 0;
+    pipelineLayoutInfo.pPushConstantRanges =
+        desc.PushConstantSize > 0 ? &pushConstantRange : nullptr;
 
     if (vkCreatePipelineLayout(nijiEngine.m_context.m_device, &pipelineLayoutInfo, nullptr,
                                &PipelineLayout) != VK_SUCCESS)
@@ -416,6 +552,111 @@ Pipeline::Pipeline(GraphicsPipelineDesc desc)
     depthStencil.front = {};
     depthStencil.back = {};
 
+    PipelineLibrary& library = nijiEngine.m_context.get_pipeline_library();
+    if (library.is_enabled())
+    {
+        VkDevice& device = nijiEngine.m_context.m_device;
+
+        // Every part is keyed by the state it gets built from, the layout one by the set layouts
+        // and push constants (pipeline layouts that match in those link together fine)
+        uint64_t layoutKey = hash_bytes(setLayouts.data(),
+                                        setLayouts.size() * sizeof(VkDescriptorSetLayout));
+        layoutKey = hash_value(pushConstantRange, layoutKey);
+
+        uint64_t vertexInputKey = hash_value(inputAssembly.topology, 0xcbf29ce484222325ull);
+        if (hasVertexInput)
+        {
+            vertexInputKey = hash_value(desc.VertexLayout.Binding, vertexInputKey);
+            vertexInputKey = hash_bytes(desc.VertexLayout.Attributes.data(),
+                                        desc.VertexLayout.Attributes.size() *
+                                            sizeof(VkVertexInputAttributeDescription),
+                                        vertexInputKey);
+        }
+
+        uint64_t preRasterKey = hash_bytes(vertShaderCode.data(), vertShaderCode.size(), layoutKey);
+        preRasterKey = hash_value(rasterizer.depthClampEnable, preRasterKey);
+        preRasterKey = hash_value(rasterizer.rasterizerDiscardEnable, preRasterKey);
+        preRasterKey = hash_value(rasterizer.polygonMode, preRasterKey);
+        preRasterKey = hash_value(rasterizer.cullMode, preRasterKey);
+        preRasterKey = hash_value(rasterizer.lineWidth, preRasterKey);
+
+        uint64_t fragmentKey = hash_bytes(fragShaderCode.data(), fragShaderCode.size(), layoutKey);
+        fragmentKey = hash_bytes(desc.FragmentConstants.data(),
+                                 desc.FragmentConstants.size() * sizeof(uint32_t), fragmentKey);
+        fragmentKey = hash_value(depthStencil.depthTestEnable, fragmentKey);
+        fragmentKey = hash_value(depthStencil.depthWriteEnable, fragmentKey);
+        fragmentKey = hash_value(depthStencil.depthCompareOp, fragmentKey);
+
+        uint64_t outputKey = hash_value(pipelineRenderingInfo.colorAttachmentCount,
+                                        0xcbf29ce484222325ull);
+        outputKey = hash_value(desc.ColorAttachmentFormat, outputKey);
+        outputKey = hash_value(pipelineRenderingInfo.depthAttachmentFormat, outputKey);
+        outputKey = hash_value(colorBlendAttachment, outputKey);
+
+        std::array<VkPipeline, 4> parts = {};
+        parts[0] = library.get_part(PipelinePart::VERTEX_INPUT, vertexInputKey, [&]() {
+            VkGraphicsPipelineCreateInfo partInfo = {};
+            partInfo.pVertexInputState = &vertexInputInfo;
+            partInfo.pInputAssemblyState = &inputAssembly;
+            return create_library_part(VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,
+                                       partInfo, Name);
+        });
+        parts[1] = library.get_part(PipelinePart::PRE_RASTERIZATION, preRasterKey, [&]() {
+            vertShaderStageInfo.module = create_shader_module(device, vertShaderCode);
+
+            VkGraphicsPipelineCreateInfo partInfo = {};
+            partInfo.pNext = &pipelineRenderingInfo;
+            partInfo.stageCount = 1;
+            partInfo.pStages = &vertShaderStageInfo;
+            partInfo.pViewportState = &viewportState;
+            partInfo.pRasterizationState = &rasterizer;
+            partInfo.pDynamicState = &dynamicState;
+            partInfo.layout = PipelineLayout;
+            VkPipeline part = create_library_part(
+                VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT, partInfo, Name);
+
+            vkDestroyShaderModule(device, vertShaderStageInfo.module, nullptr);
+            return part;
+        });
+        parts[2] = library.get_part(PipelinePart::FRAGMENT_SHADER, fragmentKey, [&]() {
+            fragShaderStageInfo.module = create_shader_module(device, fragShaderCode);
+
+            VkGraphicsPipelineCreateInfo partInfo = {};
+            partInfo.pNext = &pipelineRenderingInfo;
+            partInfo.stageCount = 1;
+            partInfo.pStages = &fragShaderStageInfo;
+            partInfo.pMultisampleState = &multisampling;
+            partInfo.pDepthStencilState = &depthStencil;
+            partInfo.layout = PipelineLayout;
+            VkPipeline part = create_library_part(
+                VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT, partInfo, Name);
+
+            vkDestroyShaderModule(device, fragShaderStageInfo.module, nullptr);
+            return part;
+        });
+        parts[3] = library.get_part(PipelinePart::FRAGMENT_OUTPUT, outputKey, [&]() {
+            VkGraphicsPipelineCreateInfo partInfo = {};
+            partInfo.pNext = &pipelineRenderingInfo;
+            partInfo.pMultisampleState = &multisampling;
+            partInfo.pColorBlendState = &colorBlending;
+            return create_library_part(
+                VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT, partInfo, Name);
+        });
+
+        PipelineObject = library.link(parts, PipelineLayout, Name);
+        SetObjectName(device, VK_OBJECT_TYPE_PIPELINE, PipelineObject, Name);
+        return;
+    }
+
+    VkShaderModule vertShaderModule =
+        create_shader_module(nijiEngine.m_context.m_device, vertShaderCode);
+    VkShaderModule fragShaderModule =
+        create_shader_module(nijiEngine.m_context.m_device, fragShaderCode);
+    vertShaderStageInfo.module = vertShaderModule;
+    fragShaderStageInfo.module = fragShaderModule;
+
+    VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
+
     VkGraphicsPipelineCreateInfo pipelineInfo = {};
     pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineInfo.stageCount = 2;
@@ -434,10 +675,21 @@ Pipeline::Pipeline(GraphicsPipelineDesc desc)
     pipelineInfo.subpass = 0;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineInfo.basePipelineIndex = -1;
+    if (nijiEngine.m_context.has_pipeline_executable_info())
+        pipelineInfo.flags |= VK_PIPELINE_CREATE_CAPTURE_STATISTICS_BIT_KHR;
+
+    PipelineCache& cache = nijiEngine.m_context.get_pipeline_cache();
+    VkPipelineCreationFeedback feedback = {};
+    VkPipelineCreationFeedbackCreateInfo feedbackInfo = PipelineCache::make_feedback_info(feedback);
+    pipelineRenderingInfo.pNext = &feedbackInfo;
 
-    if (vkCreateGraphicsPipelines(nijiEngine.m_context.m_device, VK_NULL_HANDLE, 1, &pipelineInfo,
-                                  nullptr, &PipelineObject) != VK_SUCCESS)
+    auto start = std::chrono::high_resolution_clock::now();
+    if (vkCreateGraphicsPipelines(nijiEngine.m_context.m_device, cache.get_handle(), 1,
+                                  &pipelineInfo, nullptr, &PipelineObject) != VK_SUCCESS)
         throw std::runtime_error("Failed to Create Graphics Pipeline!");
+    cache.record_creation(feedback, std::chrono::duration<double, std::milli>(
+                                        std::chrono::high_resolution_clock::now() - start)
+                                        .count());
 
     SetObjectName(nijiEngine.m_context.m_device, VK_OBJECT_TYPE_PIPELINE, PipelineObject, Name);
 
@@ -483,9 +735,18 @@ Pipeline::Pipeline(ComputePipelineDesc desc)
     computePipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     computePipelineInfo.basePipelineIndex = -1;
 
-    if (vkCreateComputePipelines(nijiEngine.m_context.m_device, VK_NULL_HANDLE, 1,
+    PipelineCache& cache = nijiEngine.m_context.get_pipeline_cache();
+    VkPipelineCreationFeedback feedback = {};
+    VkPipelineCreationFeedbackCreateInfo feedbackInfo = PipelineCache::make_feedback_info(feedback);
+    computePipelineInfo.pNext = &feedbackInfo;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    if (vkCreateComputePipelines(nijiEngine.m_context.m_device, cache.get_handle(), 1,
                                  &computePipelineInfo, nullptr, &PipelineObject) != VK_SUCCESS)
         throw std::runtime_error("Failed to create compute pipeline!");
+    cache.record_creation(feedback, std::chrono::duration<double, std::milli>(
+                                        std::chrono::high_resolution_clock::now() - start)
+                                        .count());
 
     SetObjectName(nijiEngine.m_context.m_device, VK_OBJECT_TYPE_PIPELINE, PipelineObject, Name);
 
@@ -494,6 +755,8 @@ Pipeline::Pipeline(ComputePipelineDesc desc)
 
 void Pipeline::cleanup()
 {
+    if (IsGraphicsPipeline)
+        nijiEngine.m_context.get_pipeline_library().release(PipelineObject);
     if (PipelineObject)
         vkDestroyPipeline(nijiEngine.m_context.m_device, PipelineObject, nullptr);
     if (PipelineLayout)
@@ -512,6 +775,9 @@ Texture::Texture(const TextureDesc& desc) : Desc(desc)
     if (desc.Type == TextureDesc::TextureType::CUBEMAP && desc.Layers != 6)
         throw std::runtime_error("Cubemaps must have exactly 6 layers!");
 
+    // There is no ImGui renderer to register with when headless
+    Desc.ShowInImGui = desc.ShowInImGui && !nijiEngine.m_context.is_headless();
+
     const VkImageCreateFlags flags =
         desc.Type == TextureDesc::TextureType::CUBEMAP ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
 
@@ -524,7 +790,7 @@ Texture::Texture(const TextureDesc& desc) : Desc(desc)
 
     nijiEngine.m_context.create_image(Desc.Width, Desc.Height, Desc.Mips, Desc.Layers, Desc.Format,
                                       VK_IMAGE_TILING_OPTIMAL, Desc.Usage, Desc.MemoryUsage, flags,
-                                      TextureImage, TextureImageAllocation);
+                                      TextureImage, TextureImageAllocation, Desc.SharedQueues);
 
     nijiEngine.m_context.transition_image_layout(TextureImage, Desc.Format,
                                                  VK_IMAGE_LAYOUT_UNDEFINED,
@@ -925,7 +1191,8 @@ RenderTarget::RenderTarget(RenderTargetDesc desc)
     nijiEngine.m_context.create_image(desc.Width, desc.Height, 1, 1, Format,
                                       VK_IMAGE_TILING_OPTIMAL,
                                       VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
-                                          VK_IMAGE_USAGE_SAMPLED_BIT,
+                                          VK_IMAGE_USAGE_SAMPLED_BIT |
+                                          VK_IMAGE_USAGE_TRANSFER_SRC_BIT, // Captures
                                       VMA_MEMORY_USAGE_AUTO, 0, Image, Allocation);
 
     ImageView =
@@ -933,7 +1200,7 @@ RenderTarget::RenderTarget(RenderTargetDesc desc)
 
     ImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-    if (desc.ShowInImGui)
+    if (desc.ShowInImGui && !nijiEngine.m_context.is_headless())
     {
         ImGuiHandle =
             ImGui_ImplVulkan_AddTexture(nijiEngine.m_context.m_globalSampler.Handle,
@@ -988,34 +1255,3 @@ void Shader::init()
         Spirv.push_back(compute);
     }
 }
-
-bool Shader::re_compile()
-{
-    bool result = false;
-
-    if (Type == ShaderType::NONE)
-        return result;
-
-    if (Type == ShaderType::FRAG_AND_VERT)
-    {
-        {
-            std::string cmd = "slangc " + Source + " -entry " + "vertex" +
-                              "_main -profile vs_6_0 -target spirv -o " + Spirv[0] + " -g";
-            result = std::system(cmd.c_str()) == 0;
-        }
-
-        {
-            std::string cmd = "slangc " + Source + " -entry " + "fragment" +
-                              "_main -profile ps_6_0 -target spirv -o " + Spirv[1] + " -g";
-            result &= std::system(cmd.c_str()) == 0;
-        }
-    }
-    else if (Type == ShaderType::COMPUTE)
-    {
-        std::string cmd = "slangc " + Source + " -entry " + "compute" +
-                          "_main -profile cs_6_0 -target spirv -o " + Spirv[0] + " -g";
-        result = std::system(cmd.c_str()) == 0;
-    }
-
-    return result;
-}
@@ -35,6 +35,21 @@ std::vector<char> read_binary_file(const std::string& path);
 
 std::vector<char> read_file(const std::string& filename);
 
+// FNV-1a, for content keyed caches. Pass the previous result as `hash` to chain several ranges
+uint64_t hash_bytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull);
+
+struct ShaderStatistic
+{
+    // Executable (shader stage) as the driver names it
+    std::string Executable = {};
+    std::string Name = {};
+    double Value = 0.0;
+};
+
+// Driver reported statistics (registers, instructions, ...) of every shader in a pipeline, empty
+// without VK_KHR_pipeline_executable_properties
+std::vector<ShaderStatistic> query_shader_statistics(VkPipeline pipeline);
+
 struct Vertex
 {
     glm::vec3 Pos = {};
@@ -44,6 +59,17 @@ struct Vertex
     glm::vec2 TexCoord = {};
 };
 
+// Vertex layout of the geometry pool. Fetched in the shaders through a buffer device address,
+// so it only uses vec4s to keep the C++ and shader layouts identical.
+struct PackedVertex
+{
+    glm::vec4 PosU = {};    // xyz = Position, w = TexCoord.x
+    glm::vec4 NormalV = {}; // xyz = Normal, w = TexCoord.y
+    glm::vec4 Tangent = {};
+    glm::vec4 Color = {};
+};
+static_assert(sizeof(PackedVertex) == 64, "PackedVertex must match the shader layout!");
+
 struct SkyboxVertex
 {
     glm::vec3 Pos = {};
@@ -75,13 +101,6 @@ struct CameraData
     alignas(16) glm::mat4 Proj = {};
     alignas(16) glm::vec3 Pos = {};
 };
-struct ModelData
-{
-    alignas(16) glm::mat4 Model = {};
-    alignas(16) glm::mat4 InvModel = {};
-
-    alignas(16) MaterialInfo MaterialInfo = {};
-};
 struct DebugSettings
 {
     enum class RenderFlags
@@ -120,10 +139,13 @@ struct BufferDesc
         Vertex,
         Index,
         Uniform,
-        Storage
+        Storage,
+        Indirect
     } Usage = {};
 
     bool IsPersistent = false;
+    // Used on the async compute queue too, see Context::create_buffer()
+    bool SharedQueues = false;
     char* Name = "Unknown Buffer";
 };
 
@@ -168,8 +190,6 @@ struct Shader
     ShaderType Type = {};
 
     void init();
-
-    bool re_compile();
 };
 
 struct RenderTargetDesc
@@ -214,11 +234,24 @@ struct RenderTarget
 
     char* Name = nullptr;
 
+    // The image got created for use on the async compute queue too
+    bool SharedQueues = false;
+
     // Used only for Custom RTs
     VmaAllocation Allocation = {};
     VkDescriptorSet ImGuiHandle = {};
 };
 
+// Counted by the GPU profiler's pipeline statistics queries, secondaries inherit the same set
+constexpr VkQueryPipelineStatisticFlags PROFILED_PIPELINE_STATISTICS =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+constexpr uint32_t PROFILED_PIPELINE_STATISTIC_COUNT = 6;
+
 struct RenderInfo
 {
     RenderInfo() = default;
@@ -236,7 +269,6 @@ struct RenderInfo
     RenderTarget* ViewportTarget = nullptr;
 
     bool HasDepth = false;
-    bool PrepareForPresent = false;
 };
 
 struct TextureDesc
@@ -257,6 +289,8 @@ struct TextureDesc
     bool IsReadWrite = false;
     bool IsMipMapped = false;
     bool ShowInImGui = false;
+    // Used on the async compute queue too, see Context::create_image()
+    bool SharedQueues = false;
     uint32_t Mips = 1;
     uint32_t Layers = 1;
 
@@ -454,6 +488,13 @@ struct GraphicsPipelineDesc
     RasterizerState Rasterizer = {};
     VkFormat ColorAttachmentFormat = {};
 
+    // Single push constant range (0 = none)
+    uint32_t PushConstantSize = 0;
+    VkShaderStageFlags PushConstantStages = VK_SHADER_STAGE_VERTEX_BIT;
+
+    // Fragment shader specialization constants, constant_id i gets FragmentConstants[i]
+    std::vector<uint32_t> FragmentConstants = {};
+
     char* Name = "Unknown Graphics Pipeline";
 
   private:
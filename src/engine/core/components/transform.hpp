@@ -12,6 +12,11 @@
 
 namespace niji
 {
+namespace bench
+{
+struct TransformHierarchy;
+}
+
 /// <summary>
 /// Transform component. Contains the position, rotation and scale of the entity.
 /// Implemented on top of the entity-component-system (entt).
@@ -88,7 +93,8 @@ struct Transform
     [[nodiscard]] const glm::mat4& World();
 
     /// <summary>Updates the translation of this Transform.
-    /// Also marks this Transform and its children as dirty.</summary>
+    /// Also marks this Transform and its children as dirty. Once the entity renders, the
+    /// system moving it also calls ECS::mark_moved() so the renderer picks it up.</summary>
     /// <param name="translation">The new translation vector to use.</param>
     void SetTranslation(const glm::vec3& translation)
     {
@@ -119,6 +125,10 @@ struct Transform
     void SetFromMatrix(const glm::mat4& transform);
 
   private:
+    // Links real parent chains for the micro-benchmarks (bench/bench_transform.cpp), SetParent()
+    // is stubbed out until the model loader stops baking the node matrices into its primitives
+    friend struct bench::TransformHierarchy;
+
     glm::vec3 m_translation = glm::vec3(0.0f, 0.0f, 0.0f);
     glm::vec3 m_scale = glm::vec3(1.0f, 1.0f, 1.0f);
     glm::quat m_rotation = glm::identity<glm::quat>();
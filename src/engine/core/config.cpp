@@ -0,0 +1,90 @@
+#include "config.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+using namespace niji;
+
+static bool read_value(const std::string& arg, const std::string& option, std::string& value)
+{
+    const std::string prefix = option + "=";
+    if (arg.rfind(prefix, 0) != 0)
+        return false;
+
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+EngineConfig EngineConfig::from_args(int argc, char** argv)
+{
+    EngineConfig config = {};
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        std::string value = {};
+
+        if (read_value(arg, "--frames-in-flight", value))
+        {
+            const int frames = std::atoi(value.c_str());
+            config.FramesInFlight =
+                static_cast<uint32_t>(std::clamp(frames, 1, MAX_FRAMES_IN_FLIGHT));
+        }
+        else if (read_value(arg, "--present-mode", value))
+        {
+            if (value != "immediate" && value != "mailbox" && value != "fifo")
+                std::cout << "[Config] Unknown Present Mode: " << value << ", Using FIFO\n";
+            config.PresentMode = value;
+        }
+        else if (arg == "--low-latency")
+            config.LowLatency = true;
+        else if (arg == "--no-render-thread")
+            config.RenderThread = false;
+        else if (arg == "--headless")
+            config.Headless = true;
+        else if (read_value(arg, "--frames", value))
+            config.HeadlessFrames = static_cast<uint32_t>(std::max(std::atoi(value.c_str()), 1));
+        else if (read_value(arg, "--resolution", value))
+        {
+            uint32_t width = 0, height = 0;
+            if (sscanf(value.c_str(), "%ux%u", &width, &height) == 2 && width > 0 && height > 0)
+            {
+                config.Width = width;
+                config.Height = height;
+            }
+            else
+                std::cout << "[Config] Invalid Resolution: " << value << "\n";
+        }
+        else if (read_value(arg, "--output", value))
+            config.OutputDir = value;
+        else if (read_value(arg, "--camera", value))
+        {
+            glm::vec3 position = {};
+            float yaw = 0.0f, pitch = 0.0f;
+            if (sscanf(value.c_str(), "%f,%f,%f,%f,%f", &position.x, &position.y, &position.z,
+                       &yaw, &pitch) == 5)
+            {
+                config.OverrideCamera = true;
+                config.CameraPosition = position;
+                config.CameraYaw = yaw;
+                config.CameraPitch = pitch;
+            }
+            else
+                std::cout << "[Config] Invalid Camera: " << value << "\n";
+        }
+        else if (read_value(arg, "--benchmark", value))
+            config.Benchmark = value;
+        else if (read_value(arg, "--pipeline-cache", value))
+            config.PipelineCachePath = value;
+        else if (arg == "--no-pipeline-cache")
+            config.PipelineCachePath.clear();
+        else if (arg == "--no-pipeline-libraries")
+            config.PipelineLibraries = false;
+        else
+            std::cout << "[Config] Unknown Argument: " << arg << "\n";
+    }
+
+    return config;
+}
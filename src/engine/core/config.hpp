@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <glm/glm.hpp>
+
+namespace niji
+{
+
+// Settings picked per run on the command line, so deployments don't need a rebuild
+struct EngineConfig
+{
+    // Frames the CPU may record ahead of the GPU, clamped to [1, MAX_FRAMES_IN_FLIGHT]
+    uint32_t FramesInFlight = 2;
+    // "immediate", "mailbox" or "fifo", falls back to FIFO when the surface lacks it
+    std::string PresentMode = "immediate";
+    // Waits on the GPU before input gets polled instead of after, trading throughput for latency
+    bool LowLatency = false;
+    // Records and submits on a render thread while the main thread simulates the next frame.
+    // Headless and benchmark runs always render on the main thread.
+    bool RenderThread = true;
+
+    // Renders offscreen without a window, surface or editor and exits after HeadlessFrames
+    bool Headless = false;
+    uint32_t HeadlessFrames = 120;
+    // Offscreen resolution, headless only
+    uint32_t Width = WIN_WIDTH;
+    uint32_t Height = WIN_HEIGHT;
+    // Where a headless run writes its last frame and the frame times
+    std::string OutputDir = "headless";
+
+    // Fixed starting camera, so runs can be compared against each other
+    bool OverrideCamera = false;
+    glm::vec3 CameraPosition = glm::vec3(0.0f);
+    float CameraYaw = -90.0f;
+    float CameraPitch = 0.0f;
+
+    // Scenario out of assets/benchmarks.json to run, the report goes to OutputDir
+    std::string Benchmark = {};
+
+    // Pipeline cache file, loaded at startup and saved on shutdown. Empty keeps it in memory only
+    std::string PipelineCachePath = "pipeline_cache.bin";
+    // Graphics pipelines get linked from cached per-stage libraries instead of built in one go
+    bool PipelineLibraries = true;
+
+    // --frames-in-flight=<1-3> --present-mode=<immediate|mailbox|fifo> --low-latency
+    // --no-render-thread --headless --frames=<n> --resolution=<w>x<h> --output=<dir>
+    // --camera=<x>,<y>,<z>,<yaw>,<pitch> --benchmark=<scenario> --pipeline-cache=<file>
+    // --no-pipeline-cache --no-pipeline-libraries
+    static EngineConfig from_args(int argc, char** argv);
+};
+
+} // namespace niji
@@ -3,6 +3,7 @@
 #include <stdexcept>
 #include <iostream>
 #include <set>
+#include <cstring>
 
 #include <vk_mem_alloc.h>
 
@@ -47,22 +48,31 @@ static void DestroyDebugUtilsMessengerEXT(VkInstance instance,
 
 Context::Context()
 {
-    init_window();
+}
+
+void Context::init(const EngineConfig& config)
+{
+    m_headless = config.Headless;
+    m_headlessExtent = {config.Width, config.Height};
+
+    if (!m_headless)
+        init_window();
 
     create_instance();
     setup_debug_messenger();
-    create_surface();
+    if (!m_headless)
+        create_surface();
     pick_physical_device();
     create_logical_device();
     create_command_pool();
 
     load_vulkan_function_pointers(m_device);
 
+    m_pipelineCache.init(m_device, m_physicalDevice, config.PipelineCachePath);
+    m_pipelineLibrary.init(m_device, m_physicalDevice, config.PipelineLibraries);
+
     init_allocator();
-}
 
-void Context::init()
-{
     // Init Global Sampler
     {
         SamplerDesc desc = {};
@@ -99,6 +109,10 @@ void Context::cleanup()
 
     vkDestroyCommandPool(m_device, m_commandPool, nullptr);
 
+    // Its optimized links go through the cache
+    m_pipelineLibrary.cleanup();
+    m_pipelineCache.cleanup();
+
 #if DEBUG_ALLOCATIONS
     char* statsString = nullptr;
     vmaBuildStatsString(m_allocator, &statsString, VK_TRUE);
@@ -113,11 +127,15 @@ void Context::cleanup()
     if (ENABLE_VALIDATION_LAYERS)
         DestroyDebugUtilsMessengerEXT(m_instance, m_debugMessenger, nullptr);
 
-    vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+    if (m_surface != VK_NULL_HANDLE)
+        vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
     vkDestroyInstance(m_instance, nullptr);
 
-    glfwDestroyWindow(m_window);
-    glfwTerminate();
+    if (m_window)
+    {
+        glfwDestroyWindow(m_window);
+        glfwTerminate();
+    }
 }
 
 void Context::framebuffer_resize_callback(GLFWwindow* window, int width, int height)
@@ -128,6 +146,13 @@ void Context::framebuffer_resize_callback(GLFWwindow* window, int width, int hei
 
 void Context::get_window_size(int& width, int& height)
 {
+    if (m_headless)
+    {
+        width = static_cast<int>(m_headlessExtent.width);
+        height = static_cast<int>(m_headlessExtent.height);
+        return;
+    }
+
     glfwGetWindowSize(m_window, &width, &height);
 }
 
@@ -245,11 +270,15 @@ bool Context::check_validation_layer_support()
 
 std::vector<const char*> Context::get_required_extensions()
 {
-    uint32_t glfwExtCount = 0;
-    const char** glfwExt;
-    glfwExt = glfwGetRequiredInstanceExtensions(&glfwExtCount);
-
-    std::vector<const char*> extensions(glfwExt, glfwExt + glfwExtCount);
+    std::vector<const char*> extensions = {};
+    // Surface extensions, a headless run never presents
+    if (!m_headless)
+    {
+        uint32_t glfwExtCount = 0;
+        const char** glfwExt;
+        glfwExt = glfwGetRequiredInstanceExtensions(&glfwExtCount);
+        extensions.assign(glfwExt, glfwExt + glfwExtCount);
+    }
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
     return extensions;
@@ -343,8 +372,8 @@ bool Context::is_device_suitable(VkPhysicalDevice device)
     QueueFamilyIndices indices = QueueFamilyIndices::find_queue_families(device, m_surface);
 
     bool extensionsSupported = check_device_extension_support(device);
-    bool swapChainAdequate = false;
-    if (extensionsSupported)
+    bool swapChainAdequate = m_headless;
+    if (extensionsSupported && !m_headless)
     {
         SwapChainSupportDetails swapChainSupport =
             SwapChainSupportDetails::query_swap_chain_support(device, m_surface);
@@ -367,6 +396,8 @@ void Context::create_logical_device()
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = {indices.GraphicsFamily.value(),
                                               indices.PresentFamily.value()};
+    if (indices.ComputeFamily.has_value())
+        uniqueQueueFamilies.insert(indices.ComputeFamily.value());
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -382,17 +413,32 @@ void Context::create_logical_device()
     VkPhysicalDeviceFeatures deviceFeatures = {};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
     deviceFeatures.fillModeNonSolid = VK_TRUE;
+    deviceFeatures.multiDrawIndirect = VK_TRUE;
+    deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
 
-    VkPhysicalDeviceBufferDeviceAddressFeatures bufferDeviceAddressFeatures = {};
-    bufferDeviceAddressFeatures.sType =
-        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
-    bufferDeviceAddressFeatures.bufferDeviceAddress = VK_TRUE;
+    // Optional, only used by the GPU profiler (inherited so parallel recorded passes count too)
+    VkPhysicalDeviceFeatures supportedFeatures = {};
+    vkGetPhysicalDeviceFeatures(m_physicalDevice, &supportedFeatures);
+    m_pipelineStatistics =
+        supportedFeatures.pipelineStatisticsQuery && supportedFeatures.inheritedQueries;
+    deviceFeatures.pipelineStatisticsQuery = m_pipelineStatistics ? VK_TRUE : VK_FALSE;
+    deviceFeatures.inheritedQueries = m_pipelineStatistics ? VK_TRUE : VK_FALSE;
+
+    // Vulkan 1.2 features (BDA + GPU-driven indirect draws)
+    VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan12Features.bufferDeviceAddress = VK_TRUE;
+    vulkan12Features.drawIndirectCount = VK_TRUE;
+    // Frame pacing
+    vulkan12Features.timelineSemaphore = VK_TRUE;
+    // GPU profiler queries get reset from the host once they are read back
+    vulkan12Features.hostQueryReset = VK_TRUE;
 
     VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeature = {};
     dynamicRenderingFeature.sType =
         VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
     dynamicRenderingFeature.dynamicRendering = VK_TRUE;
-    dynamicRenderingFeature.pNext = &bufferDeviceAddressFeatures;
+    dynamicRenderingFeature.pNext = &vulkan12Features;
 
     // Add synchronization2 features
     VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Feature = {};
@@ -408,18 +454,51 @@ void Context::create_logical_device()
 
     // Chain the pNext pointers properly
     synchronization2Feature.pNext = &dynamicRenderingFeature;
-    dynamicRenderingFeature.pNext = &bufferDeviceAddressFeatures;
-    bufferDeviceAddressFeatures.pNext = &graphicsPipelineLib;
+    dynamicRenderingFeature.pNext = &vulkan12Features;
+    vulkan12Features.pNext = &graphicsPipelineLib;
     graphicsPipelineLib.pNext = nullptr; // end of chain
 
+    // Optional, lets pipelines report their shader statistics (registers, instructions, ...)
+    VkPhysicalDevicePipelineExecutablePropertiesFeaturesKHR executableInfo = {};
+    executableInfo.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PIPELINE_EXECUTABLE_PROPERTIES_FEATURES_KHR;
+    {
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount,
+                                             availableExtensions.data());
+
+        for (const auto& extension : availableExtensions)
+        {
+            if (strcmp(extension.extensionName,
+                       VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME) == 0)
+            {
+                VkPhysicalDeviceFeatures2 features = {};
+                features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+                features.pNext = &executableInfo;
+                vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features);
+                m_pipelineExecutableInfo = executableInfo.pipelineExecutableInfo == VK_TRUE;
+            }
+        }
+    }
+
+    std::vector<const char*> extensions = get_device_extensions();
+    if (m_pipelineExecutableInfo)
+    {
+        extensions.push_back(VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME);
+        executableInfo.pNext = nullptr;
+        graphicsPipelineLib.pNext = &executableInfo;
+    }
+
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     createInfo.pNext = &synchronization2Feature;
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
     createInfo.pEnabledFeatures = &deviceFeatures;
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(DEVICE_EXTENSIONS.size());
-    createInfo.ppEnabledExtensionNames = DEVICE_EXTENSIONS.data();
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
     if (ENABLE_VALIDATION_LAYERS)
     {
         createInfo.enabledLayerCount = static_cast<uint32_t>(VALIDATION_LAYERS.size());
@@ -433,6 +512,13 @@ void Context::create_logical_device()
 
     vkGetDeviceQueue(m_device, indices.GraphicsFamily.value(), 0, &m_graphicsQueue);
     vkGetDeviceQueue(m_device, indices.PresentFamily.value(), 0, &m_presentQueue);
+
+    m_graphicsFamily = indices.GraphicsFamily.value();
+    if (indices.ComputeFamily.has_value())
+    {
+        m_computeFamily = indices.ComputeFamily.value();
+        vkGetDeviceQueue(m_device, m_computeFamily, 0, &m_computeQueue);
+    }
 }
 
 bool Context::check_device_extension_support(VkPhysicalDevice device)
@@ -443,7 +529,8 @@ bool Context::check_device_extension_support(VkPhysicalDevice device)
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount,
                                          availableExtensions.data());
 
-    std::set<std::string> requiredExtensions(DEVICE_EXTENSIONS.begin(), DEVICE_EXTENSIONS.end());
+    const std::vector<const char*> extensions = get_device_extensions();
+    std::set<std::string> requiredExtensions(extensions.begin(), extensions.end());
 
     for (const auto& extension : availableExtensions)
     {
@@ -453,6 +540,18 @@ bool Context::check_device_extension_support(VkPhysicalDevice device)
     return requiredExtensions.empty();
 }
 
+std::vector<const char*> Context::get_device_extensions() const
+{
+    std::vector<const char*> extensions = {};
+    for (const char* extension : DEVICE_EXTENSIONS)
+    {
+        if (m_headless && strcmp(extension, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0)
+            continue;
+        extensions.push_back(extension);
+    }
+    return extensions;
+}
+
 void Context::create_command_pool()
 {
     QueueFamilyIndices queueFamilyIndices =
@@ -549,7 +648,8 @@ void Context::end_single_time_commands(VkCommandBuffer commandBuffer) const
 }
 
 void Context::create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage,
-                            VkBuffer& buffer, VmaAllocation& allocation, bool persistent) const
+                            VkBuffer& buffer, VmaAllocation& allocation, bool persistent,
+                            bool sharedQueues) const
 {
     VkBufferCreateInfo bufferInfo = {};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -557,6 +657,16 @@ void Context::create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaMemo
     bufferInfo.usage = usage;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    // Only resources the async compute queue touches as well, concurrent sharing saves the
+    // ownership transfers between the queues
+    const uint32_t queueFamilies[] = {m_graphicsFamily, m_computeFamily};
+    if (sharedQueues && has_async_compute())
+    {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = 2;
+        bufferInfo.pQueueFamilyIndices = queueFamilies;
+    }
+
     VmaAllocationCreateInfo allocInfo = {};
     allocInfo.usage = memoryUsage;
     if (persistent)
@@ -567,13 +677,14 @@ void Context::create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaMemo
         throw std::runtime_error("Failed to Create Buffer with VMA!");
 }
 
-void Context::copy_buffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+void Context::copy_buffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size,
+                          VkDeviceSize srcOffset, VkDeviceSize dstOffset)
 {
     VkCommandBuffer commandBuffer = begin_single_time_commands();
 
     VkBufferCopy copyRegion = {};
-    copyRegion.srcOffset = 0;
-    copyRegion.dstOffset = 0;
+    copyRegion.srcOffset = srcOffset;
+    copyRegion.dstOffset = dstOffset;
     copyRegion.size = size;
     vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
@@ -590,8 +701,8 @@ void Context::create_texture_image_view(Texture& texture)
 void Context::create_image(uint32_t width, uint32_t height, uint32_t mipLevels,
                            uint32_t arrayLayers, VkFormat format, VkImageTiling tiling,
                            VkImageUsageFlags usage, VmaMemoryUsage memoryUsage,
-                           VkImageCreateFlags flags, VkImage& image,
-                           VmaAllocation& allocation) const
+                           VkImageCreateFlags flags, VkImage& image, VmaAllocation& allocation,
+                           bool sharedQueues) const
 {
     VkImageCreateInfo imageInfo = {};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -607,6 +718,16 @@ void Context::create_image(uint32_t width, uint32_t height, uint32_t mipLevels,
     imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     imageInfo.flags = flags;
 
+    // Concurrent images can lose their compression, everything the graphics queue keeps to itself
+    // stays exclusive
+    const uint32_t queueFamilies[] = {m_graphicsFamily, m_computeFamily};
+    if (sharedQueues && has_async_compute())
+    {
+        imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        imageInfo.queueFamilyIndexCount = 2;
+        imageInfo.pQueueFamilyIndices = queueFamilies;
+    }
+
     VmaAllocationCreateInfo allocInfo = {};
     allocInfo.usage = memoryUsage;
 
@@ -900,7 +1021,10 @@ QueueFamilyIndices QueueFamilyIndices::find_queue_families(VkPhysicalDevice devi
     for (const auto& queueFamily : queueFamilies)
     {
         VkBool32 presentSupport = {};
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+        if (surface != VK_NULL_HANDLE)
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+        else // Headless, nothing gets presented so the graphics queue stands in
+            presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) ? VK_TRUE : VK_FALSE;
 
         if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
             indices.GraphicsFamily = i;
@@ -914,5 +1038,16 @@ QueueFamilyIndices QueueFamilyIndices::find_queue_families(VkPhysicalDevice devi
         i++;
     }
 
+    // Looked for separately, the loop above stops as soon as graphics and present are found
+    for (uint32_t family = 0; family < queueFamilyCount; family++)
+    {
+        const VkQueueFlags flags = queueFamilies[family].queueFlags;
+        if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT))
+        {
+            indices.ComputeFamily = family;
+            break;
+        }
+    }
+
     return indices;
 }
@@ -3,6 +3,9 @@
 #include <optional>
 
 #include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/pipeline_cache.hpp"
+#include "core/pipeline_library.hpp"
 
 class GLFWwindow;
 
@@ -24,6 +27,8 @@ struct QueueFamilyIndices
 {
     std::optional<uint32_t> GraphicsFamily = {};
     std::optional<uint32_t> PresentFamily = {};
+    // Compute family without graphics support, for async compute
+    std::optional<uint32_t> ComputeFamily = {};
 
     bool is_complete() const
     {
@@ -55,10 +60,16 @@ class Context
     friend class SkyboxPass;
     friend class LightCullingPass;
     friend class RenderTarget;
+    friend class GeometryPool;
+    friend class DrawCullingPass;
+    friend class ParallelCommandRecorder;
+    friend class RenderGraph;
+    friend class GpuProfiler;
 
   public:
     Context();
-    void init();
+    // Creates the window (unless headless), instance and device
+    void init(const EngineConfig& config);
 
     void init_window();
 
@@ -68,6 +79,33 @@ class Context
 
     void get_window_size(int& width, int& height);
 
+    bool has_async_compute() const
+    {
+        return m_computeQueue != VK_NULL_HANDLE;
+    }
+    bool has_pipeline_statistics() const
+    {
+        return m_pipelineStatistics;
+    }
+    // VK_KHR_pipeline_executable_properties, pipelines get created with their statistics captured
+    bool has_pipeline_executable_info() const
+    {
+        return m_pipelineExecutableInfo;
+    }
+    PipelineCache& get_pipeline_cache()
+    {
+        return m_pipelineCache;
+    }
+    PipelineLibrary& get_pipeline_library()
+    {
+        return m_pipelineLibrary;
+    }
+    // No window, surface or swapchain, everything renders offscreen
+    bool is_headless() const
+    {
+        return m_headless;
+    }
+
   private:
     void init_allocator();
     void create_instance();
@@ -86,6 +124,8 @@ class Context
     bool is_device_suitable(VkPhysicalDevice device);
     void create_logical_device();
     bool check_device_extension_support(VkPhysicalDevice device);
+    // DEVICE_EXTENSIONS without the swapchain one when headless
+    std::vector<const char*> get_device_extensions() const;
 
     void create_command_pool();
 
@@ -101,15 +141,17 @@ class Context
     void end_single_time_commands(VkCommandBuffer commandBuffer) const;
 
     void create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage,
-                       VkBuffer& buffer, VmaAllocation& allocation, bool persistent = false) const;
+                       VkBuffer& buffer, VmaAllocation& allocation, bool persistent = false,
+                       bool sharedQueues = false) const;
 
-    void copy_buffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+    void copy_buffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size,
+                     VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
 
     void create_texture_image_view(Texture& texture);
     void create_image(uint32_t width, uint32_t height, uint32_t mipLevels, uint32_t arrayLayers,
                       VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
                       VmaMemoryUsage memoryUsage, VkImageCreateFlags flags, VkImage& image,
-                      VmaAllocation& allocation) const;
+                      VmaAllocation& allocation, bool sharedQueues = false) const;
     VkImageView create_image_view(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags,
                                   uint32_t mipLevels, uint32_t layerCount) const;
     void transition_image_layout(VkImage image, VkFormat format, VkImageLayout oldLayout,
@@ -122,6 +164,8 @@ class Context
   private:
     GLFWwindow* m_window = nullptr;
     bool m_framebufferResized = false;
+    bool m_headless = false;
+    VkExtent2D m_headlessExtent = {};
     VkInstance m_instance = {};
     VkDebugUtilsMessengerEXT m_debugMessenger = {};
 
@@ -133,8 +177,16 @@ class Context
     VkDevice m_device = {};
     VkQueue m_graphicsQueue = {};
     VkQueue m_presentQueue = {};
+    // Only set when the device has a dedicated compute family
+    VkQueue m_computeQueue = VK_NULL_HANDLE;
+    uint32_t m_graphicsFamily = 0;
+    uint32_t m_computeFamily = UINT32_MAX;
+    bool m_pipelineStatistics = false;
+    bool m_pipelineExecutableInfo = false;
     VkCommandPool m_commandPool = {};
 
     Sampler m_globalSampler = {};
+    PipelineCache m_pipelineCache = {};
+    PipelineLibrary m_pipelineLibrary = {};
 };
 } // namespace niji
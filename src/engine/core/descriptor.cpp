@@ -266,14 +266,21 @@ Descriptor::Descriptor(DescriptorInfo& info) : m_info(info)
     }
 }
 
-void Descriptor::push_descriptor_writes(std::vector<VkWriteDescriptorSet>& writes,
-                                        std::vector<VkDescriptorBufferInfo>& bufferInfos,
-                                        std::vector<VkDescriptorImageInfo>& imageInfos)
+void Descriptor::push_descriptor_writes(FrameVector<VkWriteDescriptorSet>& writes,
+                                        FrameVector<VkDescriptorBufferInfo>& bufferInfos,
+                                        FrameVector<VkDescriptorImageInfo>& imageInfos)
 {
+    build_descriptor_writes(m_info.Bindings, writes, bufferInfos, imageInfos);
+}
 
-    for (int i = 0; i < m_info.Bindings.size(); ++i)
+void Descriptor::build_descriptor_writes(const std::vector<DescriptorBinding>& bindings,
+                                         FrameVector<VkWriteDescriptorSet>& writes,
+                                         FrameVector<VkDescriptorBufferInfo>& bufferInfos,
+                                         FrameVector<VkDescriptorImageInfo>& imageInfos)
+{
+    for (int i = 0; i < bindings.size(); ++i)
     {
-        const auto& binding = m_info.Bindings[i];
+        const auto& binding = bindings[i];
         VkWriteDescriptorSet write = {};
         write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         write.dstBinding = i;
@@ -364,8 +371,90 @@ void Descriptor::push_descriptor_writes(std::vector<VkWriteDescriptorSet>& write
     }
 }
 
+VkDescriptorUpdateTemplate Descriptor::create_update_template(VkPipelineBindPoint bindPoint,
+                                                              VkPipelineLayout layout,
+                                                              uint32_t set,
+                                                              const std::vector<uint32_t>& bindings)
+{
+    if (!m_info.IsPushDescriptor)
+        throw std::runtime_error("Update Templates are only Used for Push Descriptors!");
+
+    std::vector<uint32_t> covered = bindings;
+    if (covered.empty())
+    {
+        for (uint32_t i = 0; i < m_info.Bindings.size(); i++)
+            covered.push_back(i);
+    }
+
+    std::vector<VkDescriptorUpdateTemplateEntry> entries = {};
+    entries.reserve(covered.size());
+    for (uint32_t bindingIndex : covered)
+    {
+        const DescriptorBinding& binding = m_info.Bindings.at(bindingIndex);
+        // Every binding owns exactly one slot of DescriptorUpdateData
+        if (bindingIndex >= MAX_TEMPLATE_BINDINGS || binding.Count != 1)
+            throw std::runtime_error("Descriptor Binding doesn't fit an Update Template!");
+
+        VkDescriptorUpdateTemplateEntry entry = {};
+        entry.dstBinding = bindingIndex;
+        entry.dstArrayElement = 0;
+        entry.descriptorCount = 1;
+        entry.offset = bindingIndex * sizeof(DescriptorUpdateEntry);
+        entry.stride = sizeof(DescriptorUpdateEntry);
+
+        switch (binding.Type)
+        {
+        case DescriptorBinding::BindType::UBO:
+            entry.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            break;
+        case DescriptorBinding::BindType::SAMPLER:
+            entry.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+            break;
+        case DescriptorBinding::BindType::TEXTURE:
+            entry.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            break;
+        case DescriptorBinding::BindType::STORAGE_BUFFER:
+            entry.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            break;
+        case DescriptorBinding::BindType::STORAGE_TEXTURE:
+            entry.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            break;
+        default:
+            throw std::runtime_error("Invalid Descriptor Binding Type!");
+            break;
+        }
+        entries.push_back(entry);
+    }
+
+    VkDescriptorUpdateTemplateCreateInfo templateInfo = {};
+    templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+    templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+    templateInfo.pDescriptorUpdateEntries = entries.data();
+    templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR;
+    templateInfo.descriptorSetLayout = m_setLayout;
+    templateInfo.pipelineBindPoint = bindPoint;
+    templateInfo.pipelineLayout = layout;
+    templateInfo.set = set;
+
+    VkDescriptorUpdateTemplate updateTemplate = VK_NULL_HANDLE;
+    if (vkCreateDescriptorUpdateTemplate(nijiEngine.m_context.m_device, &templateInfo, nullptr,
+                                         &updateTemplate) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create descriptor update template.");
+    }
+
+    std::string templateName = std::string(m_info.Name) + " Update Template";
+    SetObjectName(nijiEngine.m_context.m_device, VK_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE,
+                  updateTemplate, templateName.c_str());
+
+    m_updateTemplates.push_back(updateTemplate);
+    return updateTemplate;
+}
+
 void Descriptor::cleanup() const
 {
+    for (VkDescriptorUpdateTemplate updateTemplate : m_updateTemplates)
+        vkDestroyDescriptorUpdateTemplate(nijiEngine.m_context.m_device, updateTemplate, nullptr);
     vkDestroyDescriptorSetLayout(nijiEngine.m_context.m_device, m_setLayout, nullptr);
     vkDestroyDescriptorPool(nijiEngine.m_context.m_device, m_pool, nullptr);
 }
@@ -5,6 +5,7 @@
 
 #include "commandlist.hpp"
 #include "common.hpp"
+#include "frame_arena.hpp"
 
 namespace niji
 {
@@ -40,6 +41,38 @@ struct DescriptorBinding
     DescriptorResource Resource = {};
 };
 
+// Bindings an update template can cover, DescriptorUpdateData has a slot for each
+constexpr uint32_t MAX_TEMPLATE_BINDINGS = 24;
+
+// One descriptor as an update template reads it, at the slot of its binding
+union DescriptorUpdateEntry
+{
+    VkDescriptorBufferInfo BufferInfo;
+    VkDescriptorImageInfo ImageInfo;
+};
+
+// Plain data pushed through a Descriptor's update template, no allocations and no variant
+// lookups. Bindings the template doesn't cover are ignored.
+struct DescriptorUpdateData
+{
+    std::array<DescriptorUpdateEntry, MAX_TEMPLATE_BINDINGS> Entries = {};
+
+    void set_buffer(uint32_t binding, const Buffer& buffer)
+    {
+        Entries[binding].BufferInfo = {buffer.Handle, 0, buffer.Desc.Size};
+    }
+    void set_sampler(uint32_t binding, const Sampler& sampler)
+    {
+        Entries[binding].ImageInfo = {sampler.Handle, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED};
+    }
+    // Sampled and storage images alike, the layout is the texture's own
+    void set_texture(uint32_t binding, const Texture& texture)
+    {
+        Entries[binding].ImageInfo = {VK_NULL_HANDLE, texture.ImageInfo.imageView,
+                                      texture.ImageInfo.imageLayout};
+    }
+};
+
 struct DescriptorInfo
 {
     std::vector<DescriptorBinding> Bindings = {};
@@ -53,9 +86,23 @@ class Descriptor
     Descriptor() = default;
     Descriptor(DescriptorInfo& info);
 
-    void push_descriptor_writes(std::vector<VkWriteDescriptorSet>& writes,
-                                std::vector<VkDescriptorBufferInfo>& bufferInfos,
-                                std::vector<VkDescriptorImageInfo>& imageInfos);
+    // Frame temporaries, the writes point into the info vectors
+    void push_descriptor_writes(FrameVector<VkWriteDescriptorSet>& writes,
+                                FrameVector<VkDescriptorBufferInfo>& bufferInfos,
+                                FrameVector<VkDescriptorImageInfo>& imageInfos);
+    // Same as above, but for a copy of the bindings (so passes can fill them from several threads)
+    static void build_descriptor_writes(const std::vector<DescriptorBinding>& bindings,
+                                        FrameVector<VkWriteDescriptorSet>& writes,
+                                        FrameVector<VkDescriptorBufferInfo>& bufferInfos,
+                                        FrameVector<VkDescriptorImageInfo>& imageInfos);
+
+    // Push descriptors only. Template pushing `bindings` (all of them when empty) from a
+    // DescriptorUpdateData. Push templates are tied to a pipeline layout, so this waits until the
+    // pass' pipelines exist. The template stays valid for every layout defined the same way
+    // (hot reloads, variants), it gets destroyed together with the descriptor.
+    VkDescriptorUpdateTemplate create_update_template(VkPipelineBindPoint bindPoint,
+                                                      VkPipelineLayout layout, uint32_t set,
+                                                      const std::vector<uint32_t>& bindings = {});
 
     void cleanup() const;
 
@@ -71,5 +118,6 @@ class Descriptor
     friend class DepthPass;
 
     DescriptorInfo m_info = {};
+    std::vector<VkDescriptorUpdateTemplate> m_updateTemplates = {};
 };
 } // namespace niji
\ No newline at end of file
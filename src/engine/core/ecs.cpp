@@ -1,7 +1,40 @@
 #include "ecs.hpp"
 
+#include <algorithm>
+#include <typeinfo>
+
+#include <imgui.h>
+
+#include "engine.hpp"
+
 using namespace niji;
 
+void EntityCommands::apply(ECS& ecs)
+{
+    for (auto& command : m_commands)
+        command(ecs);
+    m_commands.clear();
+}
+
+static bool intersects(const std::vector<entt::id_type>& a, const std::vector<entt::id_type>& b)
+{
+    for (entt::id_type id : a)
+    {
+        if (std::find(b.begin(), b.end(), id) != b.end())
+            return true;
+    }
+    return false;
+}
+
+bool SystemAccess::conflicts_with(const SystemAccess& other) const
+{
+    if (!Declared || !other.Declared)
+        return true;
+
+    return intersects(Writes, other.Writes) || intersects(Writes, other.Reads) ||
+           intersects(Reads, other.Writes);
+}
+
 ECS::ECS() = default;
 ECS::~ECS()
 {
@@ -19,24 +52,125 @@ void ECS::destroy_entity(Entity entity)
     m_registry.emplace_or_replace<Delete>(entity);
 }
 
+void ECS::systems_begin_frame()
+{
+    for (auto& s : m_systems)
+        s->begin_frame();
+}
+
+std::vector<std::vector<System*>> ECS::build_waves(const std::vector<System*>& systems)
+{
+    std::vector<std::vector<System*>> waves = {};
+
+    std::vector<uint32_t> systemWaves(systems.size(), 0);
+    for (size_t i = 0; i < systems.size(); i++)
+    {
+        uint32_t wave = 0;
+        for (size_t j = 0; j < i; j++)
+        {
+            if (systems[i]->m_access.conflicts_with(systems[j]->m_access))
+                wave = std::max(wave, systemWaves[j] + 1);
+        }
+        systemWaves[i] = wave;
+
+        if (wave >= waves.size())
+            waves.resize(wave + 1);
+        waves[wave].push_back(systems[i]);
+    }
+    return waves;
+}
+
+void ECS::build_schedule()
+{
+    std::vector<System*> systems = {};
+    systems.reserve(m_systems.size());
+    for (auto& s : m_systems)
+        systems.push_back(s.get());
+
+    m_waves = build_waves(systems);
+    m_scheduleDirty = false;
+}
+
 void ECS::systems_update(const float dt)
 {
+    NIJI_PROFILE_FUNCTION();
+
+    if (m_scheduleDirty)
+        build_schedule();
+
+    JobSystem& jobs = nijiEngine.m_jobSystem;
+    for (const std::vector<System*>& wave : m_waves)
+    {
+        if (wave.size() == 1)
+        {
+            wave[0]->update(dt);
+            continue;
+        }
+
+        JobCounter counter = {};
+        for (System* system : wave)
+        {
+            if (!system->m_access.MainThread)
+                jobs.run([system, dt]() { system->update(dt); }, &counter);
+        }
+        // The main thread ones meanwhile, then help out with the rest
+        for (System* system : wave)
+        {
+            if (system->m_access.MainThread)
+                system->update(dt);
+        }
+        jobs.wait(counter);
+    }
+
+    // Registration order, so the result doesn't depend on which system finished first
     for (auto& s : m_systems)
-        s->update(dt);
+        s->m_commands.apply(*this);
 }
 
 void ECS::systems_render()
 {
+    NIJI_PROFILE_FUNCTION();
     for (auto& s : m_systems)
         s->render();
 }
 
+void ECS::systems_end_frames()
+{
+    for (auto& s : m_systems)
+        s->end_frames();
+}
+
 void ECS::systems_cleanup()
 {
     for (auto& s : m_systems)
         s->cleanup();
 }
 
+void ECS::scheduler_panel()
+{
+    if (m_scheduleDirty)
+        build_schedule();
+
+    ImGui::Text("Systems: %zu in %zu waves", m_systems.size(), m_waves.size());
+    for (size_t i = 0; i < m_waves.size(); i++)
+    {
+        if (!ImGui::TreeNode(reinterpret_cast<void*>(i), "Wave %zu", i))
+            continue;
+
+        for (System* system : m_waves[i])
+        {
+            const SystemAccess& access = system->m_access;
+            if (access.Declared)
+                ImGui::Text("%s: %zu reads, %zu writes, %s", typeid(*system).name(),
+                            access.Reads.size(), access.Writes.size(),
+                            access.MainThread ? "main thread" : "job threads");
+            else
+                ImGui::Text("%s: undeclared, runs alone", typeid(*system).name());
+        }
+        ImGui::TreePop();
+    }
+}
+
 void ECS::remove_deleted()
 {
     bool queueEmpty = false;
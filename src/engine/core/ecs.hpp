@@ -1,5 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
 #include <entt/entity/registry.hpp>
 
 // Reference: https://github.com/mxcop/rogue-like/blob/main/src/wyre/core/ecs.h
@@ -10,12 +16,79 @@ namespace niji
 using Entity = entt::entity;
 inline constexpr entt::null_t null{};
 
+class ECS;
+
+// Structural changes (entities, components being added / removed) recorded while systems update,
+// possibly on job threads. They get applied on the main thread once every system updated.
+class EntityCommands
+{
+  public:
+    // `setup(ecs, entity)` runs on the new entity when the commands get applied
+    template <typename Function>
+    void create_entity(Function&& setup)
+    {
+        m_commands.emplace_back([setup = std::forward<Function>(setup)](auto& ecs) mutable {
+            setup(ecs, ecs.create_entity());
+        });
+    }
+
+    void destroy_entity(Entity entity)
+    {
+        m_commands.emplace_back([entity](auto& ecs) { ecs.destroy_entity(entity); });
+    }
+
+    template <typename T>
+    void add_component(Entity entity, T component)
+    {
+        m_commands.emplace_back([entity, component = std::move(component)](auto& ecs) mutable {
+            ecs.m_registry.template emplace_or_replace<T>(entity, std::move(component));
+        });
+    }
+
+    template <typename T>
+    void remove_component(Entity entity)
+    {
+        m_commands.emplace_back(
+            [entity](auto& ecs) { ecs.m_registry.template remove<T>(entity); });
+    }
+
+    bool empty() const
+    {
+        return m_commands.empty();
+    }
+
+    // Main thread, in recording order
+    void apply(ECS& ecs);
+
+  private:
+    std::vector<std::function<void(ECS&)>> m_commands = {};
+};
+
+// Which components a system's update() touches, see System::reads() / System::writes()
+struct SystemAccess
+{
+    std::vector<entt::id_type> Reads = {};
+    std::vector<entt::id_type> Writes = {};
+    // Nothing declared, the system might touch anything and runs on its own
+    bool Declared = false;
+    // Window input, ImGui, Vulkan submission... update() stays on the main thread
+    bool MainThread = true;
+
+    bool conflicts_with(const SystemAccess& other) const;
+};
+
 // ECS System Class
 class System
 {
   public:
     virtual ~System() = default;
 
+    // Called at the start of a frame, before input gets polled
+    virtual void begin_frame()
+    {
+        // ...
+    }
+
     virtual void update(const float dt)
     {
         // ...
@@ -26,10 +99,52 @@ class System
         // ...
     }
 
+    // Called once the main loop exits, before the device goes idle and cleanup() runs
+    virtual void end_frames()
+    {
+        // ...
+    }
+
     virtual void cleanup()
     {
 
     }
+
+    const SystemAccess& get_access() const
+    {
+        return m_access;
+    }
+
+  protected:
+    // Declared in the constructor, components or other shared state by its type (niji::Camera).
+    // Systems without conflicting access update in parallel, the ones that conflict keep their
+    // registration order.
+    template <typename... T>
+    void reads()
+    {
+        (m_access.Reads.push_back(entt::type_hash<T>::value()), ...);
+        m_access.Declared = true;
+    }
+    template <typename... T>
+    void writes()
+    {
+        (m_access.Writes.push_back(entt::type_hash<T>::value()), ...);
+        m_access.Declared = true;
+    }
+    // update() only touches its declared components and its own members, so it may run on a job
+    // thread
+    void update_on_job_threads()
+    {
+        m_access.MainThread = false;
+    }
+
+    // Entity changes made during update(), go through these instead of the registry
+    EntityCommands m_commands = {};
+
+  private:
+    friend class ECS;
+
+    SystemAccess m_access = {};
 };
 
 // EnTT Wrapper for Entities, Components and Systems
@@ -96,7 +211,16 @@ class ECS
     T& register_system(Args&&... args)
     {
         T* system = new T(std::forward<Args>(args)...);
-        m_systems.push_back(std::unique_ptr<System>(reinterpret_cast<System*>(system)));
+        m_systems.push_back(std::unique_ptr<System>(static_cast<System*>(system)));
+
+        // The first one registered is the one find_system() returns
+        const size_t typeId = get_system_type_id<T>();
+        if (typeId >= m_systemsByType.size())
+            m_systemsByType.resize(typeId + 1, nullptr);
+        if (!m_systemsByType[typeId])
+            m_systemsByType[typeId] = system;
+
+        m_scheduleDirty = true;
         return *system;
     }
 
@@ -104,6 +228,12 @@ class ECS
     template <typename T>
     T& find_system()
     {
+        // Registered under its own type, no scan
+        const size_t typeId = get_system_type_id<T>();
+        if (typeId < m_systemsByType.size() && m_systemsByType[typeId])
+            return *static_cast<T*>(m_systemsByType[typeId]);
+
+        // Looked up through a base class
         for (auto& s : m_systems)
         {
             T* found = dynamic_cast<T*>(s.get());
@@ -111,6 +241,7 @@ class ECS
                 return *found;
         }
         assert(false && "No system of given type could be found!");
+        throw std::runtime_error("No system of given type could be found!");
     }
 
     // Find all systems of given type
@@ -126,15 +257,59 @@ class ECS
         return findings;
     }
 
+    void scheduler_panel();
+
+    // Entities whose Transform changed after they got created, the renderer only extracts these
+    // (and their children) again. Systems that declared writes<Transform>() call it, the scheduler
+    // never runs two of those at once.
+    void mark_moved(Entity entity)
+    {
+        m_movedEntities.push_back(entity);
+    }
+    // Main thread, hands over what got marked since the last call. `moved` is cleared and swapped
+    // in, so both vectors keep their capacity.
+    void take_moved(std::vector<Entity>& moved)
+    {
+        moved.clear();
+        moved.swap(m_movedEntities);
+    }
+
+    // Every system lands one wave after the last earlier registered system it conflicts with
+    static std::vector<std::vector<System*>> build_waves(const std::vector<System*>& systems);
+
   private:
     struct Delete{};
 
+    static size_t next_system_type_id()
+    {
+        static std::atomic<size_t> next{0};
+        return next++;
+    }
+    template <typename T>
+    static size_t get_system_type_id()
+    {
+        static const size_t id = next_system_type_id();
+        return id;
+    }
+
+    void systems_begin_frame();
+    // Wave by wave, the systems of a wave don't conflict with each other
     void systems_update(const float dt);
     void systems_render();
+    void systems_end_frames();
     void systems_cleanup();
 
+    void build_schedule();
+
     void remove_deleted();
     std::vector<std::unique_ptr<System>> m_systems = {};
+    // Indexed by get_system_type_id()
+    std::vector<System*> m_systemsByType = {};
+
+    std::vector<std::vector<System*>> m_waves = {};
+    bool m_scheduleDirty = true;
+
+    std::vector<Entity> m_movedEntities = {};
 };
 
 } // namespace niji
\ No newline at end of file
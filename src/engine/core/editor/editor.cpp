@@ -5,6 +5,7 @@
 #include "rendering/passes/render_pass.hpp"
 #include "rendering/renderer.hpp"
 #include "core/common.hpp"
+#include "core/frame_arena.hpp"
 #include "engine.hpp"
 
 using namespace niji;
@@ -62,14 +63,14 @@ void Editor::render(Renderer& renderer)
         auto& passes = renderer.m_renderPasses;
 
         // Get All Shaders
-        std::vector<std::shared_ptr<Shader>> shaders = {};
+        FrameVector<const Shader*> shaders = {};
         for (const auto& pass : passes)
         {
             if (pass->m_vertFrag.Type != ShaderType::NONE)
-                shaders.push_back(std::make_shared<Shader>(pass->m_vertFrag));
+                shaders.push_back(&pass->m_vertFrag);
 
             if (pass->m_compute.Type != ShaderType::NONE)
-                shaders.push_back(std::make_shared<Shader>(pass->m_compute));
+                shaders.push_back(&pass->m_compute);
         }
 
         // Display All Shaders
@@ -0,0 +1,286 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+using namespace niji;
+
+// Fits every temporary of a frame in the sample scenes, bigger requests get their own block
+constexpr size_t FRAME_ARENA_BLOCK_SIZE = 256 * 1024;
+
+static size_t align_up(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+FrameArena::~FrameArena()
+{
+    for (Block& block : m_blocks)
+        ::operator delete(block.Data, std::align_val_t(alignof(std::max_align_t)));
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+    size = std::max<size_t>(size, 1);
+
+    while (m_block < m_blocks.size())
+    {
+        Block& block = m_blocks[m_block];
+        const size_t offset = align_up(m_offset, alignment);
+        if (offset + size <= block.Size)
+        {
+            m_offset = offset + size;
+            m_used += size;
+            m_last = block.Data + offset;
+            return m_last;
+        }
+
+        // Moving on wastes the rest of the block until the next reset
+        m_block++;
+        m_offset = 0;
+    }
+
+    // Only while the arena grows to the frame's peak
+    Block block = {};
+    block.Size = std::max(FRAME_ARENA_BLOCK_SIZE, align_up(size, alignof(std::max_align_t)));
+    block.Data = static_cast<std::byte*>(
+        ::operator new(block.Size, std::align_val_t(alignof(std::max_align_t))));
+    m_blocks.push_back(block);
+    m_capacity += block.Size;
+
+    m_block = m_blocks.size() - 1;
+    m_offset = size;
+    m_used += size;
+    m_last = block.Data;
+    return m_last;
+}
+
+void FrameArena::deallocate(void* pointer, size_t size)
+{
+    if (pointer == nullptr || pointer != m_last)
+        return;
+
+    m_offset = static_cast<size_t>(static_cast<std::byte*>(pointer) - m_blocks[m_block].Data);
+    m_used -= std::max<size_t>(size, 1);
+    m_last = nullptr;
+}
+
+void FrameArena::reset()
+{
+    // Several blocks mean the frame outgrew the first one, one block of the peak size from now on
+    if (m_blocks.size() > 1)
+    {
+        const size_t peak = m_capacity;
+        for (Block& block : m_blocks)
+            ::operator delete(block.Data, std::align_val_t(alignof(std::max_align_t)));
+        m_blocks.clear();
+
+        Block block = {};
+        block.Size = peak;
+        block.Data = static_cast<std::byte*>(
+            ::operator new(block.Size, std::align_val_t(alignof(std::max_align_t))));
+        m_blocks.push_back(block);
+    }
+
+    m_block = 0;
+    m_offset = 0;
+    m_used = 0;
+    m_last = nullptr;
+}
+
+namespace
+{
+struct ThreadArenas;
+
+// Function local, threads may start before this file's statics are initialized
+std::mutex& get_registry_mutex()
+{
+    static std::mutex mutex = {};
+    return mutex;
+}
+
+std::vector<ThreadArenas*>& get_registry()
+{
+    static std::vector<ThreadArenas*> registry = {};
+    return registry;
+}
+
+std::atomic<uint32_t> s_frameSlot{0};
+
+struct ThreadArenas
+{
+    ThreadArenas()
+    {
+        std::lock_guard<std::mutex> lock(get_registry_mutex());
+        get_registry().push_back(this);
+    }
+    ~ThreadArenas()
+    {
+        std::lock_guard<std::mutex> lock(get_registry_mutex());
+        auto& registry = get_registry();
+        registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+    }
+
+    std::array<FrameArena, MAX_FRAMES_IN_FLIGHT> Frames = {};
+};
+
+thread_local ThreadArenas t_arenas = {};
+} // namespace
+
+FrameArena& niji::get_frame_arena()
+{
+    return t_arenas.Frames[s_frameSlot.load(std::memory_order_acquire)];
+}
+
+void niji::begin_frame_arenas(uint32_t frameSlot)
+{
+    std::lock_guard<std::mutex> lock(get_registry_mutex());
+    for (ThreadArenas* arenas : get_registry())
+        arenas->Frames[frameSlot].reset();
+
+    s_frameSlot.store(frameSlot, std::memory_order_release);
+}
+
+FrameArenaStats niji::get_frame_arena_stats()
+{
+    const uint32_t slot = s_frameSlot.load(std::memory_order_acquire);
+
+    FrameArenaStats stats = {};
+    std::lock_guard<std::mutex> lock(get_registry_mutex());
+    for (ThreadArenas* arenas : get_registry())
+    {
+        stats.Threads++;
+        stats.UsedBytes += arenas->Frames[slot].get_used();
+        stats.CapacityBytes += arenas->Frames[slot].get_capacity();
+    }
+    return stats;
+}
+
+// Allocation counter, replaces the global operator new so every heap allocation (STL containers,
+// std::function, make_shared, ...) gets counted. The frame arenas' own blocks count as well.
+static std::atomic<uint64_t> s_heapAllocations{0};
+
+uint64_t niji::get_heap_allocation_count()
+{
+    return s_heapAllocations.load(std::memory_order_relaxed);
+}
+
+#if NIJI_HEAP_COUNTER
+
+static void* counted_alloc(size_t size)
+{
+    s_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size > 0 ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+static void* counted_aligned_alloc(size_t size, std::align_val_t alignment)
+{
+    s_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    const size_t align = static_cast<size_t>(alignment);
+    size = align_up(size > 0 ? size : 1, align);
+#if defined(_MSC_VER)
+    void* pointer = _aligned_malloc(size, align);
+#else
+    void* pointer = std::aligned_alloc(align, size);
+#endif
+    if (pointer == nullptr)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+static void counted_aligned_free(void* pointer)
+{
+#if defined(_MSC_VER)
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+void* operator new(size_t size)
+{
+    return counted_alloc(size);
+}
+void* operator new[](size_t size)
+{
+    return counted_alloc(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return counted_alloc(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return counted_alloc(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    return counted_aligned_alloc(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return counted_aligned_alloc(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+void operator delete[](void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    std::free(pointer);
+}
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    std::free(pointer);
+}
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    counted_aligned_free(pointer);
+}
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+    counted_aligned_free(pointer);
+}
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept
+{
+    counted_aligned_free(pointer);
+}
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept
+{
+    counted_aligned_free(pointer);
+}
+
+#endif
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Set by CMake (NIJI_HEAP_COUNTER option, for benchmark and profiling builds), with 0 the global
+// operator new isn't replaced and get_heap_allocation_count() stays at 0
+#ifndef NIJI_HEAP_COUNTER
+#define NIJI_HEAP_COUNTER 0
+#endif
+
+namespace niji
+{
+
+// Bump allocator for temporaries that die within the frame. Blocks are kept across resets, so
+// once it has grown to the frame's peak it never touches the heap again.
+class FrameArena
+{
+  public:
+    FrameArena() = default;
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+    // Only the latest allocation gets handed back, which is what a growing vector frees
+    void deallocate(void* pointer, size_t size);
+    void reset();
+
+    size_t get_used() const
+    {
+        return m_used;
+    }
+    size_t get_capacity() const
+    {
+        return m_capacity;
+    }
+
+  private:
+    struct Block
+    {
+        std::byte* Data = nullptr;
+        size_t Size = 0;
+    };
+
+    // Grown from, every block but the last one is full
+    std::vector<Block> m_blocks = {};
+    size_t m_block = 0;
+    size_t m_offset = 0;
+    void* m_last = nullptr;
+
+    size_t m_used = 0;
+    size_t m_capacity = 0;
+};
+
+// The calling thread's arena of the frame being recorded. Every thread gets one per frame slot.
+FrameArena& get_frame_arena();
+// Main thread, at the sync point while the render thread and the jobs are idle. Resets every
+// thread's arena of that slot and makes it the current one. The arenas only hold CPU temporaries,
+// nothing the GPU reads, so the slot's frame fence doesn't have to be waited on first.
+void begin_frame_arenas(uint32_t frameSlot);
+
+struct FrameArenaStats
+{
+    uint32_t Threads = 0;
+    // Summed over the threads' arenas of the current slot
+    size_t UsedBytes = 0;
+    size_t CapacityBytes = 0;
+};
+FrameArenaStats get_frame_arena_stats();
+
+// Global operator new calls since startup, every thread
+uint64_t get_heap_allocation_count();
+
+// STL allocator on a FrameArena, the current frame's arena of the thread that constructs it.
+// Only for locals and other containers that don't outlive the frame.
+template <typename T>
+class FrameAllocator
+{
+  public:
+    using value_type = T;
+
+    FrameAllocator() : m_arena(&get_frame_arena())
+    {
+    }
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>& other) noexcept : m_arena(other.m_arena)
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(m_arena->allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* pointer, size_t count) noexcept
+    {
+        m_arena->deallocate(pointer, count * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const FrameAllocator<U>& other) const noexcept
+    {
+        return m_arena == other.m_arena;
+    }
+    template <typename U>
+    bool operator!=(const FrameAllocator<U>& other) const noexcept
+    {
+        return m_arena != other.m_arena;
+    }
+
+  private:
+    template <typename U>
+    friend class FrameAllocator;
+
+    FrameArena* m_arena = nullptr;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+} // namespace niji
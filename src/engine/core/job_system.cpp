@@ -0,0 +1,406 @@
+#include "job_system.hpp"
+
+#include <string>
+
+#include <imgui.h>
+
+#include "engine.hpp"
+
+using namespace niji;
+
+// Tries on every other thread's deque before a worker goes to sleep
+constexpr uint32_t JOB_SPIN_ROUNDS = 64;
+
+static_assert((JOB_POOL_SIZE & (JOB_POOL_SIZE - 1)) == 0, "JOB_POOL_SIZE has to be a power of 2");
+
+namespace
+{
+struct ThreadIdentity
+{
+    const JobSystem* Owner = nullptr;
+    int32_t Index = -1;
+};
+
+thread_local ThreadIdentity t_identity = {};
+thread_local uint32_t t_randomState = 0;
+
+uint32_t next_random()
+{
+    // xorshift32, picks the first victim to steal from
+    uint32_t x = t_randomState;
+    if (x == 0)
+        x = static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    t_randomState = x;
+    return x;
+}
+} // namespace
+
+bool JobDeque::push(Job* job)
+{
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    const int64_t top = m_top.load(std::memory_order_acquire);
+    if (bottom - top >= static_cast<int64_t>(JOB_DEQUE_CAPACITY))
+        return false;
+
+    m_jobs[bottom & MASK].store(job, std::memory_order_relaxed);
+    m_bottom.store(bottom + 1, std::memory_order_release);
+    return true;
+}
+
+Job* JobDeque::pop()
+{
+    // Sequentially consistent instead of the usual fences, same code on x86 and sanitizers
+    // understand it. Either the thieves see the lowered bottom or this sees their raised top.
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(bottom, std::memory_order_seq_cst);
+    int64_t top = m_top.load(std::memory_order_seq_cst);
+
+    if (top > bottom)
+    {
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = m_jobs[bottom & MASK].load(std::memory_order_relaxed);
+    if (top == bottom)
+    {
+        // Last one, races the thieves for it
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                           std::memory_order_relaxed))
+            job = nullptr;
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* JobDeque::steal()
+{
+    int64_t top = m_top.load(std::memory_order_seq_cst);
+    const int64_t bottom = m_bottom.load(std::memory_order_seq_cst);
+    if (top >= bottom)
+        return nullptr;
+
+    Job* job = m_jobs[top & MASK].load(std::memory_order_relaxed);
+    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed))
+        return nullptr;
+    return job;
+}
+
+JobSystem::~JobSystem()
+{
+    cleanup();
+}
+
+void JobSystem::init(uint32_t threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    m_threadCount = threadCount;
+    m_quit = false;
+    m_workers.resize(m_threadCount);
+    for (auto& worker : m_workers)
+    {
+        worker = std::make_unique<Worker>();
+        worker->Pool = std::make_unique<Job[]>(JOB_POOL_SIZE);
+    }
+
+    t_identity = {this, 0};
+    for (uint32_t i = 1; i < m_threadCount; i++)
+        m_threads.emplace_back(&JobSystem::worker_loop, this, i);
+
+    printf("[JobSystem]: Started %u threads \n", m_threadCount);
+}
+
+void JobSystem::cleanup()
+{
+    if (m_workers.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads)
+        thread.join();
+    m_threads.clear();
+
+    // Whatever is still queued on the main thread's deque or came in from other threads
+    const int32_t threadIndex = get_thread_index();
+    while (Job* job = find_job(threadIndex))
+        execute(job);
+
+    m_workers.clear();
+    m_threadCount = 0;
+    if (t_identity.Owner == this)
+        t_identity = {};
+}
+
+int32_t JobSystem::get_thread_index() const
+{
+    return t_identity.Owner == this ? t_identity.Index : -1;
+}
+
+Job* JobSystem::allocate_job()
+{
+    const int32_t threadIndex = get_thread_index();
+    if (threadIndex >= 0)
+    {
+        // Only the owning thread hands out its pool's jobs, any thread may give them back
+        Worker& worker = *m_workers[threadIndex];
+        Job* job = &worker.Pool[worker.NextPoolJob & (JOB_POOL_SIZE - 1)];
+        if (!job->Busy.load(std::memory_order_acquire))
+        {
+            worker.NextPoolJob++;
+            job->Busy.store(true, std::memory_order_relaxed);
+            job->FromHeap = false;
+            return job;
+        }
+    }
+
+    m_heapJobs.fetch_add(1, std::memory_order_relaxed);
+    Job* job = new Job();
+    job->FromHeap = true;
+    return job;
+}
+
+void JobSystem::submit(Job* job)
+{
+    if (m_workers.empty())
+    {
+        execute(job);
+        return;
+    }
+
+    const int32_t threadIndex = get_thread_index();
+    if (threadIndex >= 0)
+    {
+        if (!m_workers[threadIndex]->Deque.push(job))
+        {
+            m_inlineJobs.fetch_add(1, std::memory_order_relaxed);
+            execute(job);
+            return;
+        }
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(m_sharedMutex);
+        m_sharedJobs.push_back(job);
+        m_sharedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Pairs with the sleepers bumping m_sleepers before they check m_queuedJobs
+    m_queuedJobs.fetch_add(1);
+    if (m_sleepers.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_wake.notify_one();
+    }
+}
+
+void JobSystem::execute(Job* job)
+{
+    try
+    {
+        job->Run(*job);
+    }
+    catch (const std::exception& error)
+    {
+        report_error(job->Counter, std::current_exception(), error.what());
+    }
+    catch (...)
+    {
+        report_error(job->Counter, std::current_exception(), "Unknown exception");
+    }
+    job->Destroy(*job);
+
+    const int32_t threadIndex = get_thread_index();
+    if (threadIndex >= 0)
+        m_workers[threadIndex]->JobsRun.fetch_add(1, std::memory_order_relaxed);
+    else
+        m_foreignJobsRun.fetch_add(1, std::memory_order_relaxed);
+
+    JobCounter* counter = job->Counter;
+    if (job->FromHeap)
+        delete job;
+    else
+        job->Busy.store(false, std::memory_order_release);
+
+    if (counter)
+        finish(*counter);
+}
+
+void JobSystem::report_error(JobCounter* counter, std::exception_ptr error, const char* message)
+{
+    // Nobody waits on a job without a counter, its exception would otherwise get lost
+    if (!counter)
+    {
+        printf("[JobSystem]: Job without a counter threw: %s \n", message);
+        return;
+    }
+
+    // Before the job counts as finished, so the waiter always sees it
+    std::lock_guard<std::mutex> lock(counter->m_mutex);
+    if (!counter->m_error)
+        counter->m_error = error;
+}
+
+void JobSystem::finish(JobCounter& counter)
+{
+    counter.m_finishing.fetch_add(1);
+    if (counter.m_pending.fetch_sub(1) != 1)
+    {
+        counter.m_finishing.fetch_sub(1);
+        return;
+    }
+
+    Job* continuations = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(counter.m_mutex);
+        continuations = counter.m_continuations;
+        counter.m_continuations = nullptr;
+    }
+    // The counter may be gone past this point
+    counter.m_finishing.fetch_sub(1);
+
+    while (continuations)
+    {
+        Job* next = continuations->Next;
+        continuations->Next = nullptr;
+        submit(continuations);
+        continuations = next;
+    }
+}
+
+Job* JobSystem::find_job(int32_t threadIndex)
+{
+    Job* job = nullptr;
+    if (threadIndex >= 0)
+        job = m_workers[threadIndex]->Deque.pop();
+
+    if (!job && m_sharedCount.load(std::memory_order_relaxed) > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_sharedMutex);
+        if (!m_sharedJobs.empty())
+        {
+            job = m_sharedJobs.front();
+            m_sharedJobs.pop_front();
+            m_sharedCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (!job && m_threadCount > 1)
+    {
+        const uint32_t first = next_random() % m_threadCount;
+        for (uint32_t i = 0; i < m_threadCount && !job; i++)
+        {
+            const uint32_t victim = (first + i) % m_threadCount;
+            if (static_cast<int32_t>(victim) == threadIndex)
+                continue;
+
+            job = m_workers[victim]->Deque.steal();
+            if (job && threadIndex >= 0)
+                m_workers[threadIndex]->Steals.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (job)
+        m_queuedJobs.fetch_sub(1);
+    return job;
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    const int32_t threadIndex = get_thread_index();
+    while (!counter.is_done())
+    {
+        if (Job* job = find_job(threadIndex))
+            execute(job);
+        else
+            std::this_thread::yield();
+    }
+
+    std::exception_ptr error = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(counter.m_mutex);
+        std::swap(error, counter.m_error);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void JobSystem::worker_loop(uint32_t threadIndex)
+{
+    t_identity = {this, static_cast<int32_t>(threadIndex)};
+    NIJI_PROFILE_THREAD("Job Worker " + std::to_string(threadIndex));
+
+    uint32_t idleRounds = 0;
+    while (true)
+    {
+        if (Job* job = find_job(static_cast<int32_t>(threadIndex)))
+        {
+            execute(job);
+            idleRounds = 0;
+            continue;
+        }
+
+        if (++idleRounds < JOB_SPIN_ROUNDS)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        idleRounds = 0;
+
+        m_sleepers.fetch_add(1);
+        {
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wake.wait(lock, [this]() { return m_quit || m_queuedJobs.load() > 0; });
+        }
+        m_sleepers.fetch_sub(1);
+
+        // Jobs pushed before the quit still get run, they only stop coming from the main thread
+        if (m_quit && m_queuedJobs.load() <= 0)
+            return;
+    }
+}
+
+JobSystemStats JobSystem::get_stats() const
+{
+    JobSystemStats stats = {};
+    stats.Threads = m_threadCount;
+    stats.JobsRun = m_foreignJobsRun.load(std::memory_order_relaxed);
+    for (const auto& worker : m_workers)
+    {
+        stats.JobsRun += worker->JobsRun.load(std::memory_order_relaxed);
+        stats.Steals += worker->Steals.load(std::memory_order_relaxed);
+    }
+    stats.HeapJobs = m_heapJobs.load(std::memory_order_relaxed);
+    stats.InlineJobs = m_inlineJobs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void JobSystem::debug_panel()
+{
+    const JobSystemStats stats = get_stats();
+    ImGui::Text("Threads: %u (main + %u workers)", stats.Threads,
+                stats.Threads > 0 ? stats.Threads - 1 : 0);
+    ImGui::Text("Jobs Run: %llu, %llu stolen", static_cast<unsigned long long>(stats.JobsRun),
+                static_cast<unsigned long long>(stats.Steals));
+    ImGui::Text("Heap Jobs: %llu, Inline Jobs: %llu",
+                static_cast<unsigned long long>(stats.HeapJobs),
+                static_cast<unsigned long long>(stats.InlineJobs));
+
+    if (ImGui::TreeNode("Per Thread"))
+    {
+        for (uint32_t i = 0; i < m_workers.size(); i++)
+            ImGui::Text("%s %u: %llu run, %llu stolen", i == 0 ? "Main" : "Worker", i,
+                        static_cast<unsigned long long>(m_workers[i]->JobsRun.load()),
+                        static_cast<unsigned long long>(m_workers[i]->Steals.load()));
+        ImGui::TreePop();
+    }
+}
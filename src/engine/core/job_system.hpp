@@ -0,0 +1,286 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace niji
+{
+
+// Captures of a job's function have to fit in here (a handful of pointers / indices)
+constexpr size_t JOB_DATA_SIZE = 64;
+// Jobs a thread can have queued at once, a full deque runs new jobs inline
+constexpr uint32_t JOB_DEQUE_CAPACITY = 4096;
+// Jobs every worker keeps around for reuse, submits past that go to the heap
+constexpr uint32_t JOB_POOL_SIZE = 4096;
+
+class JobCounter;
+
+struct Job
+{
+    void (*Run)(Job& job) = nullptr;
+    void (*Destroy)(Job& job) = nullptr;
+    // Decremented once the job ran
+    JobCounter* Counter = nullptr;
+    // Intrusive list of the jobs waiting on a counter
+    Job* Next = nullptr;
+    std::atomic<bool> Busy{false};
+    bool FromHeap = false;
+
+    alignas(std::max_align_t) std::byte Data[JOB_DATA_SIZE] = {};
+};
+
+// Counts the unfinished jobs it got handed to. Jobs queued with run_after() start once it
+// reaches 0, JobSystem::wait() helps running jobs until it does and rethrows the first exception
+// one of them threw. Has to outlive its jobs.
+class JobCounter
+{
+  public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    // Also waits for the thread that finished the last job to let go of the counter, so it can
+    // be destroyed once this returns true
+    bool is_done() const
+    {
+        return m_pending.load() == 0 && m_finishing.load() == 0;
+    }
+
+  private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t> m_pending{0};
+    // Threads in JobSystem::finish(), which may still touch the counter after m_pending hit 0
+    std::atomic<uint32_t> m_finishing{0};
+    std::mutex m_mutex = {};
+    Job* m_continuations = nullptr;
+    // First exception of one of its jobs, handed to the next wait()
+    std::exception_ptr m_error = nullptr;
+};
+
+// Chase-Lev work stealing deque with a fixed capacity. The owning thread pushes and pops at the
+// bottom, any other thread steals from the top.
+class JobDeque
+{
+  public:
+    // Owner only, false when it's full
+    bool push(Job* job);
+    // Owner only, newest job first
+    Job* pop();
+    // Any thread, oldest job first. nullptr when empty or when another thief won the race.
+    Job* steal();
+
+    bool empty() const
+    {
+        return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static constexpr int64_t MASK = JOB_DEQUE_CAPACITY - 1;
+    static_assert((JOB_DEQUE_CAPACITY & MASK) == 0, "JOB_DEQUE_CAPACITY has to be a power of 2");
+
+    alignas(64) std::atomic<int64_t> m_top{0};
+    alignas(64) std::atomic<int64_t> m_bottom{0};
+    std::array<std::atomic<Job*>, JOB_DEQUE_CAPACITY> m_jobs = {};
+};
+
+struct JobSystemStats
+{
+    uint32_t Threads = 0;
+    uint64_t JobsRun = 0;
+    uint64_t Steals = 0;
+    // Pool was exhausted or the job came from a thread that isn't part of the system
+    uint64_t HeapJobs = 0;
+    // Deque was full, the job ran right away on the submitting thread
+    uint64_t InlineJobs = 0;
+};
+
+// Work stealing job system. Thread 0 is the thread that called init() (the main thread), which
+// only runs jobs while it waits. Every other thread is a worker with its own deque that steals
+// from the others once it runs dry. Threads that aren't part of the system (asset loaders, the
+// shader compiler...) can submit and wait too, their jobs go through a shared queue.
+//
+// Dependencies are continuation based: a job queued with run_after() gets pushed by whichever
+// thread finishes the last job of its dependency, nothing ever blocks inside a job except in
+// wait(), which keeps running other jobs meanwhile.
+class JobSystem
+{
+  public:
+    JobSystem() = default;
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // 0 threads sizes it to the hardware concurrency (the calling thread included)
+    void init(uint32_t threadCount = 0);
+    // Finishes the queued jobs first
+    void cleanup();
+
+    // Thread safe. Queues `function()`, `counter` (optional) counts it until it finished.
+    template <typename Function>
+    void run(Function&& function, JobCounter* counter = nullptr)
+    {
+        if (counter)
+            counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+        submit(make_job(std::forward<Function>(function), counter));
+    }
+
+    // Thread safe. Queues `function()` once every job counted by `dependency` finished.
+    template <typename Function>
+    void run_after(JobCounter& dependency, Function&& function, JobCounter* counter = nullptr)
+    {
+        if (counter)
+            counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+        Job* job = make_job(std::forward<Function>(function), counter);
+
+        {
+            std::lock_guard<std::mutex> lock(dependency.m_mutex);
+            if (dependency.m_pending.load() > 0)
+            {
+                job->Next = dependency.m_continuations;
+                dependency.m_continuations = job;
+                return;
+            }
+        }
+
+        // The thread that finished the dependency's last job may still be letting go of it, and
+        // the dependency is allowed to go away as soon as this job ran
+        while (dependency.m_finishing.load() > 0)
+            std::this_thread::yield();
+        submit(job);
+    }
+
+    // Runs other jobs until every job counted by `counter` finished, rethrows the first
+    // exception one of them threw. Jobs without a counter only get their exception logged.
+    void wait(JobCounter& counter);
+
+    // Calls `function(begin, end)` over [0, count) split into batches of at least `minBatch`,
+    // returns once all of them are done. The calling thread takes part.
+    template <typename Function>
+    void parallel_for(uint32_t count, uint32_t minBatch, const Function& function)
+    {
+        if (count == 0)
+            return;
+        if (m_threadCount < 2)
+        {
+            function(0u, count);
+            return;
+        }
+
+        // A few batches per thread, so threads that finish early can steal the rest
+        const uint32_t targetBatches = m_threadCount * 4;
+        const uint32_t batchSize = std::max(std::max(minBatch, 1u),
+                                            (count + targetBatches - 1) / targetBatches);
+        if (batchSize >= count)
+        {
+            function(0u, count);
+            return;
+        }
+
+        JobCounter counter = {};
+        const Function* body = &function;
+        for (uint32_t begin = batchSize; begin < count; begin += batchSize)
+        {
+            const uint32_t end = std::min(begin + batchSize, count);
+            run([body, begin, end]() { (*body)(begin, end); }, &counter);
+        }
+
+        // The batches still point at `function` and `counter`, so they have to finish either way
+        try
+        {
+            function(0u, batchSize);
+        }
+        catch (...)
+        {
+            wait(counter);
+            throw;
+        }
+        wait(counter);
+    }
+
+    uint32_t get_thread_count() const
+    {
+        return m_threadCount;
+    }
+    // Index of the calling thread within this system, -1 for threads that aren't part of it
+    int32_t get_thread_index() const;
+
+    JobSystemStats get_stats() const;
+
+    void debug_panel();
+
+  private:
+    struct alignas(64) Worker
+    {
+        JobDeque Deque = {};
+        std::unique_ptr<Job[]> Pool = nullptr;
+        uint32_t NextPoolJob = 0;
+
+        std::atomic<uint64_t> JobsRun{0};
+        std::atomic<uint64_t> Steals{0};
+    };
+
+    template <typename Function>
+    Job* make_job(Function&& function, JobCounter* counter)
+    {
+        using Stored = std::decay_t<Function>;
+        static_assert(sizeof(Stored) <= JOB_DATA_SIZE, "Job captures don't fit in JOB_DATA_SIZE");
+        static_assert(alignof(Stored) <= alignof(std::max_align_t), "Job captures overaligned");
+
+        Job* job = allocate_job();
+        new (job->Data) Stored(std::forward<Function>(function));
+        job->Run = [](Job& j) { (*std::launder(reinterpret_cast<Stored*>(j.Data)))(); };
+        job->Destroy = [](Job& j) { std::launder(reinterpret_cast<Stored*>(j.Data))->~Stored(); };
+        job->Counter = counter;
+        job->Next = nullptr;
+        return job;
+    }
+
+    Job* allocate_job();
+    void submit(Job* job);
+    void execute(Job* job);
+    void report_error(JobCounter* counter, std::exception_ptr error, const char* message);
+    void finish(JobCounter& counter);
+
+    // One job from the calling thread's deque, another thread's deque or the shared queue
+    Job* find_job(int32_t threadIndex);
+    void worker_loop(uint32_t threadIndex);
+
+  private:
+    uint32_t m_threadCount = 0;
+    std::vector<std::unique_ptr<Worker>> m_workers = {};
+    std::vector<std::thread> m_threads = {};
+
+    // Jobs from threads without a deque
+    std::mutex m_sharedMutex = {};
+    std::deque<Job*> m_sharedJobs = {};
+    std::atomic<uint32_t> m_sharedCount{0};
+
+    // Sleeping workers, woken by submits
+    std::mutex m_sleepMutex = {};
+    std::condition_variable m_wake = {};
+    // Can dip below 0 for a moment, a job may get taken before its submit counted it
+    std::atomic<int32_t> m_queuedJobs{0};
+    std::atomic<uint32_t> m_sleepers{0};
+    std::atomic<bool> m_quit{false};
+
+    std::atomic<uint64_t> m_foreignJobsRun{0};
+    std::atomic<uint64_t> m_heapJobs{0};
+    std::atomic<uint64_t> m_inlineJobs{0};
+};
+
+} // namespace niji
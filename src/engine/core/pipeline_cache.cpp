@@ -0,0 +1,269 @@
+#include "pipeline_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include <imgui.h>
+
+#include "core/common.hpp"
+
+using namespace niji;
+
+// "NJPC"
+constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x43504A4E;
+// Bump when PipelineCacheFileHeader changes
+constexpr uint32_t PIPELINE_CACHE_FILE_VERSION = 1;
+
+struct PipelineCacheFileHeader
+{
+    uint32_t Magic = PIPELINE_CACHE_MAGIC;
+    uint32_t Version = PIPELINE_CACHE_FILE_VERSION;
+    uint32_t VendorID = 0;
+    uint32_t DeviceID = 0;
+    uint32_t DriverVersion = 0;
+    uint8_t DeviceUUID[VK_UUID_SIZE] = {};
+    uint8_t PipelineCacheUUID[VK_UUID_SIZE] = {};
+    uint64_t DataSize = 0;
+    uint64_t DataHash = 0;
+};
+
+void PipelineCache::init(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& path)
+{
+    m_device = device;
+    m_path = path;
+
+    VkPhysicalDeviceIDProperties idProperties = {};
+    idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 properties = {};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &idProperties;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+    m_vendorID = properties.properties.vendorID;
+    m_deviceID = properties.properties.deviceID;
+    m_driverVersion = properties.properties.driverVersion;
+    std::memcpy(m_deviceUUID, idProperties.deviceUUID, VK_UUID_SIZE);
+    std::memcpy(m_pipelineCacheUUID, properties.properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    std::vector<char> file = load_file();
+    const bool valid = !file.empty() && validate(file);
+    if (!file.empty() && !valid)
+        printf("[PipelineCache]: %s doesn't match this device or driver, starting empty \n",
+               m_path.c_str());
+
+    VkPipelineCacheCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    if (valid)
+    {
+        createInfo.initialDataSize = file.size() - sizeof(PipelineCacheFileHeader);
+        createInfo.pInitialData = file.data() + sizeof(PipelineCacheFileHeader);
+        m_loadedBytes = createInfo.initialDataSize;
+    }
+
+    VkResult result = vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_cache);
+    // Drivers may still refuse data that passed our checks, fall back to an empty cache
+    if (result != VK_SUCCESS && valid)
+    {
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+        m_loadedBytes = 0;
+        result = vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_cache);
+    }
+    if (result != VK_SUCCESS)
+        throw std::runtime_error("Failed to Create Pipeline Cache!");
+
+    SetObjectName(m_device, VK_OBJECT_TYPE_PIPELINE_CACHE, m_cache, "Pipeline Cache");
+
+    if (m_loadedBytes > 0)
+        printf("[PipelineCache]: Loaded %zu bytes from %s \n", m_loadedBytes, m_path.c_str());
+}
+
+void PipelineCache::cleanup()
+{
+    if (m_cache == VK_NULL_HANDLE)
+        return;
+
+    save();
+
+    const PipelineCacheStats stats = get_stats();
+    printf("[PipelineCache]: %u hits, %u misses, %.1f ms creating pipelines \n", stats.Hits,
+           stats.Misses, stats.CreationMs);
+
+    vkDestroyPipelineCache(m_device, m_cache, nullptr);
+    m_cache = VK_NULL_HANDLE;
+}
+
+void PipelineCache::update(float deltaTime)
+{
+    m_timeSinceSave += deltaTime;
+    if (m_timeSinceSave < PIPELINE_CACHE_SAVE_INTERVAL)
+        return;
+
+    m_timeSinceSave = 0.0f;
+    if (m_unsavedMisses > 0)
+        save();
+}
+
+bool PipelineCache::save()
+{
+    if (m_path.empty() || m_cache == VK_NULL_HANDLE)
+        return false;
+
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(m_device, m_cache, &dataSize, nullptr) != VK_SUCCESS)
+        return false;
+
+    std::vector<char> file(sizeof(PipelineCacheFileHeader) + dataSize);
+    if (vkGetPipelineCacheData(m_device, m_cache, &dataSize,
+                               file.data() + sizeof(PipelineCacheFileHeader)) != VK_SUCCESS)
+        return false;
+    file.resize(sizeof(PipelineCacheFileHeader) + dataSize);
+
+    PipelineCacheFileHeader header = {};
+    header.VendorID = m_vendorID;
+    header.DeviceID = m_deviceID;
+    header.DriverVersion = m_driverVersion;
+    std::memcpy(header.DeviceUUID, m_deviceUUID, VK_UUID_SIZE);
+    std::memcpy(header.PipelineCacheUUID, m_pipelineCacheUUID, VK_UUID_SIZE);
+    header.DataSize = dataSize;
+    // Only there to catch truncated or damaged files
+    header.DataHash = hash_bytes(file.data() + sizeof(PipelineCacheFileHeader), dataSize);
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    // Written next to the old file and swapped in, a crash mid-write leaves the old cache intact
+    const std::string tempPath = m_path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open() || !out.write(file.data(), file.size()))
+        {
+            printf("[PipelineCache]: Failed to write %s \n", tempPath.c_str());
+            return false;
+        }
+    }
+
+    std::error_code error = {};
+    std::filesystem::rename(tempPath, m_path, error);
+    if (error)
+    {
+        printf("[PipelineCache]: Failed to replace %s: %s \n", m_path.c_str(),
+               error.message().c_str());
+        return false;
+    }
+
+    m_unsavedMisses = 0;
+    m_savedBytes = dataSize;
+    m_saves++;
+    return true;
+}
+
+VkPipelineCreationFeedbackCreateInfo
+PipelineCache::make_feedback_info(VkPipelineCreationFeedback& feedback)
+{
+    feedback = {};
+
+    VkPipelineCreationFeedbackCreateInfo feedbackInfo = {};
+    feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+    feedbackInfo.pPipelineCreationFeedback = &feedback;
+    return feedbackInfo;
+}
+
+void PipelineCache::record_creation(const VkPipelineCreationFeedback& feedback, double creationMs)
+{
+    const bool valid = feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT;
+    const bool hit =
+        valid && (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT);
+
+    if (hit)
+        m_hits++;
+    else
+    {
+        m_misses++;
+        m_unsavedMisses++;
+    }
+    m_creationNs += static_cast<uint64_t>(creationMs * 1e6);
+}
+
+PipelineCacheStats PipelineCache::get_stats() const
+{
+    PipelineCacheStats stats = {};
+    stats.Hits = m_hits;
+    stats.Misses = m_misses;
+    stats.CreationMs = static_cast<double>(m_creationNs.load()) / 1e6;
+    stats.LoadedBytes = m_loadedBytes;
+    stats.SavedBytes = m_savedBytes;
+    stats.Saves = m_saves;
+    return stats;
+}
+
+void PipelineCache::debug_panel()
+{
+    const PipelineCacheStats stats = get_stats();
+    const uint32_t total = stats.Hits + stats.Misses;
+
+    ImGui::Text("File: %s", m_path.empty() ? "(in memory only)" : m_path.c_str());
+    ImGui::Text("Hits: %u / %u (%.1f%%)", stats.Hits, total,
+                total > 0 ? 100.0f * stats.Hits / total : 0.0f);
+    ImGui::Text("Misses: %u (%u unsaved)", stats.Misses, m_unsavedMisses.load());
+    ImGui::Text("Pipeline Creation: %.2f ms", stats.CreationMs);
+
+    ImGui::Separator();
+    ImGui::Text("Loaded: %.1f KB", stats.LoadedBytes / 1024.0f);
+    ImGui::Text("Last Save: %.1f KB (%u saves)", stats.SavedBytes / 1024.0f, stats.Saves);
+    if (ImGui::Button("Save Now"))
+        save();
+}
+
+std::vector<char> PipelineCache::load_file() const
+{
+    if (m_path.empty())
+        return {};
+
+    std::ifstream file(m_path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return {};
+
+    const std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    std::vector<char> buffer(static_cast<size_t>(size));
+    if (!file.read(buffer.data(), size))
+        return {};
+    return buffer;
+}
+
+bool PipelineCache::validate(const std::vector<char>& file) const
+{
+    if (file.size() < sizeof(PipelineCacheFileHeader))
+        return false;
+
+    PipelineCacheFileHeader header = {};
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if (header.Magic != PIPELINE_CACHE_MAGIC || header.Version != PIPELINE_CACHE_FILE_VERSION)
+        return false;
+    if (header.VendorID != m_vendorID || header.DeviceID != m_deviceID ||
+        header.DriverVersion != m_driverVersion)
+        return false;
+    if (std::memcmp(header.DeviceUUID, m_deviceUUID, VK_UUID_SIZE) != 0 ||
+        std::memcmp(header.PipelineCacheUUID, m_pipelineCacheUUID, VK_UUID_SIZE) != 0)
+        return false;
+
+    const char* data = file.data() + sizeof(PipelineCacheFileHeader);
+    const size_t dataSize = file.size() - sizeof(PipelineCacheFileHeader);
+    if (header.DataSize != dataSize || header.DataHash != hash_bytes(data, dataSize))
+        return false;
+
+    // The driver's own header has to agree as well
+    VkPipelineCacheHeaderVersionOne vkHeader = {};
+    if (dataSize < sizeof(vkHeader))
+        return false;
+    std::memcpy(&vkHeader, data, sizeof(vkHeader));
+
+    return vkHeader.headerSize >= sizeof(vkHeader) &&
+           vkHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           vkHeader.vendorID == m_vendorID && vkHeader.deviceID == m_deviceID &&
+           std::memcmp(vkHeader.pipelineCacheUUID, m_pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace niji
+{
+
+// Seconds between two saves of a cache that picked up new pipelines, besides the one on shutdown
+constexpr float PIPELINE_CACHE_SAVE_INTERVAL = 30.0f;
+
+struct PipelineCacheStats
+{
+    // Counted through pipeline creation feedback, pipelines the driver didn't report on are misses
+    uint32_t Hits = 0;
+    uint32_t Misses = 0;
+    double CreationMs = 0.0;
+    // Size of the blob that got loaded at startup and of the last one that got saved
+    size_t LoadedBytes = 0;
+    size_t SavedBytes = 0;
+    uint32_t Saves = 0;
+};
+
+// The VkPipelineCache every pipeline gets created through. It's loaded from disk at startup and
+// saved on shutdown and every PIPELINE_CACHE_SAVE_INTERVAL seconds while new pipelines show up.
+// The file starts with our own header (device / driver identity and a hash of the blob), a file
+// from another GPU, another driver version or a damaged one starts an empty cache instead.
+class PipelineCache
+{
+  public:
+    // An empty path keeps the cache in memory only
+    void init(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& path);
+    // Saves and destroys the cache, before the device goes
+    void cleanup();
+
+    // Periodic save, main thread
+    void update(float deltaTime);
+    bool save();
+
+    // Chain into the pNext of the pipeline create info, then report it with record_creation
+    static VkPipelineCreationFeedbackCreateInfo
+    make_feedback_info(VkPipelineCreationFeedback& feedback);
+    // Thread safe, `creationMs` is the CPU time vkCreate*Pipelines took
+    void record_creation(const VkPipelineCreationFeedback& feedback, double creationMs);
+
+    VkPipelineCache get_handle() const
+    {
+        return m_cache;
+    }
+    PipelineCacheStats get_stats() const;
+
+    void debug_panel();
+
+  private:
+    std::vector<char> load_file() const;
+    bool validate(const std::vector<char>& file) const;
+
+  private:
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkPipelineCache m_cache = VK_NULL_HANDLE;
+    std::string m_path = {};
+
+    // Identity of the device the cache belongs to
+    uint32_t m_vendorID = 0;
+    uint32_t m_deviceID = 0;
+    uint32_t m_driverVersion = 0;
+    uint8_t m_deviceUUID[VK_UUID_SIZE] = {};
+    uint8_t m_pipelineCacheUUID[VK_UUID_SIZE] = {};
+
+    std::atomic<uint32_t> m_hits{0};
+    std::atomic<uint32_t> m_misses{0};
+    std::atomic<uint64_t> m_creationNs{0};
+    // Misses since the last save, nothing new to write while it's 0
+    std::atomic<uint32_t> m_unsavedMisses{0};
+    size_t m_loadedBytes = 0;
+    size_t m_savedBytes = 0;
+    uint32_t m_saves = 0;
+    float m_timeSinceSave = 0.0f;
+};
+
+} // namespace niji
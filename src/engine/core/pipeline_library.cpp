@@ -0,0 +1,282 @@
+#include "pipeline_library.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+
+#include <imgui.h>
+
+#include "engine.hpp"
+
+using namespace niji;
+
+static double to_ms(uint64_t ns)
+{
+    return static_cast<double>(ns) / 1e6;
+}
+
+void PipelineLibrary::init(VkDevice device, VkPhysicalDevice physicalDevice, bool enabled)
+{
+    m_device = device;
+    m_enabled = enabled;
+    if (!m_enabled)
+        return;
+
+    VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT libraryProperties = {};
+    libraryProperties.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+
+    VkPhysicalDeviceProperties2 properties = {};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &libraryProperties;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+    m_fastLinking = libraryProperties.graphicsPipelineLibraryFastLinking == VK_TRUE;
+    if (!m_fastLinking)
+        printf("[PipelineLibrary]: No fast linking on this device, links get optimized right "
+               "away \n");
+
+    m_worker = std::thread(&PipelineLibrary::worker_loop, this);
+}
+
+void PipelineLibrary::cleanup()
+{
+    if (m_worker.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_jobMutex);
+            m_quit = true;
+        }
+        m_jobSignal.notify_one();
+        m_worker.join();
+    }
+
+    // Whatever didn't get swapped in belongs to pipelines that are gone by now
+    for (auto& [pipeline, optimized] : m_ready)
+        vkDestroyPipeline(m_device, optimized, nullptr);
+    m_ready.clear();
+    m_jobs.clear();
+
+    for (auto& parts : m_parts)
+    {
+        for (auto& [key, part] : parts)
+            vkDestroyPipeline(m_device, part, nullptr);
+        parts.clear();
+    }
+}
+
+VkPipeline PipelineLibrary::get_part(PipelinePart part, uint64_t key,
+                                     const std::function<VkPipeline()>& create)
+{
+    auto& parts = m_parts[static_cast<size_t>(part)];
+    {
+        std::lock_guard<std::mutex> lock(m_partMutex);
+        auto it = parts.find(key);
+        if (it != parts.end())
+        {
+            m_partsReused++;
+            return it->second;
+        }
+    }
+
+    // Built outside the lock, the other threads keep linking meanwhile
+    VkPipeline created = create();
+
+    std::lock_guard<std::mutex> lock(m_partMutex);
+    auto [it, inserted] = parts.emplace(key, created);
+    if (!inserted)
+    {
+        // Another thread built the same part in the meantime
+        vkDestroyPipeline(m_device, created, nullptr);
+        m_partsReused++;
+        return it->second;
+    }
+
+    m_partsCreated++;
+    return created;
+}
+
+VkPipeline PipelineLibrary::create_linked(const std::array<VkPipeline, 4>& parts,
+                                          VkPipelineLayout layout, bool optimize) const
+{
+    VkPipelineLibraryCreateInfoKHR libraryInfo = {};
+    libraryInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+    libraryInfo.libraryCount = static_cast<uint32_t>(parts.size());
+    libraryInfo.pLibraries = parts.data();
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = &libraryInfo;
+    pipelineInfo.flags = optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+    if (nijiEngine.m_context.has_pipeline_executable_info())
+        pipelineInfo.flags |= VK_PIPELINE_CREATE_CAPTURE_STATISTICS_BIT_KHR;
+    pipelineInfo.layout = layout;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo.basePipelineIndex = -1;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(m_device, nijiEngine.m_context.get_pipeline_cache().get_handle(),
+                                  1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+        return VK_NULL_HANDLE;
+    return pipeline;
+}
+
+VkPipeline PipelineLibrary::link(const std::array<VkPipeline, 4>& parts, VkPipelineLayout layout,
+                                 const char* name)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    VkPipeline pipeline = create_linked(parts, layout, !m_fastLinking);
+    if (pipeline == VK_NULL_HANDLE)
+        throw std::runtime_error("Failed to Link Graphics Pipeline!");
+    const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::high_resolution_clock::now() - start)
+                            .count();
+
+    m_links++;
+    m_linkNs += ns;
+    uint64_t maxNs = m_maxLinkNs.load();
+    while (ns > maxNs && !m_maxLinkNs.compare_exchange_weak(maxNs, ns))
+    {
+    }
+    printf("[PipelineLibrary]: Linked '%s' in %.3f ms \n", name, to_ms(ns));
+
+    if (m_fastLinking)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_jobMutex);
+            m_jobs.push_back({pipeline, parts, layout, name});
+        }
+        m_jobSignal.notify_one();
+    }
+    return pipeline;
+}
+
+VkPipeline PipelineLibrary::take_optimized(VkPipeline pipeline)
+{
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    auto it = m_ready.find(pipeline);
+    if (it == m_ready.end())
+        return VK_NULL_HANDLE;
+
+    VkPipeline optimized = it->second;
+    m_ready.erase(it);
+    m_readyCount.store(static_cast<uint32_t>(m_ready.size()), std::memory_order_release);
+    return optimized;
+}
+
+void PipelineLibrary::release(VkPipeline pipeline)
+{
+    if (!m_enabled || pipeline == VK_NULL_HANDLE)
+        return;
+
+    std::unique_lock<std::mutex> lock(m_jobMutex);
+    for (auto it = m_jobs.begin(); it != m_jobs.end(); ++it)
+    {
+        if (it->Pipeline == pipeline)
+        {
+            m_jobs.erase(it);
+            return;
+        }
+    }
+
+    // The link in progress uses the pipeline's layout, which goes together with the pipeline
+    m_buildDone.wait(lock, [this, pipeline]() { return m_building != pipeline; });
+
+    auto it = m_ready.find(pipeline);
+    if (it != m_ready.end())
+    {
+        vkDestroyPipeline(m_device, it->second, nullptr);
+        m_ready.erase(it);
+        m_readyCount.store(static_cast<uint32_t>(m_ready.size()), std::memory_order_release);
+    }
+}
+
+void PipelineLibrary::worker_loop()
+{
+    nijiEngine.m_profiler.set_thread_name("Pipeline Optimizer");
+
+    while (true)
+    {
+        OptimizeJob job = {};
+        {
+            std::unique_lock<std::mutex> lock(m_jobMutex);
+            m_jobSignal.wait(lock, [this]() { return m_quit || !m_jobs.empty(); });
+            if (m_quit)
+                return;
+
+            job = m_jobs.front();
+            m_jobs.pop_front();
+            m_building = job.Pipeline;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        VkPipeline optimized = VK_NULL_HANDLE;
+        {
+            NIJI_PROFILE_SCOPE("Optimized Pipeline Link");
+            optimized = create_linked(job.Parts, job.Layout, true);
+        }
+        const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::high_resolution_clock::now() - start)
+                                .count();
+
+        // The fast linked one simply stays in use
+        if (optimized == VK_NULL_HANDLE)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_jobMutex);
+                m_building = VK_NULL_HANDLE;
+            }
+            m_buildDone.notify_all();
+            continue;
+        }
+
+        m_optimizedLinks++;
+        m_optimizedLinkNs += ns;
+
+        SetObjectName(m_device, VK_OBJECT_TYPE_PIPELINE, optimized, job.Name);
+        printf("[PipelineLibrary]: Optimized '%s' in %.3f ms \n", job.Name, to_ms(ns));
+
+        {
+            std::lock_guard<std::mutex> lock(m_jobMutex);
+            m_building = VK_NULL_HANDLE;
+            m_ready[job.Pipeline] = optimized;
+            m_readyCount.store(static_cast<uint32_t>(m_ready.size()), std::memory_order_release);
+        }
+        m_buildDone.notify_all();
+    }
+}
+
+PipelineLibraryStats PipelineLibrary::get_stats() const
+{
+    PipelineLibraryStats stats = {};
+    stats.PartsCreated = m_partsCreated.load();
+    stats.PartsReused = m_partsReused.load();
+    stats.Links = m_links.load();
+    stats.LinkMs = to_ms(m_linkNs.load());
+    stats.MaxLinkMs = to_ms(m_maxLinkNs.load());
+    stats.OptimizedLinks = m_optimizedLinks.load();
+    stats.OptimizedLinkMs = to_ms(m_optimizedLinkNs.load());
+
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    stats.PendingOptimizedLinks =
+        static_cast<uint32_t>(m_jobs.size()) + (m_building != VK_NULL_HANDLE ? 1 : 0);
+    return stats;
+}
+
+void PipelineLibrary::debug_panel()
+{
+    if (!m_enabled)
+    {
+        ImGui::Text("Pipeline Libraries: off, pipelines are built monolithically");
+        return;
+    }
+
+    const PipelineLibraryStats stats = get_stats();
+    ImGui::Text("Fast Linking: %s", m_fastLinking ? "yes" : "no");
+    ImGui::Text("Parts: %u built, %u reused", stats.PartsCreated, stats.PartsReused);
+    ImGui::Text("Links: %u, %.3f ms avg, %.3f ms max", stats.Links,
+                stats.Links > 0 ? stats.LinkMs / stats.Links : 0.0, stats.MaxLinkMs);
+    ImGui::Text("Optimized Links: %u, %.2f ms avg (%u pending)", stats.OptimizedLinks,
+                stats.OptimizedLinks > 0 ? stats.OptimizedLinkMs / stats.OptimizedLinks : 0.0,
+                stats.PendingOptimizedLinks);
+}
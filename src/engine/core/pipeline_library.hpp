@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace niji
+{
+
+// The four libraries of VK_EXT_graphics_pipeline_library a graphics pipeline gets linked from
+enum class PipelinePart
+{
+    VERTEX_INPUT,
+    PRE_RASTERIZATION,
+    FRAGMENT_SHADER,
+    FRAGMENT_OUTPUT,
+    COUNT
+};
+
+struct PipelineLibraryStats
+{
+    uint32_t PartsCreated = 0;
+    uint32_t PartsReused = 0;
+    // Links the pipelines got created with, fast unless the device lacks fast linking
+    uint32_t Links = 0;
+    double LinkMs = 0.0;
+    double MaxLinkMs = 0.0;
+    // Link time optimized replacements built in the background
+    uint32_t OptimizedLinks = 0;
+    double OptimizedLinkMs = 0.0;
+    uint32_t PendingOptimizedLinks = 0;
+};
+
+// Graphics pipelines get built from per-stage libraries instead of in one go. Every part is
+// cached by the state it was built from, so a hot reload or another variant of a pass only
+// compiles the part that actually changed and fast links it with the rest (well under a
+// millisecond on drivers with graphicsPipelineLibraryFastLinking). The fast linked pipeline is
+// usable right away, a worker thread links an optimized one which the renderer swaps in.
+class PipelineLibrary
+{
+  public:
+    // Disabled, every graphics pipeline gets created monolithically like before
+    void init(VkDevice device, VkPhysicalDevice physicalDevice, bool enabled);
+    // After every pipeline linked from the parts got destroyed
+    void cleanup();
+
+    bool is_enabled() const
+    {
+        return m_enabled;
+    }
+
+    // Thread safe. The part built from the state behind `key`, `create` builds it on a miss.
+    VkPipeline get_part(PipelinePart part, uint64_t key, const std::function<VkPipeline()>& create);
+
+    // Thread safe. Links the parts into a pipeline and queues the optimized link of it.
+    VkPipeline link(const std::array<VkPipeline, 4>& parts, VkPipelineLayout layout,
+                    const char* name);
+
+    // Main thread. An optimized replacement of `pipeline` that's ready, VK_NULL_HANDLE otherwise.
+    VkPipeline take_optimized(VkPipeline pipeline);
+    // One atomic load, lets the renderer skip looking for replacements
+    bool has_optimized() const
+    {
+        return m_readyCount.load(std::memory_order_acquire) > 0;
+    }
+    // `pipeline` is about to be destroyed, drops its optimized link
+    void release(VkPipeline pipeline);
+
+    PipelineLibraryStats get_stats() const;
+
+    void debug_panel();
+
+  private:
+    struct OptimizeJob
+    {
+        VkPipeline Pipeline = VK_NULL_HANDLE;
+        std::array<VkPipeline, 4> Parts = {};
+        VkPipelineLayout Layout = VK_NULL_HANDLE;
+        const char* Name = nullptr;
+    };
+
+    VkPipeline create_linked(const std::array<VkPipeline, 4>& parts, VkPipelineLayout layout,
+                             bool optimize) const;
+    void worker_loop();
+
+  private:
+    VkDevice m_device = VK_NULL_HANDLE;
+    bool m_enabled = false;
+    // Without it linking costs about as much as a monolithic build, so it's optimized right away
+    bool m_fastLinking = false;
+
+    mutable std::mutex m_partMutex = {};
+    std::array<std::unordered_map<uint64_t, VkPipeline>, static_cast<size_t>(PipelinePart::COUNT)>
+        m_parts = {};
+
+    std::thread m_worker = {};
+    mutable std::mutex m_jobMutex = {};
+    std::condition_variable m_jobSignal = {};
+    std::deque<OptimizeJob> m_jobs = {};
+    // Pipeline whose optimized link is being built
+    VkPipeline m_building = VK_NULL_HANDLE;
+    std::condition_variable m_buildDone = {};
+    // Fast linked pipeline -> its optimized replacement
+    std::unordered_map<VkPipeline, VkPipeline> m_ready = {};
+    std::atomic<uint32_t> m_readyCount{0};
+    bool m_quit = false;
+
+    std::atomic<uint32_t> m_partsCreated{0};
+    std::atomic<uint32_t> m_partsReused{0};
+    std::atomic<uint32_t> m_links{0};
+    std::atomic<uint64_t> m_linkNs{0};
+    std::atomic<uint64_t> m_maxLinkNs{0};
+    std::atomic<uint32_t> m_optimizedLinks{0};
+    std::atomic<uint64_t> m_optimizedLinkNs{0};
+};
+
+} // namespace niji
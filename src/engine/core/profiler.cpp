@@ -0,0 +1,389 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+
+#include <imgui.h>
+#include <nlohmann/json.hpp>
+
+#include "engine.hpp"
+
+using namespace niji;
+
+struct CpuProfiler::ThreadBuffer
+{
+    uint32_t Index = 0;
+    std::string Name = {};
+
+    // Ring of finished zones, Head is only written by the owning thread, Tail by frame_mark()
+    std::unique_ptr<CpuZone[]> Zones = {};
+    std::atomic<uint64_t> Head{0};
+    std::atomic<uint64_t> Tail{0};
+    std::atomic<uint64_t> Dropped{0};
+
+    // Zones that are still open, owning thread only
+    std::vector<std::pair<const char*, int64_t>> Open = {};
+};
+
+CpuProfiler::CpuProfiler() : m_epoch(std::chrono::steady_clock::now())
+{
+    m_history.resize(CPU_PROFILER_HISTORY);
+
+    // Created along with the engine, before anything else runs
+    set_thread_name("Main Thread");
+}
+
+CpuProfiler::~CpuProfiler() = default;
+
+void CpuProfiler::set_thread_name(const std::string& name)
+{
+    ThreadBuffer& buffer = get_thread_buffer();
+
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    buffer.Name = name;
+}
+
+const char* CpuProfiler::intern(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_namesMutex);
+    return m_names.insert(name).first->c_str();
+}
+
+void CpuProfiler::begin_zone(const char* name)
+{
+    ThreadBuffer& buffer = get_thread_buffer();
+    buffer.Open.emplace_back(name, now());
+}
+
+void CpuProfiler::end_zone()
+{
+    ThreadBuffer& buffer = get_thread_buffer();
+    if (buffer.Open.empty())
+        return;
+
+    const auto [name, start] = buffer.Open.back();
+    buffer.Open.pop_back();
+
+    const uint64_t head = buffer.Head.load(std::memory_order_relaxed);
+    if (head - buffer.Tail.load(std::memory_order_acquire) >= CPU_PROFILER_THREAD_EVENTS)
+    {
+        buffer.Dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    CpuZone& zone = buffer.Zones[head % CPU_PROFILER_THREAD_EVENTS];
+    zone.Name = name;
+    zone.Thread = buffer.Index;
+    zone.Depth = static_cast<uint32_t>(buffer.Open.size());
+    zone.Start = start;
+    zone.End = now();
+
+    buffer.Head.store(head + 1, std::memory_order_release);
+}
+
+void CpuProfiler::frame_mark()
+{
+    const int64_t time = now();
+
+    // Zones still get drained while paused, so the thread buffers don't fill up
+    CpuFrame discarded = {};
+    CpuFrame& frame = m_paused ? discarded : m_history[m_historyNext];
+    frame.Number = m_frameNumber++;
+    frame.Start = m_frameStart;
+    frame.End = time;
+    collect(frame);
+
+    m_frameStart = time;
+
+    if (m_paused)
+        return;
+
+    m_historyNext = (m_historyNext + 1) % CPU_PROFILER_HISTORY;
+    m_historyCount = std::min(m_historyCount + 1, CPU_PROFILER_HISTORY);
+
+    check_hitch(frame);
+}
+
+CpuProfiler::ThreadBuffer& CpuProfiler::get_thread_buffer()
+{
+    // There is only ever one profiler (the engine's)
+    thread_local ThreadBuffer* threadBuffer = nullptr;
+    if (threadBuffer)
+        return *threadBuffer;
+
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->Index = static_cast<uint32_t>(m_threads.size());
+    buffer->Name = "Thread " + std::to_string(buffer->Index);
+    buffer->Zones = std::make_unique<CpuZone[]>(CPU_PROFILER_THREAD_EVENTS);
+    buffer->Open.reserve(32);
+
+    threadBuffer = buffer.get();
+    m_threads.push_back(std::move(buffer));
+    return *threadBuffer;
+}
+
+void CpuProfiler::collect(CpuFrame& frame)
+{
+    frame.Zones.clear();
+
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    for (auto& buffer : m_threads)
+    {
+        const uint64_t head = buffer->Head.load(std::memory_order_acquire);
+        const uint64_t tail = buffer->Tail.load(std::memory_order_relaxed);
+
+        for (uint64_t i = tail; i < head; i++)
+            frame.Zones.push_back(buffer->Zones[i % CPU_PROFILER_THREAD_EVENTS]);
+
+        buffer->Tail.store(head, std::memory_order_release);
+        m_droppedZones += buffer->Dropped.exchange(0, std::memory_order_relaxed);
+    }
+}
+
+void CpuProfiler::check_hitch(const CpuFrame& frame)
+{
+    m_framesSinceDump++;
+
+    // The first frame covers everything from startup to the first mark
+    if (!m_autoDump || frame.Number == 0 || frame.duration_ms() < m_hitchThresholdMs)
+        return;
+    if (m_framesSinceDump < CPU_PROFILER_HISTORY)
+        return;
+
+    const std::string path = "hitch_frame_" + std::to_string(frame.Number) + ".json";
+    if (!write_trace(path, get_history()))
+    {
+        nijiEngine.m_logger.log_error("Failed to save " + path);
+        return;
+    }
+
+    m_framesSinceDump = 0;
+    m_lastDump = path;
+
+    char message[128] = {};
+    snprintf(message, sizeof(message), "Frame %llu took %.2f ms, saved the last %u frames to ",
+             static_cast<unsigned long long>(frame.Number), frame.duration_ms(), m_historyCount);
+    nijiEngine.m_logger.log_warning(message + path);
+}
+
+std::vector<const CpuFrame*> CpuProfiler::get_history() const
+{
+    std::vector<const CpuFrame*> frames = {};
+    frames.reserve(m_historyCount);
+
+    const uint32_t first = (m_historyNext + CPU_PROFILER_HISTORY - m_historyCount) %
+                           CPU_PROFILER_HISTORY;
+    for (uint32_t i = 0; i < m_historyCount; i++)
+        frames.push_back(&m_history[(first + i) % CPU_PROFILER_HISTORY]);
+
+    return frames;
+}
+
+bool CpuProfiler::export_chrome_trace(const std::string& path) const
+{
+    return write_trace(path, get_history());
+}
+
+bool CpuProfiler::write_trace(const std::string& path,
+                              const std::vector<const CpuFrame*>& frames) const
+{
+    if (frames.empty())
+        return false;
+
+    const int64_t origin = frames.front()->Start;
+    const auto to_us = [origin](int64_t time) { return (time - origin) / 1000.0; };
+
+    nlohmann::json events = nlohmann::json::array();
+    {
+        std::lock_guard<std::mutex> lock(m_threadsMutex);
+        for (const auto& buffer : m_threads)
+        {
+            events.push_back({{"name", "thread_name"},
+                              {"ph", "M"},
+                              {"pid", 0},
+                              {"tid", buffer->Index},
+                              {"args", {{"name", buffer->Name}}}});
+        }
+    }
+
+    for (const CpuFrame* frame : frames)
+    {
+        events.push_back({{"name", "Frame " + std::to_string(frame->Number)},
+                          {"ph", "i"},
+                          {"s", "g"},
+                          {"pid", 0},
+                          {"tid", 0},
+                          {"ts", to_us(frame->Start)}});
+
+        for (const CpuZone& zone : frame->Zones)
+        {
+            events.push_back({{"name", zone.Name},
+                              {"cat", "cpu"},
+                              {"ph", "X"},
+                              {"pid", 0},
+                              {"tid", zone.Thread},
+                              {"ts", to_us(zone.Start)},
+                              {"dur", (zone.End - zone.Start) / 1000.0}});
+        }
+    }
+
+    std::ofstream file(path);
+    if (!file.is_open())
+        return false;
+
+    nlohmann::json trace = {{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+    file << trace.dump(1);
+    return true;
+}
+
+int64_t CpuProfiler::now() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                m_epoch)
+        .count();
+}
+
+void CpuProfiler::debug_panel()
+{
+#if !NIJI_CPU_PROFILER
+    ImGui::Text("CPU profiling is compiled out (NIJI_CPU_PROFILER=OFF)");
+#else
+    ImGui::Checkbox("Paused", &m_paused);
+    ImGui::SameLine();
+    ImGui::Checkbox("Dump Hitches", &m_autoDump);
+    ImGui::SliderFloat("Hitch Threshold (ms)", &m_hitchThresholdMs, 5.0f, 200.0f, "%.1f");
+    if (!m_lastDump.empty())
+        ImGui::Text("Last Hitch Dump: %s", m_lastDump.c_str());
+    if (m_droppedZones > 0)
+        ImGui::Text("Dropped Zones: %llu", static_cast<unsigned long long>(m_droppedZones));
+
+    const std::vector<const CpuFrame*> frames = get_history();
+    if (frames.empty())
+        return;
+
+    std::vector<float> frameTimes(frames.size());
+    float maxTime = 0.0f;
+    int slowest = 0;
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        frameTimes[i] = frames[i]->duration_ms();
+        if (frameTimes[i] > maxTime)
+        {
+            maxTime = frameTimes[i];
+            slowest = static_cast<int>(frames.size() - 1 - i);
+        }
+    }
+
+    ImGui::PlotLines("Frame Times", frameTimes.data(), static_cast<int>(frameTimes.size()), 0,
+                     nullptr, 0.0f, maxTime * 1.1f, ImVec2(0.0f, 60.0f));
+
+    const int lastFrame = static_cast<int>(frames.size()) - 1;
+    ImGui::SliderInt("Frames Back", &m_selectedFrame, 0, lastFrame);
+    m_selectedFrame = std::clamp(m_selectedFrame, 0, lastFrame);
+    if (ImGui::Button("Slowest Frame"))
+        m_selectedFrame = slowest;
+    ImGui::SameLine();
+    if (ImGui::Button("Export Chrome Trace"))
+    {
+        if (export_chrome_trace("cpu_trace.json"))
+            nijiEngine.m_logger.log_info("Saved CPU trace to cpu_trace.json");
+        else
+            nijiEngine.m_logger.log_error("Failed to save cpu_trace.json");
+    }
+
+    const CpuFrame& frame = *frames[lastFrame - m_selectedFrame];
+    ImGui::Text("Frame %llu: %.3f ms, %zu zones", static_cast<unsigned long long>(frame.Number),
+                frame.duration_ms(), frame.Zones.size());
+
+    flame_view(frame);
+#endif
+}
+
+void CpuProfiler::flame_view(const CpuFrame& frame)
+{
+    if (frame.End <= frame.Start)
+        return;
+
+    std::vector<std::string> threadNames = {};
+    {
+        std::lock_guard<std::mutex> lock(m_threadsMutex);
+        for (const auto& buffer : m_threads)
+            threadNames.push_back(buffer->Name);
+    }
+
+    // Rows per thread, only threads that did something this frame get one
+    std::vector<uint32_t> threadDepth(threadNames.size(), 0);
+    std::vector<bool> threadUsed(threadNames.size(), false);
+    for (const CpuZone& zone : frame.Zones)
+    {
+        threadDepth[zone.Thread] = std::max(threadDepth[zone.Thread], zone.Depth + 1);
+        threadUsed[zone.Thread] = true;
+    }
+
+    const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+    const float labelWidth = 120.0f;
+    const float width = std::max(ImGui::GetContentRegionAvail().x - labelWidth, 100.0f);
+    const double scale = width / static_cast<double>(frame.End - frame.Start);
+
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    float y = origin.y;
+
+    for (size_t thread = 0; thread < threadNames.size(); thread++)
+    {
+        if (!threadUsed[thread])
+            continue;
+
+        drawList->AddText(ImVec2(origin.x, y), ImGui::GetColorU32(ImGuiCol_Text),
+                          threadNames[thread].c_str());
+
+        for (const CpuZone& zone : frame.Zones)
+        {
+            if (zone.Thread != thread)
+                continue;
+
+            // Zones that started in an earlier frame get cut off at the frame start
+            const float start = static_cast<float>(
+                std::clamp((zone.Start - frame.Start) * scale, 0.0, static_cast<double>(width)));
+            const float end = static_cast<float>(
+                std::clamp((zone.End - frame.Start) * scale, 0.0, static_cast<double>(width)));
+
+            const ImVec2 min(origin.x + labelWidth + start, y + zone.Depth * rowHeight);
+            const ImVec2 max(origin.x + labelWidth + std::max(end, start + 1.0f),
+                             min.y + rowHeight - 1.0f);
+
+            const float hue = (std::hash<const void*>{}(zone.Name) % 360) / 360.0f;
+            drawList->AddRectFilled(min, max, ImColor::HSV(hue, 0.5f, 0.7f));
+
+            const ImVec4 clip(min.x, min.y, max.x, max.y);
+            drawList->AddText(ImGui::GetFont(), ImGui::GetFontSize(), ImVec2(min.x + 2.0f, min.y),
+                              ImGui::GetColorU32(ImGuiCol_Text), zone.Name, nullptr, 0.0f, &clip);
+
+            if (ImGui::IsMouseHoveringRect(min, max))
+                ImGui::SetTooltip("%s: %.3f ms", zone.Name, (zone.End - zone.Start) / 1e6f);
+        }
+
+        y += threadDepth[thread] * rowHeight + rowHeight * 0.5f;
+    }
+
+    ImGui::Dummy(ImVec2(labelWidth + width, y - origin.y));
+}
+
+CpuProfileScope::CpuProfileScope(const char* name)
+{
+    nijiEngine.m_profiler.begin_zone(name);
+}
+
+CpuProfileScope::CpuProfileScope(const std::string& name)
+{
+    nijiEngine.m_profiler.begin_zone(nijiEngine.m_profiler.intern(name));
+}
+
+CpuProfileScope::~CpuProfileScope()
+{
+    nijiEngine.m_profiler.end_zone();
+}
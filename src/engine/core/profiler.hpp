@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Set by CMake (NIJI_CPU_PROFILER option), with 0 every NIJI_PROFILE_* macro compiles to nothing
+#ifndef NIJI_CPU_PROFILER
+#define NIJI_CPU_PROFILER 1
+#endif
+
+namespace niji
+{
+
+// Zones a thread can finish between two frame marks, anything past that gets dropped
+constexpr uint32_t CPU_PROFILER_THREAD_EVENTS = 16384;
+// Frames kept for the flame view and for hitch dumps
+constexpr uint32_t CPU_PROFILER_HISTORY = 240;
+
+struct CpuZone
+{
+    const char* Name = nullptr;
+    uint32_t Thread = 0;
+    uint32_t Depth = 0;
+    int64_t Start = 0; // Nanoseconds since the profiler got created
+    int64_t End = 0;
+};
+
+struct CpuFrame
+{
+    uint64_t Number = 0;
+    int64_t Start = 0;
+    int64_t End = 0;
+    // Zones that ended during the frame, any thread
+    std::vector<CpuZone> Zones = {};
+
+    float duration_ms() const
+    {
+        return static_cast<float>(End - Start) / 1e6f;
+    }
+};
+
+// Scoped CPU zones, recorded through the NIJI_PROFILE_* macros. Every thread writes finished
+// zones into its own ring buffer (single producer / single consumer, no locks), frame_mark()
+// collects them on the main thread into a rolling window of frames. A frame slower than the
+// hitch threshold dumps that window to a Chrome trace file.
+class CpuProfiler
+{
+  public:
+    CpuProfiler();
+    ~CpuProfiler();
+
+    // Name of the calling thread in the flame view and in traces
+    void set_thread_name(const std::string& name);
+    // Stable copy of a name that doesn't outlive its zone (render graph pass names...)
+    const char* intern(const std::string& name);
+
+    // `name` has to stay valid until the profiler is gone (string literals, intern())
+    void begin_zone(const char* name);
+    void end_zone();
+
+    // Closes the current frame and starts the next one, main thread only
+    void frame_mark();
+
+    // Chrome trace event format, also opens in Perfetto
+    bool export_chrome_trace(const std::string& path) const;
+
+    void debug_panel();
+
+  private:
+    struct ThreadBuffer;
+
+    ThreadBuffer& get_thread_buffer();
+    void collect(CpuFrame& frame);
+    void check_hitch(const CpuFrame& frame);
+    // Oldest to newest
+    std::vector<const CpuFrame*> get_history() const;
+    bool write_trace(const std::string& path, const std::vector<const CpuFrame*>& frames) const;
+    int64_t now() const;
+
+    void flame_view(const CpuFrame& frame);
+
+  private:
+    std::chrono::steady_clock::time_point m_epoch = {};
+
+    mutable std::mutex m_threadsMutex = {};
+    std::vector<std::unique_ptr<ThreadBuffer>> m_threads = {};
+
+    std::mutex m_namesMutex = {};
+    std::unordered_set<std::string> m_names = {};
+
+    std::vector<CpuFrame> m_history = {};
+    uint32_t m_historyNext = 0;
+    uint32_t m_historyCount = 0;
+    uint64_t m_frameNumber = 0;
+    int64_t m_frameStart = 0;
+
+    bool m_paused = false;
+    bool m_autoDump = true;
+    float m_hitchThresholdMs = 50.0f;
+    // Frames since the last dump, one dump per window at most
+    uint32_t m_framesSinceDump = CPU_PROFILER_HISTORY;
+    std::string m_lastDump = {};
+    uint64_t m_droppedZones = 0;
+
+    // Frames back from the newest one, shown in the flame view
+    int m_selectedFrame = 0;
+};
+
+// Ends its zone when it goes out of scope
+class CpuProfileScope
+{
+  public:
+    explicit CpuProfileScope(const char* name);
+    // Interned, for names built at runtime
+    explicit CpuProfileScope(const std::string& name);
+    ~CpuProfileScope();
+
+    CpuProfileScope(const CpuProfileScope&) = delete;
+    CpuProfileScope& operator=(const CpuProfileScope&) = delete;
+};
+
+} // namespace niji
+
+#if NIJI_CPU_PROFILER
+#define NIJI_PROFILE_CONCAT_IMPL(a, b) a##b
+#define NIJI_PROFILE_CONCAT(a, b) NIJI_PROFILE_CONCAT_IMPL(a, b)
+#define NIJI_PROFILE_SCOPE(name)                                                                   \
+    ::niji::CpuProfileScope NIJI_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define NIJI_PROFILE_FUNCTION() NIJI_PROFILE_SCOPE(__func__)
+#define NIJI_PROFILE_THREAD(name) nijiEngine.m_profiler.set_thread_name(name)
+#define NIJI_PROFILE_FRAME() nijiEngine.m_profiler.frame_mark()
+#else
+#define NIJI_PROFILE_SCOPE(name) ((void)0)
+#define NIJI_PROFILE_FUNCTION() ((void)0)
+#define NIJI_PROFILE_THREAD(name) ((void)0)
+#define NIJI_PROFILE_FRAME() ((void)0)
+#endif
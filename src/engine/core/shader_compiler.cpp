@@ -0,0 +1,308 @@
+#include "shader_compiler.hpp"
+
+#if NIJI_RUNTIME_SHADER_COMPILER
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include <slang/slang.h>
+#include <slang/slang-com-ptr.h>
+
+#include "engine.hpp"
+
+namespace fs = std::filesystem;
+
+using namespace niji;
+
+struct EntryPointInfo
+{
+    const char* Name = nullptr;
+    SlangStage Stage = SLANG_STAGE_NONE;
+};
+
+static std::vector<EntryPointInfo> get_entry_points(ShaderType type)
+{
+    if (type == ShaderType::FRAG_AND_VERT)
+        return {{"vertex_main", SLANG_STAGE_VERTEX}, {"fragment_main", SLANG_STAGE_FRAGMENT}};
+    if (type == ShaderType::COMPUTE)
+        return {{"compute_main", SLANG_STAGE_COMPUTE}};
+    return {};
+}
+
+static void append_diagnostics(std::string& diagnostics, slang::IBlob* blob)
+{
+    if (blob && blob->getBufferSize() > 0)
+        diagnostics += static_cast<const char*>(blob->getBufferPointer());
+}
+
+// Quiet on a miss, unlike read_binary_file
+static std::vector<char> read_cache_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return {};
+
+    const std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    std::vector<char> buffer(static_cast<size_t>(size));
+    if (!file.read(buffer.data(), size))
+        return {};
+    return buffer;
+}
+
+static bool write_file(const std::string& path, const std::vector<char>& data)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    return file.is_open() && file.write(data.data(), data.size());
+}
+
+void ShaderCompiler::init(const std::string& cacheDir)
+{
+    m_cacheDir = cacheDir;
+    fs::create_directories(m_cacheDir);
+
+    m_worker = std::thread(&ShaderCompiler::worker_loop, this);
+}
+
+void ShaderCompiler::cleanup()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+
+    if (m_worker.joinable())
+        m_worker.join();
+}
+
+std::future<ShaderCompileResult> ShaderCompiler::compile(const Shader& shader, Continuation then)
+{
+    Request request = {};
+    request.Target = shader;
+    request.Then = std::move(then);
+    std::future<ShaderCompileResult> future = request.Promise.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requests.push_back(std::move(request));
+    }
+    m_wake.notify_one();
+
+    return future;
+}
+
+void ShaderCompiler::worker_loop()
+{
+    nijiEngine.m_profiler.set_thread_name("Shader Compiler");
+
+    while (true)
+    {
+        Request request = {};
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_quit || !m_requests.empty(); });
+            if (m_requests.empty())
+                break;
+
+            request = std::move(m_requests.front());
+            m_requests.pop_front();
+        }
+
+        NIJI_PROFILE_SCOPE("Compile Shader");
+
+        ShaderCompileResult result = {};
+        try
+        {
+            result = process(request.Target);
+            if (result.Success && request.Then)
+                request.Then();
+        }
+        catch (const std::exception& e)
+        {
+            result.Success = false;
+            result.Diagnostics += e.what();
+        }
+        request.Promise.set_value(std::move(result));
+    }
+
+    if (m_globalSession)
+    {
+        m_globalSession->release();
+        m_globalSession = nullptr;
+    }
+}
+
+ShaderCompileResult ShaderCompiler::process(const Shader& shader)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    ShaderCompileResult result = {};
+
+    const std::vector<char> sourceFile = read_binary_file(shader.Source);
+    if (sourceFile.empty())
+    {
+        result.Diagnostics = "Failed to read " + shader.Source;
+        return result;
+    }
+    const std::string source(sourceFile.begin(), sourceFile.end());
+
+    const std::vector<EntryPointInfo> entryPoints = get_entry_points(shader.Type);
+    if (entryPoints.size() != shader.Spirv.size())
+    {
+        result.Diagnostics = "Invalid shader type for " + shader.Source;
+        return result;
+    }
+
+    result.Success = true;
+    for (size_t i = 0; i < entryPoints.size(); i++)
+    {
+        const EntryPointInfo& entryPoint = entryPoints[i];
+        result.EntryPoints++;
+
+        // Keyed on the source itself, the shaders don't import any modules yet
+        uint64_t key = hash_bytes(&SHADER_CACHE_VERSION, sizeof(SHADER_CACHE_VERSION));
+        key = hash_bytes(source.data(), source.size(), key);
+        key = hash_bytes(entryPoint.Name, strlen(entryPoint.Name), key);
+        key = hash_bytes(&entryPoint.Stage, sizeof(entryPoint.Stage), key);
+
+        char keyName[32] = {};
+        snprintf(keyName, sizeof(keyName), "%016llx.spv", static_cast<unsigned long long>(key));
+        const std::string cachePath = (fs::path(m_cacheDir) / keyName).string();
+
+        std::vector<char> spirv = read_cache_file(cachePath);
+        if (!spirv.empty())
+            result.CacheHits++;
+        else
+        {
+            if (!compile_entry_point(shader.Source, source, entryPoint.Name, entryPoint.Stage,
+                                     spirv, result.Diagnostics))
+            {
+                result.Success = false;
+                break;
+            }
+
+            if (!write_file(cachePath, spirv))
+                result.Diagnostics += "Failed to write " + cachePath + "\n";
+        }
+
+        if (!write_file(shader.Spirv[i], spirv))
+        {
+            result.Diagnostics += "Failed to write " + shader.Spirv[i] + "\n";
+            result.Success = false;
+            break;
+        }
+    }
+
+    result.CompileMs = std::chrono::duration<float, std::milli>(
+                           std::chrono::high_resolution_clock::now() - start)
+                           .count();
+    return result;
+}
+
+bool ShaderCompiler::compile_entry_point(const std::string& path, const std::string& source,
+                                         const char* entryPoint, uint32_t stage,
+                                         std::vector<char>& spirv, std::string& diagnostics)
+{
+    if (!m_globalSession && SLANG_FAILED(slang::createGlobalSession(&m_globalSession)))
+    {
+        diagnostics += "Failed to create the Slang global session\n";
+        return false;
+    }
+
+    // Same output as the slangc build step (-target spirv -g)
+    slang::TargetDesc targetDesc = {};
+    targetDesc.format = SLANG_SPIRV;
+    targetDesc.profile = m_globalSession->findProfile("spirv_1_5");
+
+    slang::CompilerOptionEntry debugInfo = {};
+    debugInfo.name = slang::CompilerOptionName::DebugInformation;
+    debugInfo.value.kind = slang::CompilerOptionValueKind::Int;
+    debugInfo.value.intValue0 = SLANG_DEBUG_INFO_LEVEL_STANDARD;
+
+    const std::string searchPath = fs::path(path).parent_path().string();
+    const char* searchPaths[] = {searchPath.c_str()};
+
+    slang::SessionDesc sessionDesc = {};
+    sessionDesc.targets = &targetDesc;
+    sessionDesc.targetCount = 1;
+    sessionDesc.searchPaths = searchPaths;
+    sessionDesc.searchPathCount = 1;
+    sessionDesc.compilerOptionEntries = &debugInfo;
+    sessionDesc.compilerOptionEntryCount = 1;
+
+    Slang::ComPtr<slang::ISession> session;
+    if (SLANG_FAILED(m_globalSession->createSession(sessionDesc, session.writeRef())))
+    {
+        diagnostics += "Failed to create a Slang session\n";
+        return false;
+    }
+
+    Slang::ComPtr<slang::IBlob> diagnosticsBlob;
+    const std::string moduleName = fs::path(path).stem().string();
+    slang::IModule* module = session->loadModuleFromSourceString(
+        moduleName.c_str(), path.c_str(), source.c_str(), diagnosticsBlob.writeRef());
+    append_diagnostics(diagnostics, diagnosticsBlob);
+    if (!module)
+        return false;
+
+    Slang::ComPtr<slang::IEntryPoint> entry;
+    diagnosticsBlob = nullptr;
+    module->findAndCheckEntryPoint(entryPoint, static_cast<SlangStage>(stage), entry.writeRef(),
+                                   diagnosticsBlob.writeRef());
+    append_diagnostics(diagnostics, diagnosticsBlob);
+    if (!entry)
+        return false;
+
+    slang::IComponentType* components[] = {module, entry};
+    Slang::ComPtr<slang::IComponentType> program;
+    diagnosticsBlob = nullptr;
+    session->createCompositeComponentType(components, 2, program.writeRef(),
+                                          diagnosticsBlob.writeRef());
+    append_diagnostics(diagnostics, diagnosticsBlob);
+    if (!program)
+        return false;
+
+    Slang::ComPtr<slang::IComponentType> linked;
+    diagnosticsBlob = nullptr;
+    program->link(linked.writeRef(), diagnosticsBlob.writeRef());
+    append_diagnostics(diagnostics, diagnosticsBlob);
+    if (!linked)
+        return false;
+
+    Slang::ComPtr<slang::IBlob> code;
+    diagnosticsBlob = nullptr;
+    linked->getEntryPointCode(0, 0, code.writeRef(), diagnosticsBlob.writeRef());
+    append_diagnostics(diagnostics, diagnosticsBlob);
+    if (!code)
+        return false;
+
+    const char* bytes = static_cast<const char*>(code->getBufferPointer());
+    spirv.assign(bytes, bytes + code->getBufferSize());
+    return true;
+}
+
+#else
+
+using namespace niji;
+
+void ShaderCompiler::init(const std::string& cacheDir) { m_cacheDir = cacheDir; }
+
+void ShaderCompiler::cleanup() {}
+
+std::future<ShaderCompileResult> ShaderCompiler::compile(const Shader& shader, Continuation)
+{
+    ShaderCompileResult result = {};
+    result.Diagnostics = "Built without the runtime shader compiler, rebuild CompileShaders for " +
+                         shader.Source;
+
+    std::promise<ShaderCompileResult> promise = {};
+    promise.set_value(std::move(result));
+    return promise.get_future();
+}
+
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "core/common.hpp"
+
+// Set by CMake (NIJI_RUNTIME_SHADER_COMPILER option, OFF as well when Slang wasn't found), with 0
+// compile() always fails and the passes keep the prebuilt SPIR-V
+#ifndef NIJI_RUNTIME_SHADER_COMPILER
+#define NIJI_RUNTIME_SHADER_COMPILER 1
+#endif
+
+namespace slang
+{
+struct IGlobalSession;
+}
+
+namespace niji
+{
+
+constexpr const char* SHADER_CACHE_DIR = "shaders/cache";
+// Part of every cache key, bump when the compile options below change
+constexpr uint32_t SHADER_CACHE_VERSION = 1;
+
+struct ShaderCompileResult
+{
+    bool Success = false;
+    // Slang's warnings and errors, or what went wrong after compiling
+    std::string Diagnostics = {};
+    // Entry points that came out of the SPIR-V cache instead of getting compiled
+    uint32_t CacheHits = 0;
+    uint32_t EntryPoints = 0;
+    float CompileMs = 0.0f;
+};
+
+// Compiles shaders in-process with the Slang API on its own thread, one request after another.
+// Every entry point's SPIR-V is cached on disk under a hash of the source and the compile
+// options, so reverting an edit (or starting with already seen sources) skips compiling.
+class ShaderCompiler
+{
+  public:
+    // Runs on the compiler thread after a successful compile, e.g. to build the new pipelines.
+    // Throwing fails the request with the exception's message.
+    using Continuation = std::function<void()>;
+
+    void init(const std::string& cacheDir);
+    // Finishes the queued requests first
+    void cleanup();
+
+    // Writes every entry point of `shader` to its Spirv paths
+    std::future<ShaderCompileResult> compile(const Shader& shader, Continuation then = nullptr);
+
+  private:
+    struct Request
+    {
+        Shader Target = {};
+        Continuation Then = nullptr;
+        std::promise<ShaderCompileResult> Promise = {};
+    };
+
+    void worker_loop();
+    ShaderCompileResult process(const Shader& shader);
+    // Compiles one entry point, false with the diagnostics on failure
+    bool compile_entry_point(const std::string& path, const std::string& source,
+                             const char* entryPoint, uint32_t stage, std::vector<char>& spirv,
+                             std::string& diagnostics);
+
+  private:
+    std::string m_cacheDir = {};
+    // Created on the first request, the global session never leaves the compiler thread
+    slang::IGlobalSession* m_globalSession = nullptr;
+
+    std::thread m_worker = {};
+    std::mutex m_mutex = {};
+    std::condition_variable m_wake = {};
+    std::deque<Request> m_requests = {};
+    bool m_quit = false;
+};
+
+} // namespace niji
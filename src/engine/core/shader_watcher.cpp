@@ -0,0 +1,490 @@
+#include "shader_watcher.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include "engine.hpp"
+
+namespace fs = std::filesystem;
+
+using namespace niji;
+
+// Absolute and lexically normal, so paths from track(), imports and OS events compare equal
+static std::string normalize(const fs::path& path)
+{
+    std::error_code error = {};
+    fs::path absolute = fs::absolute(path, error);
+    return (error ? path : absolute).lexically_normal().string();
+}
+
+#if defined(__linux__)
+
+struct ShaderWatcher::Backend
+{
+    Backend()
+    {
+        m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        // Non-blocking, draining the wake bytes must not block once the pipe is empty
+        if (m_inotify < 0 || pipe2(m_wakePipe, O_NONBLOCK | O_CLOEXEC) != 0)
+            printf("[ShaderWatcher]: Failed to create the inotify instance \n");
+    }
+
+    ~Backend()
+    {
+        if (m_inotify >= 0)
+            close(m_inotify);
+        for (int fd : m_wakePipe)
+        {
+            if (fd >= 0)
+                close(fd);
+        }
+    }
+
+    void watch(const std::string& file)
+    {
+        const std::string directory = fs::path(file).parent_path().string();
+        for (const auto& [wd, path] : m_directories)
+        {
+            if (path == directory)
+                return;
+        }
+
+        // Directories rather than files, editors that save through a rename replace the inode
+        const int wd = inotify_add_watch(m_inotify, directory.c_str(),
+                                         IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd >= 0)
+            m_directories[wd] = directory;
+    }
+
+    void wait(int timeoutMs, std::vector<std::string>& changedFiles)
+    {
+        pollfd fds[2] = {};
+        fds[0].fd = m_inotify;
+        fds[0].events = POLLIN;
+        fds[1].fd = m_wakePipe[0];
+        fds[1].events = POLLIN;
+
+        if (poll(fds, 2, timeoutMs) <= 0)
+            return;
+
+        char buffer[4096] = {};
+        if (fds[1].revents & POLLIN)
+        {
+            while (read(m_wakePipe[0], buffer, sizeof(buffer)) == static_cast<ssize_t>(sizeof(buffer)))
+            {
+            }
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            // inotify_event is variable sized, the buffer has to be aligned for it
+            alignas(inotify_event) char events[4096] = {};
+            ssize_t length = 0;
+            while ((length = read(m_inotify, events, sizeof(events))) > 0)
+            {
+                for (char* ptr = events; ptr < events + length;)
+                {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+                    auto directory = m_directories.find(event->wd);
+                    if (event->len > 0 && directory != m_directories.end())
+                        changedFiles.push_back(
+                            normalize(fs::path(directory->second) / event->name));
+                    ptr += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+    }
+
+    void wake()
+    {
+        const char byte = 1;
+        [[maybe_unused]] ssize_t written = write(m_wakePipe[1], &byte, 1);
+    }
+
+  private:
+    int m_inotify = -1;
+    int m_wakePipe[2] = {-1, -1};
+    std::unordered_map<int, std::string> m_directories = {};
+};
+
+#elif defined(_WIN32)
+
+struct ShaderWatcher::Backend
+{
+    Backend()
+    {
+        m_wakeEvent = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    }
+
+    ~Backend()
+    {
+        for (auto& directory : m_directories)
+        {
+            CancelIo(directory->Handle);
+            CloseHandle(directory->Overlapped.hEvent);
+            CloseHandle(directory->Handle);
+        }
+        CloseHandle(m_wakeEvent);
+    }
+
+    void watch(const std::string& file)
+    {
+        const std::string path = fs::path(file).parent_path().string();
+        for (const auto& directory : m_directories)
+        {
+            if (directory->Path == path)
+                return;
+        }
+
+        // WaitForMultipleObjects takes the wake event plus 63 directories
+        if (m_directories.size() >= MAXIMUM_WAIT_OBJECTS - 1)
+        {
+            printf("[ShaderWatcher]: Too many directories, not watching %s \n", path.c_str());
+            return;
+        }
+
+        auto directory = std::make_unique<Directory>();
+        directory->Path = path;
+        directory->Handle =
+            CreateFileA(path.c_str(), FILE_LIST_DIRECTORY,
+                        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                        OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (directory->Handle == INVALID_HANDLE_VALUE)
+            return;
+
+        directory->Overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        issue_read(*directory);
+        m_directories.push_back(std::move(directory));
+    }
+
+    void wait(int timeoutMs, std::vector<std::string>& changedFiles)
+    {
+        HANDLE handles[MAXIMUM_WAIT_OBJECTS] = {m_wakeEvent};
+        DWORD count = 1;
+        for (const auto& directory : m_directories)
+            handles[count++] = directory->Overlapped.hEvent;
+
+        const DWORD result = WaitForMultipleObjects(
+            count, handles, FALSE, timeoutMs < 0 ? INFINITE : static_cast<DWORD>(timeoutMs));
+        if (result <= WAIT_OBJECT_0 || result >= WAIT_OBJECT_0 + count)
+            return;
+
+        Directory& directory = *m_directories[result - WAIT_OBJECT_0 - 1];
+        DWORD bytes = 0;
+        // 0 bytes means the buffer overflowed, the next save still gets caught
+        if (GetOverlappedResult(directory.Handle, &directory.Overlapped, &bytes, FALSE) &&
+            bytes > 0)
+        {
+            for (const char* ptr = directory.Buffer;;)
+            {
+                const FILE_NOTIFY_INFORMATION* info =
+                    reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(ptr);
+                const std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                changedFiles.push_back(normalize(fs::path(directory.Path) / fs::path(name)));
+
+                if (info->NextEntryOffset == 0)
+                    break;
+                ptr += info->NextEntryOffset;
+            }
+        }
+
+        ResetEvent(directory.Overlapped.hEvent);
+        issue_read(directory);
+    }
+
+    void wake()
+    {
+        SetEvent(m_wakeEvent);
+    }
+
+  private:
+    struct Directory
+    {
+        std::string Path = {};
+        HANDLE Handle = INVALID_HANDLE_VALUE;
+        OVERLAPPED Overlapped = {};
+        alignas(DWORD) char Buffer[16384] = {};
+    };
+
+    void issue_read(Directory& directory)
+    {
+        ReadDirectoryChangesW(directory.Handle, directory.Buffer, sizeof(directory.Buffer), FALSE,
+                              FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+                              nullptr, &directory.Overlapped, nullptr);
+    }
+
+    HANDLE m_wakeEvent = nullptr;
+    std::vector<std::unique_ptr<Directory>> m_directories = {};
+};
+
+#else
+
+// No change notifications, the watcher thread compares timestamps every debounce interval
+struct ShaderWatcher::Backend
+{
+    void watch(const std::string& file)
+    {
+        std::error_code error = {};
+        m_timestamps.emplace(file, fs::last_write_time(file, error));
+    }
+
+    void wait(int timeoutMs, std::vector<std::string>& changedFiles)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait_for(lock, std::chrono::milliseconds(SHADER_WATCH_DEBOUNCE_MS),
+                            [this]() { return m_woken; });
+            m_woken = false;
+        }
+
+        for (auto& [file, timestamp] : m_timestamps)
+        {
+            std::error_code error = {};
+            const fs::file_time_type current = fs::last_write_time(file, error);
+            if (!error && current != timestamp)
+            {
+                timestamp = current;
+                changedFiles.push_back(file);
+            }
+        }
+    }
+
+    void wake()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_woken = true;
+        }
+        m_wake.notify_one();
+    }
+
+  private:
+    std::unordered_map<std::string, fs::file_time_type> m_timestamps = {};
+    std::mutex m_mutex = {};
+    std::condition_variable m_wake = {};
+    bool m_woken = false;
+};
+
+#endif
+
+ShaderWatcher::ShaderWatcher() = default;
+ShaderWatcher::~ShaderWatcher() = default;
+
+void ShaderWatcher::init()
+{
+    m_backend = std::make_unique<Backend>();
+    m_worker = std::thread(&ShaderWatcher::worker_loop, this);
+}
+
+void ShaderWatcher::cleanup()
+{
+    if (!m_backend)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_backend->wake();
+
+    if (m_worker.joinable())
+        m_worker.join();
+    m_backend.reset();
+}
+
+void ShaderWatcher::track(const std::string& source)
+{
+    if (std::find(m_trackedSources.begin(), m_trackedSources.end(), source) !=
+        m_trackedSources.end())
+        return;
+
+    m_trackedSources.push_back(source);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_newSources.push_back(source);
+    }
+    if (m_backend)
+        m_backend->wake();
+}
+
+void ShaderWatcher::drain(std::vector<std::string>& changed)
+{
+    const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+    const uint32_t head = m_head.load(std::memory_order_acquire);
+    if (tail == head)
+        return;
+
+    for (uint32_t i = tail; i != head; i++)
+    {
+        const std::string& source = m_trackedSources[m_events[i % SHADER_WATCH_QUEUE_SIZE]];
+        if (std::find(changed.begin(), changed.end(), source) == changed.end())
+            changed.push_back(source);
+    }
+    m_tail.store(head, std::memory_order_release);
+}
+
+void ShaderWatcher::worker_loop()
+{
+    nijiEngine.m_profiler.set_thread_name("Shader Watcher");
+
+    std::vector<std::string> changedFiles = {};
+    int timeoutMs = -1;
+    while (true)
+    {
+        // Sources tracked before init() get picked up before the first wait
+        std::vector<std::string> newSources = {};
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_quit)
+                break;
+            newSources.swap(m_newSources);
+        }
+        for (const std::string& source : newSources)
+            add_source(source);
+
+        m_backend->wait(timeoutMs, changedFiles);
+
+        const auto now = std::chrono::steady_clock::now();
+        for (const std::string& file : changedFiles)
+        {
+            if (m_dependents.count(file))
+                m_pending[file] = now;
+        }
+        changedFiles.clear();
+
+        flush_pending(now, timeoutMs);
+    }
+}
+
+void ShaderWatcher::add_source(const std::string& source)
+{
+    const uint32_t index = static_cast<uint32_t>(m_sources.size());
+    m_sources.push_back(normalize(source));
+    m_sourceFiles.emplace_back();
+    scan_dependencies(index);
+}
+
+// Slang pulls in other files through `import a.b;` (a/b.slang), `import "file.slang";`,
+// `__include` with the same two forms and the preprocessor's `#include "file"`
+static bool parse_dependency(const std::string& line, std::string& dependency)
+{
+    const size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos)
+        return false;
+
+    size_t nameStart = std::string::npos;
+    for (const char* keyword : {"import ", "__include ", "#include "})
+    {
+        if (line.compare(start, strlen(keyword), keyword) == 0)
+        {
+            nameStart = line.find_first_not_of(" \t", start + strlen(keyword));
+            break;
+        }
+    }
+    if (nameStart == std::string::npos)
+        return false;
+
+    if (line[nameStart] == '"')
+    {
+        const size_t end = line.find('"', nameStart + 1);
+        if (end == std::string::npos)
+            return false;
+        dependency = line.substr(nameStart + 1, end - nameStart - 1);
+        return true;
+    }
+
+    const size_t end = line.find_first_of("; \t", nameStart);
+    std::string module = line.substr(nameStart, end - nameStart);
+    if (module.empty() || module[0] == '<')
+        return false;
+
+    std::replace(module.begin(), module.end(), '.', '/');
+    dependency = module + ".slang";
+    return true;
+}
+
+void ShaderWatcher::scan_dependencies(uint32_t source)
+{
+    for (const std::string& file : m_sourceFiles[source])
+        m_dependents[file].erase(source);
+
+    // Breadth first through the imports, a file gets visited once even with import cycles
+    std::vector<std::string> files = {m_sources[source]};
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        std::ifstream stream(files[i]);
+        std::string line = {};
+        std::string dependency = {};
+        while (std::getline(stream, line))
+        {
+            if (!parse_dependency(line, dependency))
+                continue;
+
+            const std::string path = normalize(fs::path(files[i]).parent_path() / dependency);
+            if (std::find(files.begin(), files.end(), path) == files.end())
+                files.push_back(path);
+        }
+    }
+
+    for (const std::string& file : files)
+    {
+        m_dependents[file].insert(source);
+        m_backend->watch(file);
+    }
+    m_sourceFiles[source] = std::move(files);
+}
+
+void ShaderWatcher::flush_pending(std::chrono::steady_clock::time_point now, int& timeoutMs)
+{
+    const auto debounce = std::chrono::milliseconds(SHADER_WATCH_DEBOUNCE_MS);
+
+    std::unordered_set<uint32_t> changedSources = {};
+    timeoutMs = -1;
+    for (auto it = m_pending.begin(); it != m_pending.end();)
+    {
+        const auto quiet = now - it->second;
+        if (quiet < debounce)
+        {
+            // Wake up again once the most recent burst went quiet
+            const int remaining = static_cast<int>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(debounce - quiet).count());
+            timeoutMs = timeoutMs < 0 ? remaining + 1 : std::min(timeoutMs, remaining + 1);
+            ++it;
+            continue;
+        }
+
+        for (uint32_t source : m_dependents[it->first])
+            changedSources.insert(source);
+        it = m_pending.erase(it);
+    }
+
+    for (uint32_t source : changedSources)
+    {
+        // The edit may have added or removed imports
+        scan_dependencies(source);
+        post(source);
+    }
+}
+
+void ShaderWatcher::post(uint32_t source)
+{
+    const uint32_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) >= SHADER_WATCH_QUEUE_SIZE)
+        return;
+
+    m_events[head % SHADER_WATCH_QUEUE_SIZE] = source;
+    m_head.store(head + 1, std::memory_order_release);
+}
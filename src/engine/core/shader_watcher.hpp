@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace niji
+{
+
+// Quiet time after the last write to a file before its change gets posted, editors tend to
+// save in bursts (truncate, write, rename, touch)
+constexpr uint32_t SHADER_WATCH_DEBOUNCE_MS = 100;
+// Changes the main thread hasn't drained yet, anything past this is dropped
+constexpr uint32_t SHADER_WATCH_QUEUE_SIZE = 256;
+
+// Watches shader sources and every file they import or include from one thread: inotify on
+// Linux, ReadDirectoryChangesW on Windows, a timestamp poll on that thread elsewhere. Debounced
+// changes land in a single producer / single consumer queue that the main thread drains once per
+// frame, which costs one atomic load when nothing changed.
+class ShaderWatcher
+{
+  public:
+    ShaderWatcher();
+    ~ShaderWatcher();
+
+    void init();
+    void cleanup();
+
+    // Main thread. Dependencies get scanned (and rescanned on every change) on the watcher thread.
+    void track(const std::string& source);
+
+    // Main thread, once per frame. Appends the tracked sources that changed since the last call,
+    // as they were passed to track(), each one once.
+    void drain(std::vector<std::string>& changed);
+
+  private:
+    struct Backend;
+
+    void worker_loop();
+    // Watcher thread only from here on
+    void add_source(const std::string& source);
+    void scan_dependencies(uint32_t source);
+    void flush_pending(std::chrono::steady_clock::time_point now, int& timeoutMs);
+    void post(uint32_t source);
+
+  private:
+    std::unique_ptr<Backend> m_backend;
+    std::thread m_worker = {};
+
+    // Main thread, indexed by the queued events
+    std::vector<std::string> m_trackedSources = {};
+
+    std::mutex m_mutex = {};
+    std::vector<std::string> m_newSources = {};
+    bool m_quit = false;
+
+    // Normalized paths of the sources, the files each one depends on (itself included) and the
+    // sources every watched file feeds into
+    std::vector<std::string> m_sources = {};
+    std::vector<std::vector<std::string>> m_sourceFiles = {};
+    std::unordered_map<std::string, std::unordered_set<uint32_t>> m_dependents = {};
+    // Last raw event per file, posted once it's been quiet for SHADER_WATCH_DEBOUNCE_MS
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> m_pending = {};
+
+    std::array<uint32_t, SHADER_WATCH_QUEUE_SIZE> m_events = {};
+    std::atomic<uint32_t> m_head{0};
+    std::atomic<uint32_t> m_tail{0};
+};
+
+} // namespace niji
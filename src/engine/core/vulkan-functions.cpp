@@ -6,8 +6,11 @@ PFN_vkCmdEndRenderingKHR VKCmdEndRenderingKHR = nullptr;
 PFN_vkSetDebugUtilsObjectNameEXT VKSetDebugUtilsObjectNameEXT = nullptr;
 PFN_vkCmdPipelineBarrier2KHR VKCmdPipelineBarrier2KHR = nullptr;
 PFN_vkCmdPushDescriptorSetKHR VKCmdPushDescriptorSetKHR = nullptr;
+PFN_vkCmdPushDescriptorSetWithTemplateKHR VKCmdPushDescriptorSetWithTemplateKHR = nullptr;
 PFN_vkCmdBeginDebugUtilsLabelEXT VKCmdBeginDebugUtilsLabelEXT = nullptr;
 PFN_vkCmdEndDebugUtilsLabelEXT VKCmdEndDebugUtilsLabelEXT = nullptr;
+PFN_vkGetPipelineExecutablePropertiesKHR VKGetPipelineExecutablePropertiesKHR = nullptr;
+PFN_vkGetPipelineExecutableStatisticsKHR VKGetPipelineExecutableStatisticsKHR = nullptr;
 
 void niji::load_vulkan_function_pointers(VkDevice device)
 {
@@ -21,8 +24,15 @@ void niji::load_vulkan_function_pointers(VkDevice device)
         vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2KHR"));
     VKCmdPushDescriptorSetKHR = reinterpret_cast<PFN_vkCmdPushDescriptorSetKHR>(
         vkGetDeviceProcAddr(device, "vkCmdPushDescriptorSetKHR"));
+    VKCmdPushDescriptorSetWithTemplateKHR =
+        reinterpret_cast<PFN_vkCmdPushDescriptorSetWithTemplateKHR>(
+            vkGetDeviceProcAddr(device, "vkCmdPushDescriptorSetWithTemplateKHR"));
     VKCmdBeginDebugUtilsLabelEXT = reinterpret_cast<PFN_vkCmdBeginDebugUtilsLabelEXT>(
         vkGetDeviceProcAddr(device, "vkCmdBeginDebugUtilsLabelEXT"));
     VKCmdEndDebugUtilsLabelEXT = reinterpret_cast<PFN_vkCmdEndDebugUtilsLabelEXT>(
         vkGetDeviceProcAddr(device, "vkCmdEndDebugUtilsLabelEXT"));
+    VKGetPipelineExecutablePropertiesKHR = reinterpret_cast<PFN_vkGetPipelineExecutablePropertiesKHR>(
+        vkGetDeviceProcAddr(device, "vkGetPipelineExecutablePropertiesKHR"));
+    VKGetPipelineExecutableStatisticsKHR = reinterpret_cast<PFN_vkGetPipelineExecutableStatisticsKHR>(
+        vkGetDeviceProcAddr(device, "vkGetPipelineExecutableStatisticsKHR"));
 }
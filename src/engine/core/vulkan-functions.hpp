@@ -5,8 +5,12 @@ extern PFN_vkCmdEndRenderingKHR VKCmdEndRenderingKHR;
 extern PFN_vkSetDebugUtilsObjectNameEXT VKSetDebugUtilsObjectNameEXT;
 extern PFN_vkCmdPipelineBarrier2KHR VKCmdPipelineBarrier2KHR;
 extern PFN_vkCmdPushDescriptorSetKHR VKCmdPushDescriptorSetKHR;
+extern PFN_vkCmdPushDescriptorSetWithTemplateKHR VKCmdPushDescriptorSetWithTemplateKHR;
 extern PFN_vkCmdBeginDebugUtilsLabelEXT VKCmdBeginDebugUtilsLabelEXT;
 extern PFN_vkCmdEndDebugUtilsLabelEXT VKCmdEndDebugUtilsLabelEXT;
+// Only loaded when VK_KHR_pipeline_executable_properties is available
+extern PFN_vkGetPipelineExecutablePropertiesKHR VKGetPipelineExecutablePropertiesKHR;
+extern PFN_vkGetPipelineExecutableStatisticsKHR VKGetPipelineExecutableStatisticsKHR;
 
 namespace niji
 {
@@ -12,7 +12,8 @@ void Engine::run()
 }
 
 Engine::Engine()
-    : ecs(*new ECS()), m_context(*new Context()), m_editor(*new Editor()), m_logger(*new Logger())
+    : ecs(*new ECS()), m_context(*new Context()), m_editor(*new Editor()), m_logger(*new Logger()),
+      m_profiler(*new CpuProfiler()), m_jobSystem(*new JobSystem())
 {
 }
 
@@ -21,33 +22,72 @@ Engine::~Engine()
     delete &ecs;
     delete &m_context;
     delete &m_editor;
+    delete &m_profiler;
+    delete &m_jobSystem;
 }
 
-void Engine::init()
+void Engine::init(const EngineConfig& config)
 {
-    m_context.init();
+    m_config = config;
+    m_jobSystem.init();
+    m_context.init(config);
+
+    m_editor.add_debug_menu_panel("CPU Profiler Panel",
+                                  std::bind(&CpuProfiler::debug_panel, &m_profiler));
+    m_editor.add_debug_menu_panel("Pipeline Cache Panel",
+                                  std::bind(&PipelineCache::debug_panel,
+                                            &m_context.get_pipeline_cache()));
+    m_editor.add_debug_menu_panel("Pipeline Library Panel",
+                                  std::bind(&PipelineLibrary::debug_panel,
+                                            &m_context.get_pipeline_library()));
+    m_editor.add_debug_menu_panel("Job System Panel",
+                                  std::bind(&JobSystem::debug_panel, &m_jobSystem));
+    m_editor.add_debug_menu_panel("ECS Scheduler Panel", std::bind(&ECS::scheduler_panel, &ecs));
 }
 
 void Engine::update()
 {
     auto time = std::chrono::high_resolution_clock::now();
-    while (!glfwWindowShouldClose(m_context.m_window))
+    uint32_t frame = 0;
+    while (!m_exitRequested && (m_context.is_headless()
+                                    ? frame < m_config.HeadlessFrames
+                                    : !glfwWindowShouldClose(m_context.m_window)))
     {
-        glfwPollEvents();
+        // Runs before input gets polled, so anything blocking here doesn't age the input
+        {
+            NIJI_PROFILE_SCOPE("Begin Frame");
+            ecs.systems_begin_frame();
+        }
+
+        if (!m_context.is_headless())
+        {
+            NIJI_PROFILE_SCOPE("Poll Events");
+            glfwPollEvents();
+        }
 
         auto ctime = std::chrono::high_resolution_clock::now();
         auto elapsed = ctime - time;
         float dt =
             (float)((double)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() /
                     1000000.0);
+        // Fixed step, so a headless run renders the same frames no matter how fast the device is
+        if (m_context.is_headless())
+            dt = HEADLESS_DELTA_TIME;
 
         ecs.systems_update(dt);
         ecs.remove_deleted();
 
         ecs.systems_render();
 
+        m_context.get_pipeline_cache().update(dt);
+
         time = ctime;
+        frame++;
+
+        NIJI_PROFILE_FRAME();
     }
+    // Systems finish the frames they still have going on other threads
+    ecs.systems_end_frames();
     vkDeviceWaitIdle(m_context.m_device);
 }
 
@@ -55,6 +95,7 @@ void Engine::cleanup()
 {
     ecs.systems_cleanup();
     m_context.cleanup();
+    m_jobSystem.cleanup();
 }
 
 void Engine::add_line(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& color)
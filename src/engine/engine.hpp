@@ -5,20 +5,36 @@
 
 #include "core/editor/editor.hpp"
 #include "core/context.hpp"
+#include "core/config.hpp"
 #include "core/logger.hpp"
+#include "core/profiler.hpp"
+#include "core/job_system.hpp"
 #include "core/ecs.hpp"
 
 namespace niji
 {
+constexpr float HEADLESS_DELTA_TIME = 1.0f / 60.0f;
+
 class Engine
 {
   public:
     Engine();
     ~Engine();
-    void init();
+    void init(const EngineConfig& config = {});
     void run();
     void cleanup();
 
+    // Leaves the main loop once the current frame is done, main() returns `exitCode`
+    void request_exit(int exitCode = 0)
+    {
+        m_exitRequested = true;
+        m_exitCode = exitCode;
+    }
+    int get_exit_code() const
+    {
+        return m_exitCode;
+    }
+
     void add_line(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& color);
 
     void add_sphere(const glm::vec3& center, const float& radius, const glm::vec3& color,
@@ -32,11 +48,17 @@ class Engine
     Context& m_context;
     Editor& m_editor;
     Logger& m_logger;
+    CpuProfiler& m_profiler;
+    JobSystem& m_jobSystem;
+
+    EngineConfig m_config = {};
 
   private:
-    friend class LineRenderPass;
+    friend class Renderer;
 
     std::vector<DebugLine> m_debugLines = {};
+    bool m_exitRequested = false;
+    int m_exitCode = 0;
 };
 } // namespace niji
 
@@ -0,0 +1,181 @@
+#include "frustum_culler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define NIJI_CULLING_SSE 1
+#include <immintrin.h>
+#else
+#define NIJI_CULLING_SSE 0
+#endif
+
+using namespace niji;
+
+void FrustumCuller::resize(uint32_t count)
+{
+    m_count = count;
+
+    const size_t padded = (static_cast<size_t>(count) + 3) & ~static_cast<size_t>(3);
+
+    m_localCenters.resize(count);
+    m_localExtents.resize(count);
+
+    m_centerX.assign(padded, 0.0f);
+    m_centerY.assign(padded, 0.0f);
+    m_centerZ.assign(padded, 0.0f);
+    m_extentX.assign(padded, 0.0f);
+    m_extentY.assign(padded, 0.0f);
+    m_extentZ.assign(padded, 0.0f);
+}
+
+void FrustumCuller::set_local_bounds(uint32_t index, const glm::vec3& boundsMin,
+                                     const glm::vec3& boundsMax)
+{
+    m_localCenters[index] = (boundsMin + boundsMax) * 0.5f;
+    m_localExtents[index] = (boundsMax - boundsMin) * 0.5f;
+}
+
+void FrustumCuller::update_world_bounds(uint32_t index, const glm::mat4& world)
+{
+    const glm::vec3& center = m_localCenters[index];
+    const glm::vec3& extent = m_localExtents[index];
+
+    // Arvo: the world extents are the local extents projected onto the absolute basis vectors
+    const glm::vec3 worldCenter = glm::vec3(world * glm::vec4(center, 1.0f));
+    const glm::vec3 worldExtent = glm::abs(glm::vec3(world[0])) * extent.x +
+                                  glm::abs(glm::vec3(world[1])) * extent.y +
+                                  glm::abs(glm::vec3(world[2])) * extent.z;
+
+    m_centerX[index] = worldCenter.x;
+    m_centerY[index] = worldCenter.y;
+    m_centerZ[index] = worldCenter.z;
+    m_extentX[index] = worldExtent.x;
+    m_extentY[index] = worldExtent.y;
+    m_extentZ[index] = worldExtent.z;
+}
+
+void FrustumCuller::cull(const glm::vec4 (&planes)[6], const glm::vec3& cameraPos,
+                         float projScale, float minScreenSize, std::vector<uint32_t>& visible)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    visible.clear();
+    m_stats = {};
+    m_stats.Tested = m_count;
+
+    // The projected diameter (as a fraction of the screen height) is roughly radius * P11 / distance,
+    // so an object is too small when radius^2 * (P11 / minSize)^2 < distance^2
+    const float sizeScale =
+        minScreenSize > 0.0f ? (projScale * projScale) / (minScreenSize * minScreenSize) : 0.0f;
+
+#if NIJI_CULLING_SSE
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+    __m128 absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+    for (int p = 0; p < 6; p++)
+    {
+        planeX[p] = _mm_set1_ps(planes[p].x);
+        planeY[p] = _mm_set1_ps(planes[p].y);
+        planeZ[p] = _mm_set1_ps(planes[p].z);
+        planeW[p] = _mm_set1_ps(planes[p].w);
+        absPlaneX[p] = _mm_and_ps(planeX[p], signMask);
+        absPlaneY[p] = _mm_and_ps(planeY[p], signMask);
+        absPlaneZ[p] = _mm_and_ps(planeZ[p], signMask);
+    }
+
+    const __m128 camX = _mm_set1_ps(cameraPos.x);
+    const __m128 camY = _mm_set1_ps(cameraPos.y);
+    const __m128 camZ = _mm_set1_ps(cameraPos.z);
+    const __m128 scale = _mm_set1_ps(sizeScale);
+
+    for (uint32_t i = 0; i < m_count; i += 4)
+    {
+        const __m128 cx = _mm_loadu_ps(&m_centerX[i]);
+        const __m128 cy = _mm_loadu_ps(&m_centerY[i]);
+        const __m128 cz = _mm_loadu_ps(&m_centerZ[i]);
+        const __m128 ex = _mm_loadu_ps(&m_extentX[i]);
+        const __m128 ey = _mm_loadu_ps(&m_extentY[i]);
+        const __m128 ez = _mm_loadu_ps(&m_extentZ[i]);
+
+        // Outside when the box is fully behind any plane (distance < -projected extent)
+        __m128 outside = zero;
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 dist = _mm_add_ps(_mm_mul_ps(cx, planeX[p]), _mm_mul_ps(cy, planeY[p]));
+            dist = _mm_add_ps(dist, _mm_add_ps(_mm_mul_ps(cz, planeZ[p]), planeW[p]));
+
+            __m128 radius = _mm_add_ps(_mm_mul_ps(ex, absPlaneX[p]), _mm_mul_ps(ey, absPlaneY[p]));
+            radius = _mm_add_ps(radius, _mm_mul_ps(ez, absPlaneZ[p]));
+
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), zero));
+        }
+        const int outsideMask = _mm_movemask_ps(outside);
+
+        int smallMask = 0;
+        if (sizeScale > 0.0f)
+        {
+            const __m128 dx = _mm_sub_ps(cx, camX);
+            const __m128 dy = _mm_sub_ps(cy, camY);
+            const __m128 dz = _mm_sub_ps(cz, camZ);
+            __m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            distSq = _mm_add_ps(distSq, _mm_mul_ps(dz, dz));
+
+            __m128 radiusSq = _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey));
+            radiusSq = _mm_add_ps(radiusSq, _mm_mul_ps(ez, ez));
+
+            smallMask = _mm_movemask_ps(_mm_cmplt_ps(_mm_mul_ps(radiusSq, scale), distSq));
+        }
+
+        // The last group can contain padding lanes
+        const uint32_t lanes = std::min(4u, m_count - i);
+        for (uint32_t lane = 0; lane < lanes; lane++)
+        {
+            const int bit = 1 << lane;
+            if (outsideMask & bit)
+                m_stats.FrustumCulled++;
+            else if (smallMask & bit)
+                m_stats.SmallCulled++;
+            else
+                visible.push_back(i + lane);
+        }
+    }
+#else
+    for (uint32_t i = 0; i < m_count; i++)
+    {
+        const glm::vec3 center = glm::vec3(m_centerX[i], m_centerY[i], m_centerZ[i]);
+        const glm::vec3 extent = glm::vec3(m_extentX[i], m_extentY[i], m_extentZ[i]);
+
+        bool outside = false;
+        for (int p = 0; p < 6 && !outside; p++)
+        {
+            const glm::vec3 normal = glm::vec3(planes[p]);
+            const float dist = glm::dot(normal, center) + planes[p].w;
+            const float radius = glm::dot(glm::abs(normal), extent);
+            outside = dist + radius < 0.0f;
+        }
+
+        if (outside)
+        {
+            m_stats.FrustumCulled++;
+            continue;
+        }
+
+        const glm::vec3 toCamera = center - cameraPos;
+        if (sizeScale > 0.0f && glm::dot(extent, extent) * sizeScale < glm::dot(toCamera, toCamera))
+        {
+            m_stats.SmallCulled++;
+            continue;
+        }
+
+        visible.push_back(i);
+    }
+#endif
+
+    m_stats.Visible = static_cast<uint32_t>(visible.size());
+    m_stats.CullTimeMs = std::chrono::duration<float, std::milli>(
+                             std::chrono::high_resolution_clock::now() - start)
+                             .count();
+}
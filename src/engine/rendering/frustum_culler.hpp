@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace niji
+{
+
+struct FrustumCullingStats
+{
+    uint32_t Tested = 0;
+    uint32_t Visible = 0;
+    uint32_t FrustumCulled = 0;
+    uint32_t SmallCulled = 0;
+    float CullTimeMs = 0.0f;
+};
+
+// CPU frustum (and optional small object) culling of world space AABBs.
+// Boxes are kept as SoA (center + extents per axis) so SSE can test four of them at once.
+class FrustumCuller
+{
+  public:
+    FrustumCuller() = default;
+
+    void resize(uint32_t count);
+
+    // Object space box, only needs to be set once per object
+    void set_local_bounds(uint32_t index, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+    // Transforms the local box into a world space AABB, call whenever the object moves
+    void update_world_bounds(uint32_t index, const glm::mat4& world);
+
+    // Writes the indices of every box that passes into `visible`.
+    // `projScale` is proj[1][1], `minScreenSize` is a fraction of the screen height (0 = off).
+    void cull(const glm::vec4 (&planes)[6], const glm::vec3& cameraPos, float projScale,
+              float minScreenSize, std::vector<uint32_t>& visible);
+
+    glm::vec3 get_world_center(uint32_t index) const
+    {
+        return glm::vec3(m_centerX[index], m_centerY[index], m_centerZ[index]);
+    }
+
+    uint32_t get_count() const
+    {
+        return m_count;
+    }
+    const FrustumCullingStats& get_stats() const
+    {
+        return m_stats;
+    }
+
+  private:
+    uint32_t m_count = 0;
+
+    // Local boxes (AoS, only read when an object moves)
+    std::vector<glm::vec3> m_localCenters = {};
+    std::vector<glm::vec3> m_localExtents = {};
+
+    // World boxes (SoA, padded to a multiple of 4)
+    std::vector<float> m_centerX = {};
+    std::vector<float> m_centerY = {};
+    std::vector<float> m_centerZ = {};
+    std::vector<float> m_extentX = {};
+    std::vector<float> m_extentY = {};
+    std::vector<float> m_extentZ = {};
+
+    FrustumCullingStats m_stats = {};
+};
+
+} // namespace niji
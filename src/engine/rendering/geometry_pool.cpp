@@ -0,0 +1,422 @@
+#include "geometry_pool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <imgui.h>
+#include <vk_mem_alloc.h>
+
+#include "core/commandlist.hpp"
+#include "engine.hpp"
+
+using namespace niji;
+
+// Compact once the holes between allocations waste more than this fraction of the used space
+constexpr float COMPACTION_THRESHOLD = 0.25f;
+
+FreeListAllocator::FreeListAllocator(uint64_t capacity) : m_capacity(capacity)
+{
+    if (capacity > 0)
+        m_freeBlocks.emplace(0, capacity);
+}
+
+bool FreeListAllocator::allocate(uint64_t size, uint64_t& offset)
+{
+    if (size == 0)
+        return false;
+
+    for (auto it = m_freeBlocks.begin(); it != m_freeBlocks.end(); ++it)
+    {
+        if (it->second < size)
+            continue;
+
+        offset = it->first;
+        const uint64_t remaining = it->second - size;
+        m_freeBlocks.erase(it);
+        if (remaining > 0)
+            m_freeBlocks.emplace(offset + size, remaining);
+
+        m_used += size;
+        return true;
+    }
+
+    return false;
+}
+
+void FreeListAllocator::free(uint64_t offset, uint64_t size)
+{
+    if (size == 0)
+        return;
+
+    auto [it, inserted] = m_freeBlocks.emplace(offset, size);
+    if (!inserted)
+        throw std::runtime_error("Geometry Pool block was freed twice!");
+
+    m_used -= size;
+
+    // Merge with the next block
+    auto next = std::next(it);
+    if (next != m_freeBlocks.end() && it->first + it->second == next->first)
+    {
+        it->second += next->second;
+        m_freeBlocks.erase(next);
+    }
+
+    // Merge with the previous block
+    if (it != m_freeBlocks.begin())
+    {
+        auto prev = std::prev(it);
+        if (prev->first + prev->second == it->first)
+        {
+            prev->second += it->second;
+            m_freeBlocks.erase(it);
+        }
+    }
+}
+
+void FreeListAllocator::grow(uint64_t newCapacity)
+{
+    if (newCapacity <= m_capacity)
+        return;
+
+    const uint64_t oldCapacity = m_capacity;
+    m_capacity = newCapacity;
+
+    // Temporarily count the new range as used so free() can merge it with a trailing block
+    m_used += newCapacity - oldCapacity;
+    free(oldCapacity, newCapacity - oldCapacity);
+}
+
+void FreeListAllocator::reset(uint64_t usedSize)
+{
+    m_freeBlocks.clear();
+    m_used = usedSize;
+    if (usedSize < m_capacity)
+        m_freeBlocks.emplace(usedSize, m_capacity - usedSize);
+}
+
+uint64_t FreeListAllocator::get_largest_free_block() const
+{
+    uint64_t largest = 0;
+    for (const auto& [offset, size] : m_freeBlocks)
+        largest = std::max(largest, size);
+    return largest;
+}
+
+void GeometryPool::init(uint64_t vertexCapacity, uint64_t indexCapacity)
+{
+    create_arenas(vertexCapacity, indexCapacity, m_vertexArena, m_indexArena);
+
+    m_vertexAllocator = FreeListAllocator(vertexCapacity);
+    m_indexAllocator = FreeListAllocator(indexCapacity);
+
+    VkBufferDeviceAddressInfo addressInfo = {};
+    addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+    addressInfo.buffer = m_vertexArena.Handle;
+    m_vertexAddress = vkGetBufferDeviceAddress(nijiEngine.m_context.m_device, &addressInfo);
+
+    m_initialized = true;
+}
+
+void GeometryPool::create_arenas(uint64_t vertexCapacity, uint64_t indexCapacity,
+                                 Buffer& vertexArena, Buffer& indexArena) const
+{
+    // Created directly (instead of through Buffer's constructor) to skip the zero-filled staging
+    // upload, the arenas only ever get written through upload() and compaction copies
+    {
+        vertexArena.Desc.Size = sizeof(PackedVertex) * vertexCapacity;
+        vertexArena.Desc.Usage = BufferDesc::BufferUsage::Storage;
+        vertexArena.Desc.Name = "Geometry Pool Vertex Arena";
+
+        nijiEngine.m_context.create_buffer(vertexArena.Desc.Size,
+                                           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                               VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                                               VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                               VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                           VMA_MEMORY_USAGE_GPU_ONLY, vertexArena.Handle,
+                                           vertexArena.BufferAllocation);
+        vmaSetAllocationName(nijiEngine.m_context.m_allocator, vertexArena.BufferAllocation,
+                             vertexArena.Desc.Name);
+        SetObjectName(nijiEngine.m_context.m_device, VK_OBJECT_TYPE_BUFFER, vertexArena.Handle,
+                      vertexArena.Desc.Name);
+    }
+
+    {
+        indexArena.Desc.Size = sizeof(uint32_t) * indexCapacity;
+        indexArena.Desc.Usage = BufferDesc::BufferUsage::Index;
+        indexArena.Desc.Name = "Geometry Pool Index Arena";
+
+        nijiEngine.m_context.create_buffer(indexArena.Desc.Size,
+                                           VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                                               VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                               VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                           VMA_MEMORY_USAGE_GPU_ONLY, indexArena.Handle,
+                                           indexArena.BufferAllocation);
+        vmaSetAllocationName(nijiEngine.m_context.m_allocator, indexArena.BufferAllocation,
+                             indexArena.Desc.Name);
+        SetObjectName(nijiEngine.m_context.m_device, VK_OBJECT_TYPE_BUFFER, indexArena.Handle,
+                      indexArena.Desc.Name);
+    }
+}
+
+void GeometryPool::upload(Buffer& dst, VkDeviceSize dstOffset, const void* data,
+                          VkDeviceSize size) const
+{
+    VkBuffer stagingBuffer = {};
+    VmaAllocation stagingAllocation = {};
+    nijiEngine.m_context.create_buffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                       VMA_MEMORY_USAGE_CPU_ONLY, stagingBuffer,
+                                       stagingAllocation);
+
+    void* mapped = nullptr;
+    vmaMapMemory(nijiEngine.m_context.m_allocator, stagingAllocation, &mapped);
+    memcpy(mapped, data, static_cast<size_t>(size));
+    vmaUnmapMemory(nijiEngine.m_context.m_allocator, stagingAllocation);
+
+    nijiEngine.m_context.copy_buffer(stagingBuffer, dst.Handle, size, 0, dstOffset);
+
+    vmaDestroyBuffer(nijiEngine.m_context.m_allocator, stagingBuffer, stagingAllocation);
+}
+
+void GeometryPool::grow(uint64_t minVertexCapacity, uint64_t minIndexCapacity)
+{
+    uint64_t vertexCapacity = std::max<uint64_t>(m_vertexAllocator.get_capacity(), 1);
+    while (vertexCapacity < minVertexCapacity)
+        vertexCapacity *= 2;
+
+    uint64_t indexCapacity = std::max<uint64_t>(m_indexAllocator.get_capacity(), 1);
+    while (indexCapacity < minIndexCapacity)
+        indexCapacity *= 2;
+
+    // The old arenas may still be read by frames in flight
+    vkDeviceWaitIdle(nijiEngine.m_context.m_device);
+
+    Buffer vertexArena = {};
+    Buffer indexArena = {};
+    create_arenas(vertexCapacity, indexCapacity, vertexArena, indexArena);
+
+    // Offsets stay the same, so the old contents are copied over as a whole
+    {
+        VkCommandBuffer commandBuffer = nijiEngine.m_context.begin_single_time_commands();
+
+        VkBufferCopy vertexRegion = {0, 0, m_vertexArena.Desc.Size};
+        vkCmdCopyBuffer(commandBuffer, m_vertexArena.Handle, vertexArena.Handle, 1, &vertexRegion);
+
+        VkBufferCopy indexRegion = {0, 0, m_indexArena.Desc.Size};
+        vkCmdCopyBuffer(commandBuffer, m_indexArena.Handle, indexArena.Handle, 1, &indexRegion);
+
+        nijiEngine.m_context.end_single_time_commands(commandBuffer);
+    }
+
+    m_vertexArena.cleanup();
+    m_indexArena.cleanup();
+    m_vertexArena = std::move(vertexArena);
+    m_indexArena = std::move(indexArena);
+
+    m_vertexAllocator.grow(vertexCapacity);
+    m_indexAllocator.grow(indexCapacity);
+
+    VkBufferDeviceAddressInfo addressInfo = {};
+    addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+    addressInfo.buffer = m_vertexArena.Handle;
+    m_vertexAddress = vkGetBufferDeviceAddress(nijiEngine.m_context.m_device, &addressInfo);
+}
+
+GeometryHandle GeometryPool::allocate(const std::vector<PackedVertex>& vertices,
+                                      const std::vector<uint32_t>& indices)
+{
+    if (!m_initialized)
+        throw std::runtime_error("Geometry Pool used before it was initialized!");
+
+    uint64_t vertexOffset = 0;
+    uint64_t firstIndex = 0;
+
+    const bool hasVertices = m_vertexAllocator.allocate(vertices.size(), vertexOffset);
+    const bool hasIndices = hasVertices && m_indexAllocator.allocate(indices.size(), firstIndex);
+    if (!hasIndices)
+    {
+        // Give back the vertex range before growing, both arenas get reallocated
+        if (hasVertices)
+            m_vertexAllocator.free(vertexOffset, vertices.size());
+
+        grow(m_vertexAllocator.get_capacity() + vertices.size(),
+             m_indexAllocator.get_capacity() + indices.size());
+
+        if (!m_vertexAllocator.allocate(vertices.size(), vertexOffset) ||
+            !m_indexAllocator.allocate(indices.size(), firstIndex))
+            throw std::runtime_error("Geometry Pool failed to allocate mesh!");
+    }
+
+    upload(m_vertexArena, sizeof(PackedVertex) * vertexOffset, vertices.data(),
+           sizeof(PackedVertex) * vertices.size());
+    upload(m_indexArena, sizeof(uint32_t) * firstIndex, indices.data(),
+           sizeof(uint32_t) * indices.size());
+
+    GeometryAllocation allocation = {};
+    allocation.VertexOffset = static_cast<uint32_t>(vertexOffset);
+    allocation.VertexCount = static_cast<uint32_t>(vertices.size());
+    allocation.FirstIndex = static_cast<uint32_t>(firstIndex);
+    allocation.IndexCount = static_cast<uint32_t>(indices.size());
+    allocation.Valid = true;
+
+    if (!m_freeHandles.empty())
+    {
+        GeometryHandle handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+        m_allocations[handle] = allocation;
+        return handle;
+    }
+
+    m_allocations.push_back(allocation);
+    return static_cast<GeometryHandle>(m_allocations.size() - 1);
+}
+
+void GeometryPool::free(GeometryHandle handle)
+{
+    if (handle == INVALID_GEOMETRY_HANDLE || handle >= m_allocations.size())
+        return;
+
+    GeometryAllocation& allocation = m_allocations[handle];
+    if (!allocation.Valid)
+        return;
+
+    m_vertexAllocator.free(allocation.VertexOffset, allocation.VertexCount);
+    m_indexAllocator.free(allocation.FirstIndex, allocation.IndexCount);
+
+    allocation = {};
+    m_freeHandles.push_back(handle);
+}
+
+void GeometryPool::compact()
+{
+    if (!m_initialized)
+        return;
+
+    std::vector<GeometryHandle> live = {};
+    for (GeometryHandle handle = 0; handle < m_allocations.size(); handle++)
+    {
+        if (m_allocations[handle].Valid)
+            live.push_back(handle);
+    }
+
+    // The arenas are still read by frames in flight
+    vkDeviceWaitIdle(nijiEngine.m_context.m_device);
+
+    Buffer vertexArena = {};
+    Buffer indexArena = {};
+    create_arenas(m_vertexAllocator.get_capacity(), m_indexAllocator.get_capacity(), vertexArena,
+                  indexArena);
+
+    std::vector<VkBufferCopy> vertexRegions = {};
+    std::vector<VkBufferCopy> indexRegions = {};
+    vertexRegions.reserve(live.size());
+    indexRegions.reserve(live.size());
+
+    // Pack every allocation in handle order, vertices and indices move independently
+    uint32_t vertexCursor = 0;
+    uint32_t indexCursor = 0;
+    for (GeometryHandle handle : live)
+    {
+        GeometryAllocation& allocation = m_allocations[handle];
+
+        if (allocation.VertexCount > 0)
+        {
+            vertexRegions.push_back({sizeof(PackedVertex) * allocation.VertexOffset,
+                                     sizeof(PackedVertex) * vertexCursor,
+                                     sizeof(PackedVertex) * allocation.VertexCount});
+        }
+        if (allocation.IndexCount > 0)
+        {
+            indexRegions.push_back({sizeof(uint32_t) * allocation.FirstIndex,
+                                    sizeof(uint32_t) * indexCursor,
+                                    sizeof(uint32_t) * allocation.IndexCount});
+        }
+
+        allocation.VertexOffset = vertexCursor;
+        allocation.FirstIndex = indexCursor;
+        vertexCursor += allocation.VertexCount;
+        indexCursor += allocation.IndexCount;
+    }
+
+    if (!vertexRegions.empty() || !indexRegions.empty())
+    {
+        VkCommandBuffer commandBuffer = nijiEngine.m_context.begin_single_time_commands();
+
+        if (!vertexRegions.empty())
+            vkCmdCopyBuffer(commandBuffer, m_vertexArena.Handle, vertexArena.Handle,
+                            static_cast<uint32_t>(vertexRegions.size()), vertexRegions.data());
+        if (!indexRegions.empty())
+            vkCmdCopyBuffer(commandBuffer, m_indexArena.Handle, indexArena.Handle,
+                            static_cast<uint32_t>(indexRegions.size()), indexRegions.data());
+
+        nijiEngine.m_context.end_single_time_commands(commandBuffer);
+    }
+
+    m_vertexArena.cleanup();
+    m_indexArena.cleanup();
+    m_vertexArena = std::move(vertexArena);
+    m_indexArena = std::move(indexArena);
+
+    m_vertexAllocator.reset(vertexCursor);
+    m_indexAllocator.reset(indexCursor);
+
+    VkBufferDeviceAddressInfo addressInfo = {};
+    addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+    addressInfo.buffer = m_vertexArena.Handle;
+    m_vertexAddress = vkGetBufferDeviceAddress(nijiEngine.m_context.m_device, &addressInfo);
+
+    m_version++;
+}
+
+void GeometryPool::compact_if_fragmented()
+{
+    const auto is_fragmented = [](const FreeListAllocator& allocator) {
+        if (allocator.get_free_block_count() < 2)
+            return false;
+
+        const uint64_t free = allocator.get_capacity() - allocator.get_used();
+        const uint64_t holes = free - allocator.get_largest_free_block();
+        return holes > allocator.get_used() * COMPACTION_THRESHOLD;
+    };
+
+    if (m_compactRequested || is_fragmented(m_vertexAllocator) || is_fragmented(m_indexAllocator))
+    {
+        compact();
+        m_compactRequested = false;
+    }
+}
+
+void GeometryPool::bind(const CommandList& cmd) const
+{
+    cmd.bind_index_buffer(m_indexArena.Handle, 0, VK_INDEX_TYPE_UINT32);
+}
+
+void GeometryPool::debug_panel()
+{
+    const auto draw_arena = [](const char* name, const FreeListAllocator& allocator,
+                               size_t elementSize) {
+        const float toMB = 1.0f / (1024.0f * 1024.0f);
+        ImGui::Text("%s: %.2f / %.2f MB", name, allocator.get_used() * elementSize * toMB,
+                    allocator.get_capacity() * elementSize * toMB);
+        ImGui::Text("  Free Blocks: %llu, Largest: %.2f MB",
+                    static_cast<unsigned long long>(allocator.get_free_block_count()),
+                    allocator.get_largest_free_block() * elementSize * toMB);
+    };
+
+    draw_arena("Vertex Arena", m_vertexAllocator, sizeof(PackedVertex));
+    draw_arena("Index Arena", m_indexAllocator, sizeof(uint32_t));
+    ImGui::Text("Allocations: %u",
+                static_cast<uint32_t>(m_allocations.size() - m_freeHandles.size()));
+
+    // Deferred to the next frame, compaction can't happen while commands are being recorded
+    if (ImGui::Button("Compact"))
+        m_compactRequested = true;
+}
+
+void GeometryPool::cleanup()
+{
+    m_vertexArena.cleanup();
+    m_indexArena.cleanup();
+    m_vertexAddress = 0;
+    m_initialized = false;
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "core/common.hpp"
+
+namespace niji
+{
+
+class CommandList;
+
+// First-fit free-list over a range of elements, neighbouring free blocks get merged on free
+class FreeListAllocator
+{
+  public:
+    FreeListAllocator() = default;
+    FreeListAllocator(uint64_t capacity);
+
+    bool allocate(uint64_t size, uint64_t& offset);
+    void free(uint64_t offset, uint64_t size);
+
+    // Appends [oldCapacity, newCapacity) as free space
+    void grow(uint64_t newCapacity);
+    // Marks [0, usedSize) as used and everything after it as free
+    void reset(uint64_t usedSize);
+
+    uint64_t get_capacity() const
+    {
+        return m_capacity;
+    }
+    uint64_t get_used() const
+    {
+        return m_used;
+    }
+    uint64_t get_largest_free_block() const;
+    uint64_t get_free_block_count() const
+    {
+        return m_freeBlocks.size();
+    }
+
+  private:
+    // Offset -> Size
+    std::map<uint64_t, uint64_t> m_freeBlocks = {};
+
+    uint64_t m_capacity = 0;
+    uint64_t m_used = 0;
+};
+
+// Initial arena sizes (in elements), the pool doubles when it runs out of space
+constexpr uint64_t GEOMETRY_POOL_VERTEX_CAPACITY = 1 << 18;
+constexpr uint64_t GEOMETRY_POOL_INDEX_CAPACITY = 1 << 20;
+
+using GeometryHandle = uint32_t;
+constexpr GeometryHandle INVALID_GEOMETRY_HANDLE = UINT32_MAX;
+
+// Where a mesh lives inside the pool (in elements, not bytes)
+struct GeometryAllocation
+{
+    uint32_t VertexOffset = 0;
+    uint32_t VertexCount = 0;
+    uint32_t FirstIndex = 0;
+    uint32_t IndexCount = 0;
+
+    bool Valid = false;
+};
+
+// Push constants used by every pass that pulls its vertices from the pool
+struct GeometryPushConstants
+{
+    VkDeviceAddress Vertices = 0;
+};
+
+// One large vertex arena (read through its device address) and one index arena that all meshes
+// are sub-allocated from, so a single index buffer bind serves every draw.
+class GeometryPool
+{
+  public:
+    GeometryPool() = default;
+
+    void init(uint64_t vertexCapacity, uint64_t indexCapacity);
+
+    GeometryHandle allocate(const std::vector<PackedVertex>& vertices,
+                            const std::vector<uint32_t>& indices);
+    void free(GeometryHandle handle);
+
+    const GeometryAllocation& get_allocation(GeometryHandle handle) const
+    {
+        return m_allocations[handle];
+    }
+
+    // Moves all live allocations to the front of the arenas (waits for the GPU to go idle)
+    void compact();
+    // Call outside of command recording, compacts when requested or when the holes get too big
+    void compact_if_fragmented();
+
+    void bind(const CommandList& cmd) const;
+
+    VkDeviceAddress get_vertex_address() const
+    {
+        return m_vertexAddress;
+    }
+    // Bumped whenever allocation offsets move (compaction)
+    uint64_t get_version() const
+    {
+        return m_version;
+    }
+
+    void debug_panel();
+
+    void cleanup();
+
+  private:
+    void create_arenas(uint64_t vertexCapacity, uint64_t indexCapacity, Buffer& vertexArena,
+                       Buffer& indexArena) const;
+    void grow(uint64_t minVertexCapacity, uint64_t minIndexCapacity);
+    void upload(Buffer& dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size) const;
+
+  private:
+    Buffer m_vertexArena = {};
+    Buffer m_indexArena = {};
+    VkDeviceAddress m_vertexAddress = 0;
+
+    FreeListAllocator m_vertexAllocator = {};
+    FreeListAllocator m_indexAllocator = {};
+
+    std::vector<GeometryAllocation> m_allocations = {};
+    std::vector<GeometryHandle> m_freeHandles = {};
+
+    uint64_t m_version = 0;
+    bool m_initialized = false;
+    bool m_compactRequested = false;
+};
+
+} // namespace niji
\ No newline at end of file
@@ -0,0 +1,368 @@
+#include "gpu_profiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#include <imgui.h>
+#include <nlohmann/json.hpp>
+
+#include "engine.hpp"
+
+using namespace niji;
+
+static uint64_t timestamp_mask(uint32_t validBits)
+{
+    if (validBits == 0)
+        return 0;
+    return validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+}
+
+void GpuProfiler::init()
+{
+    Context& context = nijiEngine.m_context;
+
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(context.m_physicalDevice, &properties);
+    m_timestampPeriod = properties.limits.timestampPeriod;
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(context.m_physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(context.m_physicalDevice, &familyCount,
+                                             families.data());
+
+    m_graphicsTimestampMask = timestamp_mask(families[context.m_graphicsFamily].timestampValidBits);
+    if (context.m_computeFamily != UINT32_MAX)
+        m_computeTimestampMask =
+            timestamp_mask(families[context.m_computeFamily].timestampValidBits);
+
+    for (size_t i = 0; i < m_frames.size(); i++)
+    {
+        FrameQueries& frame = m_frames[i];
+
+        VkQueryPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = MAX_GPU_PROFILER_SCOPES * 2;
+
+        if (vkCreateQueryPool(context.m_device, &poolInfo, nullptr, &frame.Timestamps) !=
+            VK_SUCCESS)
+            throw std::runtime_error("Failed to Create GPU Profiler Timestamp Pool!");
+        vkResetQueryPool(context.m_device, frame.Timestamps, 0, poolInfo.queryCount);
+
+        std::string name = "GPU Profiler Timestamps " + std::to_string(i);
+        SetObjectName(context.m_device, VK_OBJECT_TYPE_QUERY_POOL, frame.Timestamps,
+                      name.c_str());
+
+        if (!context.has_pipeline_statistics())
+            continue;
+
+        poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        poolInfo.queryCount = MAX_GPU_PROFILER_SCOPES;
+        poolInfo.pipelineStatistics = PROFILED_PIPELINE_STATISTICS;
+
+        if (vkCreateQueryPool(context.m_device, &poolInfo, nullptr, &frame.Statistics) !=
+            VK_SUCCESS)
+            throw std::runtime_error("Failed to Create GPU Profiler Statistics Pool!");
+        vkResetQueryPool(context.m_device, frame.Statistics, 0, poolInfo.queryCount);
+
+        name = "GPU Profiler Statistics " + std::to_string(i);
+        SetObjectName(context.m_device, VK_OBJECT_TYPE_QUERY_POOL, frame.Statistics,
+                      name.c_str());
+    }
+
+    m_trace.resize(GPU_PROFILER_TRACE_FRAMES);
+}
+
+void GpuProfiler::begin_frame(uint32_t frameIndex)
+{
+    m_frameIndex = frameIndex;
+
+    FrameQueries& frame = m_frames[frameIndex];
+    read_back(frame);
+
+    frame.Scopes.clear();
+    frame.FrameNumber = ++m_frameNumber;
+}
+
+void GpuProfiler::read_back(FrameQueries& frame)
+{
+    if (frame.Scopes.empty())
+        return;
+
+    VkDevice device = nijiEngine.m_context.m_device;
+    const uint32_t scopeCount = static_cast<uint32_t>(frame.Scopes.size());
+
+    // [value, availability] per query, the slot's frame is done so nothing should be missing
+    std::vector<uint64_t>& timestamps = m_timestamps;
+    timestamps.resize(scopeCount * 2 * 2);
+    VkResult result = vkGetQueryPoolResults(
+        device, frame.Timestamps, 0, scopeCount * 2, timestamps.size() * sizeof(uint64_t),
+        timestamps.data(), sizeof(uint64_t) * 2,
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    const uint32_t statisticsStride = PROFILED_PIPELINE_STATISTIC_COUNT + 1;
+    std::vector<uint64_t>& statistics = m_statistics;
+    if (frame.Statistics != VK_NULL_HANDLE)
+    {
+        statistics.resize(scopeCount * statisticsStride);
+        vkGetQueryPoolResults(device, frame.Statistics, 0, scopeCount,
+                              statistics.size() * sizeof(uint64_t), statistics.data(),
+                              sizeof(uint64_t) * statisticsStride,
+                              VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    }
+
+    std::vector<TraceEvent>& trace = m_trace[m_traceNext];
+    trace.clear();
+
+    for (uint32_t i = 0; i < scopeCount && (result == VK_SUCCESS || result == VK_NOT_READY); i++)
+    {
+        const Scope& scope = frame.Scopes[i];
+        const uint64_t* begin = &timestamps[i * 4];
+        const uint64_t* end = &timestamps[i * 4 + 2];
+        if (begin[1] == 0 || end[1] == 0)
+            continue;
+
+        const uint64_t mask = scope.GraphicsQueue ? m_graphicsTimestampMask : m_computeTimestampMask;
+        const uint64_t startNs = static_cast<uint64_t>((begin[0] & mask) * m_timestampPeriod);
+        const uint64_t endNs = static_cast<uint64_t>((end[0] & mask) * m_timestampPeriod);
+        const uint64_t durationNs = endNs > startNs ? endNs - startNs : 0;
+
+        auto& entry = m_historyLookup[scope.Name];
+        if (entry == nullptr)
+        {
+            auto [it, inserted] = m_history.try_emplace(scope.Name);
+            if (inserted)
+            {
+                m_scopeOrder.push_back(scope.Name);
+                it->second.SamplesMs.reserve(GPU_PROFILER_HISTORY);
+            }
+            entry = &*it;
+        }
+        ScopeHistory& history = entry->second;
+
+        const float durationMs = durationNs / 1e6f;
+        if (history.SamplesMs.size() < GPU_PROFILER_HISTORY)
+            history.SamplesMs.push_back(durationMs);
+        else
+            history.SamplesMs[history.Next] = durationMs;
+        history.Next = (history.Next + 1) % GPU_PROFILER_HISTORY;
+
+        const uint64_t* stats = scope.HasStatistics ? &statistics[i * statisticsStride] : nullptr;
+        history.HasStatistics = stats && stats[PROFILED_PIPELINE_STATISTIC_COUNT] != 0;
+        if (history.HasStatistics)
+            std::copy(stats, stats + PROFILED_PIPELINE_STATISTIC_COUNT, history.Statistics.begin());
+
+        trace.push_back(
+            {&entry->first, scope.GraphicsQueue, frame.FrameNumber, startNs, durationNs});
+    }
+
+    m_traceNext = (m_traceNext + 1) % GPU_PROFILER_TRACE_FRAMES;
+
+    vkResetQueryPool(device, frame.Timestamps, 0, scopeCount * 2);
+    if (frame.Statistics != VK_NULL_HANDLE)
+        vkResetQueryPool(device, frame.Statistics, 0, scopeCount);
+}
+
+uint32_t GpuProfiler::begin_scope(CommandList& cmd, const char* name, bool graphicsQueue)
+{
+    FrameQueries& frame = m_frames[m_frameIndex];
+
+    const uint64_t mask = graphicsQueue ? m_graphicsTimestampMask : m_computeTimestampMask;
+    if (!m_enabled || mask == 0 || frame.Scopes.size() == MAX_GPU_PROFILER_SCOPES)
+        return UINT32_MAX;
+
+    const uint32_t scope = static_cast<uint32_t>(frame.Scopes.size());
+
+    Scope scopeInfo = {};
+    scopeInfo.Name = name;
+    scopeInfo.GraphicsQueue = graphicsQueue;
+    // The statistics cover graphics stages, those queries can't be used on a compute queue
+    scopeInfo.HasStatistics =
+        m_pipelineStatistics && graphicsQueue && frame.Statistics != VK_NULL_HANDLE;
+    frame.Scopes.push_back(scopeInfo);
+
+    vkCmdWriteTimestamp(cmd.m_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.Timestamps,
+                        scope * 2);
+    if (scopeInfo.HasStatistics)
+        vkCmdBeginQuery(cmd.m_commandBuffer, frame.Statistics, scope, 0);
+
+    return scope;
+}
+
+void GpuProfiler::end_scope(CommandList& cmd, uint32_t scope)
+{
+    if (scope == UINT32_MAX)
+        return;
+
+    FrameQueries& frame = m_frames[m_frameIndex];
+
+    if (frame.Scopes[scope].HasStatistics)
+        vkCmdEndQuery(cmd.m_commandBuffer, frame.Statistics, scope);
+    vkCmdWriteTimestamp(cmd.m_commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                        frame.Timestamps, scope * 2 + 1);
+}
+
+void GpuProfiler::reset_stats()
+{
+    for (auto& [name, history] : m_history)
+    {
+        history.SamplesMs.clear();
+        history.Next = 0;
+    }
+}
+
+GpuScopeStats GpuProfiler::get_scope_stats(const std::string& name) const
+{
+    GpuScopeStats stats = {};
+
+    auto it = m_history.find(name);
+    if (it == m_history.end() || it->second.SamplesMs.empty())
+        return stats;
+
+    std::vector<float> samples = it->second.SamplesMs;
+    std::sort(samples.begin(), samples.end());
+
+    const auto percentile = [&samples](float p) {
+        return samples[static_cast<size_t>(p * (samples.size() - 1) + 0.5f)];
+    };
+
+    float total = 0.0f;
+    for (float sample : samples)
+        total += sample;
+
+    stats.Samples = static_cast<uint32_t>(samples.size());
+    stats.AverageMs = total / samples.size();
+    stats.P50Ms = percentile(0.50f);
+    stats.P95Ms = percentile(0.95f);
+    stats.P99Ms = percentile(0.99f);
+    stats.MaxMs = samples.back();
+    stats.Statistics = it->second.Statistics;
+    stats.HasStatistics = it->second.HasStatistics;
+    return stats;
+}
+
+bool GpuProfiler::export_chrome_trace(const std::string& path) const
+{
+    // Timestamps are relative to the oldest frame that's still around
+    uint64_t origin = UINT64_MAX;
+    for (const auto& frame : m_trace)
+    {
+        for (const TraceEvent& event : frame)
+            origin = std::min(origin, event.Start);
+    }
+
+    nlohmann::json events = nlohmann::json::array();
+    events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", 1},
+                      {"args", {{"name", "Graphics Queue"}}}});
+    events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", 2},
+                      {"args", {{"name", "Async Compute Queue"}}}});
+
+    for (const auto& frame : m_trace)
+    {
+        for (const TraceEvent& event : frame)
+        {
+            events.push_back({{"name", *event.Name},
+                              {"cat", "gpu"},
+                              {"ph", "X"},
+                              {"pid", 1},
+                              {"tid", event.GraphicsQueue ? 1 : 2},
+                              {"ts", (event.Start - origin) / 1000.0},
+                              {"dur", event.Duration / 1000.0},
+                              {"args", {{"frame", event.FrameNumber}}}});
+        }
+    }
+
+    std::ofstream file(path);
+    if (!file.is_open())
+        return false;
+
+    nlohmann::json trace = {{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+    file << trace.dump(1);
+    return true;
+}
+
+void GpuProfiler::debug_panel()
+{
+    ImGui::Checkbox("Enabled", &m_enabled);
+    if (nijiEngine.m_context.has_pipeline_statistics())
+        ImGui::Checkbox("Pipeline Statistics", &m_pipelineStatistics);
+    else
+        ImGui::Text("Pipeline Statistics: Not Supported");
+
+    if (ImGui::Button("Export Chrome Trace"))
+    {
+        if (export_chrome_trace("gpu_trace.json"))
+            nijiEngine.m_logger.log_info("Saved GPU trace to gpu_trace.json");
+        else
+            nijiEngine.m_logger.log_error("Failed to save gpu_trace.json");
+    }
+
+    const int columns = m_pipelineStatistics ? 10 : 6;
+    if (!ImGui::BeginTable("GPU Scopes", columns,
+                           ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                               ImGuiTableFlags_SizingFixedFit))
+        return;
+
+    ImGui::TableSetupColumn("Scope");
+    ImGui::TableSetupColumn("Avg (ms)");
+    ImGui::TableSetupColumn("p50");
+    ImGui::TableSetupColumn("p95");
+    ImGui::TableSetupColumn("p99");
+    ImGui::TableSetupColumn("Max");
+    if (m_pipelineStatistics)
+    {
+        ImGui::TableSetupColumn("Primitives");
+        ImGui::TableSetupColumn("VS Invocations");
+        ImGui::TableSetupColumn("FS Invocations");
+        ImGui::TableSetupColumn("CS Invocations");
+    }
+    ImGui::TableHeadersRow();
+
+    for (const std::string& name : m_scopeOrder)
+    {
+        const GpuScopeStats stats = get_scope_stats(name);
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(name.c_str());
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", stats.AverageMs);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", stats.P50Ms);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", stats.P95Ms);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", stats.P99Ms);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", stats.MaxMs);
+
+        if (!m_pipelineStatistics)
+            continue;
+
+        // Bit order: IA vertices, IA primitives, VS, clipping primitives, FS, CS
+        const uint32_t shown[] = {1, 2, 4, 5};
+        for (uint32_t statistic : shown)
+        {
+            ImGui::TableNextColumn();
+            if (stats.HasStatistics)
+                ImGui::Text("%llu", static_cast<unsigned long long>(stats.Statistics[statistic]));
+            else
+                ImGui::TextUnformatted("-");
+        }
+    }
+
+    ImGui::EndTable();
+}
+
+void GpuProfiler::cleanup()
+{
+    for (FrameQueries& frame : m_frames)
+    {
+        vkDestroyQueryPool(nijiEngine.m_context.m_device, frame.Timestamps, nullptr);
+        if (frame.Statistics != VK_NULL_HANDLE)
+            vkDestroyQueryPool(nijiEngine.m_context.m_device, frame.Statistics, nullptr);
+        frame = {};
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/commandlist.hpp"
+
+namespace niji
+{
+
+constexpr uint32_t MAX_GPU_PROFILER_SCOPES = 64;
+// Samples kept per scope for the averages and percentiles
+constexpr uint32_t GPU_PROFILER_HISTORY = 256;
+// Frames kept around for the Chrome trace export
+constexpr uint32_t GPU_PROFILER_TRACE_FRAMES = 120;
+
+struct GpuScopeStats
+{
+    uint32_t Samples = 0;
+    float AverageMs = 0.0f;
+    float P50Ms = 0.0f;
+    float P95Ms = 0.0f;
+    float P99Ms = 0.0f;
+    float MaxMs = 0.0f;
+    // Last frame's pipeline statistics, in PROFILED_PIPELINE_STATISTICS bit order
+    std::array<uint64_t, PROFILED_PIPELINE_STATISTIC_COUNT> Statistics = {};
+    bool HasStatistics = false;
+};
+
+// Timestamp (and optionally pipeline statistics) queries around every render graph pass. Each
+// frame slot has its own query pools, which get read back once the slot comes around again, so
+// the results are a few frames old but reading them never stalls.
+class GpuProfiler
+{
+  public:
+    GpuProfiler() = default;
+
+    void init();
+
+    // Reads back the slot's previous frame and resets its queries, call once the frame slot has
+    // been waited on (and before any scope of the frame gets recorded)
+    void begin_frame(uint32_t frameIndex);
+
+    // Scopes don't nest, statistics are only gathered on the graphics queue. Returns UINT32_MAX
+    // when the scope isn't recorded (out of queries, or no timestamps on that queue). `name` has
+    // to stay valid until the scope got read back (string literals, render graph pass names).
+    uint32_t begin_scope(CommandList& cmd, const char* name, bool graphicsQueue);
+    void end_scope(CommandList& cmd, uint32_t scope);
+
+    GpuScopeStats get_scope_stats(const std::string& name) const;
+    // In the order they were first seen
+    const std::vector<std::string>& get_scope_names() const
+    {
+        return m_scopeOrder;
+    }
+    // Drops every scope's samples, so the stats only cover what comes after (benchmark warm-up)
+    void reset_stats();
+
+    // Chrome trace event format, also opens in Perfetto
+    bool export_chrome_trace(const std::string& path) const;
+
+    void debug_panel();
+
+    void cleanup();
+
+  private:
+    struct Scope
+    {
+        const char* Name = nullptr;
+        bool GraphicsQueue = true;
+        bool HasStatistics = false;
+    };
+
+    struct FrameQueries
+    {
+        VkQueryPool Timestamps = VK_NULL_HANDLE;
+        VkQueryPool Statistics = VK_NULL_HANDLE;
+        std::vector<Scope> Scopes = {};
+        uint64_t FrameNumber = 0;
+    };
+
+    struct ScopeHistory
+    {
+        std::vector<float> SamplesMs = {};
+        uint32_t Next = 0;
+        std::array<uint64_t, PROFILED_PIPELINE_STATISTIC_COUNT> Statistics = {};
+        bool HasStatistics = false;
+    };
+
+    struct TraceEvent
+    {
+        // Key of the scope's m_history entry
+        const std::string* Name = nullptr;
+        bool GraphicsQueue = true;
+        uint64_t FrameNumber = 0;
+        uint64_t Start = 0; // Nanoseconds
+        uint64_t Duration = 0;
+    };
+
+    void read_back(FrameQueries& frame);
+
+  private:
+    std::array<FrameQueries, MAX_FRAMES_IN_FLIGHT> m_frames = {};
+    uint32_t m_frameIndex = 0;
+    uint64_t m_frameNumber = 0;
+
+    float m_timestampPeriod = 0.0f;
+    uint64_t m_graphicsTimestampMask = 0;
+    uint64_t m_computeTimestampMask = 0;
+
+    bool m_enabled = true;
+    bool m_pipelineStatistics = false;
+
+    std::unordered_map<std::string, ScopeHistory> m_history = {};
+    // History entry of every name pointer seen so far, looking a name up by pointer doesn't have
+    // to build a std::string every frame
+    std::unordered_map<const char*, std::pair<const std::string, ScopeHistory>*> m_historyLookup =
+        {};
+    std::vector<std::string> m_scopeOrder = {};
+    // Query results of the frame being read back
+    std::vector<uint64_t> m_timestamps = {};
+    std::vector<uint64_t> m_statistics = {};
+    // Ring of the last GPU_PROFILER_TRACE_FRAMES frames
+    std::vector<std::vector<TraceEvent>> m_trace = {};
+    uint32_t m_traceNext = 0;
+};
+
+} // namespace niji
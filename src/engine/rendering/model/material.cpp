@@ -22,30 +22,34 @@ inline static glm::vec4 ToGLM(const fastgltf::math::nvec4& v)
 Material::Material(fastgltf::Asset& model, fastgltf::Primitive& primitive,
                    std::filesystem::path gltfPath)
 {
-    // Create Material Data Buffer
-    VkDeviceSize bufferSize = sizeof(ModelData);
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-    {
-        ModelData ubo = {};
-        BufferDesc bufferDesc = {};
-        bufferDesc.IsPersistent = true;
-        bufferDesc.Name = "Model Data";
-        bufferDesc.Size = sizeof(ModelData);
-        bufferDesc.Usage = BufferDesc::BufferUsage::Uniform;
-        m_data[i] = Buffer(bufferDesc, &ubo);
-    }
+    auto& renderer = nijiEngine.ecs.find_system<Renderer>();
 
     if (!primitive.materialIndex.has_value())
     {
         printf("[Material]: Model has no Material data! \n");
+        m_materialIndex = renderer.register_material(m_materialInfo);
         return;
     }
     auto& material = model.materials[primitive.materialIndex.value()];
 
     int largestWidth = 1, largestHeight = 1;
 
-    auto loadTexture = [&](const auto& textureInfo, bool isLinear) -> std::optional<Texture> {
+    // Decoding is the slow part of a material, so the images get decoded on the job system and
+    // only the uploads happen in order on this thread
+    struct TextureRequest
+    {
+        std::optional<Texture>* Target = nullptr;
+        size_t ImageIndex = 0;
+        bool IsLinear = false;
+
+        int Width = -1, Height = -1;
+        unsigned char* Data = nullptr;
+    };
+    std::array<TextureRequest, 5> requests = {};
+    uint32_t requestCount = 0;
+
+    auto requestTexture = [&](const auto& textureInfo, std::optional<Texture>& target,
+                              bool isLinear) {
         size_t textureIndex = {};
 
         // Base Color, RM, Emissive Textures
@@ -65,19 +69,27 @@ Material::Material(fastgltf::Asset& model, fastgltf::Primitive& primitive,
         }
 
         if (textureIndex >= model.textures.size())
-            return std::nullopt;
+            return;
 
         auto& gltfTexture = model.textures[textureIndex];
         if (!gltfTexture.imageIndex.has_value())
-            return std::nullopt;
+            return;
 
         size_t imageIndex = gltfTexture.imageIndex.value();
         if (imageIndex >= model.images.size())
-            return std::nullopt;
+            return;
 
-        auto& image = model.images[imageIndex];
+        TextureRequest& request = requests[requestCount++];
+        request.Target = &target;
+        request.ImageIndex = imageIndex;
+        request.IsLinear = isLinear;
+    };
 
-        int width = -1, height = -1, channels = -1;
+    // Job thread, only reads the asset
+    auto decodeImage = [&](TextureRequest& request) {
+        auto& image = model.images[request.ImageIndex];
+
+        int channels = -1;
         unsigned char* imageData = nullptr;
 
         // Handle different image sources
@@ -88,8 +100,8 @@ Material::Material(fastgltf::Asset& model, fastgltf::Primitive& primitive,
             auto& uri = std::get<fastgltf::sources::URI>(image.data);
             std::filesystem::path fullTexturePath = baseDir / uri.uri.fspath();
 
-            imageData = stbi_load(fullTexturePath.string().c_str(), &width, &height, &channels,
-                                  STBI_rgb_alpha);
+            imageData = stbi_load(fullTexturePath.string().c_str(), &request.Width,
+                                  &request.Height, &channels, STBI_rgb_alpha);
         }
         else if (std::holds_alternative<fastgltf::sources::Vector>(image.data))
         {
@@ -98,7 +110,7 @@ Material::Material(fastgltf::Asset& model, fastgltf::Primitive& primitive,
 
             imageData =
                 stbi_load_from_memory((stbi_uc*)bufferData.bytes.data(), bufferData.bytes.size(),
-                                      &width, &height, &channels, STBI_rgb_alpha);
+                                      &request.Width, &request.Height, &channels, STBI_rgb_alpha);
         }
         else if (std::holds_alternative<fastgltf::sources::BufferView>(image.data))
         {
@@ -111,49 +123,61 @@ Material::Material(fastgltf::Asset& model, fastgltf::Primitive& primitive,
 
             imageData =
                 stbi_load_from_memory((stbi_uc*)bufferBytes.bytes.data() + bufferView.byteOffset,
-                                      bufferView.byteLength, &width, &height, &channels,
-                                      STBI_rgb_alpha);
-        }
-
-        if (!imageData)
-        {
-            printf("[Material]: Failed to load image data from file! \n");
-            return std::nullopt;
+                                      bufferView.byteLength, &request.Width, &request.Height,
+                                      &channels, STBI_rgb_alpha);
         }
 
-        largestWidth = width > largestWidth ? width : largestWidth;
-        largestHeight = height > largestHeight ? height : largestHeight;
-
-        TextureDesc desc = {};
-        desc.Width = width;
-        desc.Height = height;
-        desc.Channels = 4;
-        desc.IsMipMapped = true;
-        desc.Data = imageData;
-        desc.Format = isLinear ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB;
-        desc.MemoryUsage = VMA_MEMORY_USAGE_GPU_ONLY;
-        desc.Usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-
-        Texture finalTexture = Texture(desc);
-        return finalTexture;
+        request.Data = imageData;
     };
 
     // Load all relevant textures
     if (material.pbrData.baseColorTexture.has_value())
-        m_materialData.BaseColor = loadTexture(material.pbrData.baseColorTexture.value(), false);
+        requestTexture(material.pbrData.baseColorTexture.value(), m_materialData.BaseColor,
+                       false);
 
     if (material.normalTexture.has_value())
-        m_materialData.NormalTexture = loadTexture(material.normalTexture.value(), true);
+        requestTexture(material.normalTexture.value(), m_materialData.NormalTexture, true);
 
     if (material.occlusionTexture.has_value())
-        m_materialData.OcclusionTexture = loadTexture(material.occlusionTexture.value(), true);
+        requestTexture(material.occlusionTexture.value(), m_materialData.OcclusionTexture, true);
 
     if (material.pbrData.metallicRoughnessTexture.has_value())
-        m_materialData.RoughMetallic =
-            loadTexture(material.pbrData.metallicRoughnessTexture.value(), true);
+        requestTexture(material.pbrData.metallicRoughnessTexture.value(),
+                       m_materialData.RoughMetallic, true);
 
     if (material.emissiveTexture.has_value())
-        m_materialData.Emissive = loadTexture(material.emissiveTexture.value(), false);
+        requestTexture(material.emissiveTexture.value(), m_materialData.Emissive, false);
+
+    nijiEngine.m_jobSystem.parallel_for(requestCount, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++)
+            decodeImage(requests[i]);
+    });
+
+    for (uint32_t i = 0; i < requestCount; i++)
+    {
+        TextureRequest& request = requests[i];
+        if (!request.Data)
+        {
+            printf("[Material]: Failed to load image data from file! \n");
+            continue;
+        }
+
+        largestWidth = request.Width > largestWidth ? request.Width : largestWidth;
+        largestHeight = request.Height > largestHeight ? request.Height : largestHeight;
+
+        // The texture owns the decoded pixels from here on
+        TextureDesc desc = {};
+        desc.Width = request.Width;
+        desc.Height = request.Height;
+        desc.Channels = 4;
+        desc.IsMipMapped = true;
+        desc.Data = request.Data;
+        desc.Format = request.IsLinear ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB;
+        desc.MemoryUsage = VMA_MEMORY_USAGE_GPU_ONLY;
+        desc.Usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+        *request.Target = Texture(desc);
+    }
 
     // Create Sampler
     {
@@ -182,10 +206,20 @@ Material::Material(fastgltf::Asset& model, fastgltf::Primitive& primitive,
     m_materialInfo.HasRoughnessMap = m_materialData.RoughMetallic.has_value();
     m_materialInfo.HasNormalMap = m_materialData.NormalTexture.has_value();
 
+    m_features = 0;
+    m_features |= m_materialData.BaseColor.has_value() ? MATERIAL_BASE_COLOR_MAP : 0;
+    m_features |= m_materialData.NormalTexture.has_value() ? MATERIAL_NORMAL_MAP : 0;
+    m_features |= m_materialData.OcclusionTexture.has_value() ? MATERIAL_OCCLUSION_MAP : 0;
+    m_features |= m_materialData.RoughMetallic.has_value() ? MATERIAL_METALLIC_ROUGHNESS_MAP : 0;
+    m_features |= m_materialData.Emissive.has_value() ? MATERIAL_EMISSIVE_MAP : 0;
+
     m_materialInfo.AlbedoFactor = ToGLM(material.pbrData.baseColorFactor);
     m_materialInfo.EmissiveFactor = glm::vec4(ToGLM(material.emissiveFactor), 0.0f);
     m_materialInfo.RoughnessFactor = material.pbrData.roughnessFactor;
     m_materialInfo.MetallicFactor = material.pbrData.metallicFactor;
+
+    // Material info is static, so it only gets uploaded once into the renderer's material buffer
+    m_materialIndex = renderer.register_material(m_materialInfo);
 }
 
 void Material::cleanup()
@@ -202,9 +236,4 @@ void Material::cleanup()
         m_materialData.OcclusionTexture->cleanup();
     if (m_materialData.RoughMetallic.has_value())
         m_materialData.RoughMetallic->cleanup();
-
-    for (int i = 0; i < m_data.size(); i++)
-    {
-        m_data[i].cleanup();
-    }
 }
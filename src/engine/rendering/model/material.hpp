@@ -8,6 +8,14 @@
 namespace niji
 {
 
+// Textures a material has, the forward shader gets specialized on them (see ForwardPass)
+constexpr uint32_t MATERIAL_BASE_COLOR_MAP = 1 << 0;
+constexpr uint32_t MATERIAL_NORMAL_MAP = 1 << 1;
+constexpr uint32_t MATERIAL_OCCLUSION_MAP = 1 << 2;
+constexpr uint32_t MATERIAL_METALLIC_ROUGHNESS_MAP = 1 << 3;
+constexpr uint32_t MATERIAL_EMISSIVE_MAP = 1 << 4;
+constexpr uint32_t MATERIAL_FEATURE_COUNT = 5;
+
 struct MaterialData
 {
     std::optional<Texture> NormalTexture = {};
@@ -29,10 +37,13 @@ class Material
     friend class Renderer;
     friend class ForwardPass;
     friend class DepthPass;
+    friend class DrawCullingPass;
 
     MaterialData m_materialData = {};
     MaterialInfo m_materialInfo = {};
-    std::array<Buffer, MAX_FRAMES_IN_FLIGHT> m_data = {};
+    uint32_t m_materialIndex = 0;
+    // MATERIAL_* bits
+    uint32_t m_features = 0;
 
     Sampler m_sampler = {};
 };
@@ -7,6 +7,7 @@
 
 #include "engine.hpp"
 #include "core/context.hpp"
+#include "rendering/renderer.hpp"
 
 #include "tangent_space_wrapper.hpp"
 
@@ -14,55 +15,49 @@ using namespace niji;
 
 void Mesh::cleanup()
 {
+    if (m_geometry != INVALID_GEOMETRY_HANDLE)
+    {
+        nijiEngine.ecs.find_system<Renderer>().m_geometryPool.free(m_geometry);
+        m_geometry = INVALID_GEOMETRY_HANDLE;
+    }
+
     m_vertexBuffer.cleanup();
     m_indexBuffer.cleanup();
 }
 
-Mesh::Mesh(fastgltf::Asset& model, fastgltf::Primitive& primitive)
+MeshData Mesh::load_primitive(const fastgltf::Asset& model, const fastgltf::Primitive& primitive)
 {
-    std::vector<uint32_t> uintIndices = {};
-    std::vector<uint16_t> ushortIndices = {};
-    std::vector<Vertex> vertices = {};
+    MeshData data = {};
+    std::vector<Vertex>& vertices = data.Vertices;
 
-    // Load Indices
+    // Load Indices (the pool only stores 32-bit indices, 16-bit ones get widened while reading)
     {
-        fastgltf::Accessor& indexAccessor = model.accessors[primitive.indicesAccessor.value()];
+        const fastgltf::Accessor& indexAccessor = model.accessors[primitive.indicesAccessor.value()];
 
         switch (indexAccessor.componentType)
         {
         case fastgltf::ComponentType::UnsignedShort:
-            m_ushortIndices = true;
-            ushortIndices.reserve(ushortIndices.size() + indexAccessor.count);
-
-            fastgltf::iterateAccessor<std::uint16_t>(model, indexAccessor, [&](std::uint16_t idx) {
-                ushortIndices.push_back(idx);
-            });
-
-            m_indexCount = ushortIndices.size();
-            break;
-
         case fastgltf::ComponentType::UnsignedInt:
-            uintIndices.reserve(uintIndices.size() + indexAccessor.count);
+            data.Indices.reserve(indexAccessor.count);
 
             fastgltf::iterateAccessor<std::uint32_t>(model, indexAccessor, [&](std::uint32_t idx) {
-                uintIndices.push_back(idx);
+                data.Indices.push_back(idx);
             });
-
-            m_indexCount = uintIndices.size();
             break;
 
         default:
             break;
         }
-
-        
     }
 
     // Load Vertices
     {
-        fastgltf::Accessor& posAccessor =
+        const fastgltf::Accessor& posAccessor =
             model.accessors[primitive.findAttribute("POSITION")->accessorIndex];
-        vertices.resize(vertices.size() + posAccessor.count);
+        vertices.resize(posAccessor.count);
+
+        data.BoundsMin = glm::vec3(std::numeric_limits<float>::max());
+        data.BoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
         fastgltf::iterateAccessorWithIndex<glm::vec3>(model, posAccessor,
                                                       [&](glm::vec3 v, size_t index) {
                                                           Vertex newVertex;
@@ -71,6 +66,9 @@ Mesh::Mesh(fastgltf::Asset& model, fastgltf::Primitive& primitive)
                                                           newVertex.TexCoord =
                                                               glm::vec2(0.0f, 0.0f);
                                                           vertices[index] = newVertex;
+
+                                                          data.BoundsMin = glm::min(data.BoundsMin, v);
+                                                          data.BoundsMax = glm::max(data.BoundsMax, v);
                                                       });
     }
 
@@ -79,7 +77,6 @@ Mesh::Mesh(fastgltf::Asset& model, fastgltf::Primitive& primitive)
         auto uv = primitive.findAttribute("TEXCOORD_0");
         if (uv != primitive.attributes.end())
         {
-
             fastgltf::iterateAccessorWithIndex<glm::vec2>(model,
                                                           model.accessors[(*uv).accessorIndex],
                                                           [&](glm::vec2 v, size_t index) {
@@ -93,7 +90,6 @@ Mesh::Mesh(fastgltf::Asset& model, fastgltf::Primitive& primitive)
         auto colors = primitive.findAttribute("COLOR_0");
         if (colors != primitive.attributes.end())
         {
-
             fastgltf::iterateAccessorWithIndex<glm::vec4>(model,
                                                           model.accessors[(*colors).accessorIndex],
                                                           [&](glm::vec4 v, size_t index) {
@@ -126,43 +122,24 @@ Mesh::Mesh(fastgltf::Asset& model, fastgltf::Primitive& primitive)
                                                               vertices[index].Tangent = t;
                                                           });
         }
-        if (tangents->name == "")
+        else
         {
-            std::vector<uint32_t> indices = {};
-            if (m_ushortIndices)
-            {
-                indices.resize(ushortIndices.size());
-                for (size_t i = 0; i < ushortIndices.size(); ++i)
-                {
-                    indices[i] = static_cast<uint32_t>(ushortIndices[i]);
-                }
-            }
-            else
+            MikkTSpaceTangent::MikktSpaceMesh m = {};
+            m.m_indices = data.Indices;
+            m.m_positions.resize(vertices.size());
+            m.m_normals.resize(vertices.size());
+            m.m_texcoords.resize(vertices.size());
+            for (size_t i = 0; i < vertices.size(); i++)
             {
-                indices.resize(uintIndices.size());
-                for (size_t i = 0; i < uintIndices.size(); ++i)
-                {
-                    indices[i] = uintIndices[i];
-                }
+                m.m_positions[i] = vertices[i].Pos;
+                m.m_normals[i] = vertices[i].Normal;
+                m.m_texcoords[i] = vertices[i].TexCoord;
             }
-            std::vector<glm::vec3> p = {};
-            std::vector<glm::vec3> n = {};
-            std::vector<glm::vec2> t = {};
+
             std::vector<glm::vec4> tan = {};
-            for (int i = 0; i < vertices.size(); i++)
-            {
-                p.push_back(vertices[i].Pos);
-                n.push_back(vertices[i].Normal);
-                t.push_back(vertices[i].TexCoord);
-            }
-            MikkTSpaceTangent::MikktSpaceMesh m = {};
-            m.m_indices = indices;
-            m.m_normals = n;
-            m.m_positions = p;
-            m.m_texcoords = t;
             if (!MikkTSpaceTangent::GetTangents(m, tan))
                 printf("Failed to generate Tangents! \n");
-            for (int i = 0; i < vertices.size(); i++)
+            for (size_t i = 0; i < vertices.size() && i < tan.size(); i++)
             {
                 vertices[i].Tangent = tan[i];
                 vertices[i].Tangent.w *= -1;
@@ -170,38 +147,37 @@ Mesh::Mesh(fastgltf::Asset& model, fastgltf::Primitive& primitive)
         }
     }
 
-    // Create Vertex Buffer
-    {
-        BufferDesc desc = {};
-        desc.IsPersistent = false;
-        desc.Size = sizeof(vertices[0]) * vertices.size();
-        desc.Usage = BufferDesc::BufferUsage::Vertex;
-        desc.Name = "Vertex Buffer";
-        m_vertexBuffer = Buffer(desc, vertices.data());
-    }
+    return data;
+}
 
-    // Create Index Buffer
+void Mesh::pack_vertices(const std::vector<Vertex>& vertices,
+                         std::vector<PackedVertex>& packedVertices)
+{
+    packedVertices.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++)
     {
-        BufferDesc desc = {};
-        desc.IsPersistent = false;
-        desc.Usage = BufferDesc::BufferUsage::Index;
-        desc.Name = "Index Buffer";
-
-        void* data = nullptr;
+        const Vertex& v = vertices[i];
+        packedVertices[i].PosU = glm::vec4(v.Pos, v.TexCoord.x);
+        packedVertices[i].NormalV = glm::vec4(v.Normal, v.TexCoord.y);
+        packedVertices[i].Tangent = v.Tangent;
+        packedVertices[i].Color = glm::vec4(v.Color, 1.0f);
+    }
+}
 
-        if (m_ushortIndices) // Unsigned Short
-        {
-            desc.Size = sizeof(ushortIndices[0]) * ushortIndices.size();
-            
-            data = ushortIndices.data();
-        }
-        else // Unsigned Int
-        {
-            desc.Size = sizeof(uintIndices[0]) * uintIndices.size();
+Mesh::Mesh(fastgltf::Asset& model, fastgltf::Primitive& primitive)
+{
+    MeshData data = load_primitive(model, primitive);
+    m_indexCount = data.Indices.size();
+    m_ushortIndices = false;
+    m_boundsMin = data.BoundsMin;
+    m_boundsMax = data.BoundsMax;
 
-            data = uintIndices.data();
-        }
+    // Upload into the Geometry Pool, a single index buffer bind covers every mesh
+    {
+        std::vector<PackedVertex> packedVertices = {};
+        pack_vertices(data.Vertices, packedVertices);
 
-        m_indexBuffer = Buffer(desc, data);
+        auto& renderer = nijiEngine.ecs.find_system<Renderer>();
+        m_geometry = renderer.m_geometryPool.allocate(packedVertices, data.Indices);
     }
 }
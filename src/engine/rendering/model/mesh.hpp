@@ -1,25 +1,51 @@
 #pragma once
 
 #include "core/common.hpp"
+#include "../geometry_pool.hpp"
 //#include "../renderer.hpp"
 
 #include <fastgltf/types.hpp>
 
+#include <limits>
+
 namespace niji
 {
 
+// CPU side of a glTF primitive, before it goes into the geometry pool
+struct MeshData
+{
+    std::vector<Vertex> Vertices = {};
+    std::vector<uint32_t> Indices = {};
+    glm::vec3 BoundsMin = glm::vec3(0.0f);
+    glm::vec3 BoundsMax = glm::vec3(0.0f);
+};
+
 class Mesh
 {
   public:
     Mesh() = default;
     Mesh(fastgltf::Asset& model, fastgltf::Primitive& primitive);
 
+    // Reads the primitive's accessors into Vertices (and generates missing tangents), no GPU work
+    static MeshData load_primitive(const fastgltf::Asset& model,
+                                   const fastgltf::Primitive& primitive);
+    static void pack_vertices(const std::vector<Vertex>& vertices,
+                              std::vector<PackedVertex>& packedVertices);
+
     Mesh::Mesh(std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices)
     {
         m_indexCount = indices.size();
         m_ushortIndices = false;
         //m_vertexStride = sizeof(VertexType);
 
+        m_boundsMin = glm::vec3(std::numeric_limits<float>::max());
+        m_boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+        for (const auto& v : vertices)
+        {
+            m_boundsMin = glm::min(m_boundsMin, v);
+            m_boundsMax = glm::max(m_boundsMax, v);
+        }
+
         // Vertex Buffer
         {
             BufferDesc desc = {};
@@ -45,17 +71,32 @@ class Mesh
 
     void cleanup();
 
+    // Object-space bounding sphere (xyz = center, w = radius)
+    glm::vec4 get_bounding_sphere() const
+    {
+        glm::vec3 center = (m_boundsMin + m_boundsMax) * 0.5f;
+        float radius = glm::length(m_boundsMax - m_boundsMin) * 0.5f;
+        return glm::vec4(center, radius);
+    }
+
   private:
     friend class Renderer;
     friend class ForwardPass;
     friend class SkyboxPass;
     friend class DepthPass;
+    friend class DrawCullingPass;
 
+    // Only used by custom meshes (e.g. the skybox cube), glTF meshes live in the geometry pool
     Buffer m_vertexBuffer = {};
     Buffer m_indexBuffer = {};
 
+    GeometryHandle m_geometry = INVALID_GEOMETRY_HANDLE;
+
     uint64_t m_indexCount = 0;
     bool m_ushortIndices = false;
+
+    glm::vec3 m_boundsMin = glm::vec3(0.0f);
+    glm::vec3 m_boundsMax = glm::vec3(0.0f);
 };
 
 } // namespace niji
\ No newline at end of file
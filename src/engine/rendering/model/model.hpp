@@ -32,6 +32,8 @@ class Model : public std::enable_shared_from_this<Model>
     friend class ForwardPass;
     friend class SkyboxPass;
     friend class DepthPass;
+    friend class DrawCullingPass;
+    friend struct RenderScene;
 
     std::filesystem::path m_gltfPath = {};
     Entity m_parent = {};
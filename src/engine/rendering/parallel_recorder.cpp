@@ -0,0 +1,187 @@
+#include "parallel_recorder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+#include <imgui.h>
+
+#include "engine.hpp"
+
+using namespace niji;
+
+void ParallelCommandRecorder::init()
+{
+    // More chunks than threads would only add secondaries, not parallelism
+    m_maxChunks = std::clamp(nijiEngine.m_jobSystem.get_thread_count(), 1u, MAX_RECORD_CHUNKS);
+
+    QueueFamilyIndices queueFamilyIndices = QueueFamilyIndices::find_queue_families(
+        nijiEngine.m_context.m_physicalDevice, nijiEngine.m_context.m_surface);
+
+    m_pools.resize(m_maxChunks);
+    for (uint32_t chunk = 0; chunk < m_maxChunks; chunk++)
+    {
+        for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; frame++)
+        {
+            // Secondaries only live for one frame, the whole pool gets reset instead of
+            // individual command buffers
+            VkCommandPoolCreateInfo poolInfo = {};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolInfo.queueFamilyIndex = queueFamilyIndices.GraphicsFamily.value();
+
+            VkCommandPool& pool = m_pools[chunk][frame].Pool;
+            if (vkCreateCommandPool(nijiEngine.m_context.m_device, &poolInfo, nullptr, &pool) !=
+                VK_SUCCESS)
+                throw std::runtime_error("Failed to Create Recording Chunk Command Pool!");
+
+            std::string name = "Recording Chunk " + std::to_string(chunk) + " Frame " +
+                               std::to_string(frame) + " Command Pool";
+            SetObjectName(nijiEngine.m_context.m_device, VK_OBJECT_TYPE_COMMAND_POOL, pool,
+                          name.c_str());
+        }
+    }
+}
+
+void ParallelCommandRecorder::begin_frame(uint32_t frameIndex)
+{
+    m_frameIndex = frameIndex;
+
+    for (auto& chunkPools : m_pools)
+    {
+        ChunkPool& pool = chunkPools[frameIndex];
+        vkResetCommandPool(nijiEngine.m_context.m_device, pool.Pool, 0);
+        pool.UsedLists = 0;
+    }
+}
+
+void ParallelCommandRecorder::sync()
+{
+    m_lastStats = m_stats;
+    m_stats = {};
+    m_recordInParallel = m_enabled;
+}
+
+uint32_t ParallelCommandRecorder::get_chunk_count(uint32_t itemCount) const
+{
+    if (!m_recordInParallel || m_maxChunks < 2)
+        return 0;
+
+    const uint32_t chunkCount = std::min(m_maxChunks, itemCount / MIN_ITEMS_PER_RECORD_CHUNK);
+    return chunkCount >= 2 ? chunkCount : 0;
+}
+
+void ParallelCommandRecorder::record(const RenderInfo& info, uint32_t itemCount,
+                                     const RecordFunction& recordChunk,
+                                     FrameVector<VkCommandBuffer>& secondaries, BindStats& stats)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    m_chunkCount = get_chunk_count(itemCount);
+    if (m_chunkCount == 0)
+        throw std::runtime_error("Parallel recording requested for a pass that is too small!");
+
+    m_recordChunk = &recordChunk;
+    m_info = &info;
+    m_itemCount = itemCount;
+    m_chunkSize = (itemCount + m_chunkCount - 1) / m_chunkCount;
+    m_chunkBuffers.fill(VK_NULL_HANDLE);
+    m_chunkStats.fill(BindStats{});
+
+    // The calling thread records the first chunk itself, then helps with the rest in wait()
+    JobSystem& jobs = nijiEngine.m_jobSystem;
+    JobCounter counter = {};
+    for (uint32_t chunk = 1; chunk < m_chunkCount; chunk++)
+        jobs.run([this, chunk]() { record_chunk(chunk); }, &counter);
+
+    // The jobs still point at this recording and `counter`, so they have to finish either way
+    try
+    {
+        record_chunk(0);
+    }
+    catch (...)
+    {
+        jobs.wait(counter);
+        throw;
+    }
+    jobs.wait(counter);
+
+    m_recordChunk = nullptr;
+    m_info = nullptr;
+
+    secondaries.insert(secondaries.end(), m_chunkBuffers.begin(),
+                       m_chunkBuffers.begin() + m_chunkCount);
+    for (uint32_t chunk = 0; chunk < m_chunkCount; chunk++)
+        stats += m_chunkStats[chunk];
+
+    m_stats.ParallelPasses++;
+    m_stats.Chunks += m_chunkCount;
+    m_stats.RecordMs += std::chrono::duration<float, std::milli>(
+                            std::chrono::high_resolution_clock::now() - start)
+                            .count();
+}
+
+void ParallelCommandRecorder::record_inline(CommandList& cmd, uint32_t itemCount,
+                                            const RecordFunction& recordItems, BindStats& stats)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    recordItems(cmd, 0, itemCount, stats);
+
+    m_stats.InlinePasses++;
+    m_stats.RecordMs += std::chrono::duration<float, std::milli>(
+                            std::chrono::high_resolution_clock::now() - start)
+                            .count();
+}
+
+void ParallelCommandRecorder::record_chunk(uint32_t chunk)
+{
+    NIJI_PROFILE_FUNCTION();
+
+    const uint32_t begin = chunk * m_chunkSize;
+    const uint32_t end = std::min(begin + m_chunkSize, m_itemCount);
+
+    // Empty chunks still hand back a (empty) secondary, the pass executes all of them
+    CommandList& cmd = acquire_list(chunk);
+    cmd.begin_secondary(*m_info);
+    if (begin < end)
+        (*m_recordChunk)(cmd, begin, end, m_chunkStats[chunk]);
+    cmd.end_list();
+
+    m_chunkBuffers[chunk] = cmd.m_commandBuffer;
+}
+
+CommandList& ParallelCommandRecorder::acquire_list(uint32_t chunk)
+{
+    ChunkPool& pool = m_pools[chunk][m_frameIndex];
+
+    if (pool.UsedLists == pool.Lists.size())
+        pool.Lists.emplace_back(pool.Pool, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+    return pool.Lists[pool.UsedLists++];
+}
+
+void ParallelCommandRecorder::debug_panel()
+{
+    ImGui::Checkbox("Parallel Recording", &m_enabled);
+    ImGui::Text("Max Chunks: %u (job system threads)", m_maxChunks);
+    ImGui::Text("Min Batches Per Chunk: %u", MIN_ITEMS_PER_RECORD_CHUNK);
+    ImGui::Text("Passes: %u inline, %u parallel (%u chunks)", m_lastStats.InlinePasses,
+                m_lastStats.ParallelPasses, m_lastStats.Chunks);
+    ImGui::Text("Record Time: %.3f ms", m_lastStats.RecordMs);
+}
+
+void ParallelCommandRecorder::cleanup()
+{
+    // Destroying the pools frees every secondary allocated from them
+    for (auto& chunkPools : m_pools)
+    {
+        for (ChunkPool& pool : chunkPools)
+        {
+            vkDestroyCommandPool(nijiEngine.m_context.m_device, pool.Pool, nullptr);
+            pool.Lists.clear();
+        }
+    }
+    m_pools.clear();
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <vector>
+
+#include "core/commandlist.hpp"
+#include "render_queue.hpp"
+
+namespace niji
+{
+
+// Passes with fewer items than this per chunk get recorded inline on the calling thread. Items
+// are batches, one indirect draw each, so a scene like Sponza only has a few dozen of them.
+constexpr uint32_t MIN_ITEMS_PER_RECORD_CHUNK = 8;
+constexpr uint32_t MAX_RECORD_CHUNKS = 8;
+
+// CPU time the geometry passes spent recording over one frame
+struct RecordStats
+{
+    float RecordMs = 0.0f;
+    uint32_t InlinePasses = 0;
+    uint32_t ParallelPasses = 0;
+    uint32_t Chunks = 0;
+};
+
+// Records a pass' draw list as jobs on the engine's job system into secondary command buffers,
+// which the pass then executes inside its dynamic rendering scope. Every chunk owns one command
+// pool per frame in flight and is recorded by a single job, so a pool is never touched by two
+// threads at once (or by a frame the GPU is still using), whichever thread picks the job up.
+class ParallelCommandRecorder
+{
+  public:
+    // Records items [begin, end) of the pass into `cmd` (a secondary command buffer that has
+    // inherited the pass' rendering state), counting binds into `stats`
+    using RecordFunction =
+        std::function<void(CommandList& cmd, uint32_t begin, uint32_t end, BindStats& stats)>;
+
+    ParallelCommandRecorder() = default;
+
+    // Sized to the job system's threads, which have to be running by now
+    void init();
+
+    // Resets this frame's command pools, call once the frame's fence has been waited on
+    void begin_frame(uint32_t frameIndex);
+    // Call at the sync point (render thread idle): publishes the last frame's stats and applies
+    // the enabled toggle to the next one
+    void sync();
+
+    // Number of secondary command buffers `itemCount` items would get split into,
+    // 0 means the pass should just record inline
+    uint32_t get_chunk_count(uint32_t itemCount) const;
+
+    // Splits [0, itemCount) into chunks, records them in parallel and returns the secondary
+    // command buffers (in item order) to hand to vkCmdExecuteCommands
+    void record(const RenderInfo& info, uint32_t itemCount, const RecordFunction& recordChunk,
+                FrameVector<VkCommandBuffer>& secondaries, BindStats& stats);
+    // Records all of [0, itemCount) into `cmd` on the calling thread, timed like record()
+    void record_inline(CommandList& cmd, uint32_t itemCount, const RecordFunction& recordItems,
+                       BindStats& stats);
+
+    // Main thread only, takes effect from the next sync point on
+    void set_enabled(bool enabled)
+    {
+        m_enabled = enabled;
+    }
+    const RecordStats& get_last_stats() const
+    {
+        return m_lastStats;
+    }
+
+    void debug_panel();
+
+    void cleanup();
+
+  private:
+    struct ChunkPool
+    {
+        VkCommandPool Pool = VK_NULL_HANDLE;
+        std::vector<CommandList> Lists = {};
+        uint32_t UsedLists = 0;
+    };
+
+    void record_chunk(uint32_t chunk);
+    CommandList& acquire_list(uint32_t chunk);
+
+  private:
+    // [chunk][frame]
+    std::vector<std::array<ChunkPool, MAX_FRAMES_IN_FLIGHT>> m_pools = {};
+    uint32_t m_maxChunks = 1;
+    uint32_t m_frameIndex = 0;
+
+    // Current recording (only valid during record)
+    const RecordFunction* m_recordChunk = nullptr;
+    const RenderInfo* m_info = nullptr;
+    uint32_t m_itemCount = 0;
+    uint32_t m_chunkCount = 0;
+    uint32_t m_chunkSize = 0;
+    std::array<VkCommandBuffer, MAX_RECORD_CHUNKS> m_chunkBuffers = {};
+    std::array<BindStats, MAX_RECORD_CHUNKS> m_chunkStats = {};
+
+    // m_enabled belongs to the main thread, the render thread reads the copy made in sync()
+    bool m_enabled = true;
+    bool m_recordInParallel = true;
+    RecordStats m_stats = {};
+    RecordStats m_lastStats = {};
+};
+
+} // namespace niji
@@ -17,12 +17,12 @@ void DepthPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
         descriptorInfo.IsPushDescriptor = true;
         descriptorInfo.Name = "Depth Pass Descriptor";
 
-        DescriptorBinding materialBinding = {};
-        materialBinding.Type = DescriptorBinding::BindType::UBO;
-        materialBinding.Count = 1;
-        materialBinding.Stage = DescriptorBinding::BindStage::VERTEX_SHADER;
-        materialBinding.Sampler = nullptr;
-        descriptorInfo.Bindings.push_back(materialBinding);
+        DescriptorBinding instanceDataBinding = {};
+        instanceDataBinding.Type = DescriptorBinding::BindType::STORAGE_BUFFER;
+        instanceDataBinding.Count = 1;
+        instanceDataBinding.Stage = DescriptorBinding::BindStage::VERTEX_SHADER;
+        instanceDataBinding.Sampler = nullptr;
+        descriptorInfo.Bindings.push_back(instanceDataBinding);
 
         m_passDescriptor = Descriptor(descriptorInfo);
     }
@@ -57,104 +57,134 @@ void DepthPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
     pipelineDesc.ColorAttachmentFormat = swapchain.m_format;
     pipelineDesc.ColorAttachmentCount = 0;
 
-    pipelineDesc.VertexLayout =
-        DEFINE_VERTEX_LAYOUT(Vertex,
-                             VertexElement(0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, Pos)),
-                             VertexElement(1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, Color)),
-                             VertexElement(2, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, Normal)),
-                             VertexElement(3, VK_FORMAT_R32G32B32A32_SFLOAT,
-                                           offsetof(Vertex, Tangent)),
-                             VertexElement(4, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, TexCoord)));
+    // Vertices are pulled from the geometry pool through its device address
+    pipelineDesc.PushConstantSize = sizeof(GeometryPushConstants);
+    pipelineDesc.PushConstantStages = VK_SHADER_STAGE_VERTEX_BIT;
 
-    m_pipelines.emplace(pipelineDesc.Name, Pipeline(pipelineDesc));
+    add_pipeline(pipelineDesc);
 }
 
 void DepthPass::update_impl(Renderer& renderer, CommandList& cmd)
 {
-    const uint32_t& frameIndex = renderer.m_currentFrame;
-    {
-        ModelData ubo = {};
-
-        auto view = nijiEngine.ecs.m_registry.view<Transform, MeshComponent>();
-        for (auto&& [entity, trans, mesh] : view.each())
-        {
-            auto& model = mesh.Model;
-            auto& modelMesh = model->m_meshes[mesh.MeshID];
-            auto& material = model->m_materials[mesh.MaterialID];
+    // Per-instance data is uploaded by the Draw Culling Pass
 
-            ubo.Model = trans.World();
-            ubo.InvModel = glm::transpose(glm::inverse(ubo.Model));
+    // Push templates need the pipeline layout, which exists once the pipelines are ready
+    if (m_passTemplate == VK_NULL_HANDLE)
+        m_passTemplate = m_passDescriptor.create_update_template(
+            VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelines.at("Depth Pass").PipelineLayout, 1);
+}
 
-            ubo.MaterialInfo = material.m_materialInfo;
+void DepthPass::setup(Renderer& renderer, RenderGraphBuilder& builder, RenderInfo& info)
+{
+    const uint32_t& frameIndex = renderer.m_currentFrame;
 
-            vkCmdUpdateBuffer(cmd.m_commandBuffer, material.m_data[frameIndex].Handle, 0,
-                              sizeof(ModelData), &ubo);
-        }
-    }
+    RGResource viewport = builder.import_render_target("Viewport Target", *info.ViewportTarget);
+    RGResource depth = builder.import_render_target("Depth Target", *info.DepthAttachment);
+    RGResource drawCommands =
+        builder.import_buffer("Draw Commands", renderer.m_drawCommands[frameIndex]);
+    RGResource drawCounts = builder.import_buffer("Draw Counts", renderer.m_drawCounts[frameIndex]);
+
+    // The viewport stays bound (load/store NONE) so the pipeline layout matches the other passes
+    builder.read(viewport, RGUsage::ColorAttachmentRead);
+    builder.overwrite(depth, RGUsage::DepthAttachment);
+    builder.read(drawCommands, RGUsage::IndirectRead);
+    builder.read(drawCounts, RGUsage::IndirectRead);
 }
 
 void DepthPass::record(Renderer& renderer, CommandList& cmd, RenderInfo& info)
 {
-    Swapchain& swapchain = renderer.m_swapchain;
-    const uint32_t& frameIndex = renderer.m_currentFrame;
-    const Pipeline& pipeline = m_pipelines.at("Depth Pass");
-
     info.ViewportTarget->StoreOp = VK_ATTACHMENT_STORE_OP_NONE;
     info.ViewportTarget->LoadOp = VK_ATTACHMENT_LOAD_OP_NONE_KHR;
 
     info.DepthAttachment->StoreOp = VK_ATTACHMENT_STORE_OP_STORE;
     info.DepthAttachment->LoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 
-    cmd.begin_rendering(info, m_name);
+    // Big batch lists get split into chunks, recorded as jobs
+    const uint32_t batchCount = static_cast<uint32_t>(renderer.m_depthBatchOrder.size());
+    ParallelCommandRecorder& recorder = renderer.m_parallelRecorder;
+    const bool recordInParallel = recorder.get_chunk_count(batchCount) > 0;
+
+    cmd.begin_rendering(info, m_name, true, recordInParallel);
+
+    const ParallelCommandRecorder::RecordFunction recordBatches =
+        [&](CommandList& list, uint32_t begin, uint32_t end, BindStats& stats) {
+            record_batches(renderer, list, begin, end, stats);
+        };
+
+    if (recordInParallel)
+    {
+        FrameVector<VkCommandBuffer> secondaries = {};
+        recorder.record(info, batchCount, recordBatches, secondaries, renderer.m_bindStats);
+
+        cmd.execute_commands(secondaries);
+    }
+    else
+    {
+        recorder.record_inline(cmd, batchCount, recordBatches, renderer.m_bindStats);
+    }
+
+    cmd.end_rendering(info);
+}
+
+void DepthPass::record_batches(Renderer& renderer, CommandList& cmd, uint32_t begin, uint32_t end,
+                               BindStats& stats)
+{
+    Swapchain& swapchain = renderer.m_swapchain;
+    const uint32_t& frameIndex = renderer.m_currentFrame;
+    const Pipeline& pipeline = m_pipelines.at("Depth Pass");
 
     cmd.bind_pipeline(pipeline.PipelineObject);
+    stats.PipelineBinds++;
 
     cmd.bind_viewport(swapchain.m_extent);
     cmd.bind_scissor(swapchain.m_extent);
 
-    auto view = nijiEngine.ecs.m_registry.view<Transform, MeshComponent>();
-    for (auto&& [entity, trans, mesh] : view.each())
+    if (begin == end)
+        return;
+
+    // Globals - 0
     {
-        auto& model = mesh.Model;
-        auto& modelMesh = model->m_meshes[mesh.MeshID];
-        auto& material = model->m_materials[mesh.MeshID];
-
-        VkBuffer vertexBuffers[] = {modelMesh.m_vertexBuffer.Handle};
-        VkDeviceSize offsets[] = {0};
-        cmd.bind_vertex_buffer(0, 1, vertexBuffers, offsets);
-        cmd.bind_index_buffer(modelMesh.m_indexBuffer.Handle, 0,
-                              modelMesh.m_ushortIndices ? VK_INDEX_TYPE_UINT16
-                                                        : VK_INDEX_TYPE_UINT32);
-
-        // Globals - 0
-        {
-            cmd.bind_descriptor_sets(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.PipelineLayout, 0,
-                                     1,
-                                     &renderer.m_globalDescriptor.m_set[renderer.m_currentFrame]);
-        }
-
-        // Pass Set
-        {
-            m_passDescriptor.m_info.Bindings[0].Resource = &material.m_data[frameIndex];
-
-            std::vector<VkWriteDescriptorSet> writes = {};
-            std::vector<VkDescriptorBufferInfo> bufferInfos = {};
-            std::vector<VkDescriptorImageInfo> imageInfos = {};
-
-            writes.reserve(m_passDescriptor.m_info.Bindings.size());
-            bufferInfos.reserve(m_passDescriptor.m_info.Bindings.size());
-            imageInfos.reserve(m_passDescriptor.m_info.Bindings.size());
-
-            m_passDescriptor.push_descriptor_writes(writes, bufferInfos, imageInfos);
-
-            cmd.push_descriptor_set(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.PipelineLayout, 1,
-                                    static_cast<uint32_t>(writes.size()), writes.data());
-        }
-
-        cmd.draw_indexed(static_cast<uint32_t>(modelMesh.m_indexCount), 1, 0, 0, 0);
+        cmd.bind_descriptor_sets(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.PipelineLayout, 0, 1,
+                                 &renderer.m_globalDescriptor.m_set[renderer.m_currentFrame]);
+        stats.DescriptorSetBinds++;
     }
 
-    cmd.end_rendering(info);
+    // Pass Set (plain data on the stack, chunks can get recorded on several threads)
+    {
+        DescriptorUpdateData passData = {};
+        passData.set_buffer(0, renderer.m_instanceData[frameIndex]);
+
+        cmd.push_descriptor_set_with_template(m_passTemplate, pipeline.PipelineLayout, 1,
+                                              &passData);
+        stats.DescriptorPushes++;
+        stats.DescriptorWrites++;
+    }
+
+    // Geometry Pool (one bind for every draw)
+    {
+        renderer.m_geometryPool.bind(cmd);
+
+        GeometryPushConstants pushConstants = {};
+        pushConstants.Vertices = renderer.m_geometryPool.get_vertex_address();
+        cmd.push_constants(pipeline.PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                           sizeof(GeometryPushConstants), &pushConstants);
+        stats.IndexBufferBinds++;
+        stats.PushConstants++;
+    }
+
+    // One indirect draw per batch (nearest batches first for early-Z), the instance count is
+    // decided by the culling pass. Nothing changes between batches, so nothing gets rebound.
+    for (uint32_t i = begin; i < end; i++)
+    {
+        const uint32_t batchIndex = renderer.m_depthBatchOrder[i];
+        const DrawBatch& batch = renderer.m_drawBatches[batchIndex];
+        cmd.draw_indexed_indirect_count(renderer.m_drawCommands[frameIndex].Handle,
+                                        batch.CommandOffset * sizeof(VkDrawIndexedIndirectCommand),
+                                        renderer.m_drawCounts[frameIndex].Handle,
+                                        batchIndex * sizeof(uint32_t), batch.MaxDraws,
+                                        sizeof(VkDrawIndexedIndirectCommand));
+        stats.Draws++;
+    }
 }
 
 void DepthPass::cleanup()
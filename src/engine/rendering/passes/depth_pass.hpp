@@ -2,6 +2,8 @@
 
 #include "render_pass.hpp"
 
+#include "../render_queue.hpp"
+
 namespace niji
 {
 
@@ -14,10 +16,17 @@ class DepthPass final : public RenderPass
 
     void init(Swapchain& swapchain, Descriptor& globalDescriptor);
     void update_impl(Renderer& renderer, CommandList& cmd);
+    void setup(Renderer& renderer, RenderGraphBuilder& builder, RenderInfo& info);
     void record(Renderer& renderer, CommandList& cmd, RenderInfo& info);
     void cleanup();
 
   private:
+    // Records depth batches [begin, end) with all the state they need (inline or on a secondary)
+    void record_batches(Renderer& renderer, CommandList& cmd, uint32_t begin, uint32_t end,
+                        BindStats& stats);
+
+    // Owned by m_passDescriptor
+    VkDescriptorUpdateTemplate m_passTemplate = VK_NULL_HANDLE;
 };
 
 } // namespace niji
\ No newline at end of file
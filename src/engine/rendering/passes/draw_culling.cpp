@@ -0,0 +1,734 @@
+#include "draw_culling.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <numeric>
+
+#include <imgui.h>
+
+#include "core/components/render-components.hpp"
+#include "core/frame_arena.hpp"
+#include "core/vulkan-functions.hpp"
+
+#include "rendering/model/model.hpp"
+#include "rendering/render_scene.hpp"
+#include "engine.hpp"
+
+using namespace niji;
+
+// Gribb-Hartmann plane extraction (depth range [0, 1])
+static void extract_frustum_planes(const glm::mat4& viewProj, glm::vec4 (&planes)[6])
+{
+    auto row = [&](int i) {
+        return glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+    };
+
+    planes[0] = row(3) + row(0); // Left
+    planes[1] = row(3) - row(0); // Right
+    planes[2] = row(3) + row(1); // Bottom
+    planes[3] = row(3) - row(1); // Top
+    planes[4] = row(2);          // Near
+    planes[5] = row(3) - row(2); // Far
+
+    for (auto& plane : planes)
+        plane /= glm::length(glm::vec3(plane));
+}
+
+void DrawCullingPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
+{
+    m_name = "Draw Culling Pass";
+
+    // Create Culling Params Buffers
+    {
+        m_cullingParams.resize(MAX_FRAMES_IN_FLIGHT);
+        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            CullingParams ubo = {};
+            BufferDesc bufferDesc = {};
+            bufferDesc.IsPersistent = true;
+            bufferDesc.Name = "Culling Params Data";
+            bufferDesc.Size = sizeof(CullingParams);
+            bufferDesc.Usage = BufferDesc::BufferUsage::Uniform;
+            m_cullingParams[i] = Buffer(bufferDesc, &ubo);
+        }
+    }
+
+    // Init Push Descriptor
+    {
+        DescriptorInfo descriptorInfo = {};
+        descriptorInfo.IsPushDescriptor = true;
+        descriptorInfo.Name = "Draw Culling Pass Descriptor";
+
+        DescriptorBinding paramsBinding = {};
+        paramsBinding.Type = DescriptorBinding::BindType::UBO;
+        paramsBinding.Count = 1;
+        paramsBinding.Stage = DescriptorBinding::BindStage::COMPUTE;
+        paramsBinding.Sampler = nullptr;
+        descriptorInfo.Bindings.push_back(paramsBinding);
+
+        DescriptorBinding drawRecordsBinding = {};
+        drawRecordsBinding.Type = DescriptorBinding::BindType::STORAGE_BUFFER;
+        drawRecordsBinding.Count = 1;
+        drawRecordsBinding.Stage = DescriptorBinding::BindStage::COMPUTE;
+        drawRecordsBinding.Sampler = nullptr;
+        descriptorInfo.Bindings.push_back(drawRecordsBinding);
+
+        DescriptorBinding drawCommandsBinding = {};
+        drawCommandsBinding.Type = DescriptorBinding::BindType::STORAGE_BUFFER;
+        drawCommandsBinding.Count = 1;
+        drawCommandsBinding.Stage = DescriptorBinding::BindStage::COMPUTE;
+        drawCommandsBinding.Sampler = nullptr;
+        descriptorInfo.Bindings.push_back(drawCommandsBinding);
+
+        DescriptorBinding drawCountsBinding = {};
+        drawCountsBinding.Type = DescriptorBinding::BindType::STORAGE_BUFFER;
+        drawCountsBinding.Count = 1;
+        drawCountsBinding.Stage = DescriptorBinding::BindStage::COMPUTE;
+        drawCountsBinding.Sampler = nullptr;
+        descriptorInfo.Bindings.push_back(drawCountsBinding);
+
+        DescriptorBinding instanceDataBinding = {};
+        instanceDataBinding.Type = DescriptorBinding::BindType::STORAGE_BUFFER;
+        instanceDataBinding.Count = 1;
+        instanceDataBinding.Stage = DescriptorBinding::BindStage::COMPUTE;
+        instanceDataBinding.Sampler = nullptr;
+        descriptorInfo.Bindings.push_back(instanceDataBinding);
+
+        DescriptorBinding visibleRecordsBinding = {};
+        visibleRecordsBinding.Type = DescriptorBinding::BindType::STORAGE_BUFFER;
+        visibleRecordsBinding.Count = 1;
+        visibleRecordsBinding.Stage = DescriptorBinding::BindStage::COMPUTE;
+        visibleRecordsBinding.Sampler = nullptr;
+        descriptorInfo.Bindings.push_back(visibleRecordsBinding);
+
+        m_passDescriptor = Descriptor(descriptorInfo);
+    }
+
+    // Draw Culling Pipeline
+    {
+        ComputePipelineDesc cullingDesc = {globalDescriptor.m_setLayout,
+                                           m_passDescriptor.m_setLayout};
+
+        add_shader("shaders/draw_culling_cs.slang", ShaderType::COMPUTE);
+        cullingDesc.Name = "Draw Culling Compute Pass";
+        cullingDesc.ComputeShader = m_compute.Spirv[0];
+
+        add_pipeline(cullingDesc);
+    }
+
+    nijiEngine.m_editor.add_debug_menu_panel("Draw Culling Pass Panel",
+                                             std::bind(&DrawCullingPass::debug_panel, this));
+}
+
+void DrawCullingPass::debug_panel()
+{
+    ImGui::Checkbox("CPU Frustum Culling", &m_enableCpuCulling);
+    ImGui::SliderFloat("Min Screen Size", &m_minScreenSize, 0.0f, 0.1f, "%.3f");
+    ImGui::Checkbox("GPU Frustum Culling", &m_enableCulling);
+    ImGui::Text("Draw Records: %u", static_cast<uint32_t>(m_records.size()));
+    ImGui::Text("Draw Batches: %u", m_batchCount);
+    ImGui::Text("Moved Records: %u", m_movedRecords);
+    ImGui::Text("Instances Written: %u", m_instancesWritten);
+
+    const FrustumCullingStats& stats = m_cpuCuller.get_stats();
+    ImGui::Separator();
+    ImGui::Text("CPU Culling");
+    ImGui::Text("Visible: %u / %u", static_cast<uint32_t>(m_visibleRecords.size()), stats.Tested);
+    ImGui::Text("Frustum Culled: %u", stats.FrustumCulled);
+    ImGui::Text("Small Culled: %u", stats.SmallCulled);
+    ImGui::Text("Culling Time: %.3f ms", stats.CullTimeMs);
+
+    ImGui::Checkbox("Verify Results", &m_verifyResults);
+    if (m_check.Frames > 0)
+        ImGui::Text("Checked Frames: %u, Count Mismatches: %u, Instance Mismatches: %u",
+                    m_check.Frames, m_check.CountMismatches, m_check.InstanceMismatches);
+
+    const BindStats& binds = nijiEngine.ecs.find_system<Renderer>().m_lastBindStats;
+    ImGui::Separator();
+    ImGui::Text("Render Queue");
+    ImGui::Text("Queue Sort Time: %.3f ms", m_queueSortTimeMs);
+    ImGui::Text("Draws: %u", binds.Draws);
+    ImGui::Text("Pipeline Binds: %u", binds.PipelineBinds);
+    ImGui::Text("Descriptor Set Binds: %u", binds.DescriptorSetBinds);
+    ImGui::Text("Descriptor Pushes: %u (%u writes)", binds.DescriptorPushes, binds.DescriptorWrites);
+    ImGui::Text("Index Buffer Binds: %u", binds.IndexBufferBinds);
+    ImGui::Text("Push Constants: %u", binds.PushConstants);
+    ImGui::Text("Skipped Binds: %u", binds.SkippedBinds);
+}
+
+void DrawCullingPass::create_draw_buffers(Renderer& renderer, uint32_t recordCapacity,
+                                          uint32_t batchCapacity)
+{
+    // Buffers may still be in use by frames in flight
+    vkDeviceWaitIdle(nijiEngine.m_context.m_device);
+
+    renderer.m_drawRecords.resize(MAX_FRAMES_IN_FLIGHT);
+    renderer.m_instanceData.resize(MAX_FRAMES_IN_FLIGHT);
+    renderer.m_drawCommands.resize(MAX_FRAMES_IN_FLIGHT);
+    renderer.m_drawCounts.resize(MAX_FRAMES_IN_FLIGHT);
+    m_visibleRecordBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        CullingReadback& readback = m_readbacks[i];
+        if (readback.Buffer != VK_NULL_HANDLE)
+            vmaDestroyBuffer(nijiEngine.m_context.m_allocator, readback.Buffer,
+                             readback.Allocation);
+        nijiEngine.m_context.create_buffer(sizeof(uint32_t) * batchCapacity,
+                                           VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                           VMA_MEMORY_USAGE_GPU_TO_CPU, readback.Buffer,
+                                           readback.Allocation);
+        SetObjectName(nijiEngine.m_context.m_device, VK_OBJECT_TYPE_BUFFER, readback.Buffer,
+                      "Draw Counts Readback Buffer");
+        readback.Pending = false;
+
+        m_visibleRecordBuffers[i].cleanup();
+        renderer.m_drawRecords[i].cleanup();
+        renderer.m_instanceData[i].cleanup();
+        renderer.m_drawCommands[i].cleanup();
+        renderer.m_drawCounts[i].cleanup();
+
+        {
+            BufferDesc bufferDesc = {};
+            bufferDesc.IsPersistent = true;
+            bufferDesc.Name = "Draw Records Buffer";
+            bufferDesc.Size = sizeof(DrawRecord) * recordCapacity;
+            bufferDesc.Usage = BufferDesc::BufferUsage::Storage;
+            renderer.m_drawRecords[i] = Buffer(bufferDesc, nullptr);
+        }
+
+        {
+            BufferDesc bufferDesc = {};
+            bufferDesc.IsPersistent = true;
+            // Filled with the visible draws only, there are never more of those than records
+            bufferDesc.Name = "Instance Data Buffer";
+            bufferDesc.Size = sizeof(InstanceData) * recordCapacity;
+            bufferDesc.Usage = BufferDesc::BufferUsage::Storage;
+            renderer.m_instanceData[i] = Buffer(bufferDesc, nullptr);
+        }
+
+        {
+            BufferDesc bufferDesc = {};
+            bufferDesc.IsPersistent = true;
+            bufferDesc.Name = "Visible Records Buffer";
+            bufferDesc.Size = sizeof(uint32_t) * recordCapacity;
+            bufferDesc.Usage = BufferDesc::BufferUsage::Storage;
+            m_visibleRecordBuffers[i] = Buffer(bufferDesc, nullptr);
+        }
+
+        {
+            BufferDesc bufferDesc = {};
+            bufferDesc.IsPersistent = false;
+            bufferDesc.Name = "Indirect Draw Commands Buffer";
+            bufferDesc.Size = sizeof(VkDrawIndexedIndirectCommand) * recordCapacity;
+            bufferDesc.Usage = BufferDesc::BufferUsage::Indirect;
+            renderer.m_drawCommands[i] = Buffer(bufferDesc, nullptr);
+        }
+
+        {
+            BufferDesc bufferDesc = {};
+            bufferDesc.IsPersistent = false;
+            bufferDesc.Name = "Indirect Draw Counts Buffer";
+            bufferDesc.Size = sizeof(uint32_t) * batchCapacity;
+            bufferDesc.Usage = BufferDesc::BufferUsage::Indirect;
+            renderer.m_drawCounts[i] = Buffer(bufferDesc, nullptr);
+        }
+    }
+
+    m_recordCapacity = recordCapacity;
+    m_batchCapacity = batchCapacity;
+
+    // Every frame needs a fresh upload into its new buffer
+    m_uploadedVersion.fill(UINT64_MAX);
+}
+
+void DrawCullingPass::build_draw_records(Renderer& renderer)
+{
+    std::map<Material*, uint32_t> batchLookup = {};
+
+    auto& batches = renderer.m_drawBatches;
+    batches.clear();
+    m_records.clear();
+    m_instances.clear();
+    m_recordObjects.clear();
+    m_recordGeometry.clear();
+
+    std::vector<glm::vec3> boundsMin = {};
+    std::vector<glm::vec3> boundsMax = {};
+
+    const GeometryPool& geometryPool = renderer.m_geometryPool;
+
+    const std::vector<RenderObject>& objects = renderer.m_renderScene->Objects;
+    m_objectRecords.assign(objects.size(), UINT32_MAX);
+    for (uint32_t objectIndex = 0; objectIndex < objects.size(); objectIndex++)
+    {
+        const RenderObject& object = objects[objectIndex];
+        Mesh* modelMesh = object.ObjectMesh;
+        Material* material = object.ObjectMaterial;
+
+        if (modelMesh->m_geometry == INVALID_GEOMETRY_HANDLE)
+            continue;
+        m_objectRecords[objectIndex] = static_cast<uint32_t>(m_records.size());
+
+        // All geometry shares the pool's buffers, so only the material splits batches
+        auto [it, inserted] =
+            batchLookup.try_emplace(material, static_cast<uint32_t>(batches.size()));
+        if (inserted)
+        {
+            DrawBatch batch = {};
+            batch.BatchMaterial = material;
+            batches.push_back(batch);
+        }
+        batches[it->second].MaxDraws++;
+
+        const GeometryAllocation& geometry = geometryPool.get_allocation(modelMesh->m_geometry);
+
+        // Normal matrix gets computed here once, afterwards only when the transform moves. This is
+        // the CPU side copy, the visible ones get copied into the frame's instance buffer.
+        InstanceData instance = {};
+        instance.Model = object.World;
+        instance.NormalMatrix = glm::transpose(glm::inverse(instance.Model));
+        instance.MaterialIndex = material->m_materialIndex;
+        m_instances.push_back(instance);
+        m_recordObjects.push_back(objectIndex);
+        m_recordGeometry.push_back(modelMesh->m_geometry);
+        boundsMin.push_back(modelMesh->m_boundsMin);
+        boundsMax.push_back(modelMesh->m_boundsMax);
+
+        DrawRecord record = {};
+        record.BoundingSphere = modelMesh->get_bounding_sphere();
+        record.IndexCount = geometry.IndexCount;
+        record.FirstIndex = geometry.FirstIndex;
+        record.VertexOffset = static_cast<int32_t>(geometry.VertexOffset);
+        record.BatchID = it->second;
+        m_records.push_back(record);
+    }
+
+    // Hand out a contiguous range of indirect commands to every batch
+    uint32_t commandOffset = 0;
+    for (auto& batch : batches)
+    {
+        batch.CommandOffset = commandOffset;
+        commandOffset += batch.MaxDraws;
+    }
+
+    for (auto& record : m_records)
+        record.CommandOffset = batches[record.BatchID].CommandOffset;
+
+    m_cpuCuller.resize(static_cast<uint32_t>(m_records.size()));
+    for (uint32_t i = 0; i < m_records.size(); i++)
+    {
+        m_cpuCuller.set_local_bounds(i, boundsMin[i], boundsMax[i]);
+        m_cpuCuller.update_world_bounds(i, m_instances[i].Model);
+    }
+
+    m_batchCount = static_cast<uint32_t>(batches.size());
+    m_sceneVersion++;
+}
+
+void DrawCullingPass::refresh_moved_instances(const RenderScene& scene)
+{
+    m_movedRecords = 0;
+    for (uint32_t objectIndex : scene.MovedObjects)
+    {
+        const uint32_t recordIndex = m_objectRecords[objectIndex];
+        if (recordIndex == UINT32_MAX)
+            continue;
+
+        InstanceData& instance = m_instances[recordIndex];
+        instance.Model = scene.Objects[objectIndex].World;
+        instance.NormalMatrix = glm::transpose(glm::inverse(instance.Model));
+        m_cpuCuller.update_world_bounds(recordIndex, instance.Model);
+        m_movedRecords++;
+    }
+}
+
+void DrawCullingPass::build_render_queues(Renderer& renderer, const Camera& camera)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    m_depthQueue.clear();
+    m_opaqueQueue.clear();
+
+    for (uint32_t recordIndex : m_visibleRecords)
+    {
+        const glm::vec3 toCenter = m_cpuCuller.get_world_center(recordIndex) - camera.Position;
+        const uint32_t depth = quantize_sort_depth(glm::dot(toCenter, camera.Front), camera.FarPlane);
+        const uint32_t material = m_instances[recordIndex].MaterialIndex;
+        const uint32_t mesh = m_recordGeometry[recordIndex];
+        // The forward pass binds one pipeline variant per feature set, so those group first
+        const uint32_t variant =
+            renderer.m_drawBatches[m_records[recordIndex].BatchID].BatchMaterial->m_features;
+
+        m_depthQueue.push(make_depth_sort_key(RenderQueuePass::DEPTH, 0, depth, material, mesh),
+                          recordIndex);
+        m_opaqueQueue.push(
+            make_opaque_sort_key(RenderQueuePass::FORWARD, variant, material, mesh, depth),
+            recordIndex);
+    }
+
+    m_depthQueue.sort();
+    m_opaqueQueue.sort();
+
+    // Front-to-back record order, so the compute pass tends to emit the nearest draws of a batch
+    // first (atomic slots make this approximate)
+    const auto& depthItems = m_depthQueue.get_items();
+    for (size_t i = 0; i < depthItems.size(); i++)
+        m_visibleRecords[i] = depthItems[i].Value;
+
+    // Batches get drawn in the order their first record shows up in each queue
+    auto build_batch_order = [&](const RenderQueue& queue, std::vector<uint32_t>& order) {
+        FrameVector<uint8_t> seen(renderer.m_drawBatches.size(), 0);
+        order.clear();
+        for (const RenderQueueItem& item : queue.get_items())
+        {
+            const uint32_t batch = m_records[item.Value].BatchID;
+            if (seen[batch])
+                continue;
+
+            seen[batch] = 1;
+            order.push_back(batch);
+        }
+    };
+    build_batch_order(m_depthQueue, renderer.m_depthBatchOrder);
+    build_batch_order(m_opaqueQueue, renderer.m_forwardBatchOrder);
+
+    m_queueSortTimeMs = std::chrono::duration<float, std::milli>(
+                            std::chrono::high_resolution_clock::now() - start)
+                            .count();
+}
+
+void DrawCullingPass::update_impl(Renderer& renderer, CommandList& cmd)
+{
+    const uint32_t& frameIndex = renderer.m_currentFrame;
+
+    const RenderScene& scene = *renderer.m_renderScene;
+
+    // This slot's fence got waited on, so its last readback is complete
+    check_readback(frameIndex);
+
+    // Only rebuild the draw records when meshes get added or removed, or the pool got compacted.
+    // Otherwise only the moved objects get touched, nothing here walks every record.
+    const uint64_t poolVersion = renderer.m_geometryPool.get_version();
+    if (scene.StructureVersion != m_trackedStructureVersion ||
+        poolVersion != m_trackedPoolVersion)
+    {
+        m_trackedStructureVersion = scene.StructureVersion;
+        m_trackedPoolVersion = poolVersion;
+        build_draw_records(renderer);
+        m_movedRecords = 0;
+    }
+    else
+        refresh_moved_instances(scene);
+
+    const uint32_t recordCount = static_cast<uint32_t>(m_records.size());
+    const uint32_t batchCount = static_cast<uint32_t>(renderer.m_drawBatches.size());
+    if (renderer.m_drawRecords.empty() || recordCount > m_recordCapacity ||
+        batchCount > m_batchCapacity)
+    {
+        uint32_t recordCapacity = std::max(m_recordCapacity, 64u);
+        while (recordCapacity < recordCount)
+            recordCapacity *= 2;
+
+        uint32_t batchCapacity = std::max(m_batchCapacity, 16u);
+        while (batchCapacity < batchCount)
+            batchCapacity *= 2;
+
+        create_draw_buffers(renderer, recordCapacity, batchCapacity);
+    }
+
+    // Persistently mapped, the records only change with a new scene version
+    if (m_uploadedVersion[frameIndex] != m_sceneVersion)
+    {
+        memcpy(renderer.m_drawRecords[frameIndex].Data, m_records.data(),
+               sizeof(DrawRecord) * m_records.size());
+        m_uploadedVersion[frameIndex] = m_sceneVersion;
+    }
+
+    {
+        const Camera& camera = scene.View;
+        const glm::mat4 proj = camera.GetProjectionMatrix();
+
+        CullingParams ubo = {};
+        extract_frustum_planes(proj * camera.GetViewMatrix(), ubo.FrustumPlanes);
+
+        // CPU culling narrows down the records the compute pass has to look at
+        if (m_enableCpuCulling)
+        {
+            m_cpuCuller.cull(ubo.FrustumPlanes, camera.Position, glm::abs(proj[1][1]),
+                             m_minScreenSize, m_visibleRecords);
+        }
+        else
+        {
+            m_visibleRecords.resize(recordCount);
+            std::iota(m_visibleRecords.begin(), m_visibleRecords.end(), 0u);
+        }
+
+        build_render_queues(renderer, camera);
+
+        memcpy(m_visibleRecordBuffers[frameIndex].Data, m_visibleRecords.data(),
+               sizeof(uint32_t) * m_visibleRecords.size());
+
+        // One instance per visible draw, filled linearly in the same order as the visible records,
+        // the compute pass hands the slot to the draw through firstInstance
+        InstanceData* instances =
+            static_cast<InstanceData*>(renderer.m_instanceData[frameIndex].Data);
+        for (size_t i = 0; i < m_visibleRecords.size(); i++)
+            instances[i] = m_instances[m_visibleRecords[i]];
+        m_instancesWritten = static_cast<uint32_t>(m_visibleRecords.size());
+
+        if (m_verifyResults)
+            check_instances(renderer, scene, frameIndex);
+
+        ubo.RecordCount = static_cast<uint32_t>(m_visibleRecords.size());
+        ubo.EnableCulling = m_enableCulling ? 1 : 0;
+
+        if (m_verifyResults)
+            replay_culling(ubo.FrustumPlanes, m_readbacks[frameIndex]);
+
+        memcpy(m_cullingParams[frameIndex].Data, &ubo, sizeof(CullingParams));
+    }
+}
+
+void DrawCullingPass::setup(Renderer& renderer, RenderGraphBuilder& builder, RenderInfo& info)
+{
+    const uint32_t& frameIndex = renderer.m_currentFrame;
+
+    RGResource drawCommands =
+        builder.import_buffer("Draw Commands", renderer.m_drawCommands[frameIndex]);
+    RGResource drawCounts = builder.import_buffer("Draw Counts", renderer.m_drawCounts[frameIndex]);
+
+    // Counts get reset with a fill before the dispatch bumps them
+    builder.overwrite(drawCommands, RGUsage::StorageWriteCompute);
+    builder.overwrite(drawCounts, RGUsage::TransferWrite);
+    builder.write(drawCounts, RGUsage::StorageWriteCompute);
+}
+
+void DrawCullingPass::record(Renderer& renderer, CommandList& cmd, RenderInfo& info)
+{
+    const uint32_t& frameIndex = renderer.m_currentFrame;
+    const Pipeline& pipeline = m_pipelines.at("Draw Culling Compute Pass");
+
+    if (m_records.empty())
+        return;
+
+    Buffer& drawCommands = renderer.m_drawCommands[frameIndex];
+    Buffer& drawCounts = renderer.m_drawCounts[frameIndex];
+
+    VkDebugUtilsLabelEXT labelInfo{VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
+    labelInfo.pLabelName = m_name.c_str();
+    labelInfo.color[0] = 0.2f;
+    labelInfo.color[1] = 0.6f;
+    labelInfo.color[2] = 0.9f;
+    labelInfo.color[3] = 1.0f;
+
+    VKCmdBeginDebugUtilsLabelEXT(cmd.m_commandBuffer, &labelInfo);
+
+    // Reset Draw Counts
+    {
+        vkCmdFillBuffer(cmd.m_commandBuffer, drawCounts.Handle, 0, VK_WHOLE_SIZE, 0);
+
+        VkBufferMemoryBarrier2 bar = {};
+        bar.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+        bar.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        bar.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        bar.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        bar.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT;
+        bar.buffer = drawCounts.Handle;
+        bar.size = VK_WHOLE_SIZE;
+
+        VkDependencyInfo depInfo = {};
+        depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        depInfo.bufferMemoryBarrierCount = 1;
+        depInfo.pBufferMemoryBarriers = &bar;
+
+        vkCmdPipelineBarrier2(cmd.m_commandBuffer, &depInfo);
+    }
+
+    cmd.bind_pipeline(pipeline.PipelineObject, true);
+
+    // Globals - 0
+    {
+        cmd.bind_descriptor_sets(VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.PipelineLayout, 0, 1,
+                                 &renderer.m_globalDescriptor.m_set[frameIndex]);
+    }
+
+    // Per Pass - 1
+    {
+        m_passDescriptor.m_info.Bindings[0].Resource = &m_cullingParams[frameIndex];
+        m_passDescriptor.m_info.Bindings[1].Resource = &renderer.m_drawRecords[frameIndex];
+        m_passDescriptor.m_info.Bindings[2].Resource = &drawCommands;
+        m_passDescriptor.m_info.Bindings[3].Resource = &drawCounts;
+        m_passDescriptor.m_info.Bindings[4].Resource = &renderer.m_instanceData[frameIndex];
+        m_passDescriptor.m_info.Bindings[5].Resource = &m_visibleRecordBuffers[frameIndex];
+
+        FrameVector<VkWriteDescriptorSet> writes = {};
+        FrameVector<VkDescriptorBufferInfo> bufferInfos = {};
+        FrameVector<VkDescriptorImageInfo> imageInfos = {};
+
+        writes.reserve(m_passDescriptor.m_info.Bindings.size());
+        bufferInfos.reserve(m_passDescriptor.m_info.Bindings.size());
+        imageInfos.reserve(m_passDescriptor.m_info.Bindings.size());
+
+        m_passDescriptor.push_descriptor_writes(writes, bufferInfos, imageInfos);
+
+        cmd.push_descriptor_set(VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.PipelineLayout, 1,
+                                static_cast<uint32_t>(writes.size()), writes.data());
+    }
+
+    // Counts still need to be reset when everything got culled on the CPU
+    const uint32_t visibleCount = static_cast<uint32_t>(m_visibleRecords.size());
+    if (visibleCount > 0)
+    {
+        const uint32_t groupCount = (visibleCount + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE;
+        cmd.dispatch(groupCount, 1, 1);
+    }
+
+    // Copied back for the checks, the CPU reads them once this frame slot comes around again
+    if (m_verifyResults)
+    {
+        VkBufferMemoryBarrier2 toCopy = {};
+        toCopy.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+        toCopy.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        toCopy.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+        toCopy.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        toCopy.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+        toCopy.buffer = drawCounts.Handle;
+        toCopy.size = VK_WHOLE_SIZE;
+
+        VkDependencyInfo copyDepInfo = {};
+        copyDepInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        copyDepInfo.bufferMemoryBarrierCount = 1;
+        copyDepInfo.pBufferMemoryBarriers = &toCopy;
+        vkCmdPipelineBarrier2(cmd.m_commandBuffer, &copyDepInfo);
+
+        CullingReadback& readback = m_readbacks[frameIndex];
+        VkBufferCopy region = {};
+        region.size = sizeof(uint32_t) * m_batchCount;
+        vkCmdCopyBuffer(cmd.m_commandBuffer, drawCounts.Handle, readback.Buffer, 1, &region);
+
+        VkMemoryBarrier2 hostBarrier = {};
+        hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+        hostBarrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        hostBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        hostBarrier.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+        hostBarrier.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+
+        VkDependencyInfo hostDepInfo = {};
+        hostDepInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        hostDepInfo.memoryBarrierCount = 1;
+        hostDepInfo.pMemoryBarriers = &hostBarrier;
+        vkCmdPipelineBarrier2(cmd.m_commandBuffer, &hostDepInfo);
+
+        readback.BatchCount = m_batchCount;
+        readback.Pending = true;
+    }
+
+    VKCmdEndDebugUtilsLabelEXT(cmd.m_commandBuffer);
+}
+
+void DrawCullingPass::check_readback(uint32_t frameIndex)
+{
+    CullingReadback& readback = m_readbacks[frameIndex];
+    if (!readback.Pending)
+        return;
+    readback.Pending = false;
+
+    VmaAllocator allocator = nijiEngine.m_context.m_allocator;
+    void* data = nullptr;
+    vmaMapMemory(allocator, readback.Allocation, &data);
+    vmaInvalidateAllocation(allocator, readback.Allocation, 0, VK_WHOLE_SIZE);
+
+    const uint32_t* counts = static_cast<const uint32_t*>(data);
+    uint32_t gpuDraws = 0;
+    for (uint32_t batch = 0; batch < readback.BatchCount; batch++)
+        gpuDraws += counts[batch];
+    vmaUnmapMemory(allocator, readback.Allocation);
+
+    const uint32_t difference = gpuDraws > readback.ExpectedDraws
+                                    ? gpuDraws - readback.ExpectedDraws
+                                    : readback.ExpectedDraws - gpuDraws;
+    m_check.Frames++;
+    m_check.GpuDraws += gpuDraws;
+    m_check.MaxCountDifference = std::max(m_check.MaxCountDifference, difference);
+    if (difference > readback.Borderline)
+        m_check.CountMismatches++;
+}
+
+void DrawCullingPass::replay_culling(const glm::vec4 (&frustumPlanes)[6],
+                                     CullingReadback& readback) const
+{
+    readback.ExpectedDraws = 0;
+    readback.Borderline = 0;
+
+    // Same math as draw_culling_cs.slang, on the records that survived the CPU culling
+    for (uint32_t recordIndex : m_visibleRecords)
+    {
+        if (!m_enableCulling)
+        {
+            readback.ExpectedDraws++;
+            continue;
+        }
+
+        const glm::mat4& model = m_instances[recordIndex].Model;
+        const glm::vec4& sphere = m_records[recordIndex].BoundingSphere;
+        const glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(sphere), 1.0f));
+        const float scale = std::max(glm::length(glm::vec3(model[0])),
+                                     std::max(glm::length(glm::vec3(model[1])),
+                                              glm::length(glm::vec3(model[2]))));
+        const float radius = sphere.w * scale;
+
+        float margin = FLT_MAX;
+        for (const glm::vec4& plane : frustumPlanes)
+            margin = std::min(margin, glm::dot(glm::vec3(plane), center) + plane.w + radius);
+
+        if (margin >= 0.0f)
+            readback.ExpectedDraws++;
+        // The GPU may round the other way on a sphere that touches a plane
+        if (std::abs(margin) <= 1e-4f * (1.0f + glm::length(center)))
+            readback.Borderline++;
+    }
+}
+
+void DrawCullingPass::check_instances(const Renderer& renderer, const RenderScene& scene,
+                                      uint32_t frameIndex)
+{
+    // The GPU's copy has to match the transforms of the scene it's about to draw, slot by slot
+    const InstanceData* mapped =
+        static_cast<const InstanceData*>(renderer.m_instanceData[frameIndex].Data);
+    for (uint32_t i = 0; i < m_visibleRecords.size(); i++)
+    {
+        const glm::mat4& world = scene.Objects[m_recordObjects[m_visibleRecords[i]]].World;
+        if (std::memcmp(&mapped[i].Model, &world, sizeof(glm::mat4)) != 0)
+        {
+            m_check.InstanceMismatches++;
+            return;
+        }
+    }
+}
+
+void DrawCullingPass::cleanup()
+{
+    base_cleanup();
+
+    for (CullingReadback& readback : m_readbacks)
+    {
+        if (readback.Buffer != VK_NULL_HANDLE)
+            vmaDestroyBuffer(nijiEngine.m_context.m_allocator, readback.Buffer,
+                             readback.Allocation);
+        readback = {};
+    }
+
+    for (int i = 0; i < m_cullingParams.size(); i++)
+    {
+        m_cullingParams[i].cleanup();
+    }
+
+    for (int i = 0; i < m_visibleRecordBuffers.size(); i++)
+    {
+        m_visibleRecordBuffers[i].cleanup();
+    }
+}
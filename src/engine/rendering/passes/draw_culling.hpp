@@ -0,0 +1,132 @@
+#pragma once
+
+#include "render_pass.hpp"
+
+#include "../renderer.hpp"
+#include "../frustum_culler.hpp"
+#include "../render_queue.hpp"
+
+namespace niji
+{
+
+struct Camera;
+struct RenderScene;
+
+struct CullingParams
+{
+    glm::vec4 FrustumPlanes[6] = {};
+    uint32_t RecordCount = 0;
+    uint32_t EnableCulling = 1;
+    glm::u32vec2 _pad0 = {};
+};
+
+constexpr uint16_t CULLING_GROUP_SIZE = 64;
+
+// Results of DrawCullingPass::set_verify_results(), summed over the checked frames
+struct DrawCullingCheck
+{
+    uint32_t Frames = 0;
+    // Frames whose GPU draw count differed from the CPU's replay of the same sphere tests by more
+    // than the spheres that sit right on a plane
+    uint32_t CountMismatches = 0;
+    uint32_t MaxCountDifference = 0;
+    // Frames whose instance data (one slot per visible draw) didn't match the transforms of the
+    // extracted scene
+    uint32_t InstanceMismatches = 0;
+    uint64_t GpuDraws = 0;
+};
+
+// Culls the draw records on the CPU (SIMD AABB tests) and then on the GPU, which writes compacted
+// VkDrawIndexedIndirectCommands (+ a draw count per batch) for the geometry passes.
+class DrawCullingPass final : public RenderPass
+{
+  public:
+    DrawCullingPass()
+    {
+    }
+
+    void init(Swapchain& swapchain, Descriptor& globalDescriptor);
+    void update_impl(Renderer& renderer, CommandList& cmd);
+    void setup(Renderer& renderer, RenderGraphBuilder& builder, RenderInfo& info);
+    void record(Renderer& renderer, CommandList& cmd, RenderInfo& info);
+    void cleanup();
+
+    void debug_panel();
+
+    // Reads the GPU's draw counts back every frame and checks them, and the uploaded instances,
+    // against the CPU. Costs a readback and a pass over every record, meant for headless runs
+    // without the render thread.
+    void set_verify_results(bool verify)
+    {
+        m_verifyResults = verify;
+    }
+    const DrawCullingCheck& get_check() const
+    {
+        return m_check;
+    }
+
+  private:
+    struct CullingReadback
+    {
+        VkBuffer Buffer = VK_NULL_HANDLE;
+        VmaAllocation Allocation = nullptr;
+        // The CPU's replay of the shader's tests, written by update_impl()
+        uint32_t ExpectedDraws = 0;
+        uint32_t Borderline = 0;
+        uint32_t BatchCount = 0;
+        // The copy got recorded, its results are there once this frame slot comes around again
+        bool Pending = false;
+    };
+
+    void build_draw_records(Renderer& renderer);
+    // Only the scene's MovedObjects, the records line up with its objects
+    void refresh_moved_instances(const RenderScene& scene);
+    void build_render_queues(Renderer& renderer, const Camera& camera);
+    void create_draw_buffers(Renderer& renderer, uint32_t recordCapacity, uint32_t batchCapacity);
+
+    void check_readback(uint32_t frameIndex);
+    void replay_culling(const glm::vec4 (&frustumPlanes)[6], CullingReadback& readback) const;
+    void check_instances(const Renderer& renderer, const RenderScene& scene, uint32_t frameIndex);
+
+  private:
+    std::vector<Buffer> m_cullingParams = {};
+    // Records that survived CPU culling, the compute pass only looks at these
+    std::vector<Buffer> m_visibleRecordBuffers = {};
+    std::vector<uint32_t> m_visibleRecords = {};
+    FrustumCuller m_cpuCuller = {};
+
+    // Visible draws sorted front-to-back (depth pre-pass) and by material (forward pass)
+    RenderQueue m_depthQueue = {};
+    RenderQueue m_opaqueQueue = {};
+    float m_queueSortTimeMs = 0.0f;
+    std::vector<DrawRecord> m_records = {};
+    // One per record, with its normal matrix cached until the transform moves
+    std::vector<InstanceData> m_instances = {};
+    // Index into the scene's objects, and the other way around (UINT32_MAX without geometry)
+    std::vector<uint32_t> m_recordObjects = {};
+    std::vector<uint32_t> m_objectRecords = {};
+    std::vector<GeometryHandle> m_recordGeometry = {};
+
+    // Scene version each frame's record buffer was last written with
+    std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> m_uploadedVersion = {};
+    uint64_t m_sceneVersion = 0;
+    uint64_t m_trackedStructureVersion = UINT64_MAX;
+    uint64_t m_trackedPoolVersion = 0;
+
+    uint32_t m_recordCapacity = 0;
+    uint32_t m_batchCapacity = 0;
+    uint32_t m_batchCount = 0;
+    uint32_t m_instancesWritten = 0;
+    uint32_t m_movedRecords = 0;
+
+    bool m_verifyResults = false;
+    DrawCullingCheck m_check = {};
+    std::array<CullingReadback, MAX_FRAMES_IN_FLIGHT> m_readbacks = {};
+
+    bool m_enableCulling = true;
+    bool m_enableCpuCulling = true;
+    // Fraction of the screen height below which objects get rejected (0 = off)
+    float m_minScreenSize = 0.0f;
+};
+
+} // namespace niji
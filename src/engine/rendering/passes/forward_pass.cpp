@@ -1,5 +1,7 @@
 #include "forward_pass.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <functional>
 #include <stdexcept>
 
@@ -10,6 +12,8 @@
 #include "../../core/components/render-components.hpp"
 #include "../../core/components/transform.hpp"
 #include "../../engine.hpp"
+#include "../model/material.hpp"
+#include "../render_scene.hpp"
 
 using namespace niji;
 
@@ -35,11 +39,9 @@ void ForwardPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
 
     // Create Point Light Buffer
     {
-        VkDeviceSize bufferSize = sizeof(PointLight);
         m_pointLightBuffer.resize(MAX_FRAMES_IN_FLIGHT);
         for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
         {
-            std::array<PointLight, MAX_POINT_LIGHTS> buffer = {};
             BufferDesc bufferDesc = {};
             bufferDesc.IsPersistent = true;
             bufferDesc.Name = "Directional Lights Data";
@@ -86,9 +88,9 @@ void ForwardPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
         descriptorInfo.Bindings.push_back(pointLightBinding);
 
         DescriptorBinding materialBinding = {};
-        materialBinding.Type = DescriptorBinding::BindType::UBO;
+        materialBinding.Type = DescriptorBinding::BindType::STORAGE_BUFFER;
         materialBinding.Count = 1;
-        materialBinding.Stage = DescriptorBinding::BindStage::ALL_GRAPHICS;
+        materialBinding.Stage = DescriptorBinding::BindStage::FRAGMENT_SHADER;
         materialBinding.Sampler = nullptr;
         descriptorInfo.Bindings.push_back(materialBinding);
 
@@ -157,6 +159,13 @@ void ForwardPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
         samplerBinding3.Sampler = nullptr;
         descriptorInfo.Bindings.push_back(samplerBinding3);
 
+        DescriptorBinding instanceDataBinding = {};
+        instanceDataBinding.Type = DescriptorBinding::BindType::STORAGE_BUFFER;
+        instanceDataBinding.Count = 1;
+        instanceDataBinding.Stage = DescriptorBinding::BindStage::VERTEX_SHADER;
+        instanceDataBinding.Sampler = nullptr;
+        descriptorInfo.Bindings.push_back(instanceDataBinding);
+
         m_passDescriptor = Descriptor(descriptorInfo);
     }
 
@@ -189,16 +198,11 @@ void ForwardPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
 
     pipelineDesc.ColorAttachmentFormat = swapchain.m_format;
 
-    pipelineDesc.VertexLayout =
-        DEFINE_VERTEX_LAYOUT(Vertex,
-                             VertexElement(0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, Pos)),
-                             VertexElement(1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, Color)),
-                             VertexElement(2, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, Normal)),
-                             VertexElement(3, VK_FORMAT_R32G32B32A32_SFLOAT,
-                                           offsetof(Vertex, Tangent)),
-                             VertexElement(4, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, TexCoord)));
+    // Vertices are pulled from the geometry pool through its device address
+    pipelineDesc.PushConstantSize = sizeof(GeometryPushConstants);
+    pipelineDesc.PushConstantStages = VK_SHADER_STAGE_VERTEX_BIT;
 
-    m_pipelines.emplace(pipelineDesc.Name, Pipeline(pipelineDesc));
+    add_pipeline(pipelineDesc);
 
     nijiEngine.m_editor.add_debug_menu_panel("Forward Pass Panel", std::bind(&ForwardPass::debug_panel, this));
 }
@@ -222,12 +226,132 @@ void ForwardPass::debug_panel()
         ImGui::EndCombo();
     }
     ImGui::Checkbox("Draw Light Heatmap", &m_debugSettings.DrawLightHeatmap);
+
+    variants_panel();
+}
+
+void ForwardPass::variants_panel()
+{
+    if (!ImGui::CollapsingHeader("Shader Variants"))
+        return;
+
+    if (!nijiEngine.m_context.has_pipeline_executable_info())
+        ImGui::TextDisabled("No VK_KHR_pipeline_executable_properties, no shader statistics");
+
+    for (auto& [mask, variant] : m_variants)
+    {
+        char label[256] = {};
+        snprintf(label, sizeof(label), "%s (%.2f ms)###%u", get_variant_description(mask).c_str(),
+                 variant.BuildMs, mask);
+
+        if (!ImGui::TreeNode(label))
+            continue;
+
+        if (ImGui::Button("Capture Statistics"))
+            variant.Statistics = query_shader_statistics(variant.VariantPipeline->PipelineObject);
+
+        for (const ShaderStatistic& statistic : variant.Statistics)
+            ImGui::Text("%s - %s: %.0f", statistic.Executable.c_str(), statistic.Name.c_str(),
+                        statistic.Value);
+        ImGui::TreePop();
+    }
+}
+
+std::vector<ShaderStatistic> ForwardPass::get_base_statistics() const
+{
+    auto it = m_pipelines.find("Forward Pass");
+    if (it == m_pipelines.end())
+        return {};
+    return query_shader_statistics(it->second.PipelineObject);
+}
+
+std::string ForwardPass::get_variant_description(uint32_t mask)
+{
+    static const char* featureNames[MATERIAL_FEATURE_COUNT] = {"Base Color", "Normal",
+                                                               "Occlusion", "Metal/Rough",
+                                                               "Emissive"};
+
+    std::string description = {};
+    for (uint32_t i = 0; i < MATERIAL_FEATURE_COUNT; i++)
+    {
+        if (mask & (1 << i))
+            description += description.empty() ? featureNames[i]
+                                               : std::string(", ") + featureNames[i];
+    }
+    if (description.empty())
+        description = "Factors Only";
+
+    const uint32_t view = (mask >> FORWARD_VARIANT_DEBUG_VIEW_SHIFT) & 0xF;
+    description += std::string(" | ") + RenderFlagNames[view];
+    if (mask & FORWARD_VARIANT_LIGHT_HEATMAP)
+        description += " + Heatmap";
+    return description;
+}
+
+uint32_t ForwardPass::get_variant_mask(const Material& material) const
+{
+    uint32_t mask = material.m_features;
+    mask |= static_cast<uint32_t>(m_debugSettings.RenderMode) << FORWARD_VARIANT_DEBUG_VIEW_SHIFT;
+    if (m_debugSettings.DrawLightHeatmap)
+        mask |= FORWARD_VARIANT_LIGHT_HEATMAP;
+    return mask;
+}
+
+std::vector<uint32_t> ForwardPass::get_variant_constants(uint32_t mask)
+{
+    std::vector<uint32_t> constants = {};
+    for (uint32_t i = 0; i < MATERIAL_FEATURE_COUNT; i++)
+        constants.push_back((mask >> i) & 1);
+    constants.push_back((mask >> FORWARD_VARIANT_DEBUG_VIEW_SHIFT) & 0xF);
+    constants.push_back((mask & FORWARD_VARIANT_LIGHT_HEATMAP) ? 1 : 0);
+    return constants;
+}
+
+void ForwardPass::prepare_variants(Renderer& renderer)
+{
+    m_batchPipelines.resize(renderer.m_drawBatches.size());
+
+    for (size_t batchIndex = 0; batchIndex < renderer.m_drawBatches.size(); batchIndex++)
+    {
+        const uint32_t mask = get_variant_mask(*renderer.m_drawBatches[batchIndex].BatchMaterial);
+
+        auto it = m_variants.find(mask);
+        if (it == m_variants.end())
+        {
+            char name[64] = {};
+            snprintf(name, sizeof(name), "Forward Pass/%04x", mask);
+
+            // New materials or another debug view, a fast link when only the fragment part changed
+            auto start = std::chrono::high_resolution_clock::now();
+            ForwardVariant variant = {};
+            variant.VariantPipeline = &add_variant("Forward Pass", name, get_variant_constants(mask));
+            variant.BuildMs = std::chrono::duration<float, std::milli>(
+                                  std::chrono::high_resolution_clock::now() - start)
+                                  .count();
+
+            it = m_variants.emplace(mask, std::move(variant)).first;
+        }
+
+        m_batchPipelines[batchIndex] = it->second.VariantPipeline;
+    }
 }
 
 void ForwardPass::update_impl(Renderer& renderer, CommandList& cmd)
 {
     const uint32_t& frameIndex = renderer.m_currentFrame;
 
+    // Push templates need the pipeline layout, which exists once the pipelines are ready
+    if (m_passTemplate == VK_NULL_HANDLE)
+    {
+        const VkPipelineLayout layout = m_pipelines.at("Forward Pass").PipelineLayout;
+        m_passTemplate =
+            m_passDescriptor.create_update_template(VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1);
+        m_materialTemplate = m_passDescriptor.create_update_template(
+            VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1, {3, 5, 6, 7, 8, 9});
+    }
+
+    prepare_variants(renderer);
+
     /*static auto startTime = std::chrono::high_resolution_clock::now();
 
     auto currentTime = std::chrono::high_resolution_clock::now();
@@ -243,10 +367,9 @@ void ForwardPass::update_impl(Renderer& renderer, CommandList& cmd)
     }
 
     {
-        std::vector<PointLight> pointLightsArray = {};
+        FrameVector<PointLight> pointLightsArray = {};
 
-        auto pointLightView = nijiEngine.ecs.m_registry.view<PointLight>();
-        for (const auto& [ent, pointLight] : pointLightView.each())
+        for (const PointLight& pointLight : renderer.m_renderScene->PointLights)
         {
             if (pointLightsArray.size() < MAX_POINT_LIGHTS)
                 pointLightsArray.push_back(pointLight);
@@ -254,38 +377,42 @@ void ForwardPass::update_impl(Renderer& renderer, CommandList& cmd)
                 printf("\nWARNING: Max Amount of Point Lights Reached!\n");
         }
 
-        vkCmdUpdateBuffer(cmd.m_commandBuffer, m_pointLightBuffer[frameIndex].Handle, 0,
-                          sizeof(PointLight) * pointLightsArray.size(), pointLightsArray.data());
+        // Persistently mapped and owned by this frame slot, vkCmdUpdateBuffer tops out at 64KB
+        memcpy(m_pointLightBuffer[frameIndex].Data, pointLightsArray.data(),
+               sizeof(PointLight) * pointLightsArray.size());
     }
 }
 
-void ForwardPass::record(Renderer& renderer, CommandList& cmd, RenderInfo& info)
+void ForwardPass::setup(Renderer& renderer, RenderGraphBuilder& builder, RenderInfo& info)
 {
-    Swapchain& swapchain = renderer.m_swapchain;
     const uint32_t& frameIndex = renderer.m_currentFrame;
-    const Pipeline& pipeline = m_pipelines.at("Forward Pass"); 
 
+    RGResource viewport = builder.import_render_target("Viewport Target", *info.ViewportTarget);
+    RGResource depth = builder.import_render_target("Depth Target", *info.DepthAttachment);
+    RGResource lightGrid = builder.import_texture("Light Grid", renderer.m_lightGridTexture);
+    RGResource lightIndexList =
+        builder.import_buffer("Light Index List", renderer.m_lightIndexList[frameIndex]);
+    RGResource drawCommands =
+        builder.import_buffer("Draw Commands", renderer.m_drawCommands[frameIndex]);
+    RGResource drawCounts = builder.import_buffer("Draw Counts", renderer.m_drawCounts[frameIndex]);
+
+    builder.write(viewport, RGUsage::ColorAttachment);
+    // Depth was laid down by the Depth Pass, only tested against here
+    builder.read(depth, RGUsage::DepthAttachmentRead);
+    builder.read(lightGrid, RGUsage::StorageReadGraphics);
+    builder.read(lightIndexList, RGUsage::StorageReadGraphics);
+    builder.read(drawCommands, RGUsage::IndirectRead);
+    builder.read(drawCounts, RGUsage::IndirectRead);
+}
+
+void ForwardPass::record(Renderer& renderer, CommandList& cmd, RenderInfo& info)
+{
     info.ViewportTarget->StoreOp = VK_ATTACHMENT_STORE_OP_STORE;
     info.ViewportTarget->LoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
 
     info.DepthAttachment->StoreOp = VK_ATTACHMENT_STORE_OP_NONE;
     info.DepthAttachment->LoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
 
-    {
-        TransitionInfo before = {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-                                 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
-                                 VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL};
-
-        TransitionInfo after = {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-                                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
-                                VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL};
-        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
-        if (nijiEngine.m_context.has_stencil_component(info.DepthAttachment->Format))
-            aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
-
-        cmd.transition_image_explicit(*info.DepthAttachment, before, after, aspect, 1, 1);
-    }
-
     //// DEBUG ONLY
     //{
     //    VkMemoryBarrier2 memoryBarrier = {};
@@ -303,106 +430,170 @@ void ForwardPass::record(Renderer& renderer, CommandList& cmd, RenderInfo& info)
     //    vkCmdPipelineBarrier2(cmd.m_commandBuffer, &depInfo);
     //}
 
-    cmd.begin_rendering(info, m_name);
+    // Big batch lists get split into chunks, recorded as jobs
+    const uint32_t batchCount = static_cast<uint32_t>(renderer.m_forwardBatchOrder.size());
+    ParallelCommandRecorder& recorder = renderer.m_parallelRecorder;
+    const bool recordInParallel = recorder.get_chunk_count(batchCount) > 0;
+
+    cmd.begin_rendering(info, m_name, true, recordInParallel);
+
+    const ParallelCommandRecorder::RecordFunction recordBatches =
+        [&](CommandList& list, uint32_t begin, uint32_t end, BindStats& stats) {
+            record_batches(renderer, list, begin, end, stats);
+        };
 
-    cmd.bind_pipeline(pipeline.PipelineObject);
+    if (recordInParallel)
+    {
+        FrameVector<VkCommandBuffer> secondaries = {};
+        recorder.record(info, batchCount, recordBatches, secondaries, renderer.m_bindStats);
+
+        cmd.execute_commands(secondaries);
+    }
+    else
+    {
+        recorder.record_inline(cmd, batchCount, recordBatches, renderer.m_bindStats);
+    }
+
+    cmd.end_rendering(info);
+}
+
+void ForwardPass::record_batches(Renderer& renderer, CommandList& cmd, uint32_t begin,
+                                 uint32_t end, BindStats& stats)
+{
+    Swapchain& swapchain = renderer.m_swapchain;
+    const uint32_t& frameIndex = renderer.m_currentFrame;
+    // Variants share its layout, so it's used for every bind but the pipeline itself
+    const Pipeline& pipeline = m_pipelines.at("Forward Pass");
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
 
     cmd.bind_viewport(swapchain.m_extent);
     cmd.bind_scissor(swapchain.m_extent);
 
-    static bool b = true;
-    ImGui::ShowMetricsWindow(&b);
+    // Globals - 0
+    {
+        cmd.bind_descriptor_sets(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.PipelineLayout, 0, 1,
+                                 &renderer.m_globalDescriptor.m_set[renderer.m_currentFrame]);
+        stats.DescriptorSetBinds++;
+    }
 
-    auto view = nijiEngine.ecs.m_registry.view<Transform, MeshComponent>();
-    for (auto&& [entity, trans, mesh] : view.each())
+    // Geometry Pool (one bind for every draw)
     {
-        auto& model = mesh.Model;
-        auto& modelMesh = model->m_meshes[mesh.MeshID];
-        auto& material = model->m_materials[mesh.MeshID];
-
-        VkBuffer vertexBuffers[] = {modelMesh.m_vertexBuffer.Handle};
-        VkDeviceSize offsets[] = {0};
-        cmd.bind_vertex_buffer(0, 1, vertexBuffers, offsets);
-        cmd.bind_index_buffer(modelMesh.m_indexBuffer.Handle, 0,
-                              modelMesh.m_ushortIndices ? VK_INDEX_TYPE_UINT16
-                                                        : VK_INDEX_TYPE_UINT32);
-
-        // Globals - 0
-        {
-            cmd.bind_descriptor_sets(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.PipelineLayout, 0,
-                                     1,
-                                     &renderer.m_globalDescriptor.m_set[renderer.m_currentFrame]);
-        }
+        renderer.m_geometryPool.bind(cmd);
+
+        GeometryPushConstants pushConstants = {};
+        pushConstants.Vertices = renderer.m_geometryPool.get_vertex_address();
+        cmd.push_constants(pipeline.PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                           sizeof(GeometryPushConstants), &pushConstants);
+        stats.IndexBufferBinds++;
+        stats.PushConstants++;
+    }
 
-        // Per-Pass - 1
-        {
-            m_passDescriptor.m_info.Bindings[0].Resource = &m_passBuffer[frameIndex];
+    // Per-Pass - 1, pushed through update templates from plain data that's filled on the stack,
+    // so chunks can get recorded on several threads
+    DescriptorUpdateData passData = {};
+    passData.set_buffer(0, m_passBuffer[frameIndex]);
+    passData.set_buffer(1, m_pointLightBuffer[frameIndex]);
+    passData.set_buffer(2, renderer.m_materialBuffer);
 
-            m_passDescriptor.m_info.Bindings[1].Resource = &m_pointLightBuffer[frameIndex];
+    // IBL Textures (binding 10..12)
+    if (renderer.m_envmap)
+    {
+        passData.set_sampler(4, renderer.m_envmap->m_sampler);
+        passData.set_texture(10 + 0, renderer.m_envmap->m_specularCubemap);
+        passData.set_texture(10 + 1, renderer.m_envmap->m_diffuseCubemap);
+        passData.set_texture(10 + 2, renderer.m_envmap->m_brdfTexture);
+    }
+    else
+    {
+        printf("\nWARNING: Envmap is Null! \n");
+        passData.set_sampler(4, m_pointSampler);
+        passData.set_texture(10 + 0, renderer.m_fallbackTexture);
+        passData.set_texture(10 + 1, renderer.m_fallbackTexture);
+        passData.set_texture(10 + 2, renderer.m_fallbackTexture);
+    }
+    passData.set_buffer(13, renderer.m_sceneInfoBuffer[frameIndex]);
+    passData.set_texture(14, renderer.m_lightGridTexture);
+    passData.set_buffer(15, renderer.m_lightIndexList[frameIndex]);
+    passData.set_sampler(16, m_pointSampler);
+    passData.set_buffer(17, renderer.m_instanceData[frameIndex]);
 
-            m_passDescriptor.m_info.Bindings[2].Resource = &material.m_data[frameIndex];
+    const uint32_t passBindings = static_cast<uint32_t>(m_passDescriptor.m_info.Bindings.size());
 
-            m_passDescriptor.m_info.Bindings[3].Resource = &material.m_sampler;
+    // Sampler + textures of the last pushed material, batches that match it skip the push
+    std::array<const void*, 6> boundMaterial = {};
+    bool pushedPassSet = false;
 
-            m_passDescriptor.m_info.Bindings[4].Resource = &renderer.m_envmap->m_sampler;
+    // One indirect draw per batch in material order, the instance count is decided by the
+    // culling pass
+    for (uint32_t orderIndex = begin; orderIndex < end; orderIndex++)
+    {
+        const uint32_t batchIndex = renderer.m_forwardBatchOrder[orderIndex];
+        const DrawBatch& batch = renderer.m_drawBatches[batchIndex];
+        Material& material = *batch.BatchMaterial;
 
-            std::array<std::optional<Texture>*, 5> textures = {
-                &material.m_materialData.BaseColor, &material.m_materialData.NormalTexture,
-                &material.m_materialData.OcclusionTexture, &material.m_materialData.RoughMetallic,
-                &material.m_materialData.Emissive};
+        // Batches are sorted by material features, so neighbours mostly share their variant
+        const VkPipeline variant = m_batchPipelines[batchIndex]->PipelineObject;
+        if (variant != boundPipeline)
+        {
+            cmd.bind_pipeline(variant);
+            stats.PipelineBinds++;
+            boundPipeline = variant;
+        }
 
-            // Model Textures (binding 3..7)
-            for (size_t i = 0; i < 5; ++i)
-            {
-                bool hasValue = textures[i]->has_value();
-                m_passDescriptor.m_info.Bindings[5 + i].Resource =
-                    hasValue ? &(textures[i]->value()) : &renderer.m_fallbackTexture;
-            }
+        std::array<std::optional<Texture>*, 5> textures = {
+            &material.m_materialData.BaseColor, &material.m_materialData.NormalTexture,
+            &material.m_materialData.OcclusionTexture, &material.m_materialData.RoughMetallic,
+            &material.m_materialData.Emissive};
 
-            // m_depthTexture = Texture(*info.DepthAttachment);
-            // m_passDescriptor.m_info.Bindings[5].Resource = &m_depthTexture;
+        std::array<const void*, 6> materialState = {&material.m_sampler};
+        for (size_t i = 0; i < textures.size(); ++i)
+        {
+            materialState[1 + i] = textures[i]->has_value()
+                                       ? static_cast<const void*>(&(textures[i]->value()))
+                                       : static_cast<const void*>(&renderer.m_fallbackTexture);
+        }
 
-            // IBL Textures (binding 8..10)
-            if (renderer.m_envmap)
+        if (pushedPassSet && materialState == boundMaterial)
+        {
+            stats.SkippedBinds++;
+        }
+        else
+        {
+            passData.set_sampler(3, material.m_sampler);
+
+            // Model Textures (binding 5..9)
+            for (size_t i = 0; i < textures.size(); ++i)
+                passData.set_texture(5 + static_cast<uint32_t>(i),
+                                     *static_cast<const Texture*>(materialState[1 + i]));
+
+            // Pushed descriptors stay bound, so after the first push only the material
+            // bindings (sampler 3, textures 5..9) need to be written again
+            if (pushedPassSet)
             {
-                m_passDescriptor.m_info.Bindings[10 + 0].Resource =
-                    &renderer.m_envmap->m_specularCubemap;
-                m_passDescriptor.m_info.Bindings[10 + 1].Resource =
-                    &renderer.m_envmap->m_diffuseCubemap;
-                m_passDescriptor.m_info.Bindings[10 + 2].Resource =
-                    &renderer.m_envmap->m_brdfTexture;
+                cmd.push_descriptor_set_with_template(m_materialTemplate, pipeline.PipelineLayout,
+                                                      1, &passData);
+                stats.DescriptorWrites += FORWARD_MATERIAL_BINDING_COUNT;
+                stats.SkippedBinds += passBindings - FORWARD_MATERIAL_BINDING_COUNT;
             }
             else
             {
-                printf("\nWARNING: Envmap is Null! \n");
-                m_passDescriptor.m_info.Bindings[10 + 0].Resource = &renderer.m_fallbackTexture;
-                m_passDescriptor.m_info.Bindings[10 + 1].Resource = &renderer.m_fallbackTexture;
-                m_passDescriptor.m_info.Bindings[10 + 2].Resource = &renderer.m_fallbackTexture;
+                cmd.push_descriptor_set_with_template(m_passTemplate, pipeline.PipelineLayout, 1,
+                                                      &passData);
+                stats.DescriptorWrites += passBindings;
             }
-            m_passDescriptor.m_info.Bindings[13].Resource = &renderer.m_sceneInfoBuffer[frameIndex];
-
-            m_passDescriptor.m_info.Bindings[14].Resource = &renderer.m_lightGridTexture;
-            m_passDescriptor.m_info.Bindings[15].Resource = &renderer.m_lightIndexList[frameIndex];
-            m_passDescriptor.m_info.Bindings[16].Resource = &m_pointSampler;
+            stats.DescriptorPushes++;
 
-            std::vector<VkWriteDescriptorSet> writes = {};
-            std::vector<VkDescriptorBufferInfo> bufferInfos = {};
-            std::vector<VkDescriptorImageInfo> imageInfos = {};
-
-            writes.reserve(m_passDescriptor.m_info.Bindings.size());
-            bufferInfos.reserve(m_passDescriptor.m_info.Bindings.size());
-            imageInfos.reserve(m_passDescriptor.m_info.Bindings.size());
-
-            m_passDescriptor.push_descriptor_writes(writes, bufferInfos, imageInfos);
-
-            cmd.push_descriptor_set(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.PipelineLayout, 1,
-                                    static_cast<uint32_t>(writes.size()), writes.data());
+            boundMaterial = materialState;
+            pushedPassSet = true;
         }
 
-        cmd.draw_indexed(static_cast<uint32_t>(modelMesh.m_indexCount), 1, 0, 0, 0);
+        cmd.draw_indexed_indirect_count(renderer.m_drawCommands[frameIndex].Handle,
+                                        batch.CommandOffset * sizeof(VkDrawIndexedIndirectCommand),
+                                        renderer.m_drawCounts[frameIndex].Handle,
+                                        batchIndex * sizeof(uint32_t), batch.MaxDraws,
+                                        sizeof(VkDrawIndexedIndirectCommand));
+        stats.Draws++;
     }
-
-    cmd.end_rendering(info);
 }
 
 void ForwardPass::cleanup()
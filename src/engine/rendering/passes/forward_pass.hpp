@@ -2,9 +2,31 @@
 
 #include "render_pass.hpp"
 
+#include <unordered_map>
+
+#include "../render_queue.hpp"
+
 namespace niji
 {
 
+class Material;
+
+// A forward pipeline variant is picked by the material's MATERIAL_* bits plus the debug view
+// (bits 8..11) and the light heatmap (bit 12), which all become fragment specialization constants
+constexpr uint32_t FORWARD_VARIANT_DEBUG_VIEW_SHIFT = 8;
+constexpr uint32_t FORWARD_VARIANT_LIGHT_HEATMAP = 1 << 12;
+
+// Sampler 3 + textures 5..9, what changes between materials
+constexpr uint32_t FORWARD_MATERIAL_BINDING_COUNT = 6;
+
+struct ForwardVariant
+{
+    const Pipeline* VariantPipeline = nullptr;
+    float BuildMs = 0.0f;
+    // Captured on request in the debug panel
+    std::vector<ShaderStatistic> Statistics = {};
+};
+
 class ForwardPass final : public RenderPass
 {
   public:
@@ -14,15 +36,47 @@ class ForwardPass final : public RenderPass
 
     void init(Swapchain& swapchain, Descriptor& globalDescriptor);
     void update_impl(Renderer& renderer, CommandList& cmd);
+    void setup(Renderer& renderer, RenderGraphBuilder& builder, RenderInfo& info);
     void record(Renderer& renderer, CommandList& cmd, RenderInfo& info);
     void cleanup();
 
     void debug_panel();
+
+    // Driver statistics of the unspecialized pipeline (every material feature in the lit view),
+    // what the variants get compared against. Empty without VK_KHR_pipeline_executable_properties.
+    std::vector<ShaderStatistic> get_base_statistics() const;
+    // Every variant built so far, by mask
+    const std::unordered_map<uint32_t, ForwardVariant>& get_variants() const
+    {
+        return m_variants;
+    }
+    // "Base Color, Normal | Lit + Heatmap"
+    static std::string get_variant_description(uint32_t mask);
+
   private:
+    // Records forward batches [begin, end) with all the state they need (inline or on a secondary)
+    void record_batches(Renderer& renderer, CommandList& cmd, uint32_t begin, uint32_t end,
+                        BindStats& stats);
+
+    uint32_t get_variant_mask(const Material& material) const;
+    // forward_pass.slang's specialization constants, in constant_id order
+    static std::vector<uint32_t> get_variant_constants(uint32_t mask);
+    // Builds the variants the draw batches need that don't exist yet, recording only looks them up
+    void prepare_variants(Renderer& renderer);
+    void variants_panel();
+
     DebugSettings m_debugSettings = {};
     std::vector<Buffer> m_pointLightBuffer = {};
     Texture m_depthTexture = {};
     Sampler m_pointSampler = {};
+
+    std::unordered_map<uint32_t, ForwardVariant> m_variants = {};
+    // Variant of every draw batch for the current debug view, indexed like Renderer::m_drawBatches
+    std::vector<const Pipeline*> m_batchPipelines = {};
+
+    // Owned by m_passDescriptor. The whole pass set, then only the material bindings.
+    VkDescriptorUpdateTemplate m_passTemplate = VK_NULL_HANDLE;
+    VkDescriptorUpdateTemplate m_materialTemplate = VK_NULL_HANDLE;
 };
 
 } // namespace niji
\ No newline at end of file
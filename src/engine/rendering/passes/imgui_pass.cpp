@@ -6,6 +6,7 @@
 
 #include "../app/camera_system.hpp"
 #include "../../engine.hpp"
+#include "../render_scene.hpp"
 #include "../renderer.hpp"
 
 using namespace niji;
@@ -159,11 +160,13 @@ void ImGuiPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
     init_info.Device = nijiEngine.m_context.m_device;
     init_info.QueueFamily = indices.GraphicsFamily.value();
     init_info.Queue = nijiEngine.m_context.m_graphicsQueue;
-    init_info.PipelineCache = VK_NULL_HANDLE;
+    init_info.PipelineCache = nijiEngine.m_context.get_pipeline_cache().get_handle();
     init_info.DescriptorPool = m_imguiDescriptorPool;
     init_info.RenderPass = VK_NULL_HANDLE;
     init_info.MinImageCount = 2;
-    init_info.ImageCount = swapchain.m_images.size();
+    // The backend rotates its vertex buffers by this count, so it has to cover the frames in flight
+    init_info.ImageCount = std::max<uint32_t>(static_cast<uint32_t>(swapchain.m_images.size()),
+                                              MAX_FRAMES_IN_FLIGHT);
     init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
     init_info.UseDynamicRendering = true;
     init_info.PipelineRenderingCreateInfo = pipelineRenderingInfo;
@@ -173,51 +176,19 @@ void ImGuiPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
 
 void ImGuiPass::update_impl(Renderer& renderer, CommandList& cmd)
 {
-    // Draw Editor
-    nijiEngine.m_editor.render(renderer);
 }
 
-void ImGuiPass::record(Renderer& renderer, CommandList& cmd, RenderInfo& info)
+void ImGuiPass::update_ui(Renderer& renderer, RenderScene& scene)
 {
-    info.ColorAttachment->StoreOp = VK_ATTACHMENT_STORE_OP_STORE;
-    info.ColorAttachment->LoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-
-    info.DepthAttachment->StoreOp = VK_ATTACHMENT_STORE_OP_NONE;
-    info.DepthAttachment->LoadOp = VK_ATTACHMENT_LOAD_OP_NONE_KHR;
-
-    {
-        TransitionInfo before;
-        if (info.ColorAttachment->CurrentLayout == VK_IMAGE_LAYOUT_UNDEFINED)
-            before = {VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED};
-        else if (info.ColorAttachment->CurrentLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
-            before = {VK_PIPELINE_STAGE_NONE, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
-
-        TransitionInfo after = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-                                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
-
-        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
-
-        cmd.transition_image_explicit(*info.ColorAttachment, before, after, aspect, 1, 1);
-    }
-
-    {
-        TransitionInfo before;
-        if (info.ViewportTarget->CurrentLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
-            before = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-                      VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
-
-        TransitionInfo after = {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                                VK_ACCESS_COLOR_ATTACHMENT_READ_BIT,
-                                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    // Draw Editor
+    nijiEngine.m_editor.render(renderer);
 
-        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    // Built here rather than while recording, ImGui isn't touched from the render thread
+    static bool showMetrics = true;
+    ImGui::ShowMetricsWindow(&showMetrics);
 
-        cmd.transition_image_explicit(*info.ViewportTarget, before, after, aspect, 1, 1);
-    }
-
-    auto& viewportRT = renderer.m_viewportTargets[renderer.m_imageIndex];
+    // The frame slot picks the viewport target, the image gets acquired later on the render thread
+    auto& viewportRT = renderer.m_viewportTargets[renderer.m_currentFrame];
 
     ImGui::Begin("Viewport");
     auto& size = ImGui::GetContentRegionAvail();
@@ -227,11 +198,51 @@ void ImGuiPass::record(Renderer& renderer, CommandList& cmd, RenderInfo& info)
         cameraSystem.m_isInsideViewport = ImGui::IsItemHovered();
     ImGui::End();
 
-    cmd.begin_rendering(info, m_name, false);
-
     ImGui::Render();
 
-    ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmd.m_commandBuffer);
+    // Font atlas uploads go through the graphics queue, the render thread doesn't submit now
+    ImDrawData* drawData = ImGui::GetDrawData();
+    if (drawData->Textures != nullptr)
+    {
+        for (ImTextureData* texture : *drawData->Textures)
+        {
+            if (texture->Status != ImTextureStatus_OK)
+                ImGui_ImplVulkan_UpdateTexture(texture);
+        }
+    }
+
+    scene.UI.capture(*drawData);
+}
+
+void ImGuiPass::setup(Renderer& renderer, RenderGraphBuilder& builder, RenderInfo& info)
+{
+    RGResource backbuffer = builder.import_render_target("Swapchain Image", *info.ColorAttachment);
+    RGResource viewport = builder.import_render_target("Viewport Target", *info.ViewportTarget);
+    RGResource depth = builder.import_render_target("Depth Target", *info.DepthAttachment);
+
+    builder.overwrite(backbuffer, RGUsage::ColorAttachment);
+    // The viewport gets drawn as an image inside the editor
+    builder.read(viewport, RGUsage::SampledFragment);
+    // Bound with load/store NONE, never touched
+    builder.read(depth, RGUsage::DepthAttachmentRead);
+}
+
+void ImGuiPass::record(Renderer& renderer, CommandList& cmd, RenderInfo& info)
+{
+    info.ColorAttachment->StoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+    info.ColorAttachment->LoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+
+    info.DepthAttachment->StoreOp = VK_ATTACHMENT_STORE_OP_NONE;
+    info.DepthAttachment->LoadOp = VK_ATTACHMENT_LOAD_OP_NONE_KHR;
+
+    cmd.begin_rendering(info, m_name, false);
+
+    // The UI got built and captured on the main thread, see update_ui()
+    if (ImDrawData* drawData = renderer.m_renderScene->UI.get_draw_data())
+    {
+        std::lock_guard<std::mutex> lock(renderer.m_imguiMutex);
+        ImGui_ImplVulkan_RenderDrawData(drawData, cmd.m_commandBuffer);
+    }
 
     cmd.end_rendering(info);
 }
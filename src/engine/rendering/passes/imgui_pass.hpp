@@ -14,6 +14,8 @@ class ImGuiPass final : public RenderPass
 
     void init(Swapchain& swapchain, Descriptor& globalDescriptor);
     void update_impl(Renderer& renderer, CommandList& cmd);
+    void update_ui(Renderer& renderer, RenderScene& scene) override;
+    void setup(Renderer& renderer, RenderGraphBuilder& builder, RenderInfo& info);
     void record(Renderer& renderer, CommandList& cmd, RenderInfo& info);
     void cleanup();
 
@@ -2,8 +2,7 @@
 
 #include <vk_mem_alloc.h>
 
-#include "../app/camera_system.hpp"
-
+#include "rendering/render_scene.hpp"
 #include "rendering/renderer.hpp"
 #include "core/vulkan-functions.hpp"
 #include "engine.hpp"
@@ -16,7 +15,11 @@ void LightCullingPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
     m_name = "Light Culling Pass";
 
     // Init "m_totalThreads" and "m_totalThreadGroups"
-    on_window_resize();
+    {
+        int width = 0, height = 0;
+        nijiEngine.m_context.get_window_size(width, height);
+        on_window_resize(width, height);
+    }
 
     // Create Dispatch Param Buffers
     {
@@ -27,10 +30,14 @@ void LightCullingPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
             DispatchParams ubo = {};
             BufferDesc bufferDesc = {};
             bufferDesc.IsPersistent = true;
+            bufferDesc.SharedQueues = true;
             bufferDesc.Name = "Dispatch Params Data";
             bufferDesc.Size = sizeof(DispatchParams);
             bufferDesc.Usage = BufferDesc::BufferUsage::Uniform;
             m_dispatchParams[i] = Buffer(bufferDesc, &ubo);
+
+            bufferDesc.Name = "Frustum Params Data";
+            m_frustumParams.push_back(Buffer(bufferDesc, &ubo));
         }
     }
 
@@ -45,6 +52,7 @@ void LightCullingPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
             buffer.resize(totalTiles);
             BufferDesc bufferDesc = {};
             bufferDesc.IsPersistent = true;
+            bufferDesc.SharedQueues = true;
             bufferDesc.Name = "Tile Frustums";
             bufferDesc.Size = sizeof(Frustum) * totalTiles;
             bufferDesc.Usage = BufferDesc::BufferUsage::Storage;
@@ -62,22 +70,6 @@ void LightCullingPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
     //[[vk::binding(4, 1)]]
     // RWTexture2D<uint2> o_LightGrid;
 
-    // Create Light Index Counter Buffer
-    {
-        VkDeviceSize bufferSize = sizeof(LightIndexCounter);
-        m_lightIndexCounter.resize(MAX_FRAMES_IN_FLIGHT);
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-        {
-            LightIndexCounter buffer = {};
-            BufferDesc bufferDesc = {};
-            bufferDesc.IsPersistent = true;
-            bufferDesc.Name = "Light Index Counter Buffer";
-            bufferDesc.Size = sizeof(LightIndexCounter);
-            bufferDesc.Usage = BufferDesc::BufferUsage::Storage;
-            m_lightIndexCounter[i] = Buffer(bufferDesc, &buffer);
-        }
-    }
-
     //// Create Light Index List Buffer
     //{
     //    VkDeviceSize bufferSize = sizeof(LightIndexList);
@@ -122,7 +114,7 @@ void LightCullingPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
         passParamsBinding.Count = 1;
         passParamsBinding.Stage = DescriptorBinding::BindStage::COMPUTE;
         passParamsBinding.Sampler = nullptr;
-        passParamsBinding.Resource = &m_dispatchParams;
+        passParamsBinding.Resource = &m_frustumParams;
         descriptorInfo.Bindings.push_back(passParamsBinding);
 
         DescriptorBinding frustumsBinding = {};
@@ -145,7 +137,7 @@ void LightCullingPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
         gridFrustumsDesc.Name = "Grid Frustum Compute Pass";
         gridFrustumsDesc.ComputeShader = m_compute.Spirv[0];
 
-        m_pipelines.emplace(gridFrustumsDesc.Name, Pipeline(gridFrustumsDesc));
+        add_pipeline(gridFrustumsDesc);
     }
 
     // Init Light Culling Descriptor
@@ -175,7 +167,7 @@ void LightCullingPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
         lightIndexCounterBinding.Count = 1;
         lightIndexCounterBinding.Stage = DescriptorBinding::BindStage::COMPUTE;
         lightIndexCounterBinding.Sampler = nullptr;
-        lightIndexCounterBinding.Resource = &m_lightIndexCounter;
+        // Transient, bound from the render graph at record time
         descriptorInfo.Bindings.push_back(lightIndexCounterBinding);
 
         DescriptorBinding lightIndexListBinding = {};
@@ -229,7 +221,7 @@ void LightCullingPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
         lightCullingDesc.Name = "Light Culling Compute Pass";
         lightCullingDesc.ComputeShader = m_compute.Spirv[0];
 
-        m_pipelines.emplace(lightCullingDesc.Name, Pipeline(lightCullingDesc));
+        add_pipeline(lightCullingDesc);
     }
 
     nijiEngine.m_editor.add_debug_menu_panel("Light Culling Pass Panel",
@@ -238,31 +230,8 @@ void LightCullingPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
 
 void LightCullingPass::update_impl(Renderer& renderer, CommandList& cmd)
 {
-    on_window_resize();
-
-    const uint32_t& frameIndex = renderer.m_currentFrame;
-
-    {
-        DispatchParams ubo = {};
-
-        auto& cameraSystem = nijiEngine.ecs.find_system<CameraSystem>();
-        auto& camera = cameraSystem.m_camera;
-
-        ubo.InverseProjection = glm::inverse(camera.GetProjectionMatrix());
-        auto text = ubo.InverseProjection * camera.GetProjectionMatrix();
-        ubo.numThreadGroups = glm::u32vec3(m_totalThreadGroups, 1);
-        ubo.numThreads = glm::u32vec3(m_totalThreads, 1);
-        ubo.ScreenDimensions = {m_winWidth, m_winHeight};
-
-        vkCmdUpdateBuffer(cmd.m_commandBuffer, m_dispatchParams[frameIndex].Handle, 0,
-                          sizeof(DispatchParams), &ubo);
-    }
-
-    {
-        /*uint32_t zero = 0;
-        vkCmdUpdateBuffer(cmd.m_commandBuffer, m_lightIndexCounter[frameIndex].Handle, 0,
-                          sizeof(uint32_t), &zero);*/
-    }
+    // The params get uploaded by the passes themselves, on whichever queue they end up on
+    on_window_resize(renderer.m_renderScene->WindowWidth, renderer.m_renderScene->WindowHeight);
 }
 
 glm::vec3 plane_intersection(const glm::vec3& n1, float d1, const glm::vec3& n2, float d2,
@@ -362,6 +331,51 @@ void LightCullingPass::debug_panel()
     }
 }
 
+void LightCullingPass::add_to_graph(Renderer& renderer, RenderGraph& graph, RenderInfo& info)
+{
+    if (computeFrustums)
+    {
+        const uint32_t& frameIndex = renderer.m_currentFrame;
+
+        RenderGraphBuilder builder = graph.add_pass(
+            "Grid Frustums Pass",
+            [this, &renderer](CommandList& cmd) { record_frustums(renderer, cmd); });
+
+        RGResource frustums = builder.import_buffer("Tile Frustums", m_frustums[frameIndex]);
+        builder.overwrite(frustums, RGUsage::StorageWriteCompute);
+        builder.set_queue(RGQueue::AsyncCompute);
+    }
+
+    RenderPass::add_to_graph(renderer, graph, info);
+}
+
+void LightCullingPass::setup(Renderer& renderer, RenderGraphBuilder& builder, RenderInfo& info)
+{
+    const uint32_t& frameIndex = renderer.m_currentFrame;
+
+    builder.set_queue(RGQueue::AsyncCompute);
+
+    RGResource frustums = builder.import_buffer("Tile Frustums", m_frustums[frameIndex]);
+    builder.read(frustums, RGUsage::StorageReadCompute);
+
+    RGResource depth = builder.import_render_target("Depth Target", *info.DepthAttachment);
+    RGResource lightGrid = builder.import_texture("Light Grid", renderer.m_lightGridTexture);
+    RGResource lightIndexList =
+        builder.import_buffer("Light Index List", renderer.m_lightIndexList[frameIndex]);
+
+    m_lightIndexCounter = builder.create_buffer(
+        "Light Index Counter",
+        {sizeof(LightIndexCounter),
+         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT});
+
+    builder.read(depth, RGUsage::DepthSampledCompute);
+    builder.overwrite(lightGrid, RGUsage::StorageWriteCompute);
+    builder.write(lightIndexList, RGUsage::StorageWriteCompute);
+    // Cleared before the dispatch, then bumped atomically
+    builder.overwrite(m_lightIndexCounter, RGUsage::TransferWrite);
+    builder.write(m_lightIndexCounter, RGUsage::StorageWriteCompute);
+}
+
 void LightCullingPass::record(Renderer& renderer, CommandList& cmd, RenderInfo& info)
 {
     //// DEBUG ONLY
@@ -383,136 +397,18 @@ void LightCullingPass::record(Renderer& renderer, CommandList& cmd, RenderInfo&
 
     Swapchain& swapchain = renderer.m_swapchain;
     const uint32_t& frameIndex = renderer.m_currentFrame;
-    const Pipeline& frustumPipeline = m_pipelines.at("Grid Frustum Compute Pass");
     const Pipeline& cullingPipeline = m_pipelines.at("Light Culling Compute Pass");
 
     info.DepthAttachment->StoreOp = VK_ATTACHMENT_STORE_OP_NONE;
     info.DepthAttachment->LoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
 
-    {
-        TransitionInfo before = {VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-                                 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-                                 VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL};
-
-        TransitionInfo after = {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-                                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
-                                VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
-
-        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
-        if (nijiEngine.m_context.has_stencil_component(info.DepthAttachment->Format))
-            aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
-
-        cmd.transition_image_explicit(*info.DepthAttachment, before, after, aspect, 1, 1);
-    }
-
-    if (computeFrustums)
-    {
-        // computeFrustums = false;
-        //   Grid Frustums Computation
-        {
-            VkDebugUtilsLabelEXT labelInfo{VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
-            labelInfo.pLabelName = "Compute Grid Frustums";
-            labelInfo.color[0] = 0.2f;
-            labelInfo.color[1] = 0.6f;
-            labelInfo.color[2] = 0.9f;
-            labelInfo.color[3] = 1.0f;
-
-            VKCmdBeginDebugUtilsLabelEXT(cmd.m_commandBuffer, &labelInfo);
-
-            cmd.bind_pipeline(frustumPipeline.PipelineObject, true);
-
-            // Per Pass Bindings
-            {
-                m_passDescriptor.m_info.Bindings[0].Resource = &m_dispatchParams[frameIndex];
-
-                m_passDescriptor.m_info.Bindings[1].Resource = &m_frustums[frameIndex];
-
-                std::vector<VkWriteDescriptorSet> writes = {};
-                std::vector<VkDescriptorBufferInfo> bufferInfos = {};
-                std::vector<VkDescriptorImageInfo> imageInfos = {};
-
-                writes.reserve(m_passDescriptor.m_info.Bindings.size());
-                bufferInfos.reserve(m_passDescriptor.m_info.Bindings.size());
-                imageInfos.reserve(m_passDescriptor.m_info.Bindings.size());
-
-                m_passDescriptor.push_descriptor_writes(writes, bufferInfos, imageInfos);
-
-                cmd.push_descriptor_set(VK_PIPELINE_BIND_POINT_COMPUTE,
-                                        frustumPipeline.PipelineLayout, 1,
-                                        static_cast<uint32_t>(writes.size()), writes.data());
-            }
-
-            cmd.dispatch(m_totalThreadGroups.x, m_totalThreadGroups.y, 1);
-
-            VKCmdEndDebugUtilsLabelEXT(cmd.m_commandBuffer);
-
-            // cmd.end_rendering(info);
-        }
-
-        // Syncing (for Frustums Buffer)
-        {
-            VkBufferMemoryBarrier2 memBarrier = {};
-            memBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
-            memBarrier.srcStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-            memBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-            memBarrier.dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-            memBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-            memBarrier.buffer = renderer.m_lightIndexList[frameIndex].Handle;
-            memBarrier.size = renderer.m_lightIndexList[frameIndex].Desc.Size;
-
-            VkDependencyInfo depInfo = {};
-            depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
-            depInfo.bufferMemoryBarrierCount = 1;
-            depInfo.pBufferMemoryBarriers = &memBarrier;
-
-            VKCmdPipelineBarrier2KHR(cmd.m_commandBuffer, &depInfo);
-        }
-    }
+    Buffer& lightIndexCounter = renderer.m_renderGraph.get_buffer(m_lightIndexCounter);
 
     // Tiled Light Culling
     {
-        VkBufferMemoryBarrier bufferBarrier = {};
-        bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-        bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        bufferBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        bufferBarrier.buffer = m_dispatchParams[frameIndex].Handle;
-        bufferBarrier.offset = 0;
-        bufferBarrier.size = m_dispatchParams[frameIndex].Desc.Size;
-
-        vkCmdPipelineBarrier(cmd.m_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1, &bufferBarrier, 0,
-                             nullptr);
-
-        // Syncing (for Light Grid)
-        {
-            VkImageMemoryBarrier2 imgBarrier = {};
-            imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
-            imgBarrier.srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-            imgBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT,
-            imgBarrier.dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-            imgBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
-            imgBarrier.oldLayout = renderer.m_lightGridTexture.ImageInfo.imageLayout,
-            imgBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-            imgBarrier.image = renderer.m_lightGridTexture.TextureImage;
-            imgBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            imgBarrier.subresourceRange.baseMipLevel = 0;
-            imgBarrier.subresourceRange.levelCount = 1;
-            imgBarrier.subresourceRange.baseArrayLayer = 0;
-            imgBarrier.subresourceRange.layerCount = 1;
-
-            VkDependencyInfo depInfo = {};
-            depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
-            depInfo.imageMemoryBarrierCount = 1;
-            depInfo.pImageMemoryBarriers = &imgBarrier;
-
-            VKCmdPipelineBarrier2KHR(cmd.m_commandBuffer, &depInfo);
-            renderer.m_lightGridTexture.ImageInfo.imageLayout = imgBarrier.newLayout;
-        }
-
         {
-            nijiEngine.m_context.get_window_size(m_winWidth, m_winHeight);
+            m_winWidth = renderer.m_renderScene->WindowWidth;
+            m_winHeight = renderer.m_renderScene->WindowHeight;
 
             uint32_t totalThreadGroupsX = ceil((float)m_winWidth / GROUP_SIZE);
             uint32_t totalThreadGroupsY = ceil((float)m_winHeight / GROUP_SIZE);
@@ -525,8 +421,7 @@ void LightCullingPass::record(Renderer& renderer, CommandList& cmd, RenderInfo&
 
             DispatchParams ubo = {};
 
-            auto& cameraSystem = nijiEngine.ecs.find_system<CameraSystem>();
-            auto& camera = cameraSystem.m_camera;
+            const Camera& camera = renderer.m_renderScene->View;
 
             ubo.InverseProjection = glm::inverse(camera.GetProjectionMatrix());
             ubo.numThreadGroups = glm::u32vec3(m_totalThreadGroups, 1);
@@ -537,6 +432,28 @@ void LightCullingPass::record(Renderer& renderer, CommandList& cmd, RenderInfo&
                               sizeof(DispatchParams), &ubo);
         }
 
+        // Reset Light Index Counter
+        vkCmdFillBuffer(cmd.m_commandBuffer, lightIndexCounter.Handle, 0, VK_WHOLE_SIZE, 0);
+
+        // Syncing (Dispatch Params + Light Index Counter)
+        {
+            VkMemoryBarrier2 memBarrier = {};
+            memBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+            memBarrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+            memBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            memBarrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            memBarrier.dstAccessMask = VK_ACCESS_2_UNIFORM_READ_BIT |
+                                       VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                                       VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+
+            VkDependencyInfo depInfo = {};
+            depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+            depInfo.memoryBarrierCount = 1;
+            depInfo.pMemoryBarriers = &memBarrier;
+
+            VKCmdPipelineBarrier2KHR(cmd.m_commandBuffer, &depInfo);
+        }
+
         VkDebugUtilsLabelEXT labelInfo{VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
         labelInfo.pLabelName = "Tiled Light Culling Pass";
         labelInfo.color[0] = 0.2f;
@@ -561,7 +478,7 @@ void LightCullingPass::record(Renderer& renderer, CommandList& cmd, RenderInfo&
 
             m_lightCullingDescriptor.m_info.Bindings[1].Resource = &m_frustums[frameIndex];
 
-            m_lightCullingDescriptor.m_info.Bindings[2].Resource = &m_lightIndexCounter[frameIndex];
+            m_lightCullingDescriptor.m_info.Bindings[2].Resource = &lightIndexCounter;
 
             m_lightCullingDescriptor.m_info.Bindings[3].Resource =
                 &renderer.m_lightIndexList[frameIndex];
@@ -576,9 +493,9 @@ void LightCullingPass::record(Renderer& renderer, CommandList& cmd, RenderInfo&
             m_lightCullingDescriptor.m_info.Bindings[7].Resource =
                 &renderer.m_sceneInfoBuffer[frameIndex];
 
-            std::vector<VkWriteDescriptorSet> writes = {};
-            std::vector<VkDescriptorBufferInfo> bufferInfos = {};
-            std::vector<VkDescriptorImageInfo> imageInfos = {};
+            FrameVector<VkWriteDescriptorSet> writes = {};
+            FrameVector<VkDescriptorBufferInfo> bufferInfos = {};
+            FrameVector<VkDescriptorImageInfo> imageInfos = {};
 
             writes.reserve(m_lightCullingDescriptor.m_info.Bindings.size());
             bufferInfos.reserve(m_lightCullingDescriptor.m_info.Bindings.size());
@@ -594,53 +511,81 @@ void LightCullingPass::record(Renderer& renderer, CommandList& cmd, RenderInfo&
 
         VKCmdEndDebugUtilsLabelEXT(cmd.m_commandBuffer);
     }
+}
+
+void LightCullingPass::record_frustums(Renderer& renderer, CommandList& cmd)
+{
+    const uint32_t& frameIndex = renderer.m_currentFrame;
+    const Pipeline& frustumPipeline = m_pipelines.at("Grid Frustum Compute Pass");
+
+    // Culling switches the thread counts over to its own dispatch, so they get reset here
+    on_window_resize(renderer.m_renderScene->WindowWidth, renderer.m_renderScene->WindowHeight);
 
-    // Syncing (for Light Grid)
     {
-        VkImageMemoryBarrier2 imgBarrier = {};
-        imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
-        imgBarrier.srcStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-        imgBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
-        imgBarrier.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        imgBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
-        imgBarrier.oldLayout = renderer.m_lightGridTexture.ImageInfo.imageLayout,
-        imgBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-        imgBarrier.image = renderer.m_lightGridTexture.TextureImage;
-        imgBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imgBarrier.subresourceRange.baseMipLevel = 0;
-        imgBarrier.subresourceRange.levelCount = 1;
-        imgBarrier.subresourceRange.baseArrayLayer = 0;
-        imgBarrier.subresourceRange.layerCount = 1;
+        DispatchParams ubo = {};
 
-        VkDependencyInfo depInfo = {};
-        depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
-        depInfo.imageMemoryBarrierCount = 1;
-        depInfo.pImageMemoryBarriers = &imgBarrier;
+        const Camera& camera = renderer.m_renderScene->View;
+
+        ubo.InverseProjection = glm::inverse(camera.GetProjectionMatrix());
+        ubo.numThreadGroups = glm::u32vec3(m_totalThreadGroups, 1);
+        ubo.numThreads = glm::u32vec3(m_totalThreads, 1);
+        ubo.ScreenDimensions = {m_winWidth, m_winHeight};
 
-        vkCmdPipelineBarrier2(cmd.m_commandBuffer, &depInfo);
-        renderer.m_lightGridTexture.ImageInfo.imageLayout = imgBarrier.newLayout;
+        vkCmdUpdateBuffer(cmd.m_commandBuffer, m_frustumParams[frameIndex].Handle, 0,
+                          sizeof(DispatchParams), &ubo);
     }
 
-    // Syncing (for Light Index List)
+    // Syncing (Frustum Params)
     {
-        VkBufferMemoryBarrier2 bar = {};
-        bar.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
-        bar.srcStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-        bar.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-        bar.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-        bar.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        bar.buffer = renderer.m_lightIndexList[frameIndex].Handle;
-        bar.size = renderer.m_lightIndexList[frameIndex].Desc.Size;
+        VkMemoryBarrier2 memBarrier = {};
+        memBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+        memBarrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        memBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        memBarrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        memBarrier.dstAccessMask = VK_ACCESS_2_UNIFORM_READ_BIT;
 
         VkDependencyInfo depInfo = {};
         depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
-        depInfo.bufferMemoryBarrierCount = 1;
-        depInfo.pBufferMemoryBarriers = &bar;
+        depInfo.memoryBarrierCount = 1;
+        depInfo.pMemoryBarriers = &memBarrier;
+
+        VKCmdPipelineBarrier2KHR(cmd.m_commandBuffer, &depInfo);
+    }
+
+    VkDebugUtilsLabelEXT labelInfo{VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
+    labelInfo.pLabelName = "Compute Grid Frustums";
+    labelInfo.color[0] = 0.2f;
+    labelInfo.color[1] = 0.6f;
+    labelInfo.color[2] = 0.9f;
+    labelInfo.color[3] = 1.0f;
+
+    VKCmdBeginDebugUtilsLabelEXT(cmd.m_commandBuffer, &labelInfo);
+
+    cmd.bind_pipeline(frustumPipeline.PipelineObject, true);
+
+    // Per Pass Bindings
+    {
+        m_passDescriptor.m_info.Bindings[0].Resource = &m_frustumParams[frameIndex];
 
-        vkCmdPipelineBarrier2(cmd.m_commandBuffer, &depInfo);
+        m_passDescriptor.m_info.Bindings[1].Resource = &m_frustums[frameIndex];
 
-        // VKCmdPipelineBarrier2KHR(cmd.m_commandBuffer, &depInfo);
+        FrameVector<VkWriteDescriptorSet> writes = {};
+        FrameVector<VkDescriptorBufferInfo> bufferInfos = {};
+        FrameVector<VkDescriptorImageInfo> imageInfos = {};
+
+        writes.reserve(m_passDescriptor.m_info.Bindings.size());
+        bufferInfos.reserve(m_passDescriptor.m_info.Bindings.size());
+        imageInfos.reserve(m_passDescriptor.m_info.Bindings.size());
+
+        m_passDescriptor.push_descriptor_writes(writes, bufferInfos, imageInfos);
+
+        cmd.push_descriptor_set(VK_PIPELINE_BIND_POINT_COMPUTE, frustumPipeline.PipelineLayout,
+                                1, static_cast<uint32_t>(writes.size()), writes.data());
     }
+
+    cmd.dispatch(m_totalThreadGroups.x, m_totalThreadGroups.y, 1);
+
+    VKCmdEndDebugUtilsLabelEXT(cmd.m_commandBuffer);
 }
 
 void LightCullingPass::cleanup()
@@ -652,6 +597,7 @@ void LightCullingPass::cleanup()
     for (int i = 0; i < m_dispatchParams.size(); i++)
     {
         m_dispatchParams[i].cleanup();
+        m_frustumParams[i].cleanup();
     }
 
     for (int i = 0; i < m_frustums.size(); i++)
@@ -659,11 +605,6 @@ void LightCullingPass::cleanup()
         m_frustums[i].cleanup();
     }
 
-    for (int i = 0; i < m_lightIndexCounter.size(); i++)
-    {
-        m_lightIndexCounter[i].cleanup();
-    }
-
     /*for (int i = 0; i < m_lightIndexList.size(); i++)
     {
         m_lightIndexList[i].cleanup();
@@ -672,9 +613,10 @@ void LightCullingPass::cleanup()
     // m_lightGridTexture.cleanup();
 }
 
-void LightCullingPass::on_window_resize()
+void LightCullingPass::on_window_resize(int width, int height)
 {
-    nijiEngine.m_context.get_window_size(m_winWidth, m_winHeight);
+    m_winWidth = width;
+    m_winHeight = height;
 
     uint32_t totalThreadsX = ceil((float)m_winWidth / GROUP_SIZE);
     uint32_t totalThreadsY = ceil((float)m_winHeight / GROUP_SIZE);
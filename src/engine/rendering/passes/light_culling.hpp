@@ -49,21 +49,29 @@ class LightCullingPass final : public RenderPass
 
     void init(Swapchain& swapchain, Descriptor& globalDescriptor);
     void update_impl(Renderer& renderer, CommandList& cmd);
+    void setup(Renderer& renderer, RenderGraphBuilder& builder, RenderInfo& info);
+    // Grid frustums get their own graph pass, so they can overlap with the depth prepass on the
+    // async compute queue (culling itself has to wait for depth)
+    void add_to_graph(Renderer& renderer, RenderGraph& graph, RenderInfo& info) override;
     void record(Renderer& renderer, CommandList& cmd, RenderInfo& info);
     void cleanup();
 
     void debug_panel();
 
-    private:
-    void on_window_resize();
+  private:
+    void on_window_resize(int width, int height);
+    void record_frustums(Renderer& renderer, CommandList& cmd);
 
   private:
     Descriptor m_lightCullingDescriptor = {};
 
     std::vector<Buffer> m_dispatchParams = {};
+    // Grid frustums are computed per thread rather than per group, so they get their own params
+    std::vector<Buffer> m_frustumParams = {};
     std::vector<Buffer> m_frustums = {};
 
-    std::vector<Buffer> m_lightIndexCounter = {};
+    // Transient, reset at the start of every culling dispatch
+    RGResource m_lightIndexCounter = INVALID_RG_RESOURCE;
     //std::vector<Buffer> m_lightIndexList = {};
     //Texture m_lightGridTexture = {};
     Texture m_depthTexture = {};
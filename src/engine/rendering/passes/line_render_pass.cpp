@@ -1,5 +1,6 @@
 #include "line_render_pass.hpp"
 
+#include "rendering/render_scene.hpp"
 #include "rendering/renderer.hpp"
 #include "engine.hpp"
 
@@ -16,7 +17,7 @@ void LineRenderPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
         desc.Size = sizeof(DebugLine) * MAX_DEBUG_LINES;
         desc.Usage = BufferDesc::BufferUsage::Vertex;
         desc.Name = "Debug Lines Vertex Buffer";
-        m_vertexBuffer = Buffer(desc, nijiEngine.m_debugLines.data());
+        m_vertexBuffer = Buffer(desc, nullptr);
     }
 
     GraphicsPipelineDesc pipelineDesc = {globalDescriptor.m_setLayout,
@@ -54,21 +55,30 @@ void LineRenderPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
                              VertexElement(1, VK_FORMAT_R32G32B32_SFLOAT,
                                            offsetof(DebugLine, Color)));
 
-    m_pipelines.emplace(pipelineDesc.Name, Pipeline(pipelineDesc));
+    // Debug lines only, the first frames can go without them
+    add_pipeline(pipelineDesc, PipelinePriority::BACKGROUND);
 }
 
 void LineRenderPass::update_impl(Renderer& renderer, CommandList& cmd)
 {
-    if (nijiEngine.m_debugLines.size() > 0)
+    // The scene took over the lines added since the last extraction
+    const std::vector<DebugLine>& lines = renderer.m_renderScene->DebugLines;
+    if (lines.size() > 0)
     {
         /*vkCmdUpdateBuffer(cmd.m_commandBuffer, m_vertexBuffer.Handle, 0,
-                          sizeof(DebugLine) * nijiEngine.m_debugLines.size(),
-                          nijiEngine.m_debugLines.data());*/
-        memcpy(m_vertexBuffer.Data, nijiEngine.m_debugLines.data(),
-               sizeof(DebugLine) * nijiEngine.m_debugLines.size());
+                          sizeof(DebugLine) * lines.size(), lines.data());*/
+        memcpy(m_vertexBuffer.Data, lines.data(), sizeof(DebugLine) * lines.size());
     }
+}
+
+void LineRenderPass::setup(Renderer& renderer, RenderGraphBuilder& builder, RenderInfo& info)
+{
+    RGResource viewport = builder.import_render_target("Viewport Target", *info.ViewportTarget);
+    RGResource depth = builder.import_render_target("Depth Target", *info.DepthAttachment);
 
-    nijiEngine.m_debugLines.clear();
+    builder.write(viewport, RGUsage::ColorAttachment);
+    // Depth store is DONT_CARE, which counts as a write
+    builder.write(depth, RGUsage::DepthAttachment);
 }
 
 void LineRenderPass::record(Renderer& renderer, CommandList& cmd, RenderInfo& info)
@@ -100,7 +110,7 @@ void LineRenderPass::record(Renderer& renderer, CommandList& cmd, RenderInfo& in
                                  &renderer.m_globalDescriptor.m_set[renderer.m_currentFrame]);
     }
 
-    cmd.draw(nijiEngine.m_debugLines.size(), 1, 0, 0);
+    cmd.draw(renderer.m_renderScene->DebugLines.size(), 1, 0, 0);
 
     cmd.end_rendering(info);
 }
@@ -14,6 +14,7 @@ class LineRenderPass final : public RenderPass
 
     void init(Swapchain& swapchain, Descriptor& globalDescriptor);
     void update_impl(Renderer& renderer, CommandList& cmd);
+    void setup(Renderer& renderer, RenderGraphBuilder& builder, RenderInfo& info);
     void record(Renderer& renderer, CommandList& cmd, RenderInfo& info);
     void cleanup();
 
@@ -2,64 +2,171 @@
 
 using namespace niji;
 
-#include <iostream>
+#include <chrono>
+#include <cstdio>
 
 #include "rendering/renderer.hpp"
 #include "../../engine.hpp"
 
+void RenderPass::queue_pipelines(PipelineCompiler& compiler)
+{
+    for (PipelineJob& job : m_pipelineJobs)
+        compiler.add(std::move(job));
+    m_pipelineJobs.clear();
+}
+
+void RenderPass::add_pipeline(const GraphicsPipelineDesc& desc, PipelinePriority priority)
+{
+    PipelineJob job = {};
+    job.Target = &m_pipelines[desc.Name];
+    job.GraphicsDesc = desc;
+    job.Priority = priority;
+    job.PassPending = &m_pendingPipelines;
+    m_pipelineJobs.push_back(std::move(job));
+}
+
+void RenderPass::add_pipeline(const ComputePipelineDesc& desc, PipelinePriority priority)
+{
+    PipelineJob job = {};
+    job.Target = &m_pipelines[desc.Name];
+    job.IsGraphicsPipeline = false;
+    job.ComputeDesc = desc;
+    job.Priority = priority;
+    job.PassPending = &m_pendingPipelines;
+    m_pipelineJobs.push_back(std::move(job));
+}
+
+Pipeline& RenderPass::add_variant(const std::string& name, const std::string& variant,
+                                  const std::vector<uint32_t>& fragmentConstants)
+{
+    auto existing = m_pipelines.find(variant);
+    if (existing != m_pipelines.end())
+        return existing->second;
+
+    GraphicsPipelineDesc desc = m_pipelines.at(name).GraphicsDesc;
+    desc.FragmentConstants = fragmentConstants;
+
+    Pipeline& pipeline = m_pipelines[variant];
+    pipeline = Pipeline(desc);
+    return pipeline;
+}
+
 void RenderPass::update(Renderer& renderer, CommandList& cmd)
 {
-    if (m_vertFrag.Type != ShaderType::NONE && m_shaderWatcher.hasChanged(m_vertFrag.Source))
+    for (const std::string& source : renderer.m_changedShaders)
     {
-        if (!m_vertFrag.re_compile())
-        {
-            return;
-            //throw std::runtime_error("Failed To Recompile Shader");
-        }
-        vkDeviceWaitIdle(renderer.m_context->m_device);
+        if (m_vertFrag.Type != ShaderType::NONE && source == m_vertFrag.Source)
+            m_vertFragDirty = true;
+        if (m_compute.Type != ShaderType::NONE && source == m_compute.Source)
+            m_computeDirty = true;
+    }
 
-        for (auto& [name, pipeline] : m_pipelines)
-        {
-            if (!pipeline.IsGraphicsPipeline)
-                continue;
+    // A save during a reload waits for that one to finish, the compile then picks up the latest
+    if (m_vertFragDirty && !m_vertFragReload.Active)
+    {
+        m_vertFragDirty = false;
+        start_reload(renderer, m_vertFrag, m_vertFragReload);
+    }
+    if (m_computeDirty && !m_computeReload.Active)
+    {
+        m_computeDirty = false;
+        start_reload(renderer, m_compute, m_computeReload);
+    }
 
-            GraphicsPipelineDesc desc = pipeline.GraphicsDesc;
-            pipeline.cleanup();
+    finish_reload(renderer, m_vertFragReload);
+    finish_reload(renderer, m_computeReload);
+
+    update_impl(renderer, cmd);
+}
 
-            pipeline = Pipeline(desc);
+void RenderPass::start_reload(Renderer& renderer, const Shader& shader, ShaderReload& reload)
+{
+    const bool graphics = shader.Type == ShaderType::FRAG_AND_VERT;
 
-            std::cout << "[HotReload] Reloaded Pipeline:" << name << " From " << m_name << "\n";
-        }
+    // Copies, the pass keeps using its pipelines while the new ones get built
+    std::vector<std::pair<std::string, Pipeline>> descs = {};
+    for (auto& [name, pipeline] : m_pipelines)
+    {
+        if (pipeline.IsGraphicsPipeline == graphics)
+            descs.emplace_back(name, pipeline);
     }
 
-    if (m_compute.Type != ShaderType::NONE && m_shaderWatcher.hasChanged(m_compute.Source))
-    {
-        if (!m_compute.re_compile())
+    reload.Active = true;
+    reload.Pipelines.clear();
+    reload.Result = renderer.m_shaderCompiler.compile(shader, [&reload, descs]() {
+        for (const auto& [name, old] : descs)
         {
-            return;
-            //throw std::runtime_error("Failed To Recompile Shader");
+            Pipeline pipeline = old.IsGraphicsPipeline ? Pipeline(old.GraphicsDesc)
+                                                       : Pipeline(old.ComputeDesc);
+            reload.Pipelines.emplace_back(name, pipeline);
         }
+    });
+}
 
-        vkDeviceWaitIdle(renderer.m_context->m_device);
-        for (auto& [name, pipeline] : m_pipelines)
-        {
-            if (pipeline.IsGraphicsPipeline)
-                continue;
+void RenderPass::finish_reload(Renderer& renderer, ShaderReload& reload)
+{
+    if (!reload.Active ||
+        reload.Result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    const ShaderCompileResult result = reload.Result.get();
+    reload.Active = false;
 
-            ComputePipelineDesc desc = pipeline.ComputeDesc;
+    if (!result.Success)
+    {
+        // Pipelines built before one failed never got used
+        for (auto& [name, pipeline] : reload.Pipelines)
             pipeline.cleanup();
+        reload.Pipelines.clear();
 
-            pipeline = Pipeline(desc);
+        nijiEngine.m_logger.log_error("[HotReload] " + m_name + " failed:\n" +
+                                      result.Diagnostics);
+        return;
+    }
 
-            std::cout << "[HotReload] Reloaded Pipeline:" << name << " From " << m_name << "\n";
-        }
+    if (!result.Diagnostics.empty())
+        nijiEngine.m_logger.log_warning("[HotReload] " + m_name + ":\n" + result.Diagnostics);
+
+    // Frame boundary, nothing recorded this frame references the old pipelines yet
+    for (auto& [name, pipeline] : reload.Pipelines)
+    {
+        renderer.retire_pipeline(m_pipelines[name]);
+        m_pipelines[name] = pipeline;
+
+        nijiEngine.m_logger.log_info("[HotReload] Reloaded Pipeline: " + name + " From " +
+                                     m_name);
     }
+    reload.Pipelines.clear();
 
-    update_impl(renderer, cmd);
+    char timing[96] = {};
+    snprintf(timing, sizeof(timing), "[HotReload] %u/%u entry points from cache, %.1f ms",
+             result.CacheHits, result.EntryPoints, result.CompileMs);
+    nijiEngine.m_logger.log_info(timing);
+}
+
+void RenderPass::add_to_graph(Renderer& renderer, RenderGraph& graph, RenderInfo& info)
+{
+    RenderGraphBuilder builder = graph.add_pass(
+        m_name.c_str(),
+        [this, &renderer, &info](CommandList& cmd) { record(renderer, cmd, info); });
+    setup(renderer, builder, info);
 }
 
 void RenderPass::base_cleanup()
 {
+    // The compiler thread is done by now, a reload that never got swapped in still owns pipelines
+    for (ShaderReload* reload : {&m_vertFragReload, &m_computeReload})
+    {
+        if (!reload->Active)
+            continue;
+
+        reload->Result.wait();
+        for (auto& [name, pipeline] : reload->Pipelines)
+            pipeline.cleanup();
+        reload->Pipelines.clear();
+        reload->Active = false;
+    }
+
     for (auto& [name, pipeline] : m_pipelines)
     {
         pipeline.cleanup();
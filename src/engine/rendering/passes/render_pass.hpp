@@ -9,7 +9,10 @@
 #include "../../core/commandlist.hpp"
 #include "../../core/descriptor.hpp"
 #include "../../core/common.hpp"
+#include "../../core/shader_compiler.hpp"
 
+#include "../pipeline_compiler.hpp"
+#include "../render_graph.hpp"
 #include "../swapchain.hpp"
 
 namespace fs = std::filesystem;
@@ -17,43 +20,53 @@ namespace fs = std::filesystem;
 namespace niji
 {
 
-class ShaderWatcher
-{
-  public:
-    // Start tracking a file (store initial write time)
-    void trackFile(const std::string& path)
-    {
-        timestamps[path] = fs::last_write_time(path);
-    }
-
-    // Check if a tracked file has changed since last check
-    bool hasChanged(const std::string& path)
-    {
-        auto currentWriteTime = fs::last_write_time(path);
-        if (timestamps.find(path) != timestamps.end() && timestamps[path] != currentWriteTime)
-        {
-            timestamps[path] = currentWriteTime;
-            return true;
-        }
-        return false;
-    }
-
-  private:
-    std::unordered_map<std::string, fs::file_time_type> timestamps;
-};
+struct RenderScene;
 
 class RenderPass
 {
   public:
     virtual void init(Swapchain& swapchain, Descriptor& globalDescriptor) = 0;
     void update(Renderer& renderer, CommandList& cmd);
+    // Main thread, while the render thread is idle. Builds the pass' ImGui windows for the frame
+    // recorded from `scene`.
+    virtual void update_ui(Renderer& renderer, RenderScene& scene)
+    {
+    }
+    // Declares the resources the pass reads and writes this frame, the render graph derives the
+    // barriers (and whether the pass runs at all) from it. Host written buffers can be left out.
+    virtual void setup(Renderer& renderer, RenderGraphBuilder& builder, RenderInfo& info) = 0;
+    // Adds the pass to this frame's graph, passes that split their work into several graph
+    // passes (to run part of it on another queue) override it
+    virtual void add_to_graph(Renderer& renderer, RenderGraph& graph, RenderInfo& info);
     virtual void record(Renderer& renderer, CommandList& cmd, RenderInfo& info) = 0;
     virtual void cleanup() = 0;
 
+    // Hands the pipelines described during init to the compiler
+    void queue_pipelines(PipelineCompiler& compiler);
+    // False while one of the pass' pipelines is still being built, such a pass sits frames out
+    bool pipelines_ready() const
+    {
+        return m_pendingPipelines.load(std::memory_order_acquire) == 0;
+    }
+
   protected:
+    // A hot reload in flight: the shader compiles and the new pipelines get built on the
+    // compiler thread while the old ones keep rendering
+    struct ShaderReload
+    {
+        bool Active = false;
+        std::future<ShaderCompileResult> Result = {};
+        // Written by the compiler thread, only read once Result is ready
+        std::vector<std::pair<std::string, Pipeline>> Pipelines = {};
+    };
+
     virtual void update_impl(Renderer& renderer, CommandList& cmd) = 0;
     void base_cleanup();
 
+    void start_reload(Renderer& renderer, const Shader& shader, ShaderReload& reload);
+    // Swaps the new pipelines in once they're built, the old ones get retired
+    void finish_reload(Renderer& renderer, ShaderReload& reload);
+
     void add_shader(const std::string& path, ShaderType shaderType)
     {
         if (shaderType == ShaderType::NONE)
@@ -62,10 +75,20 @@ class RenderPass
             m_vertFrag = Shader(path, shaderType);
         else if (shaderType == ShaderType::COMPUTE)
             m_compute = Shader(path, shaderType);
-
-        m_shaderWatcher.trackFile(path);
     }
 
+    // Describes a pipeline, it gets built together with the other passes' ones after init.
+    // m_pipelines holds an empty entry under the desc's name until then.
+    void add_pipeline(const GraphicsPipelineDesc& desc,
+                      PipelinePriority priority = PipelinePriority::FIRST_FRAME);
+    void add_pipeline(const ComputePipelineDesc& desc,
+                      PipelinePriority priority = PipelinePriority::FIRST_FRAME);
+    // Builds a copy of the graphics pipeline `name` with other fragment specialization constants
+    // right away, it's kept under `variant` in m_pipelines so hot reloads rebuild it too. Only
+    // once the pass' pipelines are ready, before recording.
+    Pipeline& add_variant(const std::string& name, const std::string& variant,
+                          const std::vector<uint32_t>& fragmentConstants);
+
   protected:
     friend class Renderer;
     friend class Editor;
@@ -76,8 +99,15 @@ class RenderPass
 
     Descriptor m_passDescriptor = {};
 
-    ShaderWatcher m_shaderWatcher = {};
     Shader m_vertFrag = {};
     Shader m_compute = {};
+    ShaderReload m_vertFragReload = {};
+    ShaderReload m_computeReload = {};
+    // Set by the renderer's shader watcher, kept until a reload of that shader can start
+    bool m_vertFragDirty = false;
+    bool m_computeDirty = false;
+
+    std::vector<PipelineJob> m_pipelineJobs = {};
+    std::atomic<uint32_t> m_pendingPipelines{0};
 };
 } // namespace niji
@@ -80,13 +80,23 @@ void SkyboxPass::init(Swapchain& swapchain, Descriptor& globalDescriptor)
         DEFINE_VERTEX_LAYOUT(SkyboxVertex, VertexElement(0, VK_FORMAT_R32G32B32_SFLOAT,
                                                          offsetof(SkyboxVertex, Pos)));
 
-    m_pipelines.emplace(pipelineDesc.Name, Pipeline(pipelineDesc));
+    add_pipeline(pipelineDesc);
 }
 
 void SkyboxPass::update_impl(Renderer& renderer, CommandList& cmd)
 {
 }
 
+void SkyboxPass::setup(Renderer& renderer, RenderGraphBuilder& builder, RenderInfo& info)
+{
+    // First pass to touch the viewport and depth, both get cleared
+    RGResource viewport = builder.import_render_target("Viewport Target", *info.ViewportTarget);
+    RGResource depth = builder.import_render_target("Depth Target", *info.DepthAttachment);
+
+    builder.overwrite(viewport, RGUsage::ColorAttachment);
+    builder.overwrite(depth, RGUsage::DepthAttachment);
+}
+
 void SkyboxPass::record(Renderer& renderer, CommandList& cmd, RenderInfo& info)
 {
     Swapchain& swapchain = renderer.m_swapchain;
@@ -100,38 +110,6 @@ void SkyboxPass::record(Renderer& renderer, CommandList& cmd, RenderInfo& info)
     info.DepthAttachment->StoreOp = VK_ATTACHMENT_STORE_OP_NONE;
     info.DepthAttachment->LoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 
-    {
-        auto usage_before = (info.DepthAttachment->CurrentLayout == VK_IMAGE_LAYOUT_UNDEFINED)
-                                ? TransitionType::Undefined
-                                : TransitionType::DepthStencilAttachmentWrite;
-        auto usage_after = TransitionType::DepthStencilAttachmentWrite;
-
-        TransitionInfo before = usage_to_barrier(usage_before, info.DepthAttachment->Format);
-        TransitionInfo after = usage_to_barrier(usage_after, info.DepthAttachment->Format);
-
-        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
-        if (nijiEngine.m_context.has_stencil_component(info.DepthAttachment->Format))
-            aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
-
-        cmd.transition_image_explicit(*info.DepthAttachment, before, after, aspect, 1, 1);
-    }
-
-    {
-        TransitionInfo before;
-        if (info.ViewportTarget->CurrentLayout == VK_IMAGE_LAYOUT_UNDEFINED)
-            before = {VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED};
-        else if (info.ViewportTarget->CurrentLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
-            before = {VK_PIPELINE_STAGE_NONE, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
-
-        TransitionInfo after = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-                                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
-
-        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
-
-        cmd.transition_image_explicit(*info.ViewportTarget, before, after, aspect, 1, 1);
-    }
-
     cmd.begin_rendering(info, m_name);
 
     cmd.bind_pipeline(pipeline.PipelineObject);
@@ -158,9 +136,9 @@ void SkyboxPass::record(Renderer& renderer, CommandList& cmd, RenderInfo& info)
         m_passDescriptor.m_info.Bindings[0].Resource = &renderer.m_envmap->m_specularCubemap;
         m_passDescriptor.m_info.Bindings[1].Resource = &m_sampler;
 
-        std::vector<VkWriteDescriptorSet> writes = {};
-        std::vector<VkDescriptorBufferInfo> bufferInfos = {};
-        std::vector<VkDescriptorImageInfo> imageInfos = {};
+        FrameVector<VkWriteDescriptorSet> writes = {};
+        FrameVector<VkDescriptorBufferInfo> bufferInfos = {};
+        FrameVector<VkDescriptorImageInfo> imageInfos = {};
 
         writes.reserve(m_passDescriptor.m_info.Bindings.size());
         bufferInfos.reserve(m_passDescriptor.m_info.Bindings.size());
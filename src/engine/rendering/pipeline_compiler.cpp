@@ -0,0 +1,146 @@
+#include "pipeline_compiler.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <initializer_list>
+#include <string>
+
+#include "engine.hpp"
+
+using namespace niji;
+
+static float elapsed_ms(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() -
+                                                    start)
+        .count();
+}
+
+void PipelineCompiler::add(PipelineJob&& job)
+{
+    if (m_started)
+        throw std::runtime_error("Pipelines can only be queued before the compiler starts!");
+
+    job.PassPending->fetch_add(1);
+    m_jobs.push_back(std::move(job));
+}
+
+void PipelineCompiler::start()
+{
+    std::stable_sort(m_jobs.begin(), m_jobs.end(), [](const PipelineJob& a, const PipelineJob& b) {
+        return a.Priority == PipelinePriority::FIRST_FRAME &&
+               b.Priority == PipelinePriority::BACKGROUND;
+    });
+
+    JobSystem& jobs = nijiEngine.m_jobSystem;
+
+    m_stats = {};
+    m_stats.Pipelines = static_cast<uint32_t>(m_jobs.size());
+    m_stats.FirstFramePipelines = static_cast<uint32_t>(
+        std::count_if(m_jobs.begin(), m_jobs.end(), [](const PipelineJob& job) {
+            return job.Priority == PipelinePriority::FIRST_FRAME;
+        }));
+    m_stats.Threads = std::min(jobs.get_thread_count(), m_stats.Pipelines);
+
+    m_pending = m_stats.Pipelines;
+    m_pendingFirstFrame = m_stats.FirstFramePipelines;
+    m_start = std::chrono::high_resolution_clock::now();
+
+    if (m_jobs.empty())
+        return;
+    m_started = true;
+
+    // Sorted, so every FIRST_FRAME job is counted before the first BACKGROUND one waits on them
+    for (uint32_t index = 0; index < m_jobs.size(); index++)
+    {
+        if (m_jobs[index].Priority == PipelinePriority::FIRST_FRAME)
+            jobs.run([this, index]() { build(index); }, &m_firstFrame);
+        else
+            jobs.run_after(m_firstFrame, [this, index]() { build(index); }, &m_background);
+    }
+}
+
+void PipelineCompiler::wait_first_frame()
+{
+    if (!m_started)
+        return;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    nijiEngine.m_jobSystem.wait(m_firstFrame);
+    m_stats.MainThreadWaitMs += elapsed_ms(start);
+}
+
+void PipelineCompiler::wait_all()
+{
+    finish();
+}
+
+void PipelineCompiler::poll()
+{
+    if (m_started && m_firstFrame.is_done() && m_background.is_done())
+        finish();
+}
+
+void PipelineCompiler::build(uint32_t index)
+{
+    PipelineJob& job = m_jobs[index];
+    NIJI_PROFILE_SCOPE("Build Pipeline");
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::exception_ptr error = nullptr;
+    try
+    {
+        *job.Target =
+            job.IsGraphicsPipeline ? Pipeline(job.GraphicsDesc) : Pipeline(job.ComputeDesc);
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    m_pipelineTotalNs += static_cast<uint64_t>(elapsed_ms(start) * 1e6f);
+
+    // A failed build still counts as done, the exception ends up in the job's counter. The
+    // release pairs with the acquire in RenderPass::pipelines_ready
+    job.PassPending->fetch_sub(1, std::memory_order_release);
+    if (job.Priority == PipelinePriority::FIRST_FRAME && m_pendingFirstFrame.fetch_sub(1) == 1)
+        m_stats.FirstFrameMs = elapsed_ms(m_start);
+    if (m_pending.fetch_sub(1) == 1)
+        m_stats.AllMs = elapsed_ms(m_start);
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void PipelineCompiler::finish()
+{
+    // Both counters have to drain before the jobs can go, even when the first one failed
+    std::exception_ptr error = nullptr;
+    for (JobCounter* counter : {&m_firstFrame, &m_background})
+    {
+        try
+        {
+            nijiEngine.m_jobSystem.wait(*counter);
+        }
+        catch (...)
+        {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+
+    const bool wasRunning = m_started;
+    m_started = false;
+    m_jobs.clear();
+
+    if (error)
+        std::rethrow_exception(error);
+
+    if (wasRunning)
+    {
+        m_stats.PipelineTotalMs = static_cast<float>(m_pipelineTotalNs.load()) / 1e6f;
+        printf("[PipelineCompiler]: %u pipelines on %u job threads, first frame set after %.1f ms "
+               "(main thread waited %.1f ms), all after %.1f ms, %.1f ms of pipeline work \n",
+               m_stats.Pipelines, m_stats.Threads, m_stats.FirstFrameMs, m_stats.MainThreadWaitMs,
+               m_stats.AllMs, m_stats.PipelineTotalMs);
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "core/common.hpp"
+#include "core/job_system.hpp"
+
+namespace niji
+{
+
+enum class PipelinePriority
+{
+    // The first frame waits for it
+    FIRST_FRAME,
+    // The owning pass stays out of the frame until it's built
+    BACKGROUND
+};
+
+// A pipeline described during a pass' init, built later by the PipelineCompiler
+struct PipelineJob
+{
+    Pipeline* Target = nullptr;
+    bool IsGraphicsPipeline = true;
+    GraphicsPipelineDesc GraphicsDesc = {};
+    ComputePipelineDesc ComputeDesc = {};
+    PipelinePriority Priority = PipelinePriority::FIRST_FRAME;
+    // The owning pass' count of pipelines still being built
+    std::atomic<uint32_t>* PassPending = nullptr;
+};
+
+struct PipelineCompileStats
+{
+    uint32_t Pipelines = 0;
+    uint32_t FirstFramePipelines = 0;
+    uint32_t Threads = 0;
+    // Wall clock since start(), and the summed time of the individual pipelines
+    float FirstFrameMs = 0.0f;
+    float AllMs = 0.0f;
+    float PipelineTotalMs = 0.0f;
+    // Time the main thread spent blocked in wait_first_frame()
+    float MainThreadWaitMs = 0.0f;
+};
+
+// Builds the pipelines every pass described during init concurrently, one job per pipeline on the
+// engine's job system (vkCreate*Pipelines is thread safe and they all share the context's
+// pipeline cache). Startup keeps going meanwhile, only the first frame waits for the FIRST_FRAME
+// pipelines.
+class PipelineCompiler
+{
+  public:
+    void add(PipelineJob&& job);
+    // Queues the jobs, BACKGROUND ones only start once every FIRST_FRAME one is built
+    void start();
+
+    // Rethrows the first pipeline that failed to build, helps running jobs meanwhile
+    void wait_first_frame();
+    void wait_all();
+    // Wraps up once everything is built, once per frame
+    void poll();
+
+    const PipelineCompileStats& get_stats() const
+    {
+        return m_stats;
+    }
+
+  private:
+    void build(uint32_t index);
+    void finish();
+
+  private:
+    std::vector<PipelineJob> m_jobs = {};
+    bool m_started = false;
+
+    // Count the jobs of either priority, and hold their first exception
+    JobCounter m_firstFrame = {};
+    JobCounter m_background = {};
+    // Only for the timings, whoever builds the last one of either notes the time
+    std::atomic<uint32_t> m_pendingFirstFrame{0};
+    std::atomic<uint32_t> m_pending{0};
+
+    std::chrono::high_resolution_clock::time_point m_start = {};
+    std::atomic<uint64_t> m_pipelineTotalNs{0};
+    PipelineCompileStats m_stats = {};
+};
+
+} // namespace niji
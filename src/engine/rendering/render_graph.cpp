@@ -0,0 +1,1570 @@
+#include "render_graph.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+#include <imgui.h>
+
+#include <vk_mem_alloc.h>
+
+#include "core/frame_arena.hpp"
+#include "core/vulkan-functions.hpp"
+
+#include "gpu_profiler.hpp"
+
+#include "engine.hpp"
+
+using namespace niji;
+
+constexpr VkAccessFlags2 WRITE_ACCESS_MASK =
+    VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_SHADER_WRITE_BIT |
+    VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+struct UsageInfo
+{
+    VkPipelineStageFlags2 Stage = VK_PIPELINE_STAGE_2_NONE;
+    VkAccessFlags2 Access = VK_ACCESS_2_NONE;
+    VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+};
+
+static UsageInfo get_usage_info(RGUsage usage)
+{
+    constexpr VkPipelineStageFlags2 fragmentTests =
+        VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+
+    switch (usage)
+    {
+    case RGUsage::ColorAttachment:
+        return {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    case RGUsage::ColorAttachmentRead:
+        return {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    case RGUsage::DepthAttachment:
+        return {fragmentTests,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                    VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL};
+    case RGUsage::DepthAttachmentRead:
+        return {fragmentTests, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
+    case RGUsage::DepthSampledCompute:
+        return {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
+    case RGUsage::SampledFragment:
+        return {VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    case RGUsage::StorageReadCompute:
+        return {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+                VK_IMAGE_LAYOUT_GENERAL};
+    case RGUsage::StorageWriteCompute:
+        return {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_IMAGE_LAYOUT_GENERAL};
+    case RGUsage::StorageReadGraphics:
+        return {VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                VK_IMAGE_LAYOUT_GENERAL};
+    case RGUsage::IndirectRead:
+        return {VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED};
+    case RGUsage::TransferWrite:
+        return {VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL};
+    case RGUsage::TransferRead:
+        return {VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL};
+    case RGUsage::Present:
+        return {VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
+    default:
+        throw std::runtime_error("Invalid Render Graph Usage!");
+    }
+}
+
+const char* niji::rg_usage_to_string(RGUsage usage)
+{
+    switch (usage)
+    {
+    case RGUsage::ColorAttachment:
+        return "ColorAttachment";
+    case RGUsage::ColorAttachmentRead:
+        return "ColorAttachmentRead";
+    case RGUsage::DepthAttachment:
+        return "DepthAttachment";
+    case RGUsage::DepthAttachmentRead:
+        return "DepthAttachmentRead";
+    case RGUsage::DepthSampledCompute:
+        return "DepthSampledCompute";
+    case RGUsage::SampledFragment:
+        return "SampledFragment";
+    case RGUsage::StorageReadCompute:
+        return "StorageReadCompute";
+    case RGUsage::StorageWriteCompute:
+        return "StorageWriteCompute";
+    case RGUsage::StorageReadGraphics:
+        return "StorageReadGraphics";
+    case RGUsage::IndirectRead:
+        return "IndirectRead";
+    case RGUsage::TransferWrite:
+        return "TransferWrite";
+    case RGUsage::TransferRead:
+        return "TransferRead";
+    case RGUsage::Present:
+        return "Present";
+    default:
+        return "Unknown";
+    }
+}
+
+static const char* layout_to_string(VkImageLayout layout)
+{
+    switch (layout)
+    {
+    case VK_IMAGE_LAYOUT_UNDEFINED:
+        return "UNDEFINED";
+    case VK_IMAGE_LAYOUT_GENERAL:
+        return "GENERAL";
+    case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+        return "COLOR_ATTACHMENT";
+    case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL:
+        return "DEPTH_ATTACHMENT";
+    case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+        return "DEPTH_STENCIL_READ_ONLY";
+    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+        return "SHADER_READ_ONLY";
+    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+        return "TRANSFER_DST";
+    case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+        return "PRESENT_SRC";
+    default:
+        return "OTHER";
+    }
+}
+
+static VkImageAspectFlags get_aspect(VkFormat format)
+{
+    switch (format)
+    {
+    case VK_FORMAT_D16_UNORM:
+    case VK_FORMAT_X8_D24_UNORM_PACK32:
+    case VK_FORMAT_D32_SFLOAT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT;
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    default:
+        return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static uint32_t queue_index(RGQueue queue)
+{
+    return static_cast<uint32_t>(queue);
+}
+
+static uint8_t queue_bit(RGQueue queue)
+{
+    return static_cast<uint8_t>(1u << queue_index(queue));
+}
+
+static void set_sharing_mode(uint8_t queueMask, VkSharingMode& sharingMode,
+                             uint32_t& queueFamilyIndexCount, const uint32_t*& queueFamilyIndices,
+                             const uint32_t (&families)[2])
+{
+    // Only resources both queues touch pay for concurrent sharing
+    if (queueMask == (queue_bit(RGQueue::Graphics) | queue_bit(RGQueue::AsyncCompute)))
+    {
+        sharingMode = VK_SHARING_MODE_CONCURRENT;
+        queueFamilyIndexCount = 2;
+        queueFamilyIndices = families;
+    }
+    else
+        sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+}
+
+RGResource RenderGraphBuilder::import_render_target(const char* name, RenderTarget& target)
+{
+    return m_graph.import_render_target(name, target);
+}
+
+RGResource RenderGraphBuilder::import_texture(const char* name, Texture& texture)
+{
+    return m_graph.import_texture(name, texture);
+}
+
+RGResource RenderGraphBuilder::import_buffer(const char* name, Buffer& buffer)
+{
+    return m_graph.import_buffer(name, buffer);
+}
+
+RGResource RenderGraphBuilder::create_buffer(const char* name, const RGBufferDesc& desc)
+{
+    return m_graph.create_buffer(name, desc);
+}
+
+RGResource RenderGraphBuilder::create_render_target(const char* name, const RGImageDesc& desc)
+{
+    return m_graph.create_render_target(name, desc);
+}
+
+RGResource RenderGraphBuilder::get_resource(const char* name) const
+{
+    RGResource resource = m_graph.find_resource(name);
+    if (resource == INVALID_RG_RESOURCE)
+        throw std::runtime_error(std::string("Render Graph Resource '") + name +
+                                 "' does not exist (yet)!");
+    return resource;
+}
+
+void RenderGraphBuilder::read(RGResource resource, RGUsage usage)
+{
+    m_graph.add_access(m_pass, resource, usage, false, false);
+}
+
+void RenderGraphBuilder::write(RGResource resource, RGUsage usage)
+{
+    m_graph.add_access(m_pass, resource, usage, true, false);
+}
+
+void RenderGraphBuilder::overwrite(RGResource resource, RGUsage usage)
+{
+    m_graph.add_access(m_pass, resource, usage, true, true);
+}
+
+void RenderGraphBuilder::set_side_effects()
+{
+    m_graph.m_passes[m_pass].HasSideEffects = true;
+}
+
+void RenderGraphBuilder::set_queue(RGQueue queue)
+{
+    m_graph.m_passes[m_pass].RequestedQueue = queue;
+}
+
+void RenderGraph::begin_frame(uint32_t frameIndex)
+{
+    m_frameIndex = frameIndex;
+    m_compiled = false;
+
+    // Only the sizes get dropped, the capacity stays around for the next frame
+    m_passes.clear();
+    m_resources.clear();
+    m_accesses.clear();
+    m_barriers.clear();
+    m_finalBarriers.clear();
+    m_batches.clear();
+    m_batchPasses.clear();
+}
+
+RenderGraphBuilder RenderGraph::add_pass(const char* name, const ExecuteFunction& execute)
+{
+    PassNode pass = {};
+    pass.Name = name;
+    pass.Execute = execute;
+    pass.FirstAccess = static_cast<uint32_t>(m_accesses.size());
+    m_passes.push_back(pass);
+
+    return RenderGraphBuilder(*this, static_cast<uint32_t>(m_passes.size() - 1));
+}
+
+void RenderGraph::set_output(RGResource resource, RGUsage usage)
+{
+    if (resource >= m_resources.size())
+        throw std::runtime_error("Invalid Render Graph Output!");
+
+    m_resources[resource].IsOutput = true;
+    m_resources[resource].OutputUsage = usage;
+}
+
+RGResource RenderGraph::import_render_target(const char* name, RenderTarget& target)
+{
+    RGResource existing = find_resource(name);
+    if (existing != INVALID_RG_RESOURCE)
+    {
+        if (m_resources[existing].Source != &target)
+            throw std::runtime_error(std::string("Render Graph Resource '") + name +
+                                     "' was imported with two different Render Targets!");
+        return existing;
+    }
+
+    ResourceNode node = {};
+    node.Name = name;
+    node.Type = ResourceType::IMAGE;
+    node.Source = &target;
+    node.Image = target.Image;
+    node.Aspect = get_aspect(target.Format);
+    node.LayoutTracker = &target.CurrentLayout;
+    node.SharedQueues = target.SharedQueues;
+
+    m_resources.push_back(node);
+    return static_cast<RGResource>(m_resources.size() - 1);
+}
+
+RGResource RenderGraph::import_texture(const char* name, Texture& texture)
+{
+    RGResource existing = find_resource(name);
+    if (existing != INVALID_RG_RESOURCE)
+    {
+        if (m_resources[existing].Source != &texture)
+            throw std::runtime_error(std::string("Render Graph Resource '") + name +
+                                     "' was imported with two different Textures!");
+        return existing;
+    }
+
+    ResourceNode node = {};
+    node.Name = name;
+    node.Type = ResourceType::IMAGE;
+    node.Source = &texture;
+    node.IsTexture = true;
+    node.Image = texture.TextureImage;
+    node.Aspect = get_aspect(texture.Desc.Format);
+    node.LayoutTracker = &texture.ImageInfo.imageLayout;
+    node.SharedQueues = texture.Desc.SharedQueues;
+
+    m_resources.push_back(node);
+    return static_cast<RGResource>(m_resources.size() - 1);
+}
+
+RGResource RenderGraph::import_buffer(const char* name, Buffer& buffer)
+{
+    RGResource existing = find_resource(name);
+    if (existing != INVALID_RG_RESOURCE)
+    {
+        if (m_resources[existing].Source != &buffer)
+            throw std::runtime_error(std::string("Render Graph Resource '") + name +
+                                     "' was imported with two different Buffers!");
+        return existing;
+    }
+
+    ResourceNode node = {};
+    node.Name = name;
+    node.Type = ResourceType::BUFFER;
+    node.Source = &buffer;
+    node.BufferHandle = buffer.Handle;
+    node.SharedQueues = buffer.Desc.SharedQueues;
+
+    m_resources.push_back(node);
+    return static_cast<RGResource>(m_resources.size() - 1);
+}
+
+RGResource RenderGraph::create_buffer(const char* name, const RGBufferDesc& desc)
+{
+    if (find_resource(name) != INVALID_RG_RESOURCE)
+        throw std::runtime_error(std::string("Render Graph Resource '") + name +
+                                 "' was created twice!");
+    if (desc.Size == 0)
+        throw std::runtime_error(std::string("Render Graph Buffer '") + name + "' has no size!");
+
+    ResourceNode node = {};
+    node.Name = name;
+    node.Type = ResourceType::BUFFER;
+    node.IsTransient = true;
+    node.BufferDesc = desc;
+
+    m_resources.push_back(node);
+    return static_cast<RGResource>(m_resources.size() - 1);
+}
+
+RGResource RenderGraph::create_render_target(const char* name, const RGImageDesc& desc)
+{
+    if (find_resource(name) != INVALID_RG_RESOURCE)
+        throw std::runtime_error(std::string("Render Graph Resource '") + name +
+                                 "' was created twice!");
+    if (desc.Width == 0 || desc.Height == 0)
+        throw std::runtime_error(std::string("Render Graph Render Target '") + name +
+                                 "' has no size!");
+
+    ResourceNode node = {};
+    node.Name = name;
+    node.Type = ResourceType::IMAGE;
+    node.IsTransient = true;
+    node.ImageDesc = desc;
+    node.Aspect = get_aspect(desc.Format);
+
+    m_resources.push_back(node);
+    return static_cast<RGResource>(m_resources.size() - 1);
+}
+
+RGResource RenderGraph::find_resource(const char* name) const
+{
+    for (size_t i = 0; i < m_resources.size(); i++)
+    {
+        if (m_resources[i].Name == name || std::strcmp(m_resources[i].Name, name) == 0)
+            return static_cast<RGResource>(i);
+    }
+    return INVALID_RG_RESOURCE;
+}
+
+void RenderGraph::add_access(uint32_t pass, RGResource resource, RGUsage usage, bool isWrite,
+                             bool discard)
+{
+    if (resource >= m_resources.size())
+        throw std::runtime_error(std::string("Pass '") + m_passes[pass].Name +
+                                 "' uses an invalid Render Graph Resource!");
+    if (usage == RGUsage::Present)
+        throw std::runtime_error("Present is only valid as a Render Graph Output!");
+    // Accesses are stored back to back, the builder of an earlier pass can't add any more
+    if (pass + 1 != m_passes.size())
+        throw std::runtime_error(std::string("Pass '") + m_passes[pass].Name +
+                                 "' declared a resource after the next pass got added!");
+
+    const ResourceNode& node = m_resources[resource];
+    const UsageInfo info = get_usage_info(usage);
+
+    SyncState state = {info.Stage, info.Access, VK_IMAGE_LAYOUT_UNDEFINED};
+    if (node.Type == ResourceType::IMAGE)
+        state.Layout = info.Layout;
+
+    const uint32_t usageBit = 1u << static_cast<uint32_t>(usage);
+
+    // Several uses of a resource within one pass get merged into a single access
+    for (ResourceAccess& access : get_accesses(m_passes[pass]))
+    {
+        if (access.Resource != resource)
+            continue;
+
+        if (access.State.Layout != state.Layout)
+            throw std::runtime_error(std::string("Pass '") + m_passes[pass].Name + "' uses '" +
+                                     node.Name + "' in two different layouts!");
+
+        access.State.Stage |= state.Stage;
+        access.State.Access |= state.Access;
+        access.IsWrite |= isWrite;
+        access.Discard |= discard;
+        access.Usages |= usageBit;
+        return;
+    }
+
+    ResourceAccess access = {};
+    access.Resource = resource;
+    access.State = state;
+    access.IsWrite = isWrite;
+    access.Discard = discard;
+    access.Usages = usageBit;
+    m_accesses.push_back(access);
+    m_passes[pass].AccessCount++;
+}
+
+RenderGraph::Range<RenderGraph::ResourceAccess> RenderGraph::get_accesses(const PassNode& pass)
+{
+    ResourceAccess* first = m_accesses.data() + pass.FirstAccess;
+    return {first, first + pass.AccessCount};
+}
+
+RenderGraph::Range<const RenderGraph::ResourceAccess> RenderGraph::get_accesses(
+    const PassNode& pass) const
+{
+    const ResourceAccess* first = m_accesses.data() + pass.FirstAccess;
+    return {first, first + pass.AccessCount};
+}
+
+RenderGraph::Range<const RenderGraph::Barrier> RenderGraph::get_barriers(
+    const PassNode& pass) const
+{
+    const Barrier* first = m_barriers.data() + pass.FirstBarrier;
+    return {first, first + pass.BarrierCount};
+}
+
+RenderGraph::Range<const uint32_t> RenderGraph::get_passes(const RGBatch& batch) const
+{
+    const uint32_t* first = m_batchPasses.data() + batch.FirstPass;
+    return {first, first + batch.PassCount};
+}
+
+bool RenderGraph::is_async_compute_active() const
+{
+    return m_asyncCompute && nijiEngine.m_context.has_async_compute();
+}
+
+void RenderGraph::compile()
+{
+    cull_passes();
+    assign_queues();
+    compute_lifetimes();
+    allocate_transients();
+    build_batches();
+    compute_barriers();
+
+    m_stats.Passes = static_cast<uint32_t>(m_passes.size());
+    m_stats.CulledPasses = 0;
+    m_stats.AsyncPasses = 0;
+    for (const PassNode& pass : m_passes)
+    {
+        m_stats.CulledPasses += pass.Culled ? 1 : 0;
+        m_stats.AsyncPasses += (!pass.Culled && pass.Queue == RGQueue::AsyncCompute) ? 1 : 0;
+    }
+    m_stats.Batches = static_cast<uint32_t>(m_batches.size());
+
+    const TransientFrame& frame = m_transientFrames[m_frameIndex];
+    m_stats.TransientResources = static_cast<uint32_t>(frame.Resources.size());
+    m_stats.TransientBytes = 0;
+    m_stats.AliasedBytes = 0;
+    for (const TransientResource& resource : frame.Resources)
+        m_stats.TransientBytes += resource.Size;
+    for (const TransientHeap& heap : frame.Heaps)
+        m_stats.AliasedBytes += heap.Size;
+
+    m_compiled = true;
+}
+
+void RenderGraph::cull_passes()
+{
+    // Walk the passes backwards, a pass survives if something after it (or the frame output)
+    // needs one of the resources it writes
+    FrameVector<uint8_t> needed(m_resources.size(), 0);
+    for (size_t i = 0; i < m_resources.size(); i++)
+        needed[i] = m_resources[i].IsOutput;
+
+    for (size_t i = m_passes.size(); i-- > 0;)
+    {
+        PassNode& pass = m_passes[i];
+
+        bool alive = pass.HasSideEffects;
+        for (const ResourceAccess& access : get_accesses(pass))
+            alive |= access.IsWrite && needed[access.Resource];
+
+        pass.Culled = !alive;
+        if (!alive)
+            continue;
+
+        // Whatever got overwritten here doesn't need to be produced by an earlier pass
+        for (const ResourceAccess& access : get_accesses(pass))
+        {
+            if (access.IsWrite && access.Discard)
+                needed[access.Resource] = 0;
+        }
+        for (const ResourceAccess& access : get_accesses(pass))
+        {
+            if (!access.Discard)
+                needed[access.Resource] = 1;
+        }
+    }
+}
+
+void RenderGraph::assign_queues()
+{
+    constexpr VkPipelineStageFlags2 computeQueueStages =
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+
+    const bool asyncCompute = is_async_compute_active();
+
+    for (PassNode& pass : m_passes)
+    {
+        pass.Queue = (asyncCompute && pass.RequestedQueue == RGQueue::AsyncCompute)
+                         ? RGQueue::AsyncCompute
+                         : RGQueue::Graphics;
+
+        if (pass.Culled || pass.Queue != RGQueue::AsyncCompute)
+            continue;
+
+        for (const ResourceAccess& access : get_accesses(pass))
+        {
+            const ResourceNode& node = m_resources[access.Resource];
+            if ((access.State.Stage & ~computeQueueStages) != 0)
+                throw std::runtime_error(std::string("Async compute pass '") + pass.Name +
+                                         "' uses '" + node.Name +
+                                         "' outside of compute / transfer!");
+            if (node.IsOutput)
+                throw std::runtime_error(std::string("Async compute pass '") + pass.Name +
+                                         "' can't touch the frame output '" + node.Name + "'!");
+            // The graph does no queue ownership transfers, and async compute can get turned off
+            // and on, so even compute only imports end up on both queues
+            if (!node.IsTransient && !node.SharedQueues)
+                throw std::runtime_error(std::string("Async compute pass '") + pass.Name +
+                                         "' uses '" + node.Name +
+                                         "', which wasn't created with SharedQueues!");
+        }
+    }
+}
+
+void RenderGraph::compute_lifetimes()
+{
+    for (uint32_t i = 0; i < m_passes.size(); i++)
+    {
+        if (m_passes[i].Culled)
+            continue;
+
+        for (const ResourceAccess& access : get_accesses(m_passes[i]))
+        {
+            ResourceNode& node = m_resources[access.Resource];
+            node.FirstUse = std::min(node.FirstUse, i);
+            node.LastUse = std::max(node.LastUse, i);
+            node.QueueMask |= queue_bit(m_passes[i].Queue);
+        }
+    }
+
+    // Outputs have to survive until the end of the frame
+    for (ResourceNode& node : m_resources)
+    {
+        if (node.IsOutput)
+            node.LastUse = static_cast<uint32_t>(m_passes.size());
+    }
+}
+
+void RenderGraph::allocate_transients()
+{
+    TransientFrame& frame = m_transientFrames[m_frameIndex];
+
+    std::vector<RGResource>& transients = m_transients;
+    transients.clear();
+    m_signature.clear();
+    for (RGResource i = 0; i < m_resources.size(); i++)
+    {
+        const ResourceNode& node = m_resources[i];
+        if (!node.IsTransient || node.FirstUse == UINT32_MAX)
+            continue;
+
+        transients.push_back(i);
+
+        TransientKey key = {};
+        key.NameHash = std::hash<std::string_view>()(node.Name);
+        key.BufferDesc = node.BufferDesc;
+        key.ImageDesc = node.ImageDesc;
+        key.FirstUse = node.FirstUse;
+        key.LastUse = node.LastUse;
+        key.QueueMask = node.QueueMask;
+        m_signature.push_back(key);
+    }
+
+    // Same resources with the same lifetimes as the last time this frame was recorded
+    if (m_signature == frame.Signature)
+    {
+        for (uint32_t slot = 0; slot < transients.size(); slot++)
+            m_resources[transients[slot]].TransientSlot = slot;
+        return;
+    }
+
+    // The frame's fence has been waited on, nothing is using its transients anymore
+    release_transients(frame);
+    frame.Signature = m_signature;
+
+    VkDevice device = nijiEngine.m_context.m_device;
+    const uint32_t families[2] = {nijiEngine.m_context.m_graphicsFamily,
+                                  nijiEngine.m_context.m_computeFamily};
+
+    for (uint32_t slot = 0; slot < transients.size(); slot++)
+    {
+        ResourceNode& node = m_resources[transients[slot]];
+        node.TransientSlot = slot;
+
+        TransientResource resource = {};
+        resource.Name = node.Name;
+        resource.Type = node.Type;
+        resource.FirstUse = node.FirstUse;
+        resource.LastUse = node.LastUse;
+        resource.QueueMask = node.QueueMask;
+
+        VkMemoryRequirements requirements = {};
+
+        if (node.Type == ResourceType::BUFFER)
+        {
+            VkBufferCreateInfo bufferInfo = {};
+            bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufferInfo.size = node.BufferDesc.Size;
+            bufferInfo.usage = node.BufferDesc.Usage;
+            set_sharing_mode(node.QueueMask, bufferInfo.sharingMode,
+                             bufferInfo.queueFamilyIndexCount, bufferInfo.pQueueFamilyIndices,
+                             families);
+
+            VkBuffer buffer = VK_NULL_HANDLE;
+            if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+                throw std::runtime_error(std::string("Failed to Create Render Graph Buffer '") +
+                                         node.Name + "'!");
+
+            vkGetBufferMemoryRequirements(device, buffer, &requirements);
+            SetObjectName(device, VK_OBJECT_TYPE_BUFFER, buffer, node.Name);
+
+            // Wrapped without an allocation of its own, so Buffer::cleanup leaves it alone
+            resource.BufferObject.Handle = buffer;
+            resource.BufferObject.Desc.Size = node.BufferDesc.Size;
+            resource.BufferObject.Desc.Usage =
+                (node.BufferDesc.Usage & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
+                    ? BufferDesc::BufferUsage::Indirect
+                    : BufferDesc::BufferUsage::Storage;
+        }
+        else
+        {
+            VkImageCreateInfo imageInfo = {};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent = {node.ImageDesc.Width, node.ImageDesc.Height, 1};
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = node.ImageDesc.Format;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.usage = node.ImageDesc.Usage;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            set_sharing_mode(node.QueueMask, imageInfo.sharingMode,
+                             imageInfo.queueFamilyIndexCount, imageInfo.pQueueFamilyIndices,
+                             families);
+
+            VkImage image = VK_NULL_HANDLE;
+            if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS)
+                throw std::runtime_error(
+                    std::string("Failed to Create Render Graph Render Target '") + node.Name +
+                    "'!");
+
+            vkGetImageMemoryRequirements(device, image, &requirements);
+            SetObjectName(device, VK_OBJECT_TYPE_IMAGE, image, node.Name);
+
+            resource.Target.Image = image;
+            resource.Target.Format = node.ImageDesc.Format;
+            resource.Target.CurrentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        }
+
+        resource.Size = requirements.size;
+        resource.Alignment = requirements.alignment;
+        resource.MemoryTypeBits = requirements.memoryTypeBits;
+
+        frame.Resources.push_back(std::move(resource));
+    }
+
+    // Biggest resources first, each one goes to the lowest offset that doesn't overlap a
+    // resource that is alive at the same time (buffers and images never share a heap, so
+    // bufferImageGranularity never comes into play). Memory is only handed over within one
+    // queue, pass order says nothing about when the other queue is done with it.
+    std::vector<uint32_t> order(frame.Resources.size());
+    for (uint32_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return frame.Resources[a].Size > frame.Resources[b].Size;
+    });
+
+    std::vector<bool> placed(frame.Resources.size(), false);
+    for (uint32_t index : order)
+    {
+        TransientResource& resource = frame.Resources[index];
+
+        uint32_t heapIndex = UINT32_MAX;
+        for (uint32_t h = 0; h < frame.Heaps.size(); h++)
+        {
+            const TransientHeap& heap = frame.Heaps[h];
+            if (heap.Type == resource.Type && (heap.MemoryTypeBits & resource.MemoryTypeBits))
+            {
+                heapIndex = h;
+                break;
+            }
+        }
+
+        if (heapIndex == UINT32_MAX)
+        {
+            TransientHeap heap = {};
+            heap.Type = resource.Type;
+            frame.Heaps.push_back(heap);
+            heapIndex = static_cast<uint32_t>(frame.Heaps.size() - 1);
+        }
+
+        std::vector<std::pair<VkDeviceSize, VkDeviceSize>> taken = {};
+        for (uint32_t other = 0; other < frame.Resources.size(); other++)
+        {
+            const TransientResource& otherResource = frame.Resources[other];
+            const bool singleQueue = (resource.QueueMask & (resource.QueueMask - 1)) == 0;
+            const bool overlaps = otherResource.QueueMask != resource.QueueMask || !singleQueue ||
+                                  (otherResource.FirstUse <= resource.LastUse &&
+                                   resource.FirstUse <= otherResource.LastUse);
+
+            if (placed[other] && otherResource.Heap == heapIndex && overlaps)
+                taken.push_back({otherResource.Offset, otherResource.Offset + otherResource.Size});
+        }
+        std::sort(taken.begin(), taken.end());
+
+        VkDeviceSize offset = 0;
+        for (const auto& range : taken)
+        {
+            if (align_up(offset, resource.Alignment) + resource.Size <= range.first)
+                break;
+            offset = std::max(offset, range.second);
+        }
+        offset = align_up(offset, resource.Alignment);
+
+        TransientHeap& heap = frame.Heaps[heapIndex];
+        heap.Size = std::max(heap.Size, offset + resource.Size);
+        heap.Alignment = std::max(heap.Alignment, resource.Alignment);
+        heap.MemoryTypeBits &= resource.MemoryTypeBits;
+
+        resource.Heap = heapIndex;
+        resource.Offset = offset;
+        placed[index] = true;
+    }
+
+    VmaAllocator allocator = nijiEngine.m_context.m_allocator;
+
+    for (TransientHeap& heap : frame.Heaps)
+    {
+        VkMemoryRequirements requirements = {};
+        requirements.size = heap.Size;
+        requirements.alignment = heap.Alignment;
+        requirements.memoryTypeBits = heap.MemoryTypeBits;
+
+        VmaAllocationCreateInfo allocInfo = {};
+        allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+        if (vmaAllocateMemory(allocator, &requirements, &allocInfo, &heap.Allocation, nullptr) !=
+            VK_SUCCESS)
+            throw std::runtime_error("Failed to Allocate Render Graph Transient Memory!");
+
+        vmaSetAllocationName(allocator, heap.Allocation, "Render Graph Transient Heap");
+    }
+
+    for (TransientResource& resource : frame.Resources)
+    {
+        VmaAllocation allocation = frame.Heaps[resource.Heap].Allocation;
+
+        if (resource.Type == ResourceType::BUFFER)
+        {
+            if (vmaBindBufferMemory2(allocator, allocation, resource.Offset,
+                                     resource.BufferObject.Handle, nullptr) != VK_SUCCESS)
+                throw std::runtime_error("Failed to Bind Render Graph Buffer '" + resource.Name +
+                                         "'!");
+        }
+        else
+        {
+            if (vmaBindImageMemory2(allocator, allocation, resource.Offset, resource.Target.Image,
+                                    nullptr) != VK_SUCCESS)
+                throw std::runtime_error("Failed to Bind Render Graph Render Target '" +
+                                         resource.Name + "'!");
+
+            resource.Target.ImageView = nijiEngine.m_context.create_image_view(
+                resource.Target.Image, resource.Target.Format,
+                get_aspect(resource.Target.Format), 1, 1);
+        }
+    }
+}
+
+void RenderGraph::release_transients(TransientFrame& frame)
+{
+    VkDevice device = nijiEngine.m_context.m_device;
+
+    for (TransientResource& resource : frame.Resources)
+    {
+        if (resource.Type == ResourceType::BUFFER)
+        {
+            vkDestroyBuffer(device, resource.BufferObject.Handle, nullptr);
+            resource.BufferObject.Handle = VK_NULL_HANDLE;
+        }
+        else
+        {
+            vkDestroyImageView(device, resource.Target.ImageView, nullptr);
+            vkDestroyImage(device, resource.Target.Image, nullptr);
+        }
+    }
+
+    for (TransientHeap& heap : frame.Heaps)
+    {
+        if (heap.Allocation != nullptr)
+            vmaFreeMemory(nijiEngine.m_context.m_allocator, heap.Allocation);
+    }
+
+    frame.Resources.clear();
+    frame.Heaps.clear();
+    frame.Signature.clear();
+}
+
+void RenderGraph::build_batches()
+{
+    const uint32_t graphics = queue_index(RGQueue::Graphics);
+
+    bool hasAsync = false;
+    for (const PassNode& pass : m_passes)
+        hasAsync |= !pass.Culled && pass.Queue == RGQueue::AsyncCompute;
+
+    // Batch 0 takes whatever got recorded before the graph. With async compute it gets no passes,
+    // so async batches only wait on those uploads and not on the first graphics passes.
+    m_batches.push_back(RGBatch{});
+    bool sealed = hasAsync;
+
+    // Latest batch of a queue that touched a resource since the other queue last synced with it
+    struct QueueUse
+    {
+        uint32_t Batch = UINT32_MAX;
+        bool Wrote = false; // Includes layout transitions
+    };
+    FrameVector<std::array<QueueUse, 2>> uses(m_resources.size());
+    FrameVector<VkImageLayout> layouts(m_resources.size(), VK_IMAGE_LAYOUT_UNDEFINED);
+    for (size_t i = 0; i < m_resources.size(); i++)
+    {
+        const ResourceNode& node = m_resources[i];
+        if (node.IsTransient || node.Type != ResourceType::IMAGE)
+            continue;
+
+        // Imported images were last used by the graphics queue, in an earlier frame
+        layouts[i] = *node.LayoutTracker;
+        uses[i][graphics] = {0, true};
+    }
+
+    // Latest batch of the other queue each queue has waited on
+    std::array<uint32_t, 2> synced = {UINT32_MAX, UINT32_MAX};
+    auto covered = [&](uint32_t queue, uint32_t batch) {
+        return synced[queue] != UINT32_MAX && batch <= synced[queue];
+    };
+
+    for (uint32_t i = 0; i < m_passes.size(); i++)
+    {
+        PassNode& pass = m_passes[i];
+        if (pass.Culled)
+            continue;
+
+        const uint32_t queue = queue_index(pass.Queue);
+        const uint32_t other = 1 - queue;
+
+        uint32_t wait = UINT32_MAX;
+        if (pass.Queue == RGQueue::AsyncCompute && !covered(queue, 0))
+            wait = 0;
+
+        for (const ResourceAccess& access : get_accesses(pass))
+        {
+            const ResourceNode& node = m_resources[access.Resource];
+            const QueueUse& otherUse = uses[access.Resource][other];
+            if (otherUse.Batch == UINT32_MAX || covered(queue, otherUse.Batch))
+                continue;
+
+            // Reads of something the other queue only read can run side by side
+            const bool layoutChange = node.Type == ResourceType::IMAGE &&
+                                      (access.Discard || layouts[access.Resource] != access.State.Layout);
+            if (access.IsWrite || layoutChange || otherUse.Wrote)
+                wait = wait == UINT32_MAX ? otherUse.Batch : std::max(wait, otherUse.Batch);
+        }
+
+        // A wait applies to a whole batch, so passes that need one start a new batch instead of
+        // holding back the passes before them
+        const RGBatch& current = m_batches.back();
+        if (sealed || current.Queue != pass.Queue ||
+            (wait != UINT32_MAX && current.PassCount > 0))
+        {
+            RGBatch batch = {};
+            batch.Queue = pass.Queue;
+            batch.FirstPass = static_cast<uint32_t>(m_batchPasses.size());
+            m_batches.push_back(batch);
+            sealed = false;
+        }
+
+        const uint32_t batchIndex = static_cast<uint32_t>(m_batches.size() - 1);
+        if (wait != UINT32_MAX)
+        {
+            m_batches[batchIndex].WaitBatch = wait;
+            m_batches[wait].Signals = true;
+            synced[queue] = wait;
+        }
+
+        // Passes only ever go into the newest batch, so every batch's passes stay back to back
+        pass.Batch = batchIndex;
+        m_batchPasses.push_back(i);
+        m_batches[batchIndex].PassCount++;
+
+        for (ResourceAccess& access : get_accesses(pass))
+        {
+            const ResourceNode& node = m_resources[access.Resource];
+            QueueUse& otherUse = uses[access.Resource][other];
+
+            access.Synced = otherUse.Batch != UINT32_MAX && covered(queue, otherUse.Batch);
+            if (access.Synced)
+                otherUse = {};
+
+            const bool layoutChange = node.Type == ResourceType::IMAGE &&
+                                      (access.Discard || layouts[access.Resource] != access.State.Layout);
+
+            QueueUse& use = uses[access.Resource][queue];
+            use.Batch = batchIndex;
+            use.Wrote |= access.IsWrite || layoutChange;
+
+            if (node.Type == ResourceType::IMAGE)
+                layouts[access.Resource] = access.State.Layout;
+        }
+    }
+
+    // The last graphics batch signals the end of the frame, every async batch has to be done by then
+    uint32_t lastCompute = UINT32_MAX;
+    for (uint32_t b = 0; b < m_batches.size(); b++)
+    {
+        if (m_batches[b].Queue == RGQueue::AsyncCompute)
+            lastCompute = b;
+    }
+
+    if (lastCompute != UINT32_MAX && !covered(graphics, lastCompute))
+    {
+        if (m_batches.back().Queue != RGQueue::Graphics)
+        {
+            RGBatch batch = {};
+            batch.FirstPass = static_cast<uint32_t>(m_batchPasses.size());
+            m_batches.push_back(batch);
+        }
+
+        RGBatch& last = m_batches.back();
+        if (last.WaitBatch != UINT32_MAX)
+            m_batches[last.WaitBatch].Signals = false;
+
+        last.WaitBatch = lastCompute;
+        m_batches[lastCompute].Signals = true;
+    }
+
+    m_lastGraphicsBatch = static_cast<uint32_t>(m_batches.size() - 1);
+    m_outputBatch = m_lastGraphicsBatch;
+    for (const RGBatch& batch : m_batches)
+    {
+        bool touchesOutput = false;
+        for (uint32_t passIndex : get_passes(batch))
+        {
+            for (const ResourceAccess& access : get_accesses(m_passes[passIndex]))
+                touchesOutput |= m_resources[access.Resource].IsOutput;
+        }
+
+        if (touchesOutput)
+        {
+            m_outputBatch = m_passes[get_passes(batch)[0]].Batch;
+            break;
+        }
+    }
+}
+
+void RenderGraph::compute_barriers()
+{
+    // What happened to a resource since its last barrier
+    struct Tracker
+    {
+        bool Touched = false;
+        bool PendingWrite = false;
+        VkPipelineStageFlags2 WriteStage = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 WriteAccess = VK_ACCESS_2_NONE;
+        VkPipelineStageFlags2 ReadStages = VK_PIPELINE_STAGE_2_NONE;
+        // Readers the last write has already been made visible to
+        VkPipelineStageFlags2 VisibleStages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 VisibleAccess = VK_ACCESS_2_NONE;
+    };
+
+    // One tracker per queue, barriers only ever order work within a queue. Whatever crosses
+    // queues is ordered by the batch semaphores instead.
+    std::array<FrameVector<Tracker>, 2> trackers = {};
+    FrameVector<VkImageLayout> layouts(m_resources.size(), VK_IMAGE_LAYOUT_UNDEFINED);
+    for (auto& queueTrackers : trackers)
+        queueTrackers.resize(m_resources.size());
+
+    for (size_t i = 0; i < m_resources.size(); i++)
+    {
+        const ResourceNode& node = m_resources[i];
+
+        // Imported images may still be in use by earlier submissions (and have to wait on the
+        // swapchain acquire), so their first use waits on everything before it. Imported
+        // buffers are either per frame in flight or host written, the frame fence covers them.
+        if (!node.IsTransient && node.Type == ResourceType::IMAGE)
+        {
+            layouts[i] = *node.LayoutTracker;
+            for (auto& queueTrackers : trackers)
+            {
+                Tracker& tracker = queueTrackers[i];
+                tracker.PendingWrite = true;
+                tracker.WriteStage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+                tracker.WriteAccess = VK_ACCESS_2_MEMORY_WRITE_BIT;
+            }
+        }
+    }
+
+    const TransientFrame& frame = m_transientFrames[m_frameIndex];
+
+    auto transition = [&](RGResource resource, const SyncState& state, bool isWrite,
+                          bool discard, RGQueue queue, bool synced,
+                          std::vector<Barrier>& barriers) {
+        const ResourceNode& node = m_resources[resource];
+        FrameVector<Tracker>& queueTrackers = trackers[queue_index(queue)];
+        Tracker& tracker = queueTrackers[resource];
+        const bool isImage = node.Type == ResourceType::IMAGE;
+
+        // The semaphore made everything the other queue (and this one before it) did visible,
+        // only a layout transition still has to be chained to the semaphore wait
+        if (synced)
+        {
+            tracker = Tracker{};
+            tracker.Touched = true;
+        }
+
+        Barrier barrier = {};
+        barrier.Resource = resource;
+
+        // The first use of a transient has to wait for whoever had its memory before it
+        if (node.IsTransient && !tracker.Touched)
+        {
+            const TransientResource& self = frame.Resources[node.TransientSlot];
+            for (RGResource other = 0; other < m_resources.size(); other++)
+            {
+                const ResourceNode& otherNode = m_resources[other];
+                if (!otherNode.IsTransient || otherNode.TransientSlot == UINT32_MAX ||
+                    other == resource)
+                    continue;
+
+                const TransientResource& otherResource = frame.Resources[otherNode.TransientSlot];
+                const bool sharesMemory = otherResource.Heap == self.Heap &&
+                                          otherResource.Offset < self.Offset + self.Size &&
+                                          self.Offset < otherResource.Offset + otherResource.Size;
+
+                if (sharesMemory && otherResource.LastUse < self.FirstUse)
+                {
+                    const Tracker& otherTracker = queueTrackers[other];
+                    tracker.PendingWrite = true;
+                    tracker.WriteStage |= otherTracker.WriteStage | otherTracker.ReadStages;
+                    tracker.WriteAccess |= otherTracker.WriteAccess;
+                    barrier.IsAliasing = true;
+                }
+            }
+        }
+
+        const VkImageLayout oldLayout = (isImage && discard) ? VK_IMAGE_LAYOUT_UNDEFINED
+                                                             : layouts[resource];
+        const bool layoutChange = isImage && oldLayout != state.Layout;
+
+        bool needsBarrier = false;
+        SyncState before = {VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, oldLayout};
+
+        if (layoutChange || isWrite)
+        {
+            // Layout transitions and writes wait on every earlier write (WAW) and read (WAR)
+            before.Stage = (tracker.PendingWrite ? tracker.WriteStage : 0) | tracker.ReadStages;
+            before.Access = tracker.PendingWrite ? tracker.WriteAccess : 0;
+            if (synced && layoutChange)
+                before.Stage |= VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+            needsBarrier = layoutChange || before.Stage != VK_PIPELINE_STAGE_2_NONE;
+        }
+        else if (tracker.PendingWrite)
+        {
+            // Read after write, unless an earlier barrier already made it visible to this reader
+            const bool visible = (state.Stage & ~tracker.VisibleStages) == 0 &&
+                                 (state.Access & ~tracker.VisibleAccess) == 0;
+            before.Stage = tracker.WriteStage;
+            before.Access = tracker.WriteAccess;
+            needsBarrier = !visible;
+        }
+
+        if (needsBarrier)
+        {
+            barrier.Before = before;
+            barrier.After = state;
+            if (!isImage)
+                barrier.After.Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barriers.push_back(barrier);
+        }
+
+        if (layoutChange || isWrite)
+        {
+            // A layout transition counts as a write that is visible to this access only
+            tracker.PendingWrite = true;
+            tracker.WriteStage = state.Stage;
+            tracker.WriteAccess = isWrite ? (state.Access & WRITE_ACCESS_MASK) : VK_ACCESS_2_NONE;
+            tracker.ReadStages = isWrite ? VK_PIPELINE_STAGE_2_NONE : state.Stage;
+            tracker.VisibleStages = state.Stage;
+            tracker.VisibleAccess = state.Access;
+        }
+        else
+        {
+            if (needsBarrier)
+            {
+                tracker.VisibleStages |= state.Stage;
+                tracker.VisibleAccess |= state.Access;
+            }
+            tracker.ReadStages |= state.Stage;
+        }
+
+        if (isImage)
+            layouts[resource] = state.Layout;
+        tracker.Touched = true;
+    };
+
+    for (uint32_t i = 0; i < m_passes.size(); i++)
+    {
+        PassNode& pass = m_passes[i];
+        pass.FirstBarrier = static_cast<uint32_t>(m_barriers.size());
+        pass.BarrierCount = 0;
+        if (pass.Culled)
+            continue;
+
+        for (const ResourceAccess& access : get_accesses(pass))
+        {
+            const ResourceNode& node = m_resources[access.Resource];
+            if (node.IsTransient && node.FirstUse == i && !access.IsWrite)
+                throw std::runtime_error(std::string("Transient '") + node.Name +
+                                         "' is read by '" + pass.Name +
+                                         "' before anything wrote it!");
+
+            transition(access.Resource, access.State, access.IsWrite, access.Discard, pass.Queue,
+                       access.Synced, m_barriers);
+        }
+        pass.BarrierCount = static_cast<uint32_t>(m_barriers.size()) - pass.FirstBarrier;
+    }
+
+    for (RGResource i = 0; i < m_resources.size(); i++)
+    {
+        const ResourceNode& node = m_resources[i];
+        if (!node.IsOutput)
+            continue;
+
+        const UsageInfo info = get_usage_info(node.OutputUsage);
+        SyncState state = {info.Stage, info.Access, VK_IMAGE_LAYOUT_UNDEFINED};
+        if (node.Type == ResourceType::IMAGE)
+            state.Layout = info.Layout;
+
+        // Outputs never get touched by async compute
+        transition(i, state, false, false, RGQueue::Graphics, false, m_finalBarriers);
+    }
+
+    m_stats.Barriers = 0;
+    m_stats.ImageBarriers = 0;
+    m_stats.BufferBarriers = 0;
+    auto count = [&](Range<const Barrier> barriers) {
+        if (barriers.empty())
+            return;
+
+        m_stats.Barriers++;
+        for (const Barrier& barrier : barriers)
+        {
+            if (m_resources[barrier.Resource].Type == ResourceType::IMAGE)
+                m_stats.ImageBarriers++;
+            else
+                m_stats.BufferBarriers++;
+        }
+    };
+    for (const PassNode& pass : m_passes)
+        count(get_barriers(pass));
+    count({m_finalBarriers.data(), m_finalBarriers.data() + m_finalBarriers.size()});
+}
+
+VkImage RenderGraph::get_image_handle(const ResourceNode& resource) const
+{
+    if (resource.IsTransient)
+        return m_transientFrames[m_frameIndex].Resources[resource.TransientSlot].Target.Image;
+    return resource.Image;
+}
+
+VkBuffer RenderGraph::get_buffer_handle(const ResourceNode& resource) const
+{
+    if (resource.IsTransient)
+        return m_transientFrames[m_frameIndex]
+            .Resources[resource.TransientSlot]
+            .BufferObject.Handle;
+    return resource.BufferHandle;
+}
+
+void RenderGraph::record_barriers(CommandList& cmd, Range<const Barrier> barriers)
+{
+    if (barriers.empty())
+        return;
+
+    FrameVector<VkImageMemoryBarrier2> imageBarriers = {};
+    FrameVector<VkBufferMemoryBarrier2> bufferBarriers = {};
+    imageBarriers.reserve(barriers.size());
+    bufferBarriers.reserve(barriers.size());
+
+    for (const Barrier& barrier : barriers)
+    {
+        ResourceNode& node = m_resources[barrier.Resource];
+
+        if (node.Type == ResourceType::IMAGE)
+        {
+            VkImageMemoryBarrier2 imgBarrier = {};
+            imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+            imgBarrier.srcStageMask = barrier.Before.Stage;
+            imgBarrier.srcAccessMask = barrier.Before.Access;
+            imgBarrier.dstStageMask = barrier.After.Stage;
+            imgBarrier.dstAccessMask = barrier.After.Access;
+            imgBarrier.oldLayout = barrier.Before.Layout;
+            imgBarrier.newLayout = barrier.After.Layout;
+            imgBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imgBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imgBarrier.image = get_image_handle(node);
+            imgBarrier.subresourceRange.aspectMask = node.Aspect;
+            imgBarrier.subresourceRange.baseMipLevel = 0;
+            imgBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+            imgBarrier.subresourceRange.baseArrayLayer = 0;
+            imgBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+            imageBarriers.push_back(imgBarrier);
+
+            // Passes read the layout back from their render targets / textures
+            if (node.IsTransient)
+                m_transientFrames[m_frameIndex]
+                    .Resources[node.TransientSlot]
+                    .Target.CurrentLayout = barrier.After.Layout;
+            else
+                *node.LayoutTracker = barrier.After.Layout;
+        }
+        else
+        {
+            VkBufferMemoryBarrier2 bufBarrier = {};
+            bufBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+            bufBarrier.srcStageMask = barrier.Before.Stage;
+            bufBarrier.srcAccessMask = barrier.Before.Access;
+            bufBarrier.dstStageMask = barrier.After.Stage;
+            bufBarrier.dstAccessMask = barrier.After.Access;
+            bufBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufBarrier.buffer = get_buffer_handle(node);
+            bufBarrier.offset = 0;
+            bufBarrier.size = VK_WHOLE_SIZE;
+            bufferBarriers.push_back(bufBarrier);
+        }
+    }
+
+    VkDependencyInfo depInfo = {};
+    depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    depInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+    depInfo.pImageMemoryBarriers = imageBarriers.data();
+    depInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+    depInfo.pBufferMemoryBarriers = bufferBarriers.data();
+
+    VKCmdPipelineBarrier2KHR(cmd.m_commandBuffer, &depInfo);
+}
+
+void RenderGraph::execute(CommandList& cmd)
+{
+    if (m_batches.size() != 1)
+        throw std::runtime_error("Render Graph got split into several batches, execute them one "
+                                 "by one!");
+
+    execute_batch(0, cmd);
+}
+
+void RenderGraph::execute_batch(uint32_t batch, CommandList& cmd)
+{
+    if (!m_compiled)
+        throw std::runtime_error("Render Graph has to be compiled before it gets executed!");
+    if (batch >= m_batches.size())
+        throw std::runtime_error("Invalid Render Graph Batch!");
+
+    for (uint32_t passIndex : get_passes(m_batches[batch]))
+    {
+        PassNode& pass = m_passes[passIndex];
+
+        record_barriers(cmd, get_barriers(pass));
+
+        NIJI_PROFILE_SCOPE(pass.Name);
+
+        uint32_t scope = UINT32_MAX;
+        if (m_profiler)
+            scope = m_profiler->begin_scope(cmd, pass.Name, pass.Queue == RGQueue::Graphics);
+        pass.Execute(cmd);
+        if (m_profiler)
+            m_profiler->end_scope(cmd, scope);
+    }
+
+    if (batch == m_lastGraphicsBatch)
+        record_barriers(cmd, {m_finalBarriers.data(),
+                              m_finalBarriers.data() + m_finalBarriers.size()});
+}
+
+Buffer& RenderGraph::get_buffer(RGResource resource)
+{
+    if (resource >= m_resources.size() || m_resources[resource].Type != ResourceType::BUFFER)
+        throw std::runtime_error("Render Graph Resource is not a Buffer!");
+
+    ResourceNode& node = m_resources[resource];
+    if (!node.IsTransient)
+        return *static_cast<Buffer*>(node.Source);
+
+    if (!m_compiled || node.TransientSlot == UINT32_MAX)
+        throw std::runtime_error(std::string("Render Graph Buffer '") + node.Name +
+                                 "' is not allocated!");
+
+    return m_transientFrames[m_frameIndex].Resources[node.TransientSlot].BufferObject;
+}
+
+RenderTarget& RenderGraph::get_render_target(RGResource resource)
+{
+    if (resource >= m_resources.size() || m_resources[resource].Type != ResourceType::IMAGE ||
+        m_resources[resource].IsTexture)
+        throw std::runtime_error("Render Graph Resource is not a Render Target!");
+
+    ResourceNode& node = m_resources[resource];
+    if (!node.IsTransient)
+        return *static_cast<RenderTarget*>(node.Source);
+
+    if (!m_compiled || node.TransientSlot == UINT32_MAX)
+        throw std::runtime_error(std::string("Render Graph Render Target '") + node.Name +
+                                 "' is not allocated!");
+
+    return m_transientFrames[m_frameIndex].Resources[node.TransientSlot].Target;
+}
+
+std::string RenderGraph::dump() const
+{
+    std::ostringstream out;
+
+    out << "Render Graph: " << m_stats.Passes << " passes (" << m_stats.CulledPasses
+        << " culled), " << m_stats.Barriers << " barrier batches (" << m_stats.ImageBarriers
+        << " image, " << m_stats.BufferBarriers << " buffer), " << m_stats.Batches
+        << " batches\n";
+
+    auto write_barrier = [&](const Barrier& barrier) {
+        const ResourceNode& node = m_resources[barrier.Resource];
+        out << "    barrier " << node.Name << ": stage 0x" << std::hex << barrier.Before.Stage
+            << " -> 0x" << barrier.After.Stage << ", access 0x" << barrier.Before.Access
+            << " -> 0x" << barrier.After.Access << std::dec;
+        if (node.Type == ResourceType::IMAGE)
+            out << ", " << layout_to_string(barrier.Before.Layout) << " -> "
+                << layout_to_string(barrier.After.Layout);
+        if (barrier.IsAliasing)
+            out << " (aliasing)";
+        out << "\n";
+    };
+
+    for (size_t i = 0; i < m_passes.size(); i++)
+    {
+        const PassNode& pass = m_passes[i];
+        out << "[" << i << "] " << pass.Name;
+        if (pass.Culled)
+            out << " (culled)";
+        else
+            out << " (batch " << pass.Batch
+                << (pass.Queue == RGQueue::AsyncCompute ? ", async compute)" : ")");
+        out << "\n";
+
+        for (const Barrier& barrier : get_barriers(pass))
+            write_barrier(barrier);
+
+        for (const ResourceAccess& access : get_accesses(pass))
+        {
+            const char* kind = !access.IsWrite ? "read" : access.Discard ? "overwrite" : "write";
+            out << "    " << kind << " " << m_resources[access.Resource].Name << " (";
+            const char* separator = "";
+            for (uint32_t usage = 0; usage < RG_USAGE_COUNT; usage++)
+            {
+                if ((access.Usages & (1u << usage)) == 0)
+                    continue;
+                out << separator << rg_usage_to_string(static_cast<RGUsage>(usage));
+                separator = ", ";
+            }
+            out << ")\n";
+        }
+    }
+
+    if (!m_finalBarriers.empty())
+    {
+        out << "[end]\n";
+        for (const Barrier& barrier : m_finalBarriers)
+            write_barrier(barrier);
+    }
+
+    out << "Batches:\n";
+    for (size_t b = 0; b < m_batches.size(); b++)
+    {
+        const RGBatch& batch = m_batches[b];
+        out << "    " << b << ": "
+            << (batch.Queue == RGQueue::AsyncCompute ? "async compute" : "graphics") << ", "
+            << batch.PassCount << " passes";
+        if (batch.WaitBatch != UINT32_MAX)
+            out << ", waits on " << batch.WaitBatch;
+        if (batch.Signals)
+            out << ", signals";
+        if (b == m_outputBatch)
+            out << ", waits on the swapchain";
+        out << "\n";
+    }
+
+    out << "Resources:\n";
+    const TransientFrame& frame = m_transientFrames[m_frameIndex];
+    for (const ResourceNode& node : m_resources)
+    {
+        out << "    " << node.Name << (node.IsTransient ? " (transient" : " (imported")
+            << (node.Type == ResourceType::IMAGE ? " image)" : " buffer)");
+
+        if (node.FirstUse != UINT32_MAX)
+            out << " passes " << node.FirstUse << "-" << node.LastUse;
+        else
+            out << " unused";
+
+        if (node.IsTransient && node.TransientSlot != UINT32_MAX &&
+            node.TransientSlot < frame.Resources.size())
+        {
+            const TransientResource& resource = frame.Resources[node.TransientSlot];
+            out << ", heap " << resource.Heap << " offset " << resource.Offset << " size "
+                << resource.Size;
+        }
+        out << (node.IsOutput ? ", output" : "") << "\n";
+    }
+
+    out << "Transient memory: " << m_stats.AliasedBytes << " bytes allocated for "
+        << m_stats.TransientBytes << " bytes of resources\n";
+
+    return out.str();
+}
+
+std::string RenderGraph::dump_graphviz() const
+{
+    std::ostringstream out;
+    out << "digraph RenderGraph {\n    rankdir=LR;\n";
+
+    for (size_t i = 0; i < m_passes.size(); i++)
+    {
+        const PassNode& pass = m_passes[i];
+        out << "    pass" << i << " [shape=box, label=\"" << pass.Name << "\""
+            << (pass.Culled ? ", style=dashed, color=gray" : "")
+            << (!pass.Culled && pass.Queue == RGQueue::AsyncCompute ? ", color=blue" : "")
+            << "];\n";
+    }
+
+    for (size_t i = 0; i < m_resources.size(); i++)
+    {
+        const ResourceNode& node = m_resources[i];
+        out << "    res" << i << " [shape=ellipse, label=\"" << node.Name << "\""
+            << (node.IsTransient ? ", style=dashed" : "")
+            << (node.IsOutput ? ", peripheries=2" : "") << "];\n";
+    }
+
+    for (size_t i = 0; i < m_passes.size(); i++)
+    {
+        for (const ResourceAccess& access : get_accesses(m_passes[i]))
+        {
+            if (!access.IsWrite || !access.Discard)
+                out << "    res" << access.Resource << " -> pass" << i << ";\n";
+            if (access.IsWrite)
+                out << "    pass" << i << " -> res" << access.Resource << ";\n";
+        }
+    }
+
+    out << "}\n";
+    return out.str();
+}
+
+void RenderGraph::debug_panel()
+{
+    ImGui::Text("Passes: %u (%u culled)", m_stats.Passes, m_stats.CulledPasses);
+    ImGui::Text("Barrier Batches: %u (%u image, %u buffer)", m_stats.Barriers,
+                m_stats.ImageBarriers, m_stats.BufferBarriers);
+    ImGui::Text("Batches: %u (%u async compute passes)", m_stats.Batches, m_stats.AsyncPasses);
+    ImGui::Text("Transient Resources: %u", m_stats.TransientResources);
+    ImGui::Text("Transient Memory: %.1f KB (%.1f KB without aliasing)",
+                m_stats.AliasedBytes / 1024.0f, m_stats.TransientBytes / 1024.0f);
+
+    if (ImGui::Button("Log Graph"))
+        nijiEngine.m_logger.log_info(dump());
+    ImGui::SameLine();
+    if (ImGui::Button("Save Graphviz"))
+    {
+        std::ofstream file("render_graph.dot");
+        file << dump_graphviz();
+    }
+
+    if (ImGui::CollapsingHeader("Compiled Graph"))
+        ImGui::TextUnformatted(dump().c_str());
+}
+
+void RenderGraph::cleanup()
+{
+    for (TransientFrame& frame : m_transientFrames)
+        release_transients(frame);
+
+    m_passes.clear();
+    m_resources.clear();
+    m_accesses.clear();
+    m_barriers.clear();
+    m_finalBarriers.clear();
+    m_batches.clear();
+    m_batchPasses.clear();
+}
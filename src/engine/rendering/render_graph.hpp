@@ -0,0 +1,476 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "core/commandlist.hpp"
+#include "core/common.hpp"
+
+namespace niji
+{
+
+using RGResource = uint32_t;
+constexpr RGResource INVALID_RG_RESOURCE = UINT32_MAX;
+
+// How a pass touches a resource, every usage maps onto a sync2 stage/access/layout triple
+enum class RGUsage : uint8_t
+{
+    ColorAttachment,      // Rendered to (loaded and/or stored)
+    ColorAttachmentRead,  // Bound as attachment without being written
+    DepthAttachment,      // Depth tested and written
+    DepthAttachmentRead,  // Depth tested only (read-only layout)
+    DepthSampledCompute,  // Depth sampled from a compute shader
+    SampledFragment,      // Sampled image read in a fragment shader
+    StorageReadCompute,   // Storage buffer / image read in a compute shader
+    StorageWriteCompute,  // Storage buffer / image written in a compute shader
+    StorageReadGraphics,  // Storage buffer / image read in the vertex or fragment shader
+    IndirectRead,         // Indirect draw arguments and counts
+    TransferWrite,        // Fill / update / copy destination
+    TransferRead,         // Copy source (captures / readbacks)
+    Present               // Handed to the presentation engine (only valid as an output)
+};
+
+constexpr uint32_t RG_USAGE_COUNT = static_cast<uint32_t>(RGUsage::Present) + 1;
+
+const char* rg_usage_to_string(RGUsage usage);
+
+enum class RGQueue : uint8_t
+{
+    Graphics,
+    AsyncCompute
+};
+
+// Passes of one queue that get submitted together. A batch waits on at most one batch of the
+// other queue, waiting on a later batch covers everything submitted before it on that queue.
+struct RGBatch
+{
+    RGQueue Queue = RGQueue::Graphics;
+    // Range of the graph's batch pass list, the passes of a batch are back to back
+    uint32_t FirstPass = 0;
+    uint32_t PassCount = 0;
+    uint32_t WaitBatch = UINT32_MAX;
+    // A batch of the other queue waits on this one
+    bool Signals = false;
+};
+
+struct RGBufferDesc
+{
+    VkDeviceSize Size = 0;
+    VkBufferUsageFlags Usage = 0;
+};
+
+struct RGImageDesc
+{
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    VkFormat Format = VK_FORMAT_UNDEFINED;
+    VkImageUsageFlags Usage = 0;
+};
+
+struct RenderGraphStats
+{
+    uint32_t Passes = 0;
+    uint32_t CulledPasses = 0;
+    uint32_t Barriers = 0; // vkCmdPipelineBarrier2 calls
+    uint32_t ImageBarriers = 0;
+    uint32_t BufferBarriers = 0;
+    uint32_t Batches = 0;
+    uint32_t AsyncPasses = 0;
+    uint32_t TransientResources = 0;
+    VkDeviceSize TransientBytes = 0; // Size of every transient resource on its own
+    VkDeviceSize AliasedBytes = 0;   // What actually got allocated for them
+};
+
+class RenderGraph;
+class GpuProfiler;
+
+// Captures of a pass' execute function have to fit in here (a handful of pointers / references)
+constexpr size_t RG_EXECUTE_DATA_SIZE = 48;
+
+// The passes get added again every frame, so their execute functions are stored inline instead
+// of in a std::function, which heap allocates once the captures outgrow its small buffer
+class RGExecuteFunction
+{
+  public:
+    RGExecuteFunction() = default;
+
+    template <typename Function,
+              typename = std::enable_if_t<
+                  !std::is_same_v<std::decay_t<Function>, RGExecuteFunction>>>
+    RGExecuteFunction(Function&& function)
+    {
+        using Stored = std::decay_t<Function>;
+        static_assert(sizeof(Stored) <= RG_EXECUTE_DATA_SIZE,
+                      "Pass captures don't fit in RG_EXECUTE_DATA_SIZE");
+        static_assert(alignof(Stored) <= alignof(std::max_align_t), "Pass captures overaligned");
+        static_assert(std::is_trivially_copyable_v<Stored>,
+                      "Pass functions may only capture pointers, references and plain values");
+
+        new (m_data) Stored(std::forward<Function>(function));
+        m_call = [](const std::byte* data, CommandList& cmd) {
+            (*std::launder(reinterpret_cast<const Stored*>(data)))(cmd);
+        };
+    }
+
+    void operator()(CommandList& cmd) const
+    {
+        m_call(m_data, cmd);
+    }
+
+  private:
+    void (*m_call)(const std::byte* data, CommandList& cmd) = nullptr;
+    alignas(std::max_align_t) std::byte m_data[RG_EXECUTE_DATA_SIZE] = {};
+};
+
+// Names are kept as pointers, they have to stay valid as long as the graph and the profilers
+// (string literals or a pass' own name)
+
+// Handed to a pass while the graph is being built, everything it declares is relative to it
+class RenderGraphBuilder
+{
+  public:
+    // Importing the same object under the same name twice returns the same resource
+    RGResource import_render_target(const char* name, RenderTarget& target);
+    RGResource import_texture(const char* name, Texture& texture);
+    RGResource import_buffer(const char* name, Buffer& buffer);
+
+    // Transient resources are owned by the graph and only live for the frame, resources whose
+    // lifetimes don't overlap share memory
+    RGResource create_buffer(const char* name, const RGBufferDesc& desc);
+    RGResource create_render_target(const char* name, const RGImageDesc& desc);
+
+    RGResource get_resource(const char* name) const;
+
+    void read(RGResource resource, RGUsage usage);
+    // Read-modify-write, the previous contents are kept (LOAD_OP_LOAD, atomics...)
+    void write(RGResource resource, RGUsage usage);
+    // The previous contents are not needed (LOAD_OP_CLEAR, full rewrites...)
+    void overwrite(RGResource resource, RGUsage usage);
+
+    // Keeps the pass alive even when nothing reads what it writes
+    void set_side_effects();
+
+    // Compute only passes can ask for the async compute queue, they run inline on the graphics
+    // queue when the device has no separate compute queue (or async compute is turned off)
+    void set_queue(RGQueue queue);
+
+  private:
+    friend class RenderGraph;
+
+    RenderGraphBuilder(RenderGraph& graph, uint32_t passIndex) : m_graph(graph), m_pass(passIndex)
+    {
+    }
+
+    RenderGraph& m_graph;
+    uint32_t m_pass = 0;
+};
+
+// Frame graph rebuilt every frame: passes declare what they read and write, compile() culls
+// passes nobody depends on, places transient resources and works out the barriers, execute()
+// records the surviving passes with one batched sync2 barrier in front of each of them.
+// Async compute passes split the frame into batches per queue, the renderer submits those in
+// order and orders them across queues with one semaphore per waited on batch.
+// Every list the graph builds keeps its capacity across frames, so once the frame's shape settled
+// rebuilding it doesn't touch the heap.
+class RenderGraph
+{
+  public:
+    using ExecuteFunction = RGExecuteFunction;
+
+    RenderGraph() = default;
+
+    // Drops last frame's declarations, call once the frame's fence has been waited on
+    void begin_frame(uint32_t frameIndex);
+
+    // A pass declares all of its resources before the next pass gets added
+    RenderGraphBuilder add_pass(const char* name, const ExecuteFunction& execute);
+
+    // Same as the builder versions, for resources that don't belong to a pass (the backbuffer)
+    RGResource import_render_target(const char* name, RenderTarget& target);
+    RGResource import_texture(const char* name, Texture& texture);
+    RGResource import_buffer(const char* name, Buffer& buffer);
+    RGResource create_buffer(const char* name, const RGBufferDesc& desc);
+    RGResource create_render_target(const char* name, const RGImageDesc& desc);
+
+    // Marks a resource as the result of the frame, it ends up in the layout `usage` asks for
+    void set_output(RGResource resource, RGUsage usage);
+
+    void set_async_compute(bool enabled)
+    {
+        m_asyncCompute = enabled;
+    }
+    bool is_async_compute_active() const;
+
+    // Every executed pass gets a timestamp scope named after it
+    void set_profiler(GpuProfiler* profiler)
+    {
+        m_profiler = profiler;
+    }
+
+    void compile();
+    // Records the whole graph into one command list, only valid while it compiled to one batch
+    void execute(CommandList& cmd);
+
+    // Batch 0 is always on the graphics queue. With async compute it holds no passes, so the
+    // work recorded before the graph (uploads) is the only thing async batches have to wait on.
+    const std::vector<RGBatch>& get_batches() const
+    {
+        return m_batches;
+    }
+    // Graphics batch that first touches an output, it has to wait on the swapchain acquire
+    uint32_t get_output_batch() const
+    {
+        return m_outputBatch;
+    }
+    // The one that signals the end of the frame (and gets the final output transitions)
+    uint32_t get_last_graphics_batch() const
+    {
+        return m_lastGraphicsBatch;
+    }
+    void execute_batch(uint32_t batch, CommandList& cmd);
+
+    // Only valid between compile() and the end of the frame
+    Buffer& get_buffer(RGResource resource);
+    RenderTarget& get_render_target(RGResource resource);
+
+    // Resource another pass imported or created this frame
+    RGResource find_resource(const char* name) const;
+
+    // Human readable / Graphviz version of the last compiled graph
+    std::string dump() const;
+    std::string dump_graphviz() const;
+
+    const RenderGraphStats& get_stats() const
+    {
+        return m_stats;
+    }
+
+    void debug_panel();
+
+    void cleanup();
+
+  private:
+    friend class RenderGraphBuilder;
+
+    enum class ResourceType : uint8_t
+    {
+        IMAGE,
+        BUFFER
+    };
+
+    struct SyncState
+    {
+        VkPipelineStageFlags2 Stage = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 Access = VK_ACCESS_2_NONE;
+        VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    };
+
+    struct ResourceNode
+    {
+        const char* Name = nullptr;
+        ResourceType Type = ResourceType::IMAGE;
+        bool IsTransient = false;
+
+        // Imported
+        void* Source = nullptr;
+        bool IsTexture = false;
+        VkImage Image = VK_NULL_HANDLE;
+        VkBuffer BufferHandle = VK_NULL_HANDLE;
+        VkImageAspectFlags Aspect = 0;
+        VkImageLayout* LayoutTracker = nullptr;
+        // Created with concurrent sharing when there is an async compute queue
+        bool SharedQueues = false;
+
+        // Transient
+        RGBufferDesc BufferDesc = {};
+        RGImageDesc ImageDesc = {};
+        uint32_t TransientSlot = UINT32_MAX;
+
+        bool IsOutput = false;
+        RGUsage OutputUsage = RGUsage::Present;
+
+        // Compiled (pass indices)
+        uint32_t FirstUse = UINT32_MAX;
+        uint32_t LastUse = 0;
+        // Bit per RGQueue the resource gets used on
+        uint8_t QueueMask = 0;
+    };
+
+    struct ResourceAccess
+    {
+        RGResource Resource = INVALID_RG_RESOURCE;
+        SyncState State = {};
+        bool IsWrite = false;
+        // One of the pass' uses overwrites, the pass is expected to do that before anything else
+        bool Discard = false;
+        // Bit per RGUsage the pass declared
+        uint32_t Usages = 0;
+
+        // Compiled, the other queue touched the resource before and a semaphore wait covers it
+        bool Synced = false;
+    };
+
+    struct Barrier
+    {
+        RGResource Resource = INVALID_RG_RESOURCE;
+        SyncState Before = {};
+        SyncState After = {};
+        // Only a transient's first use aliasing another resource's memory
+        bool IsAliasing = false;
+    };
+
+    struct PassNode
+    {
+        const char* Name = nullptr;
+        ExecuteFunction Execute = {};
+        // Range of m_accesses
+        uint32_t FirstAccess = 0;
+        uint32_t AccessCount = 0;
+        bool HasSideEffects = false;
+        RGQueue RequestedQueue = RGQueue::Graphics;
+
+        bool Culled = false;
+        RGQueue Queue = RGQueue::Graphics;
+        uint32_t Batch = 0;
+        // Range of m_barriers
+        uint32_t FirstBarrier = 0;
+        uint32_t BarrierCount = 0;
+    };
+
+    // Slice of one of the graph's lists, only valid until that list grows
+    template <typename T>
+    struct Range
+    {
+        T* First = nullptr;
+        T* Last = nullptr;
+
+        T* begin() const
+        {
+            return First;
+        }
+        T* end() const
+        {
+            return Last;
+        }
+        bool empty() const
+        {
+            return First == Last;
+        }
+        size_t size() const
+        {
+            return static_cast<size_t>(Last - First);
+        }
+        T& operator[](size_t index) const
+        {
+            return First[index];
+        }
+    };
+
+    // Transient memory of one frame in flight
+    struct TransientHeap
+    {
+        ResourceType Type = ResourceType::BUFFER;
+        VmaAllocation Allocation = nullptr;
+        VkDeviceSize Size = 0;
+        VkDeviceSize Alignment = 1;
+        uint32_t MemoryTypeBits = ~0u;
+    };
+
+    struct TransientResource
+    {
+        std::string Name = {};
+        ResourceType Type = ResourceType::BUFFER;
+        Buffer BufferObject = {};
+        RenderTarget Target = {};
+
+        uint32_t Heap = 0;
+        VkDeviceSize Offset = 0;
+        VkDeviceSize Size = 0;
+        VkDeviceSize Alignment = 1;
+        uint32_t MemoryTypeBits = ~0u;
+        uint32_t FirstUse = 0;
+        uint32_t LastUse = 0;
+        uint8_t QueueMask = 0;
+    };
+
+    // What a transient's memory got placed for
+    struct TransientKey
+    {
+        size_t NameHash = 0;
+        RGBufferDesc BufferDesc = {};
+        RGImageDesc ImageDesc = {};
+        uint32_t FirstUse = 0;
+        uint32_t LastUse = 0;
+        uint8_t QueueMask = 0;
+
+        bool operator==(const TransientKey& other) const
+        {
+            return NameHash == other.NameHash && BufferDesc.Size == other.BufferDesc.Size &&
+                   BufferDesc.Usage == other.BufferDesc.Usage &&
+                   ImageDesc.Width == other.ImageDesc.Width &&
+                   ImageDesc.Height == other.ImageDesc.Height &&
+                   ImageDesc.Format == other.ImageDesc.Format &&
+                   ImageDesc.Usage == other.ImageDesc.Usage && FirstUse == other.FirstUse &&
+                   LastUse == other.LastUse && QueueMask == other.QueueMask;
+        }
+    };
+
+    struct TransientFrame
+    {
+        // Descriptions + lifetimes the memory was placed for, reused while they don't change
+        std::vector<TransientKey> Signature = {};
+        std::vector<TransientHeap> Heaps = {};
+        std::vector<TransientResource> Resources = {};
+    };
+
+    void add_access(uint32_t pass, RGResource resource, RGUsage usage, bool isWrite,
+                    bool discard);
+
+    void cull_passes();
+    void assign_queues();
+    void compute_lifetimes();
+    void allocate_transients();
+    void release_transients(TransientFrame& frame);
+    void build_batches();
+    void compute_barriers();
+    void record_barriers(CommandList& cmd, Range<const Barrier> barriers);
+
+    Range<ResourceAccess> get_accesses(const PassNode& pass);
+    Range<const ResourceAccess> get_accesses(const PassNode& pass) const;
+    Range<const Barrier> get_barriers(const PassNode& pass) const;
+    Range<const uint32_t> get_passes(const RGBatch& batch) const;
+
+    VkImage get_image_handle(const ResourceNode& resource) const;
+    VkBuffer get_buffer_handle(const ResourceNode& resource) const;
+
+  private:
+    std::vector<PassNode> m_passes = {};
+    std::vector<ResourceNode> m_resources = {};
+    // Every pass' accesses and barriers, back to back in pass order
+    std::vector<ResourceAccess> m_accesses = {};
+    std::vector<Barrier> m_barriers = {};
+    // Transition of every output into its final layout, recorded after the last pass
+    std::vector<Barrier> m_finalBarriers = {};
+    std::vector<RGBatch> m_batches = {};
+    std::vector<uint32_t> m_batchPasses = {};
+    // Transients of the frame and what they need, compared against the frame's placement
+    std::vector<RGResource> m_transients = {};
+    std::vector<TransientKey> m_signature = {};
+    uint32_t m_outputBatch = 0;
+    uint32_t m_lastGraphicsBatch = 0;
+    bool m_asyncCompute = true;
+    GpuProfiler* m_profiler = nullptr;
+
+    std::array<TransientFrame, MAX_FRAMES_IN_FLIGHT> m_transientFrames = {};
+    uint32_t m_frameIndex = 0;
+    bool m_compiled = false;
+
+    RenderGraphStats m_stats = {};
+};
+
+} // namespace niji
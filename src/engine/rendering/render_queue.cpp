@@ -0,0 +1,82 @@
+#include "render_queue.hpp"
+
+#include <algorithm>
+#include <array>
+
+using namespace niji;
+
+constexpr uint64_t mask_bits(uint32_t value, uint32_t bits)
+{
+    return static_cast<uint64_t>(value) & ((1ull << bits) - 1);
+}
+
+uint64_t niji::make_opaque_sort_key(RenderQueuePass pass, uint32_t pipeline, uint32_t material,
+                                    uint32_t mesh, uint32_t depth)
+{
+    return (mask_bits(static_cast<uint32_t>(pass), 2) << 62) | (mask_bits(pipeline, 6) << 56) |
+           (mask_bits(material, 20) << 36) | (mask_bits(mesh, 16) << 20) | mask_bits(depth, 20);
+}
+
+uint64_t niji::make_depth_sort_key(RenderQueuePass pass, uint32_t pipeline, uint32_t depth,
+                                   uint32_t material, uint32_t mesh)
+{
+    return (mask_bits(static_cast<uint32_t>(pass), 2) << 62) | (mask_bits(pipeline, 6) << 56) |
+           (mask_bits(depth, 20) << 36) | (mask_bits(material, 20) << 16) | mask_bits(mesh, 16);
+}
+
+uint32_t niji::quantize_sort_depth(float viewDepth, float farPlane)
+{
+    constexpr uint32_t maxDepth = (1u << 20) - 1;
+
+    const float normalized = std::clamp(viewDepth / farPlane, 0.0f, 1.0f);
+    return static_cast<uint32_t>(normalized * static_cast<float>(maxDepth));
+}
+
+void RenderQueue::sort()
+{
+    const size_t count = m_items.size();
+    if (count < 2)
+        return;
+
+    m_scratch.resize(count);
+
+    // Histogram of every digit in a single pass over the keys
+    std::array<std::array<uint32_t, 256>, 8> histograms = {};
+    for (const RenderQueueItem& item : m_items)
+    {
+        for (int digit = 0; digit < 8; digit++)
+            histograms[digit][(item.Key >> (digit * 8)) & 0xff]++;
+    }
+
+    RenderQueueItem* src = m_items.data();
+    RenderQueueItem* dst = m_scratch.data();
+
+    for (int digit = 0; digit < 8; digit++)
+    {
+        auto& histogram = histograms[digit];
+
+        // All keys share this digit, the order would not change
+        if (histogram[(src[0].Key >> (digit * 8)) & 0xff] == count)
+            continue;
+
+        uint32_t offset = 0;
+        for (uint32_t& bucket : histogram)
+        {
+            const uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const uint32_t bucket = static_cast<uint32_t>((src[i].Key >> (digit * 8)) & 0xff);
+            dst[histogram[bucket]++] = src[i];
+        }
+
+        std::swap(src, dst);
+    }
+
+    // Odd number of passes leaves the result in the scratch buffer
+    if (src != m_items.data())
+        m_items.swap(m_scratch);
+}
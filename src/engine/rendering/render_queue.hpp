@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace niji
+{
+
+enum class RenderQueuePass : uint8_t
+{
+    DEPTH = 0,
+    FORWARD = 1
+};
+
+// Sort key layouts (MSB -> LSB):
+// Opaque: pass (2) | pipeline (6) | material (20) | mesh (16) | depth (20) -> grouped by state
+// Depth:  pass (2) | pipeline (6) | depth (20) | material (20) | mesh (16) -> front-to-back
+uint64_t make_opaque_sort_key(RenderQueuePass pass, uint32_t pipeline, uint32_t material,
+                              uint32_t mesh, uint32_t depth);
+uint64_t make_depth_sort_key(RenderQueuePass pass, uint32_t pipeline, uint32_t depth,
+                             uint32_t material, uint32_t mesh);
+
+// Maps a view space depth in [0, farPlane] onto the 20 bits a sort key has for it
+uint32_t quantize_sort_depth(float viewDepth, float farPlane);
+
+struct RenderQueueItem
+{
+    uint64_t Key = 0;
+    uint32_t Value = 0; // Draw record index
+};
+
+// Draws of a frame, radix sorted on their 64-bit key
+class RenderQueue
+{
+  public:
+    RenderQueue() = default;
+
+    void clear()
+    {
+        m_items.clear();
+    }
+    void push(uint64_t key, uint32_t value)
+    {
+        m_items.push_back({key, value});
+    }
+
+    // LSD radix sort, 8 bits per pass, passes where every key shares the digit are skipped
+    void sort();
+
+    const std::vector<RenderQueueItem>& get_items() const
+    {
+        return m_items;
+    }
+
+  private:
+    std::vector<RenderQueueItem> m_items = {};
+    std::vector<RenderQueueItem> m_scratch = {};
+};
+
+// State changes issued by the geometry passes in a frame
+struct BindStats
+{
+    uint32_t PipelineBinds = 0;
+    uint32_t DescriptorSetBinds = 0;
+    uint32_t DescriptorPushes = 0;
+    uint32_t DescriptorWrites = 0;
+    uint32_t IndexBufferBinds = 0;
+    uint32_t PushConstants = 0;
+    uint32_t Draws = 0;
+
+    // Binds that got skipped because the state was unchanged
+    uint32_t SkippedBinds = 0;
+
+    BindStats& operator+=(const BindStats& other)
+    {
+        PipelineBinds += other.PipelineBinds;
+        DescriptorSetBinds += other.DescriptorSetBinds;
+        DescriptorPushes += other.DescriptorPushes;
+        DescriptorWrites += other.DescriptorWrites;
+        IndexBufferBinds += other.IndexBufferBinds;
+        PushConstants += other.PushConstants;
+        Draws += other.Draws;
+        SkippedBinds += other.SkippedBinds;
+        return *this;
+    }
+};
+
+} // namespace niji
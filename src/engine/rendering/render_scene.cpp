@@ -0,0 +1,129 @@
+#include "render_scene.hpp"
+
+#include <cstring>
+
+#include "core/components/transform.hpp"
+
+using namespace niji;
+
+template <typename T>
+static void copy_vector(ImVector<T>& target, const ImVector<T>& source)
+{
+    // ImVector's assignment frees the old buffer first, resize() keeps it
+    target.resize(source.Size);
+    if (source.Size > 0)
+        std::memcpy(target.Data, source.Data, source.size_in_bytes());
+}
+
+ImGuiDrawSnapshot::~ImGuiDrawSnapshot()
+{
+    for (ImDrawList* list : m_lists)
+        IM_DELETE(list);
+}
+
+void ImGuiDrawSnapshot::capture(const ImDrawData& drawData)
+{
+    while (m_lists.size() < static_cast<size_t>(drawData.CmdLists.Size))
+        m_lists.push_back(IM_NEW(ImDrawList)(nullptr));
+
+    // Copied by hand, AddDrawList() expects lists that are still being written to
+    m_drawData.Clear();
+    for (int i = 0; i < drawData.CmdLists.Size; i++)
+    {
+        const ImDrawList& source = *drawData.CmdLists[i];
+        ImDrawList& list = *m_lists[i];
+        copy_vector(list.CmdBuffer, source.CmdBuffer);
+        copy_vector(list.IdxBuffer, source.IdxBuffer);
+        copy_vector(list.VtxBuffer, source.VtxBuffer);
+        list.Flags = source.Flags;
+        m_drawData.CmdLists.push_back(&list);
+    }
+
+    m_drawData.Valid = drawData.Valid;
+    m_drawData.CmdListsCount = drawData.CmdListsCount;
+    m_drawData.TotalIdxCount = drawData.TotalIdxCount;
+    m_drawData.TotalVtxCount = drawData.TotalVtxCount;
+    m_drawData.DisplayPos = drawData.DisplayPos;
+    m_drawData.DisplaySize = drawData.DisplaySize;
+    m_drawData.FramebufferScale = drawData.FramebufferScale;
+    // The backend keeps its per-frame buffers on the viewport, which lives as long as the context
+    m_drawData.OwnerViewport = drawData.OwnerViewport;
+    // Texture updates happen on the main thread, before the capture
+    m_drawData.Textures = nullptr;
+}
+
+void RenderScene::extract(ECS& ecs, uint64_t structureVersion,
+                          const std::vector<Entity>& movedBefore, const std::vector<Entity>& moved,
+                          const Camera& camera, std::vector<DebugLine>& debugLines)
+{
+    MovedObjects.clear();
+    if (structureVersion != StructureVersion)
+    {
+        StructureVersion = structureVersion;
+
+        Objects.clear();
+        m_objectLookup.clear();
+        auto view = ecs.m_registry.view<Transform, MeshComponent>();
+        for (auto&& [entity, trans, mesh] : view.each())
+        {
+            const uint32_t entityIndex = static_cast<uint32_t>(entt::to_entity(entity));
+            if (entityIndex >= m_objectLookup.size())
+                m_objectLookup.resize(entityIndex + 1, UINT32_MAX);
+            m_objectLookup[entityIndex] = static_cast<uint32_t>(Objects.size());
+
+            RenderObject object = {};
+            object.World = trans.World();
+            object.ObjectMesh = &mesh.Model->m_meshes[mesh.MeshID];
+            object.ObjectMaterial = &mesh.Model->m_materials[mesh.MaterialID];
+            object.Source = entity;
+            Objects.push_back(object);
+        }
+    }
+    else
+    {
+        // This scene was last extracted two frames ago, it missed the moves of the last frame
+        for (Entity entity : movedBefore)
+            update_moved(ecs, entity, false);
+        for (Entity entity : moved)
+            update_moved(ecs, entity, true);
+    }
+
+    PointLights.clear();
+    auto pointLightView = ecs.m_registry.view<PointLight>();
+    for (const auto& [entity, pointLight] : pointLightView.each())
+        PointLights.push_back(pointLight);
+
+    DirectionalLights.clear();
+    auto dirLightView = ecs.m_registry.view<DirectionalLight>();
+    for (const auto& [entity, dirLight] : dirLightView.each())
+        DirectionalLights.push_back(dirLight);
+
+    // Hands the lines of the last scene back, emptied
+    DebugLines.clear();
+    DebugLines.swap(debugLines);
+
+    View = camera;
+}
+
+void RenderScene::update_moved(ECS& ecs, Entity entity, bool thisFrame)
+{
+    // Entities can get destroyed after being marked, that bumps the structure version anyway
+    Transform* trans = ecs.m_registry.valid(entity) ? ecs.m_registry.try_get<Transform>(entity)
+                                                    : nullptr;
+    if (!trans)
+        return;
+
+    const uint32_t entityIndex = static_cast<uint32_t>(entt::to_entity(entity));
+    const uint32_t objectIndex =
+        entityIndex < m_objectLookup.size() ? m_objectLookup[entityIndex] : UINT32_MAX;
+    if (objectIndex != UINT32_MAX && Objects[objectIndex].Source == entity)
+    {
+        Objects[objectIndex].World = trans->World();
+        if (thisFrame)
+            MovedObjects.push_back(objectIndex);
+    }
+
+    // Children move along with their parent
+    for (Entity child : *trans)
+        update_moved(ecs, child, thisFrame);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <imgui.h>
+
+#include "core/components/render-components.hpp"
+#include "core/common.hpp"
+#include "core/ecs.hpp"
+
+namespace niji
+{
+
+struct RenderObject
+{
+    glm::mat4 World = glm::mat4(1.0f);
+    // Owned by the object's Model, which outlives the scenes that point into it
+    Mesh* ObjectMesh = nullptr;
+    Material* ObjectMaterial = nullptr;
+    // Only compared against, the render thread never touches the registry
+    Entity Source = null;
+};
+
+// ImGui rebuilds its draw data every frame, the render thread records a copy of it. The draw
+// lists are kept around, so their buffers only grow to the busiest frame's size.
+class ImGuiDrawSnapshot
+{
+  public:
+    ImGuiDrawSnapshot() = default;
+    ~ImGuiDrawSnapshot();
+
+    ImGuiDrawSnapshot(const ImGuiDrawSnapshot&) = delete;
+    ImGuiDrawSnapshot& operator=(const ImGuiDrawSnapshot&) = delete;
+
+    void capture(const ImDrawData& drawData);
+
+    ImDrawData* get_draw_data()
+    {
+        return m_drawData.Valid ? &m_drawData : nullptr;
+    }
+
+  private:
+    ImDrawData m_drawData = {};
+    std::vector<ImDrawList*> m_lists = {};
+};
+
+// Everything a frame renders, copied out of the ECS on the main thread. The render thread records
+// from it while the main thread simulates the next frame, it never reads live ECS state.
+struct RenderScene
+{
+    // Keeps its order while StructureVersion stays the same
+    std::vector<RenderObject> Objects = {};
+    // Indices into Objects, the ones that moved since the previous frame's scene got extracted
+    std::vector<uint32_t> MovedObjects = {};
+    // The renderer's scene structure version at extraction, see Renderer::m_sceneStructureVersion
+    uint64_t StructureVersion = UINT64_MAX;
+    std::vector<PointLight> PointLights = {};
+    std::vector<DirectionalLight> DirectionalLights = {};
+    std::vector<DebugLine> DebugLines = {};
+
+    Camera View = {};
+    int WindowWidth = 0;
+    int WindowHeight = 0;
+
+    ImGuiDrawSnapshot UI = {};
+
+    // Walks every rendered entity when the structure changed since this scene's last extraction.
+    // Otherwise only the entities that moved get copied: `movedBefore` (the last frame, which only
+    // the other scene has seen) and `moved` (this frame). Reuses the vectors' capacity,
+    // `debugLines` gets swapped in and is left empty.
+    void extract(ECS& ecs, uint64_t structureVersion, const std::vector<Entity>& movedBefore,
+                 const std::vector<Entity>& moved, const Camera& camera,
+                 std::vector<DebugLine>& debugLines);
+
+  private:
+    // Copies the world matrices of the entity and its children, the ones among Objects
+    void update_moved(ECS& ecs, Entity entity, bool thisFrame);
+
+    // Entity index to its object, UINT32_MAX for the ones that don't render
+    std::vector<uint32_t> m_objectLookup = {};
+};
+
+} // namespace niji
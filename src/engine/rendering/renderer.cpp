@@ -4,13 +4,12 @@
 #include <stdexcept>
 #include <fstream>
 #include <chrono>
+#include <filesystem>
 
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <vk_mem_alloc.h>
 
-#include <slang/slang.h>
-
 #include <imgui.h>
 #include <stb_image.h>
 #include <backends/imgui_impl_glfw.h>
@@ -23,9 +22,11 @@ using namespace niji;
 #include "core/components/render-components.hpp"
 #include "core/components/transform.hpp"
 #include "core/vulkan-functions.hpp"
+#include "core/frame_arena.hpp"
 
 #include "passes/line_render_pass.hpp"
 #include "passes/light_culling.hpp"
+#include "passes/draw_culling.hpp"
 #include "passes/forward_pass.hpp"
 #include "passes/skybox_pass.hpp"
 #include "passes/render_pass.hpp"
@@ -34,6 +35,7 @@ using namespace niji;
 
 #include "model/model.hpp"
 
+#include "render_scene.hpp"
 #include "swapchain.hpp"
 #include "engine.hpp"
 #include <iostream>
@@ -46,6 +48,7 @@ Renderer::Renderer()
 
 Renderer::~Renderer()
 {
+    stop_render_thread();
 }
 
 inline static void CreateCube(std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices)
@@ -71,8 +74,42 @@ inline static void CreateCube(std::vector<glm::vec3>& vertices, std::vector<uint
     };
 }
 
+// Running average, so the panels don't flicker
+static float smooth_time(float average, float sample)
+{
+    return average == 0.0f ? sample : average + (sample - average) * 0.05f;
+}
+
+static float elapsed_ms(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() -
+                                                    start)
+        .count();
+}
+
 void Renderer::init()
 {
+    m_headless = m_context->is_headless();
+
+    // Until an entity that renders comes or goes, the scenes only extract the moved ones
+    {
+        entt::registry& registry = nijiEngine.ecs.m_registry;
+        registry.on_construct<Transform>().connect<&Renderer::on_scene_structure_changed>(*this);
+        registry.on_destroy<Transform>().connect<&Renderer::on_scene_structure_changed>(*this);
+        registry.on_construct<MeshComponent>().connect<&Renderer::on_scene_structure_changed>(
+            *this);
+        registry.on_update<MeshComponent>().connect<&Renderer::on_scene_structure_changed>(*this);
+        registry.on_destroy<MeshComponent>().connect<&Renderer::on_scene_structure_changed>(*this);
+    }
+
+    // Geometry Pool (meshes get sub-allocated from it when models are loaded)
+    {
+        m_geometryPool.init(GEOMETRY_POOL_VERTEX_CAPACITY, GEOMETRY_POOL_INDEX_CAPACITY);
+
+        nijiEngine.m_editor.add_debug_menu_panel(
+            "Geometry Pool Panel", std::bind(&GeometryPool::debug_panel, &m_geometryPool));
+    }
+
     // Global Descriptor
     {
         // Camera Data
@@ -94,14 +131,13 @@ void Renderer::init()
         {
             // Create Point Light Buffer
             {
-                VkDeviceSize bufferSize = sizeof(Sphere);
                 m_spheres.resize(MAX_FRAMES_IN_FLIGHT);
                 for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
                 {
-                    std::array<Sphere, MAX_POINT_LIGHTS> buffer = {};
                     BufferDesc bufferDesc = {};
                     bufferDesc.IsPersistent = true;
                     bufferDesc.Name = "Point Lights (Sphere) Data";
+                    bufferDesc.SharedQueues = true;
                     bufferDesc.Size = sizeof(Sphere) * MAX_POINT_LIGHTS;
                     bufferDesc.Usage = BufferDesc::BufferUsage::Storage;
                     m_spheres[i] = Buffer(bufferDesc, nullptr);
@@ -119,6 +155,7 @@ void Renderer::init()
                 BufferDesc bufferDesc = {};
                 bufferDesc.IsPersistent = true;
                 bufferDesc.Name = "Scene Info Data";
+                bufferDesc.SharedQueues = true;
                 bufferDesc.Size = sizeof(SceneInfo);
                 bufferDesc.Usage = BufferDesc::BufferUsage::Uniform;
                 m_sceneInfoBuffer[i] = Buffer(bufferDesc, &ubo);
@@ -141,17 +178,40 @@ void Renderer::init()
     // Render Passes
     {
         m_renderPasses.push_back(std::make_unique<SkyboxPass>());
+        m_renderPasses.push_back(std::make_unique<DrawCullingPass>());
         m_renderPasses.push_back(std::make_unique<DepthPass>());
         m_renderPasses.push_back(std::make_unique<LightCullingPass>());
         m_renderPasses.push_back(std::make_unique<ForwardPass>());
         m_renderPasses.push_back(std::make_unique<LineRenderPass>());
-        m_renderPasses.push_back(std::make_unique<ImGuiPass>());
+        if (!m_headless)
+            m_renderPasses.push_back(std::make_unique<ImGuiPass>());
     }
     {
         for (auto& pass : m_renderPasses)
         {
             pass->init(m_swapchain, m_globalDescriptor);
         }
+
+        // Every pass described its pipelines, build them while the rest of startup runs
+        for (auto& pass : m_renderPasses)
+            pass->queue_pipelines(m_pipelineCompiler);
+        m_pipelineCompiler.start();
+
+        m_shaderCompiler.init(SHADER_CACHE_DIR);
+
+#if NIJI_RUNTIME_SHADER_COMPILER
+        for (auto& pass : m_renderPasses)
+        {
+            if (pass->m_vertFrag.Type != ShaderType::NONE)
+                m_shaderWatcher.track(pass->m_vertFrag.Source);
+            if (pass->m_compute.Type != ShaderType::NONE)
+                m_shaderWatcher.track(pass->m_compute.Source);
+        }
+        m_shaderWatcher.init();
+#else
+        // Nothing could recompile a saved shader, the watcher stays off
+        nijiEngine.m_logger.log_info("[HotReload] Disabled, built without the Slang library");
+#endif
     }
 
     // Fallback Texture
@@ -209,6 +269,7 @@ void Renderer::init()
         desc.Usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
         desc.IsReadWrite = true;
         desc.ShowInImGui = true;
+        desc.SharedQueues = true;
         m_lightGridTexture = Texture(desc);
     }
 
@@ -224,6 +285,7 @@ void Renderer::init()
             BufferDesc bufferDesc = {};
             bufferDesc.IsPersistent = true;
             bufferDesc.Name = "Light Index List Buffer";
+            bufferDesc.SharedQueues = true;
             bufferDesc.Size = sizeof(LightIndexList) * totalTiles * MAX_LIGHTS_PER_TILE;
             bufferDesc.Usage = BufferDesc::BufferUsage::Storage;
             m_lightIndexList[i] = Buffer(bufferDesc, &buffer);
@@ -239,21 +301,119 @@ void Renderer::init()
         m_commandBuffers[i].m_name = const_cast<char*>(name.c_str());
     }
 
+    // Parallel Command Recording (chunks get recorded as jobs on the engine's job system)
+    {
+        m_parallelRecorder.init();
+
+        nijiEngine.m_editor.add_debug_menu_panel(
+            "Parallel Recording Panel",
+            std::bind(&ParallelCommandRecorder::debug_panel, &m_parallelRecorder));
+    }
+
+    nijiEngine.m_editor.add_debug_menu_panel(
+        "Render Graph Panel", std::bind(&RenderGraph::debug_panel, &m_renderGraph));
+
+    // GPU Profiler (scope per render graph pass)
+    {
+        m_gpuProfiler.init();
+        m_renderGraph.set_profiler(&m_gpuProfiler);
+
+        nijiEngine.m_editor.add_debug_menu_panel(
+            "GPU Profiler Panel", std::bind(&GpuProfiler::debug_panel, &m_gpuProfiler));
+    }
+
     create_sync_objects();
 
+    // Frame Pacing
+    {
+        m_framesInFlight = std::clamp(nijiEngine.m_config.FramesInFlight, 1u,
+                                      static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT));
+        m_lowLatency = nijiEngine.m_config.LowLatency;
+        // Headless captures and benchmarks read the renderer's stats between frames
+        m_renderThreadEnabled = nijiEngine.m_config.RenderThread && !m_headless &&
+                                nijiEngine.m_config.Benchmark.empty();
+
+        nijiEngine.m_editor.add_debug_menu_panel("Frame Pacing Panel",
+                                                 std::bind(&Renderer::frame_pacing_panel, this));
+    }
+
+    // Async Compute
+    {
+        if (m_context->has_async_compute())
+        {
+            VkCommandPoolCreateInfo poolInfo = {};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+            poolInfo.queueFamilyIndex = m_context->m_computeFamily;
+
+            if (vkCreateCommandPool(m_context->m_device, &poolInfo, nullptr,
+                                    &m_computeCommandPool) != VK_SUCCESS)
+                throw std::runtime_error("Failed to Create Compute Command Pool!");
+            SetObjectName(m_context->m_device, VK_OBJECT_TYPE_COMMAND_POOL, m_computeCommandPool,
+                          "Compute Command Pool");
+        }
+
+        // Two timestamps per frame in flight
+        VkQueryPoolCreateInfo queryPoolInfo = {};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = MAX_FRAMES_IN_FLIGHT * 2;
+
+        if (vkCreateQueryPool(m_context->m_device, &queryPoolInfo, nullptr, &m_timestampPool) !=
+            VK_SUCCESS)
+            throw std::runtime_error("Failed to Create Timestamp Query Pool!");
+
+        VkPhysicalDeviceProperties properties = {};
+        vkGetPhysicalDeviceProperties(m_context->m_physicalDevice, &properties);
+        m_timestampPeriod = properties.limits.timestampPeriod;
+
+        nijiEngine.m_editor.add_debug_menu_panel("Async Compute Panel",
+                                                 std::bind(&Renderer::async_compute_panel, this));
+    }
+
+    // Headless, the viewport target is the output and the last frame gets read back
+    if (m_headless)
+    {
+        // Nothing gets drawn, the context only keeps the ImGui calls of the systems working
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(static_cast<float>(m_swapchain.m_extent.width),
+                                static_cast<float>(m_swapchain.m_extent.height));
+        io.DeltaTime = HEADLESS_DELTA_TIME;
+        io.IniFilename = nullptr;
+        io.Fonts->Build();
+
+        const VkDeviceSize captureSize =
+            static_cast<VkDeviceSize>(m_swapchain.m_extent.width) * m_swapchain.m_extent.height * 4;
+        m_context->create_buffer(captureSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                 VMA_MEMORY_USAGE_GPU_TO_CPU, m_captureBuffer,
+                                 m_captureAllocation);
+        SetObjectName(m_context->m_device, VK_OBJECT_TYPE_BUFFER, m_captureBuffer,
+                      "Capture Buffer");
+
+        m_frameTimings.reserve(nijiEngine.m_config.HeadlessFrames);
+    }
+
     // Render Targets and Render Info
     {
-        m_colorAttachments[0] = {m_swapchain.m_images[0], m_swapchain.m_imageViews[0]};
-        m_colorAttachments[0].ClearValue = {0.1f, 0.1f, 0.1f, 1.0f};
-        m_colorAttachments[0].Name = "Color Target 0";
-        m_colorAttachments[1] = {m_swapchain.m_images[1], m_swapchain.m_imageViews[1]};
-        m_colorAttachments[1].ClearValue = {0.1f, 0.1f, 0.1f, 1.0f};
-        m_colorAttachments[1].Name = "Color Target 1";
+        // The image + view get filled in once an image is acquired, the image count can change
+        // along with the present mode
+        for (size_t i = 0; i < m_colorAttachments.size(); i++)
+        {
+            m_colorAttachments[i].ClearValue = {0.1f, 0.1f, 0.1f, 1.0f};
+            m_colorAttachments[i].Name = "Color Target " + std::to_string(i);
+        }
+        if (!m_headless)
+        {
+            m_colorAttachments[0].Image = m_swapchain.m_images[0];
+            m_colorAttachments[0].ImageView = m_swapchain.m_imageViews[0];
+        }
 
         VkFormat depthFormat = nijiEngine.m_context.find_depth_format();
         m_depthAttachment = {m_swapchain.m_depthImage, m_swapchain.m_depthImageView, depthFormat};
         m_depthAttachment.ClearValue = {1.0f, 0.0f};
         m_depthAttachment.Name = "Depth Target";
+        m_depthAttachment.SharedQueues = true;
 
         RenderTargetDesc desc = {};
         desc.ClearValue = {0.1f, 0.1f, 0.1f, 1.0f};
@@ -261,10 +421,11 @@ void Renderer::init()
         desc.Width = m_swapchain.m_extent.width;
         desc.Height = m_swapchain.m_extent.height;
         desc.ShowInImGui = true;
-        desc.Name = "Viewport Target 0";
-        m_viewportTargets[0] = RenderTarget(desc);
-        desc.Name = "Viewport Target 1";
-        m_viewportTargets[1] = RenderTarget(desc);
+        for (size_t i = 0; i < m_viewportTargets.size(); i++)
+        {
+            desc.Name = "Viewport Target " + std::to_string(i);
+            m_viewportTargets[i] = RenderTarget(desc);
+        }
 
         m_renderInfo = RenderInfo(m_swapchain.m_extent);
         m_renderInfo.ColorAttachment = &m_colorAttachments[0];
@@ -280,37 +441,186 @@ void Renderer::init()
     nijiEngine.m_logger.log_error("Error Test");
 }
 
+void Renderer::begin_frame()
+{
+    m_frameStart = std::chrono::high_resolution_clock::now();
+
+    if (m_lowLatency)
+    {
+        // Gives up the overlap with the render thread, input only gets polled once both caught up
+        wait_for_render_thread();
+        wait_for_frame();
+    }
+}
+
 void Renderer::update(const float dt)
 {
-    ImGui_ImplVulkan_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
+    NIJI_PROFILE_FUNCTION();
+
+    // The systems build their ImGui windows during their updates, the editor's get built in
+    // render() once the render thread is idle. The render thread may still be drawing the last
+    // frame's UI through the same context, so the lock stays held until render() built the UI.
+    m_imguiLock.lock();
+    if (!m_headless)
+    {
+        ImGui_ImplVulkan_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+    }
     ImGui::NewFrame();
+}
+
+void Renderer::render()
+{
+    NIJI_PROFILE_FUNCTION();
+
+    // The render thread may still be recording from the other scene meanwhile
+    RenderScene& scene = m_scenes[m_extractScene];
+    {
+        NIJI_PROFILE_SCOPE("Extract Scene");
+        m_movedLastFrame.swap(m_movedThisFrame);
+        nijiEngine.ecs.take_moved(m_movedThisFrame);
+        scene.extract(nijiEngine.ecs, m_sceneStructureVersion, m_movedLastFrame, m_movedThisFrame,
+                      nijiEngine.ecs.find_system<CameraSystem>().m_camera,
+                      nijiEngine.m_debugLines);
+        m_context->get_window_size(scene.WindowWidth, scene.WindowHeight);
+    }
+
+    // Everything up to the kick touches the device and the renderer's state, the render thread has
+    // to be idle for it
+    wait_for_render_thread();
+
+    if (!m_headless && (m_context->m_framebufferResized || m_swapchainDirty))
+    {
+        recreate_swapchain();
+        m_context->m_framebufferResized = false;
+        m_swapchainDirty = false;
+    }
+
+    // Counted from one frame's sync point to the next, so it covers every system's work in between
+    const uint64_t heapAllocations = get_heap_allocation_count();
+    m_lastFrameHeapAllocations = heapAllocations - m_frameHeapAllocationStart;
+    m_frameHeapAllocationStart = heapAllocations;
+
+    // Temporaries of the frame that last used this slot are long gone
+    begin_frame_arenas(m_currentFrame);
+
+    // The render thread is idle, the panels read the last recorded frame's stats from here on
+    m_lastBindStats = m_bindStats;
+    m_bindStats = {};
+    m_parallelRecorder.sync();
+
+    {
+        NIJI_PROFILE_SCOPE("Build UI");
+
+        // Editor panels (and the assets they load) run here too
+        for (auto& pass : m_renderPasses)
+            pass->update_ui(*this, scene);
+
+        // Nothing renders ImGui's frame, it still has to be closed
+        if (m_headless)
+            ImGui::EndFrame();
+    }
+    m_imguiLock.unlock();
+
+    // Both may wait for the device, and model loads on the main thread add materials and geometry,
+    // so they only happen here, after this frame's loads and before the render thread reads them
+    m_geometryPool.compact_if_fragmented();
+    update_material_buffer();
+
+    m_renderScene = &scene;
+    m_extractScene = (m_extractScene + 1) % static_cast<uint32_t>(m_scenes.size());
+
+    if (m_renderThreadEnabled != m_renderThread.joinable())
+    {
+        if (m_renderThreadEnabled)
+            start_render_thread();
+        else
+            stop_render_thread();
+    }
+
+    if (m_renderThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_renderMutex);
+            m_renderRequested = true;
+        }
+        m_renderWake.notify_one();
+    }
+    else
+        render_frame();
+}
+
+void Renderer::end_frames()
+{
+    // Still held when a system threw after NewFrame(), the render thread would wait on it forever
+    if (m_imguiLock.owns_lock())
+        m_imguiLock.unlock();
+    wait_for_render_thread();
+    stop_render_thread();
+}
+
+void Renderer::render_frame()
+{
+    NIJI_PROFILE_FUNCTION();
+
+    if (!m_frameWaited)
+        wait_for_frame();
+    m_frameWaited = false;
+
+    // Only blocks on the first frame, BACKGROUND pipelines keep their pass out until they're done
+    m_pipelineCompiler.wait_first_frame();
+    m_pipelineCompiler.poll();
+
+    destroy_retired_pipelines(false);
+    swap_optimized_pipelines();
+
+    m_changedShaders.clear();
+    m_shaderWatcher.drain(m_changedShaders);
 
-    VkFence frameFence = m_inFlightFences[m_currentFrame];
-    vkWaitForFences(m_context->m_device, 1, &frameFence, VK_TRUE, UINT64_MAX);
-    vkResetFences(m_context->m_device, 1, &frameFence);
+    // The wait covers this frame's timestamps as well
+    read_frame_timestamps(m_currentFrame);
+    m_gpuProfiler.begin_frame(m_currentFrame);
+
+
+    // The frame's fence was waited on, so its secondaries are no longer in use
+    m_parallelRecorder.begin_frame(m_currentFrame);
 
     auto& cmd = m_commandBuffers[m_currentFrame];
     cmd.begin_list("Frame Commmand Buffer");
 
+    vkCmdResetQueryPool(cmd.m_commandBuffer, m_timestampPool, m_currentFrame * 2, 2);
+    vkCmdWriteTimestamp(cmd.m_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestampPool,
+                        m_currentFrame * 2);
+
     update_uniform_buffer(m_currentFrame);
 
     for (auto& pass : m_renderPasses)
     {
-        pass->update(*this, cmd);
+        if (pass->pipelines_ready())
+            pass->update(*this, cmd);
     }
-}
 
-void Renderer::render()
-{
     VkSemaphore acquireSemaphore = m_imageAvailableSemaphores[m_currentFrame];
 
-    VkResult result = vkAcquireNextImageKHR(m_context->m_device, m_swapchain.m_object, UINT64_MAX,
-                                            acquireSemaphore, VK_NULL_HANDLE, &m_imageIndex);
+    VkResult result = VK_SUCCESS;
+    if (m_headless)
+    {
+        // Every frame slot has its own viewport target, there are no images to acquire
+        m_imageIndex = m_currentFrame;
+    }
+    else
+    {
+        NIJI_PROFILE_SCOPE("Acquire");
+        auto acquireStart = std::chrono::high_resolution_clock::now();
+        result = vkAcquireNextImageKHR(m_context->m_device, m_swapchain.m_object, UINT64_MAX,
+                                       acquireSemaphore, VK_NULL_HANDLE, &m_imageIndex);
+        m_acquireMs = smooth_time(m_acquireMs, elapsed_ms(acquireStart));
+    }
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR)
     {
-        m_swapchain.recreate();
+        // Recreated by the main thread before the next frame, GLFW can't be called from here
+        m_swapchainDirty = true;
         return;
     }
     else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
@@ -318,10 +628,11 @@ void Renderer::render()
         throw std::runtime_error("Failed to Acquire Swap Chain Image!");
     }
 
-    auto& cmd = m_commandBuffers[m_currentFrame];
-
-    m_colorAttachments[m_imageIndex].Image = m_swapchain.m_images[m_imageIndex];
-    m_colorAttachments[m_imageIndex].ImageView = m_swapchain.m_imageViews[m_imageIndex];
+    if (!m_headless)
+    {
+        m_colorAttachments[m_imageIndex].Image = m_swapchain.m_images[m_imageIndex];
+        m_colorAttachments[m_imageIndex].ImageView = m_swapchain.m_imageViews[m_imageIndex];
+    }
 
     VkFormat depthFormat = nijiEngine.m_context.find_depth_format();
     m_depthAttachment.Image = m_swapchain.m_depthImage;
@@ -330,38 +641,167 @@ void Renderer::render()
 
     m_renderInfo.ColorAttachment = &m_colorAttachments[m_imageIndex];
     m_renderInfo.HasDepth = true;
-    m_renderInfo.ViewportTarget = &m_viewportTargets[m_imageIndex];
+    // Per frame slot, the editor picked it before the image got acquired
+    m_renderInfo.ViewportTarget = &m_viewportTargets[m_currentFrame];
     m_renderInfo.RenderArea.extent = m_swapchain.m_extent;
 
-    int i = 0;
-    for (auto& pass : m_renderPasses)
     {
-        // If we are on the last pass, tell the pass to prepare for present
-        m_renderInfo.PrepareForPresent = i == m_renderPasses.size() - 1 ? true : false;
+        NIJI_PROFILE_SCOPE("Build Render Graph");
 
-        pass->record(*this, cmd, m_renderInfo);
+        m_renderGraph.set_async_compute(m_asyncCompute);
+        m_renderGraph.begin_frame(m_currentFrame);
+        for (auto& pass : m_renderPasses)
+        {
+            if (pass->pipelines_ready())
+                pass->add_to_graph(*this, m_renderGraph, m_renderInfo);
+        }
 
-        i++;
+        if (m_headless)
+        {
+            RGResource viewport =
+                m_renderGraph.import_render_target("Viewport Target", *m_renderInfo.ViewportTarget);
+            m_renderGraph.set_output(viewport, RGUsage::TransferRead);
+        }
+        else
+        {
+            RGResource backbuffer = m_renderGraph.import_render_target(
+                "Swapchain Image", *m_renderInfo.ColorAttachment);
+            m_renderGraph.set_output(backbuffer, RGUsage::Present);
+        }
+
+        m_renderGraph.compile();
+    }
+
+    const std::vector<RGBatch>& batches = m_renderGraph.get_batches();
+    const uint32_t outputBatch = m_renderGraph.get_output_batch();
+    const uint32_t lastBatch = m_renderGraph.get_last_graphics_batch();
+    // The last frame of a headless run gets written out
+    const bool capture = m_headless && m_frameNumber + 1 == nijiEngine.m_config.HeadlessFrames;
+
+    // Batch 0 goes into the frame's command list, after this frame's uploads
+    FrameVector<VkCommandBuffer> batchBuffers(batches.size(), VK_NULL_HANDLE);
+    std::array<uint32_t, 2> usedLists = {};
+    for (uint32_t b = 0; b < batches.size(); b++)
+    {
+        CommandList* list = &cmd;
+        if (b > 0)
+        {
+            const uint32_t queue = static_cast<uint32_t>(batches[b].Queue);
+            std::vector<CommandList>& lists = m_batchLists[m_currentFrame][queue];
+            if (usedLists[queue] == lists.size())
+                lists.emplace_back(batches[b].Queue == RGQueue::AsyncCompute
+                                       ? m_computeCommandPool
+                                       : m_context->m_commandPool,
+                                   VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+            list = &lists[usedLists[queue]++];
+            list->begin_list("Render Graph Batch");
+        }
+
+        m_renderGraph.execute_batch(b, *list);
+
+        if (b == lastBatch && capture)
+            record_capture(*list);
+
+        if (b == lastBatch)
+            vkCmdWriteTimestamp(list->m_commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                m_timestampPool, m_currentFrame * 2 + 1);
+
+        list->end_list();
+        batchBuffers[b] = list->m_commandBuffer;
     }
 
-    cmd.end_list();
+    std::vector<VkSemaphore>& batchSemaphores = m_batchSemaphores[m_currentFrame];
+    while (batchSemaphores.size() < batches.size())
+    {
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+        if (vkCreateSemaphore(m_context->m_device, &semaphoreInfo, nullptr, &semaphore) !=
+            VK_SUCCESS)
+            throw std::runtime_error("Failed to Create Batch Semaphore!");
+
+        std::string name = "Batch Semaphore " + std::to_string(m_currentFrame) + " " +
+                           std::to_string(batchSemaphores.size());
+        SetObjectName(m_context->m_device, VK_OBJECT_TYPE_SEMAPHORE, semaphore, name.c_str());
+        batchSemaphores.push_back(semaphore);
+    }
 
     VkSemaphore submitSemaphore = m_renderFinishedSemaphores[m_imageIndex];
 
-    VkSubmitInfo submitInfo = {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_NONE};
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = &acquireSemaphore;
-    submitInfo.pWaitDstStageMask = waitStages;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &m_commandBuffers[m_currentFrame].m_commandBuffer;
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = &submitSemaphore;
-
-    if (vkQueueSubmit(m_context->m_graphicsQueue, 1, &submitInfo,
-                      m_inFlightFences[m_currentFrame]) != VK_SUCCESS)
-        throw std::runtime_error("Failed to Submit Draw Command Buffer!");
+    // Submitted in order, every wait is on a batch that already got submitted
+    for (uint32_t b = 0; b < batches.size(); b++)
+    {
+        const RGBatch& batch = batches[b];
+
+        VkSemaphore waitSemaphores[2] = {};
+        VkPipelineStageFlags waitStages[2] = {};
+        uint32_t waitCount = 0;
+        if (batch.WaitBatch != UINT32_MAX)
+        {
+            waitSemaphores[waitCount] = batchSemaphores[batch.WaitBatch];
+            waitStages[waitCount++] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        }
+        if (b == outputBatch && !m_headless)
+        {
+            // The backbuffer's first barrier waits on this stage, chaining it to the acquire
+            waitSemaphores[waitCount] = acquireSemaphore;
+            waitStages[waitCount++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        }
+
+        VkSemaphore signalSemaphores[3] = {};
+        // Only read for the timeline semaphore
+        uint64_t signalValues[3] = {};
+        uint32_t signalCount = 0;
+        if (batch.Signals)
+            signalSemaphores[signalCount++] = batchSemaphores[b];
+        if (b == lastBatch)
+        {
+            if (!m_headless)
+                signalSemaphores[signalCount++] = submitSemaphore;
+            signalValues[signalCount] = m_frameNumber + 1;
+            signalSemaphores[signalCount++] = m_frameTimeline;
+        }
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.signalSemaphoreValueCount = signalCount;
+        timelineInfo.pSignalSemaphoreValues = signalValues;
+
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.waitSemaphoreCount = waitCount;
+        submitInfo.pWaitSemaphores = waitSemaphores;
+        submitInfo.pWaitDstStageMask = waitStages;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &batchBuffers[b];
+        submitInfo.signalSemaphoreCount = signalCount;
+        submitInfo.pSignalSemaphores = signalSemaphores;
+
+        // The last graphics batch waits on every async batch, so the timeline covers the frame
+        VkQueue queue = batch.Queue == RGQueue::AsyncCompute ? m_context->m_computeQueue
+                                                             : m_context->m_graphicsQueue;
+        if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+            throw std::runtime_error("Failed to Submit Draw Command Buffer!");
+    }
+
+    m_frameNumber++;
+    m_slotFrameNumbers[m_currentFrame] = m_frameNumber;
+
+    m_timestampsWritten[m_currentFrame] = true;
+    m_frameUsedAsync[m_currentFrame] = m_renderGraph.get_stats().AsyncPasses > 0;
+
+    if (m_headless)
+    {
+        m_frameTimings.push_back({elapsed_ms(m_frameStart), m_lastFrameWaitMs, 0.0f});
+        if (capture)
+            finish_headless_run();
+
+        m_currentFrame = (m_currentFrame + 1) % m_framesInFlight;
+        return;
+    }
 
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -374,22 +814,344 @@ void Renderer::render()
     presentInfo.pImageIndices = &m_imageIndex;
     presentInfo.pResults = nullptr;
 
-    result = vkQueuePresentKHR(m_context->m_presentQueue, &presentInfo);
-
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
-        m_context->m_framebufferResized)
     {
-        m_swapchain.recreate();
-        m_context->m_framebufferResized = false;
+        NIJI_PROFILE_SCOPE("Present");
+        auto presentStart = std::chrono::high_resolution_clock::now();
+        result = vkQueuePresentKHR(m_context->m_presentQueue, &presentInfo);
+        m_presentMs = smooth_time(m_presentMs, elapsed_ms(presentStart));
     }
+
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+        m_swapchainDirty = true;
     else if (result != VK_SUCCESS)
         throw std::runtime_error("Failed to Present Swap Chain Image!");
 
-    m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    m_currentFrame = (m_currentFrame + 1) % m_framesInFlight;
+}
+
+void Renderer::on_scene_structure_changed(entt::registry& registry, Entity entity)
+{
+    m_sceneStructureVersion++;
+}
+
+void Renderer::start_render_thread()
+{
+    m_renderThreadQuit = false;
+    m_renderThread = std::thread(&Renderer::render_thread_loop, this);
+}
+
+void Renderer::stop_render_thread()
+{
+    if (!m_renderThread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_renderMutex);
+        m_renderThreadQuit = true;
+    }
+    m_renderWake.notify_one();
+    m_renderThread.join();
+}
+
+void Renderer::render_thread_loop()
+{
+    NIJI_PROFILE_THREAD("Render Thread");
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_renderMutex);
+            m_renderWake.wait(lock, [this]() { return m_renderRequested || m_renderThreadQuit; });
+            // A frame kicked before the quit still gets rendered
+            if (!m_renderRequested)
+                return;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        std::exception_ptr error = nullptr;
+        try
+        {
+            render_frame();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        m_renderThreadMs = smooth_time(m_renderThreadMs, elapsed_ms(start));
+
+        {
+            std::lock_guard<std::mutex> lock(m_renderMutex);
+            m_renderRequested = false;
+            if (!m_renderError)
+                m_renderError = error;
+        }
+        m_renderDone.notify_all();
+    }
+}
+
+void Renderer::wait_for_render_thread()
+{
+    if (!m_renderThread.joinable())
+        return;
+
+    NIJI_PROFILE_SCOPE("Render Thread Wait");
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::exception_ptr error = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(m_renderMutex);
+        m_renderDone.wait(lock, [this]() { return !m_renderRequested; });
+        std::swap(error, m_renderError);
+    }
+    m_renderWaitMs = smooth_time(m_renderWaitMs, elapsed_ms(start));
+
+    // Rethrown on the main thread, so it unwinds the main loop like any other error
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void Renderer::retire_pipeline(const Pipeline& pipeline)
+{
+    m_retiredPipelines.emplace_back(m_frameNumber, pipeline);
+}
+
+void Renderer::destroy_retired_pipelines(bool all)
+{
+    if (m_retiredPipelines.empty())
+        return;
+
+    uint64_t completedFrame = 0;
+    vkGetSemaphoreCounterValue(m_context->m_device, m_frameTimeline, &completedFrame);
+
+    auto it = std::remove_if(m_retiredPipelines.begin(), m_retiredPipelines.end(),
+                             [all, completedFrame](std::pair<uint64_t, Pipeline>& retired) {
+                                 if (!all && retired.first > completedFrame)
+                                     return false;
+                                 retired.second.cleanup();
+                                 return true;
+                             });
+    m_retiredPipelines.erase(it, m_retiredPipelines.end());
+}
+
+void Renderer::swap_optimized_pipelines()
+{
+    PipelineLibrary& library = m_context->get_pipeline_library();
+    if (!library.has_optimized())
+        return;
+
+    for (auto& pass : m_renderPasses)
+    {
+        // The compiler threads still write the pipelines of passes that aren't ready
+        if (!pass->pipelines_ready())
+            continue;
+
+        for (auto& [name, pipeline] : pass->m_pipelines)
+        {
+            if (!pipeline.IsGraphicsPipeline || pipeline.PipelineObject == VK_NULL_HANDLE)
+                continue;
+
+            VkPipeline optimized = library.take_optimized(pipeline.PipelineObject);
+            if (optimized == VK_NULL_HANDLE)
+                continue;
+
+            // Frames in flight may still use the fast linked one, the layout stays with the pass
+            Pipeline fastLinked = {};
+            fastLinked.PipelineObject = pipeline.PipelineObject;
+            retire_pipeline(fastLinked);
+            pipeline.PipelineObject = optimized;
+        }
+    }
+}
+
+void Renderer::wait_for_frame()
+{
+    NIJI_PROFILE_SCOPE("Frame Wait");
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // The frame about to be recorded may only run m_framesInFlight frames ahead of the GPU, and
+    // the last frame that used this slot has to be done with its resources
+    const uint64_t nextFrame = m_frameNumber + 1;
+    uint64_t waitValue = m_slotFrameNumbers[m_currentFrame];
+    if (nextFrame > m_framesInFlight)
+        waitValue = std::max(waitValue, nextFrame - m_framesInFlight);
+
+    if (waitValue > 0)
+    {
+        VkSemaphoreWaitInfo waitInfo = {};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &m_frameTimeline;
+        waitInfo.pValues = &waitValue;
+
+        if (vkWaitSemaphores(m_context->m_device, &waitInfo, UINT64_MAX) != VK_SUCCESS)
+            throw std::runtime_error("Failed to Wait on the Frame Timeline!");
+    }
+
+    m_lastFrameWaitMs = elapsed_ms(start);
+    m_frameWaitMs = smooth_time(m_frameWaitMs, m_lastFrameWaitMs);
+    m_frameWaited = true;
+}
+
+GpuMemoryUsage Renderer::get_memory_usage() const
+{
+    const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+    vmaGetMemoryProperties(m_context->m_allocator, &memoryProperties);
+
+    std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets = {};
+    vmaGetHeapBudgets(m_context->m_allocator, budgets.data());
+
+    GpuMemoryUsage usage = {};
+    for (uint32_t heap = 0; heap < memoryProperties->memoryHeapCount; heap++)
+    {
+        usage.AllocatedBytes += budgets[heap].statistics.allocationBytes;
+        usage.BlockBytes += budgets[heap].statistics.blockBytes;
+        usage.UsageBytes += budgets[heap].usage;
+        usage.BudgetBytes += budgets[heap].budget;
+    }
+    return usage;
+}
+
+void Renderer::read_frame_timestamps(uint32_t slot)
+{
+    if (!m_timestampsWritten[slot])
+        return;
+
+    uint64_t timestamps[2] = {};
+    if (vkGetQueryPoolResults(m_context->m_device, m_timestampPool, slot * 2, 2,
+                              sizeof(timestamps), timestamps, sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+    {
+        const float gpuTimeMs =
+            static_cast<float>(timestamps[1] - timestamps[0]) * m_timestampPeriod / 1e6f;
+        float& average = m_frameUsedAsync[slot] ? m_asyncGpuTimeMs : m_inlineGpuTimeMs;
+        average = smooth_time(average, gpuTimeMs);
+
+        if (m_headless)
+            m_frameTimings[m_slotFrameNumbers[slot] - 1].GpuMs = gpuTimeMs;
+    }
+
+    m_timestampsWritten[slot] = false;
+}
+
+void Renderer::record_capture(CommandList& cmd)
+{
+    // The final barriers left the viewport target in TRANSFER_SRC
+    VkBufferImageCopy region = {};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {m_swapchain.m_extent.width, m_swapchain.m_extent.height, 1};
+    vkCmdCopyImageToBuffer(cmd.m_commandBuffer, m_renderInfo.ViewportTarget->Image,
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_captureBuffer, 1, &region);
+
+    VkMemoryBarrier2 hostBarrier = {};
+    hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+    hostBarrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+    hostBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    hostBarrier.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+    hostBarrier.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+
+    VkDependencyInfo depInfo = {};
+    depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    depInfo.memoryBarrierCount = 1;
+    depInfo.pMemoryBarriers = &hostBarrier;
+    VKCmdPipelineBarrier2KHR(cmd.m_commandBuffer, &depInfo);
+}
+
+void Renderer::finish_headless_run()
+{
+    vkDeviceWaitIdle(m_context->m_device);
+    for (uint32_t slot = 0; slot < MAX_FRAMES_IN_FLIGHT; slot++)
+        read_frame_timestamps(slot);
+
+    const std::filesystem::path outputDir = nijiEngine.m_config.OutputDir;
+    std::filesystem::create_directories(outputDir);
+
+    // Binary PPM, the offscreen format is always B8G8R8A8
+    const uint32_t width = m_swapchain.m_extent.width;
+    const uint32_t height = m_swapchain.m_extent.height;
+    const std::filesystem::path imagePath =
+        outputDir / ("frame_" + std::to_string(m_frameNumber) + ".ppm");
+    {
+        void* data = nullptr;
+        vmaMapMemory(m_context->m_allocator, m_captureAllocation, &data);
+        vmaInvalidateAllocation(m_context->m_allocator, m_captureAllocation, 0, VK_WHOLE_SIZE);
+        const uint8_t* pixels = static_cast<const uint8_t*>(data);
+
+        std::ofstream image(imagePath, std::ios::binary);
+        image << "P6\n" << width << " " << height << "\n255\n";
+
+        std::vector<char> row(width * 3);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const uint8_t* pixel = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+                row[x * 3 + 0] = static_cast<char>(pixel[2]);
+                row[x * 3 + 1] = static_cast<char>(pixel[1]);
+                row[x * 3 + 2] = static_cast<char>(pixel[0]);
+            }
+            image.write(row.data(), row.size());
+        }
+
+        vmaUnmapMemory(m_context->m_allocator, m_captureAllocation);
+    }
+
+    float totalCpuMs = 0.0f;
+    float totalGpuMs = 0.0f;
+    {
+        std::ofstream csv(outputDir / "frame_times.csv");
+        csv << "frame,cpu_ms,frame_wait_ms,gpu_ms\n";
+        for (size_t i = 0; i < m_frameTimings.size(); i++)
+        {
+            const FrameTiming& timing = m_frameTimings[i];
+            csv << i + 1 << "," << timing.CpuMs << "," << timing.FrameWaitMs << ","
+                << timing.GpuMs << "\n";
+
+            totalCpuMs += timing.CpuMs;
+            totalGpuMs += timing.GpuMs;
+        }
+    }
+
+    const float frameCount = static_cast<float>(std::max<size_t>(m_frameTimings.size(), 1));
+    printf("[Headless] %zu frames at %ux%u, CPU %.3f ms / GPU %.3f ms per frame, wrote %s\n",
+           m_frameTimings.size(), width, height, totalCpuMs / frameCount, totalGpuMs / frameCount,
+           imagePath.string().c_str());
+}
+
+void Renderer::recreate_swapchain()
+{
+    m_swapchain.recreate();
+
+    // The images are new, the layouts the old ones were left in no longer apply
+    for (RenderTarget& target : m_colorAttachments)
+        target.CurrentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    m_depthAttachment.CurrentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 }
 
 void Renderer::cleanup()
 {
+    if (m_imguiLock.owns_lock())
+        m_imguiLock.unlock();
+    stop_render_thread();
+
+    {
+        entt::registry& registry = nijiEngine.ecs.m_registry;
+        registry.on_construct<Transform>().disconnect(this);
+        registry.on_destroy<Transform>().disconnect(this);
+        registry.on_construct<MeshComponent>().disconnect(this);
+        registry.on_update<MeshComponent>().disconnect(this);
+        registry.on_destroy<MeshComponent>().disconnect(this);
+    }
+    m_shaderWatcher.cleanup();
+    m_pipelineCompiler.wait_all();
+    m_shaderCompiler.cleanup();
+    // The device is idle by now
+    destroy_retired_pipelines(true);
+    m_parallelRecorder.cleanup();
+    m_renderGraph.cleanup();
+    m_gpuProfiler.cleanup();
+
     m_swapchain.cleanup();
 
     m_fallbackTexture.cleanup();
@@ -401,6 +1163,16 @@ void Renderer::cleanup()
         m_lightIndexList[i].cleanup();
     }
 
+    m_materialBuffer.cleanup();
+
+    for (int i = 0; i < m_drawRecords.size(); i++)
+    {
+        m_drawRecords[i].cleanup();
+        m_instanceData[i].cleanup();
+        m_drawCommands[i].cleanup();
+        m_drawCounts[i].cleanup();
+    }
+
     for (int i = 0; i < m_cameraData.size(); i++)
     {
         m_cameraData[i].cleanup();
@@ -423,6 +1195,12 @@ void Renderer::cleanup()
     }
     m_renderPasses.clear();
 
+    if (m_headless)
+    {
+        vmaDestroyBuffer(m_context->m_allocator, m_captureBuffer, m_captureAllocation);
+        ImGui::DestroyContext();
+    }
+
     for (int i = 0; i < m_viewportTargets.size(); i++)
     {
         m_viewportTargets[i].cleanup();
@@ -430,68 +1208,190 @@ void Renderer::cleanup()
 
     m_cube.cleanup();
 
+    m_geometryPool.cleanup();
+
     m_globalDescriptor.cleanup();
 
+    for (VkSemaphore semaphore : m_renderFinishedSemaphores)
+        vkDestroySemaphore(m_context->m_device, semaphore, nullptr);
+    vkDestroySemaphore(m_context->m_device, m_frameTimeline, nullptr);
+
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
-        vkDestroySemaphore(m_context->m_device, m_renderFinishedSemaphores[i], nullptr);
         vkDestroySemaphore(m_context->m_device, m_imageAvailableSemaphores[i], nullptr);
-        vkDestroyFence(m_context->m_device, m_inFlightFences[i], nullptr);
+
+        for (VkSemaphore semaphore : m_batchSemaphores[i])
+            vkDestroySemaphore(m_context->m_device, semaphore, nullptr);
+        m_batchSemaphores[i].clear();
+
+        for (auto& lists : m_batchLists[i])
+        {
+            for (CommandList& list : lists)
+                list.cleanup();
+            lists.clear();
+        }
     }
+
+    if (m_computeCommandPool != VK_NULL_HANDLE)
+        vkDestroyCommandPool(m_context->m_device, m_computeCommandPool, nullptr);
+    vkDestroyQueryPool(m_context->m_device, m_timestampPool, nullptr);
 }
 
 void Renderer::create_sync_objects()
 {
     m_imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    m_renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    m_inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+    m_renderFinishedSemaphores.resize(MAX_SWAPCHAIN_IMAGES);
 
     VkSemaphoreCreateInfo semaphoreInfo = {};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    VkFenceCreateInfo fenceInfo = {};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
         if (vkCreateSemaphore(m_context->m_device, &semaphoreInfo, nullptr,
-                              &m_imageAvailableSemaphores[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(m_context->m_device, &semaphoreInfo, nullptr,
-                              &m_renderFinishedSemaphores[i]) != VK_SUCCESS ||
-            vkCreateFence(m_context->m_device, &fenceInfo, nullptr, &m_inFlightFences[i]) !=
-                VK_SUCCESS)
-        {
-            throw std::runtime_error("Failed to Create Semaphores and Fences!");
-        }
+                              &m_imageAvailableSemaphores[i]) != VK_SUCCESS)
+            throw std::runtime_error("Failed to Create Semaphores!");
 
         std::string imageAvailableName = "Image Available Semaphore ";
         imageAvailableName += std::to_string(i);
         SetObjectName(m_context->m_device, VK_OBJECT_TYPE_SEMAPHORE, m_imageAvailableSemaphores[i],
                       imageAvailableName.c_str());
+    }
+
+    for (size_t i = 0; i < MAX_SWAPCHAIN_IMAGES; i++)
+    {
+        if (vkCreateSemaphore(m_context->m_device, &semaphoreInfo, nullptr,
+                              &m_renderFinishedSemaphores[i]) != VK_SUCCESS)
+            throw std::runtime_error("Failed to Create Semaphores!");
 
         std::string renderFinishedName = "Render Finished Semaphore ";
         renderFinishedName += std::to_string(i);
         SetObjectName(m_context->m_device, VK_OBJECT_TYPE_SEMAPHORE, m_renderFinishedSemaphores[i],
                       renderFinishedName.c_str());
+    }
+
+    // Replaces the per frame fences, one value per submitted frame
+    VkSemaphoreTypeCreateInfo timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    timelineInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo timelineSemaphoreInfo = {};
+    timelineSemaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    timelineSemaphoreInfo.pNext = &timelineInfo;
+
+    if (vkCreateSemaphore(m_context->m_device, &timelineSemaphoreInfo, nullptr,
+                          &m_frameTimeline) != VK_SUCCESS)
+        throw std::runtime_error("Failed to Create Frame Timeline Semaphore!");
+    SetObjectName(m_context->m_device, VK_OBJECT_TYPE_SEMAPHORE, m_frameTimeline,
+                  "Frame Timeline Semaphore");
+}
 
-        std::string inFlightFenceName = "In-Flight Fence ";
-        inFlightFenceName += std::to_string(i);
-        SetObjectName(m_context->m_device, VK_OBJECT_TYPE_FENCE, m_inFlightFences[i],
-                      inFlightFenceName.c_str());
+void Renderer::frame_pacing_panel()
+{
+    int framesInFlight = static_cast<int>(m_framesInFlight);
+    if (ImGui::SliderInt("Frames In Flight", &framesInFlight, 1, MAX_FRAMES_IN_FLIGHT))
+        m_framesInFlight = static_cast<uint32_t>(framesInFlight);
+    ImGui::Checkbox("Low Latency (Wait Before Input)", &m_lowLatency);
+    // Started or stopped at the next sync point
+    ImGui::Checkbox("Render Thread", &m_renderThreadEnabled);
+
+    const VkPresentModeKHR presentMode = m_swapchain.get_present_mode();
+    if (ImGui::BeginCombo("Present Mode", Swapchain::present_mode_to_string(presentMode)))
+    {
+        for (VkPresentModeKHR mode : m_swapchain.get_supported_present_modes())
+        {
+            if (ImGui::Selectable(Swapchain::present_mode_to_string(mode), mode == presentMode) &&
+                mode != presentMode)
+            {
+                // Recreated after this frame got presented
+                m_swapchain.set_present_mode(mode);
+                m_swapchainDirty = true;
+            }
+        }
+        ImGui::EndCombo();
     }
+
+    ImGui::Separator();
+    ImGui::Text("Swapchain Images: %u", static_cast<uint32_t>(m_swapchain.m_images.size()));
+    ImGui::Text("Frame Wait: %.3f ms", m_frameWaitMs);
+    ImGui::Text("Acquire: %.3f ms", m_acquireMs);
+    ImGui::Text("Present: %.3f ms", m_presentMs);
+    if (m_renderThread.joinable())
+    {
+        // Waits near 0 mean the simulation is the slower side, the frame takes max(sim, render)
+        ImGui::Text("Render Thread Frame: %.3f ms", m_renderThreadMs);
+        ImGui::Text("Main Thread Wait: %.3f ms", m_renderWaitMs);
+    }
+    ImGui::Text("Frames Submitted: %llu", static_cast<unsigned long long>(m_frameNumber));
+
+    ImGui::Separator();
+#if NIJI_HEAP_COUNTER
+    ImGui::Text("Heap Allocations: %llu last frame",
+                static_cast<unsigned long long>(m_lastFrameHeapAllocations));
+#else
+    ImGui::Text("Heap Allocations: not counted (NIJI_HEAP_COUNTER=OFF)");
+#endif
+    const FrameArenaStats arenas = get_frame_arena_stats();
+    ImGui::Text("Frame Arenas: %u threads, %.1f / %.1f KB", arenas.Threads,
+                arenas.UsedBytes / 1024.0, arenas.CapacityBytes / 1024.0);
+}
+
+void Renderer::async_compute_panel()
+{
+    if (m_context->has_async_compute())
+        ImGui::Text("Compute Queue Family: %u", m_context->m_computeFamily);
+    else
+        ImGui::Text("No dedicated compute queue, compute passes run inline");
+
+    ImGui::Checkbox("Async Compute", &m_asyncCompute);
+    ImGui::Text("Active: %s", m_renderGraph.is_async_compute_active() ? "Yes" : "No");
+    ImGui::Text("Submitted Batches: %u", m_renderGraph.get_stats().Batches);
+
+    ImGui::Separator();
+    ImGui::Text("GPU Frame (inline): %.3f ms", m_inlineGpuTimeMs);
+    ImGui::Text("GPU Frame (async): %.3f ms", m_asyncGpuTimeMs);
+    if (m_inlineGpuTimeMs > 0.0f && m_asyncGpuTimeMs > 0.0f)
+        ImGui::Text("Overlap Saves: %.3f ms", m_inlineGpuTimeMs - m_asyncGpuTimeMs);
+}
+
+uint32_t Renderer::register_material(const MaterialInfo& info)
+{
+    m_materialInfos.push_back(info);
+    m_materialBufferDirty = true;
+    return static_cast<uint32_t>(m_materialInfos.size() - 1);
+}
+
+void Renderer::update_material_buffer()
+{
+    if (!m_materialBufferDirty || m_materialInfos.empty())
+        return;
+
+    // Materials only get added while loading, so waiting for the GPU here is fine
+    vkDeviceWaitIdle(m_context->m_device);
+    m_materialBuffer.cleanup();
+
+    BufferDesc bufferDesc = {};
+    bufferDesc.IsPersistent = false;
+    bufferDesc.Name = "Material Buffer";
+    bufferDesc.Size = sizeof(MaterialInfo) * m_materialInfos.size();
+    bufferDesc.Usage = BufferDesc::BufferUsage::Storage;
+    m_materialBuffer = Buffer(bufferDesc, m_materialInfos.data());
+
+    m_materialBufferDirty = false;
 }
 
 void Renderer::update_uniform_buffer(uint32_t currentImage)
 {
+    NIJI_PROFILE_FUNCTION();
+
     static auto startTime = std::chrono::high_resolution_clock::now();
 
     auto currentTime = std::chrono::high_resolution_clock::now();
     float time =
         std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
 
-    auto& cameraSystem = nijiEngine.ecs.find_system<CameraSystem>();
-    auto& camera = cameraSystem.m_camera;
+    const RenderScene& scene = *m_renderScene;
+    const Camera& camera = scene.View;
     {
         CameraData ubo = {};
 
@@ -506,10 +1406,9 @@ void Renderer::update_uniform_buffer(uint32_t currentImage)
     }
 
     {
-        std::vector<Sphere> pointLightsArray = {};
+        FrameVector<Sphere> pointLightsArray = {};
         {
-            auto pointLightView = nijiEngine.ecs.m_registry.view<PointLight>();
-            for (const auto& [ent, pointLight] : pointLightView.each())
+            for (const PointLight& pointLight : scene.PointLights)
             {
                 if (pointLightsArray.size() < MAX_POINT_LIGHTS)
                 {
@@ -522,37 +1421,12 @@ void Renderer::update_uniform_buffer(uint32_t currentImage)
                     pointLightsArray.push_back(s);
                 }
             }
-            vkCmdUpdateBuffer(m_commandBuffers[currentImage].m_commandBuffer,
-                              m_spheres[currentImage].Handle, 0,
-                              sizeof(Sphere) * pointLightsArray.size(), pointLightsArray.data());
-
-            // size_t dataSize = sizeof(Sphere) * pointLightsArray.size();
-
-            // void* data = nullptr;
-            // VkResult result = vmaMapMemory(m_context->m_allocator,
-            //                                m_spheres[currentImage].BufferAllocation, &data);
-            // if (result != VK_SUCCESS)
-            //{
-            //     throw std::runtime_error("Failed to map memory for spheres buffer.");
-            // }
-
-            // memcpy(data, pointLightsArray.data(), dataSize);
-
-            ////// If not using VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, flush manually
-            //// VkMappedMemoryRange range{};
-            //// range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-            //// range.memory = m_spheres[currentImage].Memory;
-            //// range.offset = 0;
-            //// range.size = dataSize;
-
-            //// vkFlushMappedMemoryRanges(m_context->m_device, 1, &range);
-
-            //// Unmap if buffer is not persistently mapped (optional)
-            // vmaUnmapMemory(m_context->m_allocator, m_spheres[currentImage].BufferAllocation);
+            // Persistently mapped and owned by this frame slot, vkCmdUpdateBuffer tops out at 64KB
+            memcpy(m_spheres[currentImage].Data, pointLightsArray.data(),
+                   sizeof(Sphere) * pointLightsArray.size());
         }
 
-        auto dirLightView = nijiEngine.ecs.m_registry.view<DirectionalLight>();
-        for (const auto& [ent, dirLight] : dirLightView.each())
+        for (const DirectionalLight& dirLight : scene.DirectionalLights)
         {
             SceneInfo sceneInfo = {};
             sceneInfo.DirLight = dirLight;
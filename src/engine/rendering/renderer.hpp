@@ -3,16 +3,31 @@
 #include <memory>
 #include <string>
 #include <array>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 #include <glm/glm.hpp>
 
 #include "core/descriptor.hpp"
 #include "core/context.hpp"
+#include "core/shader_compiler.hpp"
+#include "core/shader_watcher.hpp"
 #include "core/envmap.hpp"
 #include "core/ecs.hpp"
 
 #include "model/mesh.hpp"
 
+#include "geometry_pool.hpp"
+#include "render_queue.hpp"
+#include "parallel_recorder.hpp"
+#include "pipeline_compiler.hpp"
+#include "render_graph.hpp"
+#include "gpu_profiler.hpp"
+#include "render_scene.hpp"
+
 #include "swapchain.hpp"
 
 namespace niji
@@ -24,7 +39,55 @@ struct Sphere
     float Radius = 0.0f;
 };
 
-class Renderer : System
+// GPU-side draw record, one per mesh instance (std430). Only changes when the scene does.
+struct DrawRecord
+{
+    glm::vec4 BoundingSphere = {}; // Object space (xyz = center, w = radius)
+
+    uint32_t IndexCount = 0;
+    uint32_t FirstIndex = 0;
+    int32_t VertexOffset = 0;
+    uint32_t BatchID = 0;
+
+    uint32_t CommandOffset = 0;
+    uint32_t _pad0[3] = {};
+};
+static_assert(sizeof(DrawRecord) == 48, "DrawRecord must match the shader layout!");
+
+// Per-instance data (std430). The frame's buffer holds one per visible draw, in the order of the
+// visible records, and the draw gets its slot through firstInstance
+struct InstanceData
+{
+    glm::mat4 Model = {};
+    glm::mat4 NormalMatrix = {};
+
+    uint32_t MaterialIndex = 0;
+    uint32_t _pad0[3] = {};
+};
+static_assert(sizeof(InstanceData) == 144, "InstanceData must match the shader layout!");
+
+class Material;
+
+// Summed over every memory heap
+struct GpuMemoryUsage
+{
+    VkDeviceSize AllocatedBytes = 0; // Handed out to resources
+    VkDeviceSize BlockBytes = 0;     // Allocated from the driver (VMA blocks)
+    VkDeviceSize UsageBytes = 0;     // Process usage the driver reports, other allocators included
+    VkDeviceSize BudgetBytes = 0;
+};
+
+// All draws sharing the same material. Owns a range of indirect commands
+// [CommandOffset, CommandOffset + MaxDraws) and one draw count slot (at its index).
+struct DrawBatch
+{
+    Material* BatchMaterial = nullptr;
+
+    uint32_t CommandOffset = 0;
+    uint32_t MaxDraws = 0;
+};
+
+class Renderer : public System
 {
   public:
     Renderer();
@@ -32,8 +95,14 @@ class Renderer : System
 
     void init();
 
+    // Waits on the GPU here in low latency mode, before input gets polled
+    void begin_frame() override;
     void update(const float dt);
+    // Extracts the scene and hands it to the render thread, which records and submits it while
+    // the main thread simulates the next frame. Without the thread the frame renders right away.
     void render();
+    // Lets the render thread finish its frame and stops it
+    void end_frames() override;
 
     void cleanup() override;
 
@@ -42,12 +111,84 @@ class Renderer : System
         m_envmap = &envmap;
     }
 
+    // Nullptr when the renderer runs without a pass of that type
+    template <typename T>
+    T* find_pass()
+    {
+        for (auto& pass : m_renderPasses)
+        {
+            if (T* found = dynamic_cast<T*>(pass.get()))
+                return found;
+        }
+        return nullptr;
+    }
+
+    GpuProfiler& get_gpu_profiler()
+    {
+        return m_gpuProfiler;
+    }
+    ParallelCommandRecorder& get_parallel_recorder()
+    {
+        return m_parallelRecorder;
+    }
+    const PipelineCompileStats& get_pipeline_compile_stats() const
+    {
+        return m_pipelineCompiler.get_stats();
+    }
+    // Binds and draws of the last recorded frame, as of the last sync point
+    const BindStats& get_bind_stats() const
+    {
+        return m_lastBindStats;
+    }
+    GpuMemoryUsage get_memory_usage() const;
+    // Global heap allocations between the last two frames, 0 once the render loop is warmed up
+    uint64_t get_frame_heap_allocations() const
+    {
+        return m_lastFrameHeapAllocations;
+    }
+
+    // Destroyed once the GPU finished every frame submitted so far, no device wide idle
+    void retire_pipeline(const Pipeline& pipeline);
+
   private:
+    // Records, submits and presents the frame of m_renderScene
+    void render_frame();
+
+    // Registry signal, an entity's Transform or MeshComponent got added, replaced or removed
+    void on_scene_structure_changed(entt::registry& registry, Entity entity);
+
+    void start_render_thread();
+    void stop_render_thread();
+    void render_thread_loop();
+    // Sync point, rethrows whatever the render thread threw during its last frame
+    void wait_for_render_thread();
+
     void create_sync_objects();
+    // Blocks until the current frame slot is free and the frame latency limit is met
+    void wait_for_frame();
+    void recreate_swapchain();
+    void destroy_retired_pipelines(bool all);
+    // Swaps in the optimized links of fast linked pipelines that finished in the background
+    void swap_optimized_pipelines();
+    // GPU time of the frame that last used the slot, once it's done
+    void read_frame_timestamps(uint32_t slot);
+
+    // Copies the viewport target into the capture buffer, after the graph's final barriers
+    void record_capture(CommandList& cmd);
+    // Waits on the GPU, writes the captured frame and every frame's timings to the output dir
+    void finish_headless_run();
+
+    // Returns the material's index into the static material buffer
+    uint32_t register_material(const MaterialInfo& info);
+    void update_material_buffer();
 
     void update_uniform_buffer(uint32_t currentImage);
 
+    void async_compute_panel();
+    void frame_pacing_panel();
+
   private:
+    friend class Mesh;
     friend class Material;
     friend class RenderPass;
     friend class ForwardPass;
@@ -56,6 +197,7 @@ class Renderer : System
     friend class LineRenderPass;
     friend class LightCullingPass;
     friend class DepthPass;
+    friend class DrawCullingPass;
     friend class Editor;
 
     std::vector<Buffer> m_cameraData = {};
@@ -68,16 +210,80 @@ class Renderer : System
 
     Mesh m_cube = {};
 
+    GeometryPool m_geometryPool = {};
+    // Worker threads + per-thread command pools for passes that record in parallel
+    ParallelCommandRecorder m_parallelRecorder = {};
+    // Builds the passes' pipelines on worker threads while the rest of startup runs
+    PipelineCompiler m_pipelineCompiler = {};
+    // Hot reloads, compiles shaders and builds their pipelines off the main thread
+    ShaderCompiler m_shaderCompiler = {};
+    // Passes' shader sources (and their imports), drained into m_changedShaders every frame
+    ShaderWatcher m_shaderWatcher = {};
+    std::vector<std::string> m_changedShaders = {};
+    // Pipelines replaced by a hot reload, with the last frame number that may still use them
+    std::vector<std::pair<uint64_t, Pipeline>> m_retiredPipelines = {};
+    // Rebuilt every frame from the passes' setup(), owns every barrier between them
+    RenderGraph m_renderGraph = {};
+    GpuProfiler m_gpuProfiler = {};
+
     Context* m_context = nullptr;
     Envmap* m_envmap = nullptr;
 
+    // Double buffered, the main thread extracts into one while the other one gets rendered
+    std::array<RenderScene, 2> m_scenes = {};
+    uint32_t m_extractScene = 0;
+    // A scene extracted with an older version walks every rendered entity again
+    uint64_t m_sceneStructureVersion = 0;
+    // ECS::take_moved() of the last and the current frame
+    std::vector<Entity> m_movedLastFrame = {};
+    std::vector<Entity> m_movedThisFrame = {};
+    // The scene of the frame being recorded, the passes read it instead of the ECS
+    RenderScene* m_renderScene = nullptr;
+
+    // Render Thread
+    std::thread m_renderThread = {};
+    std::mutex m_renderMutex = {};
+    std::condition_variable m_renderWake = {};
+    std::condition_variable m_renderDone = {};
+    bool m_renderRequested = false;
+    bool m_renderThreadQuit = false;
+    bool m_renderThreadEnabled = false;
+    std::exception_ptr m_renderError = nullptr;
+    // The backend's state lives in the ImGui context. The main thread holds it from NewFrame()
+    // until the UI got built and captured, the render thread around RenderDrawData()
+    std::mutex m_imguiMutex = {};
+    std::unique_lock<std::mutex> m_imguiLock = {m_imguiMutex, std::defer_lock};
+    // Running averages
+    float m_renderThreadMs = 0.0f;
+    float m_renderWaitMs = 0.0f;
+
     Texture m_fallbackTexture = {};
 
     Texture m_lightGridTexture = {};
     std::vector<Buffer> m_lightIndexList = {};
 
-    std::array<RenderTarget, MAX_FRAMES_IN_FLIGHT> m_colorAttachments = {};
-    std::array<RenderTarget, MAX_FRAMES_IN_FLIGHT> m_viewportTargets = {};
+    // Static material parameters of every loaded material
+    std::vector<MaterialInfo> m_materialInfos = {};
+    Buffer m_materialBuffer = {};
+    bool m_materialBufferDirty = false;
+
+    // GPU-Driven Rendering (filled by the Draw Culling Pass)
+    std::vector<Buffer> m_drawRecords = {};
+    std::vector<Buffer> m_instanceData = {};
+    std::vector<Buffer> m_drawCommands = {};
+    std::vector<Buffer> m_drawCounts = {};
+    std::vector<DrawBatch> m_drawBatches = {};
+    // Batch indices in the order the passes draw them (only batches with visible draws)
+    std::vector<uint32_t> m_depthBatchOrder = {};
+    std::vector<uint32_t> m_forwardBatchOrder = {};
+
+    // Binds issued by the geometry passes while recording, published to m_lastBindStats at the
+    // sync point so the main thread never reads them while the render thread writes
+    BindStats m_bindStats = {};
+    BindStats m_lastBindStats = {};
+
+    std::array<RenderTarget, MAX_SWAPCHAIN_IMAGES> m_colorAttachments = {};
+    std::array<RenderTarget, MAX_SWAPCHAIN_IMAGES> m_viewportTargets = {};
     RenderTarget m_depthAttachment = {};
     RenderInfo m_renderInfo = {};
 
@@ -87,7 +293,56 @@ class Renderer : System
     Descriptor m_globalDescriptor = {};
 
     std::vector<VkSemaphore> m_imageAvailableSemaphores = {};
+    // One per swapchain image
     std::vector<VkSemaphore> m_renderFinishedSemaphores = {};
-    std::vector<VkFence> m_inFlightFences = {};
+
+    // Frame Pacing, every submitted frame signals its frame number on the timeline
+    VkSemaphore m_frameTimeline = VK_NULL_HANDLE;
+    uint64_t m_frameNumber = 0; // Of the last submitted frame
+    // Frame number that last used a slot, slots stay safe while the latency changes at runtime
+    std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> m_slotFrameNumbers = {};
+    uint32_t m_framesInFlight = 2;
+    bool m_lowLatency = false;
+    bool m_frameWaited = false;
+    bool m_swapchainDirty = false;
+    // Running averages
+    float m_frameWaitMs = 0.0f;
+    float m_acquireMs = 0.0f;
+    float m_presentMs = 0.0f;
+    uint64_t m_frameHeapAllocationStart = 0;
+    uint64_t m_lastFrameHeapAllocations = 0;
+
+    // Async Compute (render graph batches after the first get their own command lists + submits)
+    bool m_asyncCompute = true;
+    VkCommandPool m_computeCommandPool = VK_NULL_HANDLE;
+    // [frame][queue]
+    std::array<std::array<std::vector<CommandList>, 2>, MAX_FRAMES_IN_FLIGHT> m_batchLists = {};
+    // [frame][batch], signaled by the batches the other queue waits on
+    std::array<std::vector<VkSemaphore>, MAX_FRAMES_IN_FLIGHT> m_batchSemaphores = {};
+
+    // GPU frame time, from the start of the first batch to the end of the last one
+    VkQueryPool m_timestampPool = VK_NULL_HANDLE;
+    float m_timestampPeriod = 0.0f;
+    std::array<bool, MAX_FRAMES_IN_FLIGHT> m_timestampsWritten = {};
+    std::array<bool, MAX_FRAMES_IN_FLIGHT> m_frameUsedAsync = {};
+    // Running averages, so both sides of the toggle can be compared
+    float m_inlineGpuTimeMs = 0.0f;
+    float m_asyncGpuTimeMs = 0.0f;
+
+    // Headless (offscreen, no swapchain images or editor)
+    struct FrameTiming
+    {
+        float CpuMs = 0.0f; // begin_frame() until the frame got submitted
+        float FrameWaitMs = 0.0f;
+        float GpuMs = 0.0f;
+    };
+
+    bool m_headless = false;
+    // One per submitted frame
+    std::vector<FrameTiming> m_frameTimings = {};
+    std::chrono::high_resolution_clock::time_point m_frameStart = {};
+    float m_lastFrameWaitMs = 0.0f;
+    VkBuffer m_captureBuffer = VK_NULL_HANDLE;
+    VmaAllocation m_captureAllocation = nullptr;
 };
 } // namespace niji
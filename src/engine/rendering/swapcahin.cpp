@@ -1,5 +1,6 @@
 #include "swapchain.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 
 #include <vk_mem_alloc.h>
@@ -38,9 +39,16 @@ SwapChainSupportDetails SwapChainSupportDetails::query_swap_chain_support(VkPhys
 
 Swapchain::Swapchain()
 {
-    create();
+    m_requestedPresentMode = present_mode_from_string(nijiEngine.m_config.PresentMode);
 
-    create_image_views();
+    if (nijiEngine.m_context.is_headless())
+        create_offscreen();
+    else
+    {
+        create();
+
+        create_image_views();
+    }
 
     create_depth_resources();
 }
@@ -75,9 +83,14 @@ void Swapchain::create()
     VkExtent2D extent = choose_swap_extent(swapChainSupport.Capabilities);
 
     uint32_t imageCount = swapChainSupport.Capabilities.minImageCount;
+    // Mailbox needs a spare image to replace, or it ends up blocking like FIFO
+    if (presentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+        imageCount++;
     if (swapChainSupport.Capabilities.maxImageCount > 0 &&
         imageCount > swapChainSupport.Capabilities.maxImageCount)
         imageCount = swapChainSupport.Capabilities.maxImageCount;
+    imageCount = std::max(std::min(imageCount, static_cast<uint32_t>(MAX_SWAPCHAIN_IMAGES)),
+                          swapChainSupport.Capabilities.minImageCount);
 
     VkSwapchainCreateInfoKHR createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -117,11 +130,23 @@ void Swapchain::create()
         throw std::runtime_error("Failed to Create Swap Chain!");
 
     vkGetSwapchainImagesKHR(nijiEngine.m_context.m_device, m_object, &imageCount, nullptr);
+    if (imageCount > MAX_SWAPCHAIN_IMAGES)
+        throw std::runtime_error("Swap Chain Has More Images Than MAX_SWAPCHAIN_IMAGES!");
     m_images.resize(imageCount);
     vkGetSwapchainImagesKHR(nijiEngine.m_context.m_device, m_object, &imageCount, m_images.data());
 
     m_format = surfaceFormat.format;
     m_extent = extent;
+    m_presentMode = presentMode;
+}
+
+void Swapchain::create_offscreen()
+{
+    // No images to present, the viewport targets are the output. Same format the windowed path
+    // prefers, so pipelines and captures match between the two.
+    m_images.clear();
+    m_format = VK_FORMAT_B8G8R8A8_UNORM;
+    m_extent = nijiEngine.m_context.m_headlessExtent;
 }
 
 void Swapchain::create_image_views()
@@ -142,7 +167,7 @@ void Swapchain::create_depth_resources()
                                       VK_IMAGE_USAGE_SAMPLED_BIT |
                                           VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
                                       VMA_MEMORY_USAGE_GPU_ONLY, 0, m_depthImage,
-                                      m_depthImageAllocation);
+                                      m_depthImageAllocation, true); // Light culling reads it
     m_depthImageView = nijiEngine.m_context.create_image_view(m_depthImage, depthFormat,
                                                               VK_IMAGE_ASPECT_DEPTH_BIT, 1, 1);
 
@@ -162,7 +187,8 @@ void Swapchain::cleanup()
         vkDestroyImageView(nijiEngine.m_context.m_device, imageView, nullptr);
     }
 
-    vkDestroySwapchainKHR(nijiEngine.m_context.m_device, m_object, nullptr);
+    if (m_object != VK_NULL_HANDLE)
+        vkDestroySwapchainKHR(nijiEngine.m_context.m_device, m_object, nullptr);
 }
 
 VkSurfaceFormatKHR Swapchain::choose_swap_surface_format(
@@ -182,9 +208,46 @@ VkPresentModeKHR Swapchain::choose_swap_present_mode(
 {
     for (const auto& availablePresentMode : availablePresentModes)
     {
-        if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
+        if (availablePresentMode == m_requestedPresentMode)
             return availablePresentMode;
     }
+    // The only mode every surface has to support
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+std::vector<VkPresentModeKHR> Swapchain::get_supported_present_modes() const
+{
+    if (nijiEngine.m_context.is_headless())
+        return {};
+
+    return SwapChainSupportDetails::query_swap_chain_support(
+               nijiEngine.m_context.m_physicalDevice, nijiEngine.m_context.m_surface)
+        .PresentModes;
+}
+
+const char* Swapchain::present_mode_to_string(VkPresentModeKHR presentMode)
+{
+    switch (presentMode)
+    {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:
+        return "immediate";
+    case VK_PRESENT_MODE_MAILBOX_KHR:
+        return "mailbox";
+    case VK_PRESENT_MODE_FIFO_KHR:
+        return "fifo";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+        return "fifo relaxed";
+    default:
+        return "unknown";
+    }
+}
+
+VkPresentModeKHR Swapchain::present_mode_from_string(const std::string& presentMode)
+{
+    if (presentMode == "immediate")
+        return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    if (presentMode == "mailbox")
+        return VK_PRESENT_MODE_MAILBOX_KHR;
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
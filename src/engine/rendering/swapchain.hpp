@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 struct VmaAllocation_T;
 typedef VmaAllocation_T* VmaAllocation;
 
@@ -22,8 +24,24 @@ class Swapchain
 
     void recreate();
 
+    // Takes effect on the next recreate(), falls back to FIFO when the surface lacks the mode
+    void set_present_mode(VkPresentModeKHR presentMode)
+    {
+        m_requestedPresentMode = presentMode;
+    }
+    VkPresentModeKHR get_present_mode() const
+    {
+        return m_presentMode;
+    }
+    std::vector<VkPresentModeKHR> get_supported_present_modes() const;
+
+    static const char* present_mode_to_string(VkPresentModeKHR presentMode);
+    static VkPresentModeKHR present_mode_from_string(const std::string& presentMode);
+
   private:
     void create();
+    // Headless, only the format / extent and the depth buffer
+    void create_offscreen();
     void create_image_views();
     void create_depth_resources();
 
@@ -52,5 +70,8 @@ class Swapchain
     std::vector<VkImageView> m_imageViews = {};
     VkFormat m_format = {};
     VkExtent2D m_extent = {};
+
+    VkPresentModeKHR m_requestedPresentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    VkPresentModeKHR m_presentMode = VK_PRESENT_MODE_FIFO_KHR;
 };
 } // namespace niji
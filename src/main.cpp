@@ -6,18 +6,28 @@
 #include "engine/engine.hpp"
 
 #include "app/camera_system.hpp"
+#include "app/benchmark.hpp"
 #include "app/app.hpp"
+#include "app/animation_systems.hpp"
 
-int main()
+int main(int argc, char** argv)
 {
-    nijiEngine.init();
+    nijiEngine.init(niji::EngineConfig::from_args(argc, argv));
+
+    // Before the app, which loads the scenario's scene and lights (and so the camera gets moved
+    // before the renderer uploads it)
+    if (!nijiEngine.m_config.Benchmark.empty())
+        nijiEngine.ecs.register_system<BenchmarkSystem>(nijiEngine.m_config.Benchmark);
 
     auto& app = nijiEngine.ecs.register_system<App>();
     auto& cameraSystem = nijiEngine.ecs.register_system<CameraSystem>();
+    // After the App, which edits what they animate. They share a wave with the camera.
+    nijiEngine.ecs.register_system<LightAnimationSystem>(app.get_light_sets());
+    nijiEngine.ecs.register_system<StressTestMotionSystem>(app.get_stress_test());
 
     nijiEngine.run();
 
     nijiEngine.cleanup();
     
-    return 0;
+    return nijiEngine.get_exit_code();
 }
\ No newline at end of file
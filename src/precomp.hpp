@@ -36,8 +36,11 @@ const std::vector<const char*> DEVICE_EXTENSIONS = {
     VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
     VK_EXT_LOAD_STORE_OP_NONE_EXTENSION_NAME};
 
-constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-constexpr int MAX_POINT_LIGHTS = 128;
+// Upper bound, how many frames are actually in flight is picked at runtime (EngineConfig)
+constexpr int MAX_FRAMES_IN_FLIGHT = 3;
+constexpr int MAX_SWAPCHAIN_IMAGES = 4;
+// Enough for the 10k light benchmark scenario
+constexpr int MAX_POINT_LIGHTS = 16384;
 constexpr int MAX_DEBUG_LINES = 10000;
 
 #ifdef NDEBUG